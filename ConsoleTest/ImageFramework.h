@@ -1,6 +1,11 @@
 #pragma once
 #include "Pipeline.h"
+#include "SharedMemory.h"
+#include <array>
+#include <cstdlib>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace ImageFramework
 {
@@ -46,6 +51,9 @@ namespace ImageFramework
 			} srgb;
 		};
 
+		/// size of the shared memory for pixel data (see GenThumbnail)
+		static constexpr size_t SharedMemorySize = 32 * 1024 * 1024;
+
 		/// \param consolePath location of ImageConsole.exe
 		Model(const std::string& consolePath = "ImageConsole.exe");
 
@@ -95,7 +103,8 @@ namespace ImageFramework
 		/// returns all supported formats for a file extension (png, jpg, ...)
 		std::vector<std::string> GetExportFormats(std::string_view extension) const;
 
-		/// waits for all console input to be finished
+		/// executes all pending commands and waits for them to be finished.
+		/// Commands without results (OpenImage, SetEquation etc.) are sent together with the next request
 		void Sync() const;
 
 		/// generates a thumbnail with the specified size
@@ -104,67 +113,101 @@ namespace ImageFramework
 		/// \param dstHeight (out) height of the generated thumbnail
 		std::vector<uint8_t> GenThumbnail(int size, int& dstWidth, int& dstHeight);
 	private:
-		std::string ReadLine() const
+		/// results of one request (output of all commands in the request)
+		class Results
 		{
-			// wait at most 10 seconds
-			for(int i = 0; i < 10000; ++i)
-			{
-				if (m_err.CanRead())
-					throw std::runtime_error(m_err.ReadLine());
+		public:
+			explicit Results(std::string data) : m_data(std::move(data)) {}
 
-				if (m_out.CanRead())
-					return m_out.ReadLine();
+			std::string_view ReadLine()
+			{
+				auto end = m_data.find('\n', m_pos);
+				if (end == std::string::npos) end = m_data.size();
+				std::string_view line(m_data.data() + m_pos, end - m_pos);
+				m_pos = end < m_data.size() ? end + 1 : end;
+				if (!line.empty() && line.back() == '\r')
+					line.remove_suffix(1);
+				return line;
+			}
 
-				//Yield();
-				Sleep(1);
+			std::vector<uint8_t> ReadBinary(size_t numBytes)
+			{
+				if (m_data.size() - m_pos < numBytes)
+					throw std::runtime_error("unexpected end of ImageConsole.exe results");
+				std::vector<uint8_t> res(m_data.begin() + m_pos, m_data.begin() + m_pos + numBytes);
+				m_pos += numBytes;
+				return res;
 			}
-			throw std::runtime_error("read line timeout expired");
-		}
 
-		std::vector<uint8_t> ReadBinary(DWORD numBytes)
+			int ReadInt() { return std::stoi(std::string(ReadLine())); }
+			float ReadFloat() { return std::stof(std::string(ReadLine())); }
+
+		private:
+			std::string m_data;
+			size_t m_pos = 0;
+		};
+
+		/// adds the command line to the next request. Commands without results are sent together with the next request
+		void Command(std::string_view line) const
 		{
-			return m_out.ReadBinary(numBytes);
+			m_batch.append(line);
+			m_batch.push_back('\n');
 		}
 
-		Statistic GetStatistic(std::string_view name) const
+		/// sends all pending commands as one frame and waits for the result frame:
+		/// uint32 status (0 = success, otherwise error), uint32 length, payload (command output or error message)
+		Results Request() const
 		{
-			Statistic stat;
-			stat.luminance = GetSingleStatistic(name, "luminance");
-			stat.lightness = GetSingleStatistic(name, "lightness");
-			stat.luma = GetSingleStatistic(name, "luma");
-			stat.avg = GetSingleStatistic(name, "avg");
-			return stat;
+			std::string batch;
+			batch.swap(m_batch);
+			m_in.WriteFrame(batch);
+
+			const auto status = m_out.Read<uint32_t>();
+			const auto length = m_out.Read<uint32_t>();
+			std::string payload(length, '\0');
+			m_out.ReadExact(payload.data(), payload.size());
+
+			if (status != 0)
+				throw std::runtime_error(payload);
+			return Results(std::move(payload));
 		}
 
-		float GetSingleStatistic(std::string_view metric, std::string_view name) const
+		/// reads the descriptor "offset size format" of binary results and copies the data from the shared memory.
+		/// offset = -1 => the data did not fit into the shared memory and follows the descriptor
+		std::vector<uint8_t> ReadBinary(Results& results) const
 		{
-			m_in.Write("-stats ");
-			m_in.Write(metric);
-			m_in.Write(" ");
-			m_in.Write(name);
-			m_in.Write("\n");
+			const std::string descriptor(results.ReadLine());
+			char* end = nullptr;
+			const long long offset = std::strtoll(descriptor.c_str(), &end, 10);
+			const size_t size = size_t(std::strtoull(end, nullptr, 10));
 
-			return std::stof(ReadLine());
+			if (offset < 0)
+				return results.ReadBinary(size);
+
+			const uint8_t* data = m_sharedMemory.GetData(size_t(offset), size);
+			return std::vector<uint8_t>(data, data + size);
 		}
 
-		static float GetLastFloat(const std::string& text)
+		static std::string Quote(std::string_view text)
 		{
-			const auto lastIdx = text.find_last_of(' ');
-			if (lastIdx == std::string::npos) return std::stof(text);
-			return std::stof(text.substr(lastIdx + 1));
+			std::string res = "\"";
+			res.append(text);
+			res.push_back('"');
+			return res;
 		}
 
 		template<size_t len>
-		std::array<float, len> GetFloats(std::string text)
+		static std::array<float, len> GetFloats(std::string_view text)
 		{
 			std::array<float, len> res;
-			auto i = res.begin();
-
-			size_t numRead = 0;
-			while (i != res.end())
+			std::string str(text);
+			const char* cur = str.c_str();
+			for (auto& f : res)
 			{
-				if (numRead) text = text.substr(numRead);
-				*i++ = std::stof(text, &numRead);
+				char* end = nullptr;
+				f = std::strtof(cur, &end);
+				if (end == cur) throw std::runtime_error("could not parse ImageConsole.exe results");
+				cur = end;
 			}
 
 			return res;
@@ -173,13 +216,14 @@ namespace ImageFramework
 		PROCESS_INFORMATION m_info;
 		mutable detail::Pipeline m_in;
 		detail::Pipeline m_out;
-		detail::Pipeline m_err;
+		mutable std::string m_batch;
+		detail::SharedMemory m_sharedMemory;
 		HANDLE m_jobHandle = nullptr;
 	};
 
 	inline Model::Model(const std::string& consolePath) :
 	m_info({}),
-		m_in(detail::Pipeline::StdIn), m_out(detail::Pipeline::StdOut), m_err(detail::Pipeline::StdOut)
+		m_in(detail::Pipeline::StdIn), m_out(detail::Pipeline::StdOut), m_sharedMemory(SharedMemorySize)
 	{
 		// create job which kills the child if the parent is terminated
 		m_jobHandle = CreateJobObjectA(nullptr, nullptr);
@@ -194,13 +238,14 @@ namespace ImageFramework
 		STARTUPINFOA st;
 		ZeroMemory(&st, sizeof(st));
 		st.cb = sizeof(st);
-		st.hStdError = m_err.GetWrite();
+		// errors are part of the result frames (stderr is not used in binary mode)
+		st.hStdError = nullptr;
 		st.hStdOutput = m_out.GetWrite();
 		st.hStdInput = m_in.GetRead();
 		st.dwFlags = STARTF_USESTDHANDLES;
 		
 
-		char args[] = "ImageConsole.exe -cin -silent";
+		char args[] = "ImageConsole.exe -silent -binary";
 		
 		if (!CreateProcessA(
 			consolePath.c_str(),
@@ -218,16 +263,25 @@ namespace ImageFramework
 		// link image console process with job object
 		if (!AssignProcessToJobObject(m_jobHandle, m_info.hProcess))
 			throw std::runtime_error("could not link imageconsole process with JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE object");
+
+		// reads will fail instead of blocking forever if the process exits
+		m_in.CloseChildEnd();
+		m_out.CloseChildEnd();
+
+		// pixel data is transferred via shared memory instead of the pipe
+		Command("-sharedmemory " + Quote(m_sharedMemory.GetName()) + " " + std::to_string(m_sharedMemory.GetSize()));
 	}
 
 	inline Model::~Model()
 	{
 		try
 		{
-			m_in.Write("-close\n");
+			m_batch.clear();
+			Command("-close");
+			m_in.WriteFrame(m_batch);
 			m_in.Flush();
+			WaitForSingleObject(m_info.hProcess, 1000);
 			TerminateProcess(m_info.hProcess, 0);
-			WaitForSingleObject(m_info.hProcess, 10000);
 		}
 		catch (...)
 		{}
@@ -239,61 +293,48 @@ namespace ImageFramework
 
 	inline void Model::OpenImage(std::string_view filename)
 	{
-		m_in.Write("-open \"");
-		m_in.Write(filename);
-		m_in.Write("\"\n");
+		Command("-open " + Quote(filename));
 	}
 
 	inline void Model::DeleteImage(int index)
 	{
-		m_in.Write("-delete ");
-		m_in.Write(std::to_string(index));
-		m_in.Write("\n");
+		Command("-delete " + std::to_string(index));
 	}
 
 	inline void Model::ClearImages()
 	{
-		m_in.Write("-delete\n");
+		Command("-delete");
 	}
 
 	inline void Model::MoveImage(int oldIndex, int newIndex)
 	{
-		m_in.Write("-move ");
-		m_in.Write(std::to_string(oldIndex));
-		m_in.Write(" ");
-		m_in.Write(std::to_string(newIndex));
-		m_in.Write("\n");
+		Command("-move " + std::to_string(oldIndex) + " " + std::to_string(newIndex));
 	}
 
 	inline void Model::OpenFilter(std::string_view filename)
 	{
-		m_in.Write("-addfilter \"");
-		m_in.Write(filename);
-		m_in.Write("\"\n");
+		Command("-addfilter " + Quote(filename));
 	}
 
 	inline void Model::DeleteFilter(int index)
 	{
-		m_in.Write("-deletefilter ");
-		m_in.Write(std::to_string(index));
-		m_in.Write("\n");
+		Command("-deletefilter " + std::to_string(index));
 	}
 
 	inline void Model::ClearFilter()
 	{
-		m_in.Write("-deletefilter\n");
+		Command("-deletefilter");
 	}
 
 	inline std::vector<Model::FilterParam> Model::GetFilterParams(int filterIndex) const
 	{
-		m_in.Write("-tellfilterparams ");
-		m_in.Write(std::to_string(filterIndex));
-		m_in.Write("\n");
+		Command("-tellfilterparams " + std::to_string(filterIndex));
+		auto results = Request();
 
 		std::vector<FilterParam> res;
 
-		std::string line;
-		while (!(line = ReadLine()).empty())
+		std::string_view line;
+		while (!(line = results.ReadLine()).empty())
 		{
 			auto split = line.find_last_of(' ');
 			res.emplace_back();
@@ -306,98 +347,92 @@ namespace ImageFramework
 
 	inline void Model::SetFilterParam(int filterIndex, std::string_view paramName, std::string_view value)
 	{
-		m_in.Write("-filterparam ");
-		m_in.Write(std::to_string(filterIndex));
-		m_in.Write(" \"");
-		m_in.Write(paramName);
-		m_in.Write("\" ");
-		m_in.Write(value);
-		m_in.Write("\n");
+		Command("-filterparam " + std::to_string(filterIndex) + " " + Quote(paramName) + " " + std::string(value));
 	}
 
 	inline void Model::SetEquation(std::string_view color, std::string_view alpha)
 	{
-		m_in.Write("-equation \"");
-		m_in.Write(color);
+		std::string line = "-equation " + Quote(color);
 		if (alpha.data())
-		{
-			m_in.Write("\" \"");
-			m_in.Write(alpha);
-		}
-		m_in.Write("\"\n");
+			line += " " + Quote(alpha);
+		Command(line);
 	}
 
 	inline int Model::GetNumLayers() const
 	{
-		m_in.Write("-telllayers\n");
-		return std::stol(ReadLine());
+		Command("-telllayers");
+		return Request().ReadInt();
 	}
 
 	inline int Model::GetNumMipmaps() const
 	{
-		m_in.Write("-tellmipmaps\n");
-		return std::stol(ReadLine());
+		Command("-tellmipmaps");
+		return Request().ReadInt();
 	}
 
 	inline void Model::GenMipmaps()
 	{
-		m_in.Write("-genmipmaps\n");
+		Command("-genmipmaps");
 	}
 
 	inline void Model::DeleteMipmaps()
 	{
-		m_in.Write("-deletemipmaps\n");
+		Command("-deletemipmaps");
 	}
 
 	inline Model::Int2 Model::GetSize(int mipmap) const
 	{
-		m_in.Write("-tellsize ");
-		m_in.Write(std::to_string(mipmap));
-		m_in.Write("\n");
+		Command("-tellsize " + std::to_string(mipmap));
+		auto results = Request();
 
 		Int2 res;
-		res.x = std::stol(ReadLine());
-		res.y = std::stol(ReadLine());
+		res.x = results.ReadInt();
+		res.y = results.ReadInt();
 		return res;
 	}
 
 	inline bool Model::IsAlpha() const
 	{
-		m_in.Write("-tellalpha\n");
-		return ReadLine() == "True";
+		Command("-tellalpha");
+		return Request().ReadLine() == "True";
 	}
 
 	inline Model::StatisticModel Model::GetStatistics() const
 	{
+		// all 12 statistics in one request
+		for (const char* mode : { "min", "max", "avg" })
+			for (const char* type : { "luminance", "lightness", "luma", "avg" })
+				Command(std::string("-stats ") + mode + " " + type);
+
+		auto results = Request();
+		auto readStatistic = [&results]()
+		{
+			Statistic stat;
+			stat.luminance = results.ReadFloat();
+			stat.lightness = results.ReadFloat();
+			stat.luma = results.ReadFloat();
+			stat.avg = results.ReadFloat();
+			return stat;
+		};
+
 		StatisticModel m;
-		m.min = GetStatistic("min");
-		m.max = GetStatistic("max");
-		m.avg = GetStatistic("avg");
+		m.min = readStatistic();
+		m.max = readStatistic();
+		m.avg = readStatistic();
 
 		return m;
 	}
 
 	inline Model::PixelColor Model::GetPixelColor(int x, int y, int layer, int mipmap, int radius)
 	{
-		m_in.Write("-tellpixel ");
-		m_in.Write(std::to_string(x));
-		m_in.Write(" ");
-		m_in.Write(std::to_string(y));
+		std::string line = "-tellpixel " + std::to_string(x) + " " + std::to_string(y);
 		if (layer != 0 || mipmap != 0 || radius != 0)
-		{
-			m_in.Write(" ");
-			m_in.Write(std::to_string(layer));
-			m_in.Write(" ");
-			m_in.Write(std::to_string(mipmap));
-			m_in.Write(" ");
-			m_in.Write(std::to_string(radius));
-		}
-		m_in.Write("\n");
+			line += " " + std::to_string(layer) + " " + std::to_string(mipmap) + " " + std::to_string(radius);
+		Command(line);
 
-		auto linear = ReadLine();
-		auto srgb = ReadLine();
-		const auto linVal = GetFloats<4>(move(linear));
-		const auto byteVal = GetFloats<4>(move(srgb));
+		auto results = Request();
+		const auto linVal = GetFloats<4>(results.ReadLine());
+		const auto byteVal = GetFloats<4>(results.ReadLine());
 
 		PixelColor res;
 		res.linear.r = linVal[0];
@@ -415,64 +450,46 @@ namespace ImageFramework
 
 	inline void Model::SetExportLayer(int layer)
 	{
-		m_in.Write("-exportlayer ");
-		m_in.Write(std::to_string(layer));
-		m_in.Write("\n");
+		Command("-exportlayer " + std::to_string(layer));
 	}
 
 	inline void Model::SetExportMipmap(int mipmap)
 	{
-		m_in.Write("-exportmipmap ");
-		m_in.Write(std::to_string(mipmap));
-		m_in.Write("\n");
+		Command("-exportmipmap " + std::to_string(mipmap));
 	}
 
 	inline void Model::SetExportQuality(int quality)
 	{
-		m_in.Write("-exportquality ");
-		m_in.Write(std::to_string(quality));
-		m_in.Write("\n");
+		Command("-exportquality " + std::to_string(quality));
 	}
 
 	inline void Model::SetExportCropping(int xStart, int yStart, int xEnd, int yEnd)
 	{
-		m_in.Write("-exportcrop true ");
-		m_in.Write(std::to_string(xStart));
-		m_in.Write(" ");
-		m_in.Write(std::to_string(yStart));
-		m_in.Write(" ");
-		m_in.Write(std::to_string(xEnd));
-		m_in.Write(" ");
-		m_in.Write(std::to_string(yEnd));
-		m_in.Write("\n");
+		Command("-exportcrop true " + std::to_string(xStart) + " " + std::to_string(yStart) + " " + 
+			std::to_string(xEnd) + " " + std::to_string(yEnd));
 	}
 
 	inline void Model::DisableExportCropping()
 	{
-		m_in.Write("-exportcrop false\n");
+		Command("-exportcrop false");
 	}
 
 	inline void Model::Export(std::string_view filename, std::string_view format) const
 	{
-		m_in.Write("-export ");
-		m_in.Write(filename);
-		m_in.Write(" ");
-		m_in.Write(format);
-		m_in.Write("\n");
+		Command("-export " + std::string(filename) + " " + std::string(format));
 	}
 
 	inline std::vector<std::string> Model::GetExportFormats(std::string_view extension) const
 	{
-		m_in.Write("-tellformats ");
-		m_in.Write(extension);
-		m_in.Write("\n");
+		Command("-tellformats " + std::string(extension));
+		auto results = Request();
 
 		std::vector<std::string> res;
 
-		std::string line;
-		while (!(line = ReadLine()).empty())
+		std::string_view line;
+		while (!(line = results.ReadLine()).empty())
 		{
-			res.emplace_back(std::move(line));
+			res.emplace_back(line);
 		}
 
 		return res;
@@ -480,20 +497,17 @@ namespace ImageFramework
 
 	inline void Model::Sync() const
 	{
-		// execute simple command where the client needs to respond
-		m_in.Write("-telllayers\n");
-		ReadLine();
+		// executes all pending commands
+		Request();
 	}
 
 	inline std::vector<uint8_t> Model::GenThumbnail(int size, int& dstWidth, int& dstHeight)
 	{
-		m_in.Write("-thumbnail ");
-		m_in.Write(std::to_string(size));
-		m_in.Write("\n");
+		Command("-thumbnail " + std::to_string(size));
+		auto results = Request();
 
-		dstWidth = std::stol(ReadLine());
-		dstHeight = std::stol(ReadLine());
-		return ReadBinary(dstWidth * dstHeight * 4);
+		dstWidth = results.ReadInt();
+		dstHeight = results.ReadInt();
+		return ReadBinary(results);
 	}
-}
-
+}
\ No newline at end of file
@@ -2,8 +2,9 @@
 #include <Windows.h>
 #include <stdexcept>
 #include <cassert>
-#include <array>
-#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
 
 namespace ImageFramework::detail
 {
@@ -54,23 +55,29 @@ namespace ImageFramework::detail
 
 		void Write(std::string_view text)
 		{
-			assert(m_type == StdIn);
-			DWORD written = 0;
-			if (!WriteFile(m_write, text.data(), DWORD(text.size()), &written, NULL))
-				throw std::runtime_error("WriteFile");
+			Write(text.data(), text.size());
 		}
 
-		bool CanRead() const
+		void Write(const void* data, size_t size)
 		{
-			assert(m_type == StdOut);
-
-			if (!m_pendingRead.empty()) return true;
-
-			DWORD available = 0;
-			if (!PeekNamedPipe(m_read, nullptr, 0, nullptr, &available, nullptr))
-				throw std::runtime_error("PeekNamedPipe");
+			assert(m_type == StdIn);
+			auto bytes = static_cast<const char*>(data);
+			while (size)
+			{
+				DWORD written = 0;
+				if (!WriteFile(m_write, bytes, DWORD(std::min<size_t>(size, MAXDWORD)), &written, NULL))
+					throw std::runtime_error("WriteFile");
+				bytes += written;
+				size -= written;
+			}
+		}
 
-			return available > 0;
+		/// writes a frame: uint32 length followed by the payload
+		void WriteFrame(std::string_view payload)
+		{
+			const uint32_t length = uint32_t(payload.size());
+			Write(&length, sizeof(length));
+			Write(payload.data(), payload.size());
 		}
 
 		void Flush()
@@ -79,90 +86,46 @@ namespace ImageFramework::detail
 			FlushFileBuffers(m_write);
 		}
 
-
-		std::string ReadLine() const
+		/// blocks until size bytes were read directly into dst.
+		/// Throws if the other end of the pipe was closed
+		void ReadExact(void* dst, size_t size) const
 		{
 			assert(m_type == StdOut);
-
-			std::string result;
-
-			do
+			auto bytes = static_cast<char*>(dst);
+			while (size)
 			{
-				if (!m_pendingRead.empty())
-				{
-					// append until end of line
-					auto it = m_pendingRead.find_first_of('\n');
-					if (it != std::string::npos)
-					{
-						// only append until end of line and return
-						result.append(m_pendingRead.c_str(), it);
-						m_pendingRead = m_pendingRead.substr(it + 1);
-
-						if (result.back() == '\r')
-							result.pop_back();
-
-						return result;
-					}
-
-					// append all and wait for more
-					result.append(m_pendingRead);
-					m_pendingRead.resize(0);
-				}
-
-				FillPendingRead();
-			} while (true);
+				DWORD numRead = 0;
+				if (!ReadFile(m_read, bytes, DWORD(std::min<size_t>(size, MAXDWORD)), &numRead, NULL) || numRead == 0)
+					throw std::runtime_error("ReadFile: ImageConsole.exe closed the pipe");
+				bytes += numRead;
+				size -= numRead;
+			}
 		}
 
-		std::vector<uint8_t> ReadBinary(DWORD numBytes) const
+		template<class T>
+		T Read() const
 		{
-			std::vector<uint8_t> res;
-			res.resize(numBytes);
-			auto cur = res.begin();
-
-			do
-			{
-				if (!m_pendingRead.empty())
-				{
-					if (m_pendingRead.size() < numBytes)
-					{
-						// copy all of pending read
-						cur = std::copy(m_pendingRead.begin(), m_pendingRead.end(), cur);
-						numBytes -= DWORD(m_pendingRead.size());
-						m_pendingRead.resize(0);
-					}
-					else
-					{
-						// only copy requested amount
-						std::copy(m_pendingRead.begin(), m_pendingRead.begin() + numBytes, cur);
-						m_pendingRead = m_pendingRead.substr(numBytes);
-						return res;
-					}
-
-					FillPendingRead();
-				}
-			} while (true);
+			T res;
+			ReadExact(&res, sizeof(res));
+			return res;
 		}
 
-		~Pipeline()
+		/// closes the end of the pipe that was inherited by the child process.
+		/// Otherwise reads would not notice when the child process exits
+		void CloseChildEnd()
 		{
-			CloseHandle(m_read);
-			CloseHandle(m_write);
+			HANDLE& handle = m_type == StdIn ? m_read : m_write;
+			CloseHandle(handle);
+			handle = nullptr;
 		}
 
-	private:
-		void FillPendingRead() const
+		~Pipeline()
 		{
-			std::array<char, 4096> buffer;
-			DWORD numRead = DWORD(buffer.size());
-
-			if (!ReadFile(m_read, buffer.data(), DWORD(buffer.size()), &numRead, NULL))
-				throw std::runtime_error("ReadFile");
-
-			m_pendingRead.append(buffer.data(), numRead);
+			if (m_read) CloseHandle(m_read);
+			if (m_write) CloseHandle(m_write);
 		}
 
-		mutable std::string m_pendingRead;
-
+	private:
 		HANDLE m_read = nullptr;
 		HANDLE m_write = nullptr;
 		Type m_type;
@@ -0,0 +1,57 @@
+#pragma once
+#include <Windows.h>
+#include <stdexcept>
+#include <cstdint>
+#include <string>
+
+namespace ImageFramework::detail
+{
+	/// named shared memory section for binary results of ImageConsole.exe (see -sharedmemory).
+	/// ImageConsole.exe uses the section as ring buffer and only sends the offsets through the pipe
+	class SharedMemory
+	{
+	public:
+		SharedMemory(size_t size) : m_size(size)
+		{
+			static volatile LONG s_counter = 0;
+			m_name = "Local\\ImageFramework_" + std::to_string(GetCurrentProcessId()) + "_" + std::to_string(InterlockedIncrement(&s_counter));
+
+			m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, DWORD(uint64_t(size) >> 32), DWORD(size), m_name.c_str());
+			if (!m_mapping)
+				throw std::runtime_error("CreateFileMapping");
+
+			m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, size));
+			if (!m_data)
+			{
+				CloseHandle(m_mapping);
+				throw std::runtime_error("MapViewOfFile");
+			}
+		}
+
+		SharedMemory(const SharedMemory&) = delete;
+		SharedMemory& operator=(const SharedMemory&) = delete;
+
+		~SharedMemory()
+		{
+			UnmapViewOfFile(m_data);
+			CloseHandle(m_mapping);
+		}
+
+		const std::string& GetName() const { return m_name; }
+		size_t GetSize() const { return m_size; }
+
+		/// data written by ImageConsole.exe. Valid until the next request
+		const uint8_t* GetData(size_t offset, size_t size) const
+		{
+			if (offset > m_size || size > m_size - offset)
+				throw std::runtime_error("invalid shared memory range");
+			return m_data + offset;
+		}
+
+	private:
+		std::string m_name;
+		size_t m_size;
+		HANDLE m_mapping = nullptr;
+		const uint8_t* m_data = nullptr;
+	};
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <gli/format.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace image
+{
+	// same conversion as Utility.ToSrgbFunction()
+	inline float toSrgb(float c)
+	{
+		if (c >= 1.0f) return 1.0f;
+		if (c <= 0.0f) return 0.0f;
+		if (c <= 0.0031308f) return 12.92f * c;
+		return 1.055f * std::pow(c, 0.41666f) - 0.055f;
+	}
+
+	inline float fromSrgb(float c)
+	{
+		if (c <= 0.04045f) return c / 12.92f;
+		return std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	// lookup tables for the 8 bit formats (same values as a gpu texture fetch)
+	struct ByteTable
+	{
+		std::array<float, 256> color; // linear value of the rgb channels
+		std::array<float, 256> srgb; // toSrgb(color)
+		std::array<float, 256> alpha;
+
+		explicit ByteTable(gli::format format)
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				const float unorm = float(i) / 255.0f;
+				const float snorm = std::max(float(int8_t(uint8_t(i))) / 127.0f, -1.0f);
+				switch (format)
+				{
+				case gli::FORMAT_RGBA8_SRGB_PACK8:
+					color[i] = fromSrgb(unorm);
+					alpha[i] = unorm;
+					break;
+				case gli::FORMAT_RGBA8_SNORM_PACK8:
+					color[i] = snorm;
+					alpha[i] = snorm;
+					break;
+				default:
+					color[i] = unorm;
+					alpha[i] = unorm;
+					break;
+				}
+				srgb[i] = toSrgb(color[i]);
+			}
+		}
+	};
+
+	// table of the RGBA8 format (srgb, snorm or unorm for all other formats)
+	inline const ByteTable& getByteTable(gli::format format)
+	{
+		static const ByteTable s_srgb(gli::FORMAT_RGBA8_SRGB_PACK8);
+		static const ByteTable s_unorm(gli::FORMAT_RGBA8_UNORM_PACK8);
+		static const ByteTable s_snorm(gli::FORMAT_RGBA8_SNORM_PACK8);
+		if (format == gli::FORMAT_RGBA8_SRGB_PACK8) return s_srgb;
+		if (format == gli::FORMAT_RGBA8_SNORM_PACK8) return s_snorm;
+		return s_unorm;
+	}
+}
@@ -0,0 +1,321 @@
+#include "pch.h"
+#include "FormatTable.h"
+#include "../dependencies/compressonator/cmp_compressonatorlib/compressonator.h"
+#include <array>
+#include <algorithm>
+#include <iterator>
+
+using namespace image;
+
+namespace
+{
+	// one row per gli format (in order of the gli enum). Formats without a row behave like FORMAT_UNDEFINED
+	constexpr FormatInfo s_formats[] = {
+		// format, vkFormat, cmpFormat, blockSize, blockWidth, blockHeight, numChannels, flags, supported
+		{ gli::FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 0, 0, 0, 0, 0, gli::FORMAT_UNDEFINED },
+
+		{ gli::FORMAT_RG4_UNORM_PACK8, VK_FORMAT_R4G4_UNORM_PACK8, CMP_FORMAT_Unknown, 1, 1, 1, 2, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA4_UNORM_PACK16, VK_FORMAT_R4G4B4A4_UNORM_PACK16, CMP_FORMAT_Unknown, 2, 1, 1, 4, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_BGRA4_UNORM_PACK16, VK_FORMAT_B4G4R4A4_UNORM_PACK16, CMP_FORMAT_Unknown, 2, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_R5G6B5_UNORM_PACK16, VK_FORMAT_R5G6B5_UNORM_PACK16, CMP_FORMAT_Unknown, 2, 1, 1, 3, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_B5G6R5_UNORM_PACK16, VK_FORMAT_B5G6R5_UNORM_PACK16, CMP_FORMAT_Unknown, 2, 1, 1, 3, FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGB5A1_UNORM_PACK16, VK_FORMAT_R5G5B5A1_UNORM_PACK16, CMP_FORMAT_Unknown, 2, 1, 1, 4, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_BGR5A1_UNORM_PACK16, VK_FORMAT_B5G5R5A1_UNORM_PACK16, CMP_FORMAT_Unknown, 2, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_A1RGB5_UNORM_PACK16, VK_FORMAT_A1R5G5B5_UNORM_PACK16, CMP_FORMAT_Unknown, 2, 1, 1, 4, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+
+		{ gli::FORMAT_R8_UNORM_PACK8, VK_FORMAT_R8_UNORM, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_R8_SNORM_PACK8, VK_FORMAT_R8_SNORM, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_R8_USCALED_PACK8, VK_FORMAT_R8_USCALED, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R8_SSCALED_PACK8, VK_FORMAT_R8_SSCALED, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R8_UINT_PACK8, VK_FORMAT_R8_UINT, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R8_SINT_PACK8, VK_FORMAT_R8_SINT, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R8_SRGB_PACK8, VK_FORMAT_R8_SRGB, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_SRGB | FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RG8_UNORM_PACK8, VK_FORMAT_R8G8_UNORM, CMP_FORMAT_Unknown, 2, 1, 1, 2, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RG8_SNORM_PACK8, VK_FORMAT_R8G8_SNORM, CMP_FORMAT_Unknown, 2, 1, 1, 2, 0, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_RG8_USCALED_PACK8, VK_FORMAT_R8G8_USCALED, CMP_FORMAT_Unknown, 2, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG8_SSCALED_PACK8, VK_FORMAT_R8G8_SSCALED, CMP_FORMAT_Unknown, 2, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG8_UINT_PACK8, VK_FORMAT_R8G8_UINT, CMP_FORMAT_Unknown, 2, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG8_SINT_PACK8, VK_FORMAT_R8G8_SINT, CMP_FORMAT_Unknown, 2, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG8_SRGB_PACK8, VK_FORMAT_R8G8_SRGB, CMP_FORMAT_Unknown, 2, 1, 1, 2, FORMAT_FLAG_SRGB, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RGB8_UNORM_PACK8, VK_FORMAT_R8G8B8_UNORM, CMP_FORMAT_Unknown, 3, 1, 1, 3, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGB8_SNORM_PACK8, VK_FORMAT_R8G8B8_SNORM, CMP_FORMAT_Unknown, 3, 1, 1, 3, 0, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_RGB8_USCALED_PACK8, VK_FORMAT_R8G8B8_USCALED, CMP_FORMAT_Unknown, 3, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB8_SSCALED_PACK8, VK_FORMAT_R8G8B8_SSCALED, CMP_FORMAT_Unknown, 3, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB8_UINT_PACK8, VK_FORMAT_R8G8B8_UINT, CMP_FORMAT_Unknown, 3, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB8_SINT_PACK8, VK_FORMAT_R8G8B8_SINT, CMP_FORMAT_Unknown, 3, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB8_SRGB_PACK8, VK_FORMAT_R8G8B8_SRGB, CMP_FORMAT_Unknown, 3, 1, 1, 3, FORMAT_FLAG_SRGB, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_BGR8_UNORM_PACK8, VK_FORMAT_B8G8R8_UNORM, CMP_FORMAT_Unknown, 3, 1, 1, 3, FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_BGR8_SNORM_PACK8, VK_FORMAT_B8G8R8_SNORM, CMP_FORMAT_Unknown, 3, 1, 1, 3, FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_BGR8_USCALED_PACK8, VK_FORMAT_B8G8R8_USCALED, CMP_FORMAT_Unknown, 3, 1, 1, 3, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR8_SSCALED_PACK8, VK_FORMAT_B8G8R8_SSCALED, CMP_FORMAT_Unknown, 3, 1, 1, 3, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR8_UINT_PACK8, VK_FORMAT_B8G8R8_UINT, CMP_FORMAT_Unknown, 3, 1, 1, 3, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR8_SINT_PACK8, VK_FORMAT_B8G8R8_SINT, CMP_FORMAT_Unknown, 3, 1, 1, 3, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR8_SRGB_PACK8, VK_FORMAT_B8G8R8_SRGB, CMP_FORMAT_Unknown, 3, 1, 1, 3, FORMAT_FLAG_SRGB | FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RGBA8_UNORM_PACK8, VK_FORMAT_R8G8B8A8_UNORM, CMP_FORMAT_RGBA_8888, 4, 1, 1, 4, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA8_SNORM_PACK8, VK_FORMAT_R8G8B8A8_SNORM, CMP_FORMAT_RGBA_8888_S, 4, 1, 1, 4, 0, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_RGBA8_USCALED_PACK8, VK_FORMAT_R8G8B8A8_USCALED, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA8_SSCALED_PACK8, VK_FORMAT_R8G8B8A8_SSCALED, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA8_UINT_PACK8, VK_FORMAT_R8G8B8A8_UINT, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA8_SINT_PACK8, VK_FORMAT_R8G8B8A8_SINT, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA8_SRGB_PACK8, VK_FORMAT_R8G8B8A8_SRGB, CMP_FORMAT_RGBA_8888, 4, 1, 1, 4, FORMAT_FLAG_SRGB, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_BGRA8_UNORM_PACK8, VK_FORMAT_B8G8R8A8_UNORM, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_BGRA8_SNORM_PACK8, VK_FORMAT_B8G8R8A8_SNORM, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_BGRA8_USCALED_PACK8, VK_FORMAT_B8G8R8A8_USCALED, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGRA8_SSCALED_PACK8, VK_FORMAT_B8G8R8A8_SSCALED, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGRA8_UINT_PACK8, VK_FORMAT_B8G8R8A8_UINT, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGRA8_SINT_PACK8, VK_FORMAT_B8G8R8A8_SINT, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGRA8_SRGB_PACK8, VK_FORMAT_B8G8R8A8_SRGB, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RGBA8_UNORM_PACK32, VK_FORMAT_R8G8B8A8_UNORM, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA8_SNORM_PACK32, VK_FORMAT_R8G8B8A8_SNORM, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_RGBA8_USCALED_PACK32, VK_FORMAT_R8G8B8A8_USCALED, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA8_SSCALED_PACK32, VK_FORMAT_R8G8B8A8_SSCALED, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA8_UINT_PACK32, VK_FORMAT_R8G8B8A8_UINT, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA8_SINT_PACK32, VK_FORMAT_R8G8B8A8_SINT, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA8_SRGB_PACK32, VK_FORMAT_R8G8B8A8_SRGB, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_SRGB, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RGB10A2_UNORM_PACK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB10A2_SNORM_PACK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB10A2_USCALED_PACK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB10A2_SSCALED_PACK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB10A2_UINT_PACK32, VK_FORMAT_A2R10G10B10_UINT_PACK32, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB10A2_SINT_PACK32, VK_FORMAT_A2R10G10B10_SINT_PACK32, CMP_FORMAT_Unknown, 4, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_BGR10A2_UNORM_PACK32, VK_FORMAT_A2B10G10R10_UNORM_PACK32, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR10A2_SNORM_PACK32, VK_FORMAT_A2B10G10R10_SNORM_PACK32, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR10A2_USCALED_PACK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR10A2_SSCALED_PACK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR10A2_UINT_PACK32, VK_FORMAT_A2B10G10R10_UINT_PACK32, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_BGR10A2_SINT_PACK32, VK_FORMAT_A2B10G10R10_SINT_PACK32, CMP_FORMAT_Unknown, 4, 1, 1, 4, FORMAT_FLAG_BGR, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_R16_UNORM_PACK16, VK_FORMAT_R16_UNORM, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R16_SNORM_PACK16, VK_FORMAT_R16_SNORM, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R16_USCALED_PACK16, VK_FORMAT_R16_USCALED, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R16_SSCALED_PACK16, VK_FORMAT_R16_SSCALED, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R16_UINT_PACK16, VK_FORMAT_R16_UINT, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R16_SINT_PACK16, VK_FORMAT_R16_SINT, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R16_SFLOAT_PACK16, VK_FORMAT_R16_SFLOAT, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RG16_UNORM_PACK16, VK_FORMAT_R16G16_UNORM, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG16_SNORM_PACK16, VK_FORMAT_R16G16_SNORM, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG16_USCALED_PACK16, VK_FORMAT_R16G16_USCALED, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG16_SSCALED_PACK16, VK_FORMAT_R16G16_SSCALED, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG16_UINT_PACK16, VK_FORMAT_R16G16_UINT, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG16_SINT_PACK16, VK_FORMAT_R16G16_SINT, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG16_SFLOAT_PACK16, VK_FORMAT_R16G16_SFLOAT, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RGB16_UNORM_PACK16, VK_FORMAT_R16G16B16_UNORM, CMP_FORMAT_Unknown, 6, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB16_SNORM_PACK16, VK_FORMAT_R16G16B16_SNORM, CMP_FORMAT_Unknown, 6, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB16_USCALED_PACK16, VK_FORMAT_R16G16B16_USCALED, CMP_FORMAT_Unknown, 6, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB16_SSCALED_PACK16, VK_FORMAT_R16G16B16_SSCALED, CMP_FORMAT_Unknown, 6, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB16_UINT_PACK16, VK_FORMAT_R16G16B16_UINT, CMP_FORMAT_Unknown, 6, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB16_SINT_PACK16, VK_FORMAT_R16G16B16_SINT, CMP_FORMAT_Unknown, 6, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB16_SFLOAT_PACK16, VK_FORMAT_R16G16B16_SFLOAT, CMP_FORMAT_Unknown, 6, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RGBA16_UNORM_PACK16, VK_FORMAT_R16G16B16A16_UNORM, CMP_FORMAT_Unknown, 8, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA16_SNORM_PACK16, VK_FORMAT_R16G16B16A16_SNORM, CMP_FORMAT_Unknown, 8, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA16_USCALED_PACK16, VK_FORMAT_R16G16B16A16_USCALED, CMP_FORMAT_Unknown, 8, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA16_SSCALED_PACK16, VK_FORMAT_R16G16B16A16_SSCALED, CMP_FORMAT_Unknown, 8, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA16_UINT_PACK16, VK_FORMAT_R16G16B16A16_UINT, CMP_FORMAT_Unknown, 8, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA16_SINT_PACK16, VK_FORMAT_R16G16B16A16_SINT, CMP_FORMAT_Unknown, 8, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA16_SFLOAT_PACK16, VK_FORMAT_R16G16B16A16_SFLOAT, CMP_FORMAT_Unknown, 8, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_R32_UINT_PACK32, VK_FORMAT_R32_UINT, CMP_FORMAT_Unknown, 4, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R32_SINT_PACK32, VK_FORMAT_R32_SINT, CMP_FORMAT_Unknown, 4, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R32_SFLOAT_PACK32, VK_FORMAT_R32_SFLOAT, CMP_FORMAT_Unknown, 4, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RG32_UINT_PACK32, VK_FORMAT_R32G32_UINT, CMP_FORMAT_Unknown, 8, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG32_SINT_PACK32, VK_FORMAT_R32G32_SINT, CMP_FORMAT_Unknown, 8, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG32_SFLOAT_PACK32, VK_FORMAT_R32G32_SFLOAT, CMP_FORMAT_Unknown, 8, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RGB32_UINT_PACK32, VK_FORMAT_R32G32B32_UINT, CMP_FORMAT_Unknown, 12, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB32_SINT_PACK32, VK_FORMAT_R32G32B32_SINT, CMP_FORMAT_Unknown, 12, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB32_SFLOAT_PACK32, VK_FORMAT_R32G32B32_SFLOAT, CMP_FORMAT_Unknown, 12, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RGBA32_UINT_PACK32, VK_FORMAT_R32G32B32A32_UINT, CMP_FORMAT_Unknown, 16, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA32_SINT_PACK32, VK_FORMAT_R32G32B32A32_SINT, CMP_FORMAT_Unknown, 16, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA32_SFLOAT_PACK32, VK_FORMAT_R32G32B32A32_SFLOAT, CMP_FORMAT_RGBA_32F, 16, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_R64_UINT_PACK64, VK_FORMAT_R64_UINT, CMP_FORMAT_Unknown, 8, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R64_SINT_PACK64, VK_FORMAT_R64_SINT, CMP_FORMAT_Unknown, 8, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_R64_SFLOAT_PACK64, VK_FORMAT_R64_SFLOAT, CMP_FORMAT_Unknown, 8, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RG64_UINT_PACK64, VK_FORMAT_R64G64_UINT, CMP_FORMAT_Unknown, 16, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG64_SINT_PACK64, VK_FORMAT_R64G64_SINT, CMP_FORMAT_Unknown, 16, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RG64_SFLOAT_PACK64, VK_FORMAT_R64G64_SFLOAT, CMP_FORMAT_Unknown, 16, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RGB64_UINT_PACK64, VK_FORMAT_R64G64B64_UINT, CMP_FORMAT_Unknown, 24, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB64_SINT_PACK64, VK_FORMAT_R64G64B64_SINT, CMP_FORMAT_Unknown, 24, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB64_SFLOAT_PACK64, VK_FORMAT_R64G64B64_SFLOAT, CMP_FORMAT_Unknown, 24, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RGBA64_UINT_PACK64, VK_FORMAT_R64G64B64A64_UINT, CMP_FORMAT_Unknown, 32, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA64_SINT_PACK64, VK_FORMAT_R64G64B64A64_SINT, CMP_FORMAT_Unknown, 32, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA64_SFLOAT_PACK64, VK_FORMAT_R64G64B64A64_SFLOAT, CMP_FORMAT_Unknown, 32, 1, 1, 4, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RG11B10_UFLOAT_PACK32, VK_FORMAT_B10G11R11_UFLOAT_PACK32, CMP_FORMAT_Unknown, 4, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB9E5_UFLOAT_PACK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 3, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_D16_UNORM_PACK16, VK_FORMAT_D16_UNORM, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_D24_UNORM_PACK32, VK_FORMAT_X8_D24_UNORM_PACK32, CMP_FORMAT_Unknown, 4, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_D32_SFLOAT_PACK32, VK_FORMAT_D32_SFLOAT, CMP_FORMAT_Unknown, 4, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_S8_UINT_PACK8, VK_FORMAT_S8_UINT, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_D16_UNORM_S8_UINT_PACK32, VK_FORMAT_D16_UNORM_S8_UINT, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_D24_UNORM_S8_UINT_PACK32, VK_FORMAT_D24_UNORM_S8_UINT, CMP_FORMAT_Unknown, 4, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_D32_SFLOAT_S8_UINT_PACK64, VK_FORMAT_D32_SFLOAT_S8_UINT, CMP_FORMAT_Unknown, 8, 1, 1, 2, 0, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_RGB_DXT1_UNORM_BLOCK8, VK_FORMAT_BC1_RGB_UNORM_BLOCK, CMP_FORMAT_DXT1, 8, 4, 4, 3, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGB_DXT1_SRGB_BLOCK8, VK_FORMAT_BC1_RGB_SRGB_BLOCK, CMP_FORMAT_DXT1, 8, 4, 4, 3, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8, VK_FORMAT_BC1_RGBA_UNORM_BLOCK, CMP_FORMAT_DXT1, 8, 4, 4, 4, FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_DXT1_ALPHA, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_DXT1_SRGB_BLOCK8, VK_FORMAT_BC1_RGBA_SRGB_BLOCK, CMP_FORMAT_DXT1, 8, 4, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_DXT1_ALPHA, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_DXT3_UNORM_BLOCK16, VK_FORMAT_BC2_UNORM_BLOCK, CMP_FORMAT_DXT3, 16, 4, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_DXT3_SRGB_BLOCK16, VK_FORMAT_BC2_SRGB_BLOCK, CMP_FORMAT_DXT3, 16, 4, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16, VK_FORMAT_BC3_UNORM_BLOCK, CMP_FORMAT_DXT5, 16, 4, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_DXT5_SRGB_BLOCK16, VK_FORMAT_BC3_SRGB_BLOCK, CMP_FORMAT_DXT5, 16, 4, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_R_ATI1N_UNORM_BLOCK8, VK_FORMAT_BC4_UNORM_BLOCK, CMP_FORMAT_BC4, 8, 4, 4, 1, FORMAT_FLAG_GRAYSCALE | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_R_ATI1N_SNORM_BLOCK8, VK_FORMAT_BC4_SNORM_BLOCK, CMP_FORMAT_BC4_S, 8, 4, 4, 1, FORMAT_FLAG_GRAYSCALE | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_RG_ATI2N_UNORM_BLOCK16, VK_FORMAT_BC5_UNORM_BLOCK, CMP_FORMAT_BC5, 16, 4, 4, 2, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RG_ATI2N_SNORM_BLOCK16, VK_FORMAT_BC5_SNORM_BLOCK, CMP_FORMAT_BC5_S, 16, 4, 4, 2, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_RGB_BP_UFLOAT_BLOCK16, VK_FORMAT_BC6H_UFLOAT_BLOCK, CMP_FORMAT_BC6H, 16, 4, 4, 3, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGB_BP_SFLOAT_BLOCK16, VK_FORMAT_BC6H_SFLOAT_BLOCK, CMP_FORMAT_BC6H_SF, 16, 4, 4, 3, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_RGBA_BP_UNORM_BLOCK16, VK_FORMAT_BC7_UNORM_BLOCK, CMP_FORMAT_BC7, 16, 4, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_BP_SRGB_BLOCK16, VK_FORMAT_BC7_SRGB_BLOCK, CMP_FORMAT_BC7, 16, 4, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RGB_ETC2_UNORM_BLOCK8, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, CMP_FORMAT_ETC2_RGB, 8, 4, 4, 3, FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_SWIZZLE, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGB_ETC2_SRGB_BLOCK8, VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, CMP_FORMAT_ETC2_SRGB, 8, 4, 4, 3, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_SWIZZLE, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ETC2_UNORM_BLOCK8, VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, CMP_FORMAT_ETC2_RGBA1, 8, 4, 4, 4, FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_SWIZZLE_SOURCE, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ETC2_SRGB_BLOCK8, VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK, CMP_FORMAT_ETC2_SRGBA1, 8, 4, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_SWIZZLE_SOURCE, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ETC2_UNORM_BLOCK16, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, CMP_FORMAT_ETC2_RGBA, 16, 4, 4, 4, FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_SWIZZLE_SOURCE, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ETC2_SRGB_BLOCK16, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, CMP_FORMAT_ETC2_SRGBA, 16, 4, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_SWIZZLE_SOURCE, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_R_EAC_UNORM_BLOCK8, VK_FORMAT_EAC_R11_UNORM_BLOCK, CMP_FORMAT_Unknown, 8, 4, 4, 1, FORMAT_FLAG_GRAYSCALE | FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_UNSUPPORTED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_R_EAC_SNORM_BLOCK8, VK_FORMAT_EAC_R11_SNORM_BLOCK, CMP_FORMAT_Unknown, 8, 4, 4, 1, FORMAT_FLAG_GRAYSCALE | FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_UNSUPPORTED, gli::FORMAT_RGBA8_SNORM_PACK8 },
+		{ gli::FORMAT_RG_EAC_UNORM_BLOCK16, VK_FORMAT_EAC_R11G11_UNORM_BLOCK, CMP_FORMAT_Unknown, 16, 4, 4, 2, FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_UNSUPPORTED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RG_EAC_SNORM_BLOCK16, VK_FORMAT_EAC_R11G11_SNORM_BLOCK, CMP_FORMAT_Unknown, 16, 4, 4, 2, FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_UNSUPPORTED, gli::FORMAT_RGBA8_SNORM_PACK8 },
+
+		{ gli::FORMAT_RGBA_ASTC_4X4_UNORM_BLOCK16, VK_FORMAT_ASTC_4x4_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 4, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_4X4_SRGB_BLOCK16, VK_FORMAT_ASTC_4x4_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 4, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_5X4_UNORM_BLOCK16, VK_FORMAT_ASTC_5x4_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 5, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_5X4_SRGB_BLOCK16, VK_FORMAT_ASTC_5x4_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 5, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_5X5_UNORM_BLOCK16, VK_FORMAT_ASTC_5x5_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 5, 5, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_5X5_SRGB_BLOCK16, VK_FORMAT_ASTC_5x5_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 5, 5, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_6X5_UNORM_BLOCK16, VK_FORMAT_ASTC_6x5_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 6, 5, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_6X5_SRGB_BLOCK16, VK_FORMAT_ASTC_6x5_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 6, 5, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_6X6_UNORM_BLOCK16, VK_FORMAT_ASTC_6x6_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 6, 6, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_6X6_SRGB_BLOCK16, VK_FORMAT_ASTC_6x6_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 6, 6, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_8X5_UNORM_BLOCK16, VK_FORMAT_ASTC_8x5_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 8, 5, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_8X5_SRGB_BLOCK16, VK_FORMAT_ASTC_8x5_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 8, 5, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_8X6_UNORM_BLOCK16, VK_FORMAT_ASTC_8x6_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 8, 6, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_8X6_SRGB_BLOCK16, VK_FORMAT_ASTC_8x6_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 8, 6, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_8X8_UNORM_BLOCK16, VK_FORMAT_ASTC_8x8_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 8, 8, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_8X8_SRGB_BLOCK16, VK_FORMAT_ASTC_8x8_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 8, 8, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_10X5_UNORM_BLOCK16, VK_FORMAT_ASTC_10x5_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 10, 5, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_10X5_SRGB_BLOCK16, VK_FORMAT_ASTC_10x5_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 10, 5, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_10X6_UNORM_BLOCK16, VK_FORMAT_ASTC_10x6_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 10, 6, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_10X6_SRGB_BLOCK16, VK_FORMAT_ASTC_10x6_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 10, 6, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_10X8_UNORM_BLOCK16, VK_FORMAT_ASTC_10x8_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 10, 8, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_10X8_SRGB_BLOCK16, VK_FORMAT_ASTC_10x8_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 10, 8, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_10X10_UNORM_BLOCK16, VK_FORMAT_ASTC_10x10_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 10, 10, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_10X10_SRGB_BLOCK16, VK_FORMAT_ASTC_10x10_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 10, 10, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_12X10_UNORM_BLOCK16, VK_FORMAT_ASTC_12x10_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 12, 10, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_12X10_SRGB_BLOCK16, VK_FORMAT_ASTC_12x10_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 12, 10, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_12X12_UNORM_BLOCK16, VK_FORMAT_ASTC_12x12_UNORM_BLOCK, CMP_FORMAT_ASTC, 16, 12, 12, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ASTC_12X12_SRGB_BLOCK16, VK_FORMAT_ASTC_12x12_SRGB_BLOCK, CMP_FORMAT_ASTC, 16, 12, 12, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RGB_PVRTC1_8X8_UNORM_BLOCK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 32, 8, 8, 3, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGB_PVRTC1_8X8_SRGB_BLOCK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 32, 8, 8, 3, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGB_PVRTC1_16X8_UNORM_BLOCK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 32, 16, 8, 3, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGB_PVRTC1_16X8_SRGB_BLOCK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 32, 16, 8, 3, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_PVRTC1_8X8_UNORM_BLOCK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 32, 8, 8, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_PVRTC1_8X8_SRGB_BLOCK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 32, 8, 8, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_PVRTC1_16X8_UNORM_BLOCK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 32, 16, 8, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_PVRTC1_16X8_SRGB_BLOCK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 32, 16, 8, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_PVRTC2_4X4_UNORM_BLOCK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 8, 4, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_PVRTC2_4X4_SRGB_BLOCK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 8, 4, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+		{ gli::FORMAT_RGBA_PVRTC2_8X4_UNORM_BLOCK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 8, 8, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_PVRTC2_8X4_SRGB_BLOCK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 8, 8, 4, 4, FORMAT_FLAG_SRGB | FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RGB_ETC_UNORM_BLOCK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_ETC_RGB, 8, 4, 4, 3, FORMAT_FLAG_COMPRESSED | FORMAT_FLAG_CMP_SWIZZLE_SOURCE, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGB_ATC_UNORM_BLOCK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_ATC_RGB, 8, 4, 4, 3, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ATCA_UNORM_BLOCK16, VK_FORMAT_UNDEFINED, CMP_FORMAT_ATC_RGBA_Explicit, 16, 4, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_RGBA_ATCI_UNORM_BLOCK16, VK_FORMAT_UNDEFINED, CMP_FORMAT_ATC_RGBA_Interpolated, 16, 4, 4, 4, FORMAT_FLAG_COMPRESSED, gli::FORMAT_RGBA8_UNORM_PACK8 },
+
+		{ gli::FORMAT_L8_UNORM_PACK8, VK_FORMAT_R8_UNORM, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_A8_UNORM_PACK8, VK_FORMAT_R8_UNORM, CMP_FORMAT_Unknown, 1, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_LA8_UNORM_PACK8, VK_FORMAT_R8G8_UNORM, CMP_FORMAT_Unknown, 2, 1, 1, 2, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_L16_UNORM_PACK16, VK_FORMAT_R16_UNORM, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_A16_UNORM_PACK16, VK_FORMAT_R16_UNORM, CMP_FORMAT_Unknown, 2, 1, 1, 1, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+		{ gli::FORMAT_LA16_UNORM_PACK16, VK_FORMAT_R16G16_UNORM, CMP_FORMAT_Unknown, 4, 1, 1, 2, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_RGBA32_SFLOAT_PACK32 },
+
+		{ gli::FORMAT_BGR8_UNORM_PACK32, VK_FORMAT_B8G8R8_UNORM, CMP_FORMAT_Unknown, 4, 1, 1, 3, FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_UNORM_PACK8 },
+		{ gli::FORMAT_BGR8_SRGB_PACK32, VK_FORMAT_B8G8R8_SRGB, CMP_FORMAT_Unknown, 4, 1, 1, 3, FORMAT_FLAG_SRGB | FORMAT_FLAG_BGR, gli::FORMAT_RGBA8_SRGB_PACK8 },
+
+		{ gli::FORMAT_RG3B2_UNORM_PACK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 1, 1, 1, 3, 0, gli::FORMAT_RGBA8_UNORM_PACK8 },
+
+		{ gli::FORMAT_RA8_SRGB_PACK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 2, 1, 1, 2, FORMAT_FLAG_SRGB, gli::FORMAT_UNDEFINED },
+		{ gli::FORMAT_RA8_UNORM_PACK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 2, 1, 1, 2, 0, gli::FORMAT_UNDEFINED },
+		{ gli::FORMAT_AR8_SRGB_PACK8, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 2, 1, 1, 2, FORMAT_FLAG_SRGB | FORMAT_FLAG_GRAYSCALE, gli::FORMAT_UNDEFINED },
+		{ gli::FORMAT_RA16_UNORM_PACK16, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 2, FORMAT_FLAG_GRAYSCALE, gli::FORMAT_UNDEFINED },
+
+		{ gli::FORMAT_RGB8E8_UFLOAT_PACK32, VK_FORMAT_UNDEFINED, CMP_FORMAT_Unknown, 4, 1, 1, 3, 0, gli::FORMAT_UNDEFINED },
+	};
+
+	static_assert(std::size(s_formats) <= 256, "table indices are stored as uint8_t");
+
+	constexpr size_t getNumFormats()
+	{
+		size_t count = 0;
+		for (const auto& f : s_formats)
+			count = std::max(count, size_t(f.format) + 1);
+		return count;
+	}
+
+	constexpr size_t getRow(gli::format format)
+	{
+		for (size_t i = 0; i < std::size(s_formats); ++i)
+			if (s_formats[i].format == format) return i;
+		return 0;
+	}
+
+	// gli::format => row in s_formats
+	constexpr auto s_formatRows = []()
+	{
+		std::array<uint8_t, getNumFormats()> rows = {};
+		for (size_t i = 0; i < std::size(s_formats); ++i)
+			rows[size_t(s_formats[i].format)] = uint8_t(i);
+		return rows;
+	}();
+
+	// VkFormat => row in s_formats (core formats only, the extension formats have no gli counterpart)
+	constexpr auto s_vkRows = []()
+	{
+		std::array<uint8_t, size_t(VK_FORMAT_ASTC_12x12_SRGB_BLOCK) + 1> rows = {};
+		// backwards => the first row wins for aliases (L8, A8 => R8 etc.)
+		for (size_t i = std::size(s_formats); i-- > 1;)
+			if (s_formats[i].vkFormat != VK_FORMAT_UNDEFINED)
+				rows[size_t(s_formats[i].vkFormat)] = uint8_t(i);
+
+		// ktx2 bgra8 unorm/snorm are loaded without swizzle (see ktx2_save_image)
+		rows[VK_FORMAT_B8G8R8A8_UNORM] = uint8_t(getRow(gli::FORMAT_RGBA8_UNORM_PACK8));
+		rows[VK_FORMAT_B8G8R8A8_SNORM] = uint8_t(getRow(gli::FORMAT_RGBA8_SNORM_PACK8));
+		return rows;
+	}();
+
+	static_assert(s_formats[s_formatRows[gli::FORMAT_RGBA32_SFLOAT_PACK32]].format == gli::FORMAT_RGBA32_SFLOAT_PACK32, "invalid format lookup");
+	static_assert(s_formats[s_vkRows[VK_FORMAT_R8_UNORM]].format == gli::FORMAT_R8_UNORM_PACK8, "aliases must not replace the original format");
+}
+
+const FormatInfo& image::getFormatInfo(gli::format format)
+{
+	if (size_t(format) >= s_formatRows.size()) return s_formats[0];
+	return s_formats[s_formatRows[size_t(format)]];
+}
+
+gli::format image::getFormatFromVk(VkFormat format)
+{
+	if (size_t(format) >= s_vkRows.size()) return gli::FORMAT_UNDEFINED;
+	return s_formats[s_vkRows[size_t(format)]].format;
+}
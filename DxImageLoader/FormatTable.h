@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include "framework.h"
+#include "VkFormat.h"
+
+namespace image
+{
+	enum FormatFlags : uint16_t
+	{
+		FORMAT_FLAG_SRGB = 1 << 0,
+		FORMAT_FLAG_BGR = 1 << 1, // red and blue are swapped in memory
+		FORMAT_FLAG_GRAYSCALE = 1 << 2, // only the red channel is filled after loading (neither compressonator nor gli expand it)
+		FORMAT_FLAG_COMPRESSED = 1 << 3, // block compressed
+		// compressonator specific
+		FORMAT_FLAG_CMP_DXT1_ALPHA = 1 << 4, // bc1 with 1 bit alpha
+		FORMAT_FLAG_CMP_SWIZZLE = 1 << 5, // compressonator expects BGR
+		FORMAT_FLAG_CMP_SWIZZLE_SOURCE = 1 << 6, // compressonator expects BGR only when decompressing
+		FORMAT_FLAG_CMP_UNSUPPORTED = 1 << 7, // compressed format that compressonator cannot handle (EAC)
+	};
+
+	// static description of a gli format.
+	// All descriptions are stored in a single constexpr table (FormatTable.cpp) => lookups are array accesses
+	struct FormatInfo
+	{
+		gli::format format;
+		VkFormat vkFormat; // VK_FORMAT_UNDEFINED if there is no matching vulkan format (ktx2)
+		uint32_t cmpFormat; // CMP_FORMAT of compressonator. CMP_FORMAT_Unknown (0) if not handled by compressonator
+		uint8_t blockSize; // size of a block in bytes (block = single pixel for uncompressed formats)
+		uint8_t blockWidth;
+		uint8_t blockHeight;
+		uint8_t numChannels;
+		uint16_t flags; // FormatFlags
+		gli::format supported; // supported format (see isSupported) that is used for loading the format. FORMAT_UNDEFINED if the format cannot be loaded
+
+		bool hasFlag(FormatFlags flag) const { return (flags & flag) != 0; }
+	};
+
+	// returns the description of the format. Unknown formats return the description of FORMAT_UNDEFINED
+	const FormatInfo& getFormatInfo(gli::format format);
+
+	// returns the gli format that matches the vulkan format (FORMAT_UNDEFINED if there is none)
+	gli::format getFormatFromVk(VkFormat format);
+}
@@ -2,9 +2,9 @@
 #include "GliImage.h"
 #include "compress_interface.h"
 #include "interface.h"
+#include "FormatTable.h"
 #include <stdexcept>
-
-bool is_grayscale(gli::format f);
+#include <cstring>
 
 // mofified copy of gli convert
 template <typename texture_type>
@@ -74,7 +74,7 @@ inline texture_type convert_mod(texture_type const& Texture, gli::format Format)
 bool GliImageBase::requiresGrayscalePostprocess()
 {
 	// neither compressonator nor gli load grayscale correctly (only red channel filled)
-	return is_grayscale(getOriginalFormat());
+	return image::getFormatInfo(getOriginalFormat()).hasFlag(image::FORMAT_FLAG_GRAYSCALE);
 }
 
 bool GliImageBase::requiresBGRPostprocess()
@@ -87,36 +87,7 @@ bool GliImageBase::requiresBGRPostprocess()
 
 bool GliImageBase::is_bgr_format(gli::format f)
 {
-	switch (f)
-	{
-	case gli::format::FORMAT_BGRA4_UNORM_PACK16:
-	case gli::format::FORMAT_B5G6R5_UNORM_PACK16:
-	case gli::format::FORMAT_BGR5A1_UNORM_PACK16:
-	case gli::format::FORMAT_BGR8_UNORM_PACK8:
-	case gli::format::FORMAT_BGR8_SNORM_PACK8:
-	case gli::format::FORMAT_BGR8_USCALED_PACK8:
-	case gli::format::FORMAT_BGR8_SSCALED_PACK8:
-	case gli::format::FORMAT_BGR8_UINT_PACK8:
-	case gli::format::FORMAT_BGR8_SINT_PACK8:
-	case gli::format::FORMAT_BGR8_SRGB_PACK8:
-	case gli::format::FORMAT_BGRA8_UNORM_PACK8:
-	case gli::format::FORMAT_BGRA8_SNORM_PACK8:
-	case gli::format::FORMAT_BGRA8_USCALED_PACK8:
-	case gli::format::FORMAT_BGRA8_SSCALED_PACK8:
-	case gli::format::FORMAT_BGRA8_UINT_PACK8:
-	case gli::format::FORMAT_BGRA8_SINT_PACK8:
-	case gli::format::FORMAT_BGRA8_SRGB_PACK8:
-	case gli::format::FORMAT_BGR10A2_UNORM_PACK32:
-	case gli::format::FORMAT_BGR10A2_SNORM_PACK32:
-	case gli::format::FORMAT_BGR10A2_USCALED_PACK32:
-	case gli::format::FORMAT_BGR10A2_SSCALED_PACK32:
-	case gli::format::FORMAT_BGR10A2_UINT_PACK32:
-	case gli::format::FORMAT_BGR10A2_SINT_PACK32:
-	case gli::format::FORMAT_BGR8_UNORM_PACK32:
-	case gli::format::FORMAT_BGR8_SRGB_PACK32:
-		return true;
-	}
-	return false;
+	return image::getFormatInfo(f).hasFlag(image::FORMAT_FLAG_BGR);
 }
 
 GliImage::GliImage(const gli::texture& tex)
@@ -140,6 +111,26 @@ std::unique_ptr<GliImage> GliImage::convert(gli::format format, int quality)
 	}
 }
 
+std::unique_ptr<GliImage> GliImage::convert(image::IImage& image, gli::format format, int quality)
+{
+	if (auto gliImage = dynamic_cast<GliImage*>(&image))
+		return gliImage->convert(format, quality);
+
+	auto res = std::make_unique<GliImage>(image.getFormat(), image.getOriginalFormat(), image.getNumLayers(), 1, image.getNumMipmaps(),
+		image.getWidth(0), image.getHeight(0), image.getDepth(0));
+	for (uint32_t layer = 0; layer < image.getNumLayers(); ++layer)
+		for (uint32_t mip = 0; mip < image.getNumMipmaps(); ++mip)
+		{
+			size_t srcSize, dstSize;
+			const auto src = image.getData(layer, mip, srcSize);
+			const auto dst = res->getData(layer, mip, dstSize);
+			std::memcpy(dst, src, std::min(srcSize, dstSize));
+		}
+
+	if (format == res->getFormat()) return res;
+	return res->convert(format, quality);
+}
+
 void GliImage::saveKtx(const char* filename) const
 {
 	if (m_type == Cubes) gli::save_ktx(m_cube, filename);
@@ -206,49 +197,4 @@ gli::texture& GliImage::initTex(size_t nFaces, gli::extent3d size)
 	}
 	m_type = Planes;
 	return m_array;
-}
-
-bool is_grayscale(gli::format f)
-{
-	switch (f)
-	{
-	case gli::FORMAT_R8_UNORM_PACK8:  
-	case gli::FORMAT_R8_SNORM_PACK8:  
-	case gli::FORMAT_R8_USCALED_PACK8:  
-	case gli::FORMAT_R8_SSCALED_PACK8:  
-	case gli::FORMAT_R8_UINT_PACK8:  
-	case gli::FORMAT_R8_SINT_PACK8:  
-	case gli::FORMAT_R8_SRGB_PACK8:  
-	case gli::FORMAT_R16_UNORM_PACK16:  
-	case gli::FORMAT_R16_SNORM_PACK16:  
-	case gli::FORMAT_R16_USCALED_PACK16:  
-	case gli::FORMAT_R16_SSCALED_PACK16:  
-	case gli::FORMAT_R16_UINT_PACK16:  
-	case gli::FORMAT_R16_SINT_PACK16:  
-	case gli::FORMAT_R16_SFLOAT_PACK16:  
-	case gli::FORMAT_R32_UINT_PACK32:  
-	case gli::FORMAT_R32_SINT_PACK32:  
-	case gli::FORMAT_R32_SFLOAT_PACK32:  
-	case gli::FORMAT_R64_UINT_PACK64:  
-	case gli::FORMAT_R64_SINT_PACK64:  
-	case gli::FORMAT_R64_SFLOAT_PACK64:  
-	case gli::FORMAT_D16_UNORM_PACK16:  
-	case gli::FORMAT_D24_UNORM_PACK32:  
-	case gli::FORMAT_D32_SFLOAT_PACK32:  
-	case gli::FORMAT_S8_UINT_PACK8:  
-	case gli::FORMAT_R_ATI1N_UNORM_BLOCK8:  
-	case gli::FORMAT_R_ATI1N_SNORM_BLOCK8:  
-	case gli::FORMAT_R_EAC_UNORM_BLOCK8:  
-	case gli::FORMAT_R_EAC_SNORM_BLOCK8:  
-	case gli::FORMAT_L8_UNORM_PACK8:  
-	case gli::FORMAT_A8_UNORM_PACK8:
-	case gli::FORMAT_LA8_UNORM_PACK8:  
-	case gli::FORMAT_L16_UNORM_PACK16:  
-	case gli::FORMAT_A16_UNORM_PACK16:  
-	case gli::FORMAT_LA16_UNORM_PACK16:  
-	case gli::FORMAT_AR8_SRGB_PACK8:  
-	case gli::FORMAT_RA16_UNORM_PACK16:  
-		return true;
-	}
-	return false;
 }
\ No newline at end of file
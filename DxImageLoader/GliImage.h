@@ -53,6 +53,8 @@ public:
 	GliImage(const gli::texture& tex, gli::format original);
 
 	std::unique_ptr<GliImage> convert(gli::format format, int quality);
+	// converts images of any loader. Images of other loaders are copied into a GliImage first (the fps are not preserved)
+	static std::unique_ptr<GliImage> convert(image::IImage& image, gli::format format, int quality);
 	void saveKtx(const char* filename) const;
 	void saveDds(const char* filename) const;
 	void flip();
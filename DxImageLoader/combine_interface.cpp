@@ -0,0 +1,150 @@
+#include "pch.h"
+#include "combine_interface.h"
+#include "equation.h"
+#include "GliImage.h"
+#include "parallel.h"
+#include "ByteTable.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+	// transposes count pixels of an image row into the register
+	void loadPixels(const uint8_t* row, gli::format format, uint32_t count, equation::Registers::Register& dst)
+	{
+		if (format == gli::FORMAT_RGBA32_SFLOAT_PACK32)
+		{
+			const float* px = reinterpret_cast<const float*>(row);
+			for (uint32_t i = 0; i < count; ++i, px += 4)
+			{
+				dst.c[0][i] = px[0];
+				dst.c[1][i] = px[1];
+				dst.c[2][i] = px[2];
+				dst.c[3][i] = px[3];
+			}
+			return;
+		}
+
+		const image::ByteTable& table = image::getByteTable(format);
+		for (uint32_t i = 0; i < count; ++i, row += 4)
+		{
+			dst.c[0][i] = table.color[row[0]];
+			dst.c[1][i] = table.color[row[1]];
+			dst.c[2][i] = table.color[row[2]];
+			dst.c[3][i] = table.alpha[row[3]];
+		}
+	}
+}
+
+std::unique_ptr<image::IImage> combine_images(const std::string& colorFormula, const std::string& alphaFormula, const std::vector<std::shared_ptr<image::IImage>>& images)
+{
+	if (images.empty())
+		throw std::runtime_error("combine: at least one image is required");
+
+	// both formulas share one program (images are only loaded once)
+	equation::Program program;
+	const uint32_t colorReg = program.compile(*equation::parse(colorFormula));
+	const uint32_t alphaReg = program.compile(*equation::parse(alphaFormula));
+
+	for (const auto& load : program.getImageLoads())
+		if (load.image >= images.size())
+			throw std::runtime_error("Image I" + std::to_string(load.image) + " is not available");
+
+	const auto& first = *images[0];
+	for (const auto& img : images)
+	{
+		if (!image::isSupported(img->getFormat()))
+			throw std::runtime_error("combine: unsupported image format");
+		if (img->getNumLayers() != first.getNumLayers() || img->getNumMipmaps() != first.getNumMipmaps() ||
+			img->getWidth(0) != first.getWidth(0) || img->getHeight(0) != first.getHeight(0) || img->getDepth(0) != first.getDepth(0))
+			throw std::runtime_error("combine: all images must have the same dimensions");
+	}
+
+	const uint32_t numLayers = first.getNumLayers();
+	const uint32_t numMipmaps = first.getNumMipmaps();
+	const bool is3D = first.getDepth(0) > 1;
+
+	auto res = std::make_unique<GliImage>(gli::FORMAT_RGBA32_SFLOAT_PACK32, numLayers, numMipmaps, first.getWidth(0), first.getHeight(0), first.getDepth(0));
+
+	for (uint32_t mip = 0; mip < numMipmaps; ++mip)
+	{
+		const uint32_t width = first.getWidth(mip);
+		const uint32_t height = first.getHeight(mip);
+		const uint32_t depth = first.getDepth(mip);
+		const size_t rowsPerLayer = size_t(height) * depth;
+
+		// resolve data pointers upfront, getData does not need to be thread safe
+		const auto& loads = program.getImageLoads();
+		std::vector<const uint8_t*> srcData(loads.size() * numLayers);
+		std::vector<size_t> srcRowSize(loads.size());
+		for (size_t i = 0; i < loads.size(); ++i)
+		{
+			const auto& img = *images[loads[i].image];
+			srcRowSize[i] = width * image::pixelSize(img.getFormat());
+			for (uint32_t layer = 0; layer < numLayers; ++layer)
+			{
+				size_t size;
+				srcData[layer * loads.size() + i] = img.getData(layer, mip, size);
+			}
+		}
+		std::vector<float*> dstData(numLayers);
+		for (uint32_t layer = 0; layer < numLayers; ++layer)
+		{
+			size_t size;
+			dstData[layer] = reinterpret_cast<float*>(res->getData(layer, mip, size));
+		}
+
+		image::parallelRanges(rowsPerLayer * numLayers, [&](size_t begin, size_t end, size_t)
+		{
+			equation::Registers regs(program.getNumRegisters());
+			program.runConstants(regs);
+
+			equation::Tile tile;
+			tile.is3D = is3D;
+			tile.size[0] = float(width);
+			tile.size[1] = float(height);
+			// Texture2DArray::GetDimensions returns the number of layers as depth
+			tile.size[2] = float(is3D ? depth : numLayers);
+
+			for (size_t row = begin; row < end; ++row)
+			{
+				const uint32_t layer = uint32_t(row / rowsPerLayer);
+				const size_t layerRow = row % rowsPerLayer;
+				tile.y = uint32_t(layerRow % height);
+				tile.z = is3D ? uint32_t(layerRow / height) : layer;
+				tile.layer = layer;
+
+				float* dst = dstData[layer] + layerRow * width * 4;
+
+				for (uint32_t x = 0; x < width; x += uint32_t(equation::TileSize))
+				{
+					tile.x = x;
+					tile.count = std::min(width - x, uint32_t(equation::TileSize));
+
+					for (size_t i = 0; i < loads.size(); ++i)
+					{
+						const auto& img = *images[loads[i].image];
+						const uint8_t* src = srcData[layer * loads.size() + i] + layerRow * srcRowSize[i] + x * image::pixelSize(img.getFormat());
+						loadPixels(src, img.getFormat(), tile.count, regs[loads[i].dst]);
+					}
+
+					program.run(regs, tile);
+
+					const auto& color = regs[colorReg];
+					const auto& alpha = regs[alphaReg];
+					for (uint32_t i = 0; i < tile.count; ++i, dst += 4)
+					{
+						dst[0] = color.c[0][i];
+						dst[1] = color.c[1][i];
+						dst[2] = color.c[2][i];
+						dst[3] = alpha.c[3][i];
+					}
+				}
+			}
+		}, std::max<size_t>(16384 / std::max<size_t>(width, 1), 1));
+	}
+
+	return res;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "Image.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// evaluates the image combine formulas of ImageFramework on the cpu for all layers and mipmaps of the images.
+// colorFormula determines rgb, alphaFormula determines alpha. I0 refers to images[0], I1 to images[1] etc.
+// All images need the same dimensions. The result is a RGBA32 float image
+std::unique_ptr<image::IImage> combine_images(const std::string& colorFormula, const std::string& alphaFormula, const std::vector<std::shared_ptr<image::IImage>>& images);
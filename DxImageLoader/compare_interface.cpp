@@ -0,0 +1,580 @@
+#include "pch.h"
+#include "compare_interface.h"
+#include "GliImage.h"
+#include "parallel.h"
+#include "ByteTable.h"
+#include <xmmintrin.h>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+// mirrors SSIMModel and MultiscaleSSIMShader of ImageFramework on the cpu:
+// - both images are transformed to luma (TransformShader.TransformLuma)
+// - expected values, variances and the correlation are computed with an 11x11 gauss window (sigma = 1.5).
+//   Samples outside of the image are skipped and the remaining weights are renormalized (same as GaussShader)
+// - ssim = luminance * contrast * structure
+// - ms-ssim combines contrast and structure of the next 4 mipmaps with the weights of MultiscaleSSIMShader.
+//   The luminance is taken from the last scale. Higher scales are sampled bilinear (clamp to edge)
+
+namespace
+{
+	constexpr int s_gaussRadius = 5;
+	constexpr float s_gaussVariance = 1.5f * 1.5f;
+	constexpr size_t s_numTaps = 2 * s_gaussRadius + 1;
+
+	constexpr float C1 = 0.0001f; // assume dynamic range (L) of 1 => C1 = (K1*L) = (0.01 * 1)^1
+	constexpr float C2 = 0.0009f; // assume dynamic range (L) of 1 => C2 = (K2*L) = (0.03 * 1)^2
+	constexpr float C3 = C2 * 0.5f;
+
+	constexpr size_t s_maxScales = 5;
+	constexpr float s_scaleWeights[s_maxScales] = { 0.0448f, 0.2856f, 0.3001f, 0.2363f, 0.1333f };
+
+	// single channel float volume
+	struct Volume
+	{
+		Volume() = default;
+		Volume(size_t width, size_t height, size_t depth) :
+			width(width), height(height), depth(depth), data(width * height * depth)
+		{}
+
+		float* row(size_t y, size_t z) { return data.data() + (z * height + y) * width; }
+		const float* row(size_t y, size_t z) const { return data.data() + (z * height + y) * width; }
+		size_t numRows() const { return height * depth; }
+
+		size_t width = 0;
+		size_t height = 0;
+		size_t depth = 0;
+		std::vector<float> data;
+	};
+
+	size_t minRowsPerRange(size_t width)
+	{
+		return std::max<size_t>(16384 / std::max<size_t>(width, 1), 1);
+	}
+
+	// rows of one subresource of an image
+	class SubresourceRows
+	{
+	public:
+		SubresourceRows(const image::IImage& image, uint32_t layer, uint32_t mipmap) :
+			m_format(image.getFormat()),
+			m_table(image::getByteTable(image.getFormat())),
+			m_width(image.getWidth(mipmap)),
+			m_height(image.getHeight(mipmap)),
+			m_rowSize(m_width * image::pixelSize(image.getFormat()))
+		{
+			size_t size;
+			m_data = image.getData(layer, mipmap, size);
+		}
+
+		// writes premultiplied srgb colors (a * toSrgb(rgb)) of the row into dst (3 floats per pixel)
+		void load(size_t y, size_t z, float* dst) const
+		{
+			const uint8_t* src = m_data + (z * m_height + y) * m_rowSize;
+			if (m_format == gli::FORMAT_RGBA32_SFLOAT_PACK32)
+			{
+				const float* px = reinterpret_cast<const float*>(src);
+				for (size_t x = 0; x < m_width; ++x, px += 4, dst += 3)
+				{
+					dst[0] = px[3] * image::toSrgb(px[0]);
+					dst[1] = px[3] * image::toSrgb(px[1]);
+					dst[2] = px[3] * image::toSrgb(px[2]);
+				}
+			}
+			else
+			{
+				for (size_t x = 0; x < m_width; ++x, src += 4, dst += 3)
+				{
+					const float a = m_table.alpha[src[3]];
+					dst[0] = a * m_table.srgb[src[0]];
+					dst[1] = a * m_table.srgb[src[1]];
+					dst[2] = a * m_table.srgb[src[2]];
+				}
+			}
+		}
+
+		size_t width() const { return m_width; }
+
+	private:
+		gli::format m_format;
+		const image::ByteTable& m_table;
+		const uint8_t* m_data;
+		size_t m_width;
+		size_t m_height;
+		size_t m_rowSize;
+	};
+
+	// luma of the subresource (TransformShader.TransformLuma)
+	Volume loadLuma(const image::IImage& image, uint32_t layer, uint32_t mipmap)
+	{
+		const SubresourceRows rows(image, layer, mipmap);
+		Volume res(image.getWidth(mipmap), image.getHeight(mipmap), image.getDepth(mipmap));
+
+		image::parallelRanges(res.numRows(), [&](size_t begin, size_t end, size_t)
+		{
+			std::vector<float> color(res.width * 3);
+			for (size_t r = begin; r < end; ++r)
+			{
+				rows.load(r % res.height, r / res.height, color.data());
+				float* dst = res.data.data() + r * res.width;
+				for (size_t x = 0; x < res.width; ++x)
+					dst[x] = 0.299f * color[3 * x] + 0.587f * color[3 * x + 1] + 0.114f * color[3 * x + 2];
+			}
+		}, minRowsPerRange(res.width));
+
+		return res;
+	}
+
+	const std::array<float, s_numTaps>& getGaussWeights()
+	{
+		static const std::array<float, s_numTaps> s_weights = []()
+		{
+			std::array<float, s_numTaps> w;
+			for (int i = 0; i < int(s_numTaps); ++i)
+			{
+				const float offset = float(i - s_gaussRadius);
+				w[i] = std::exp(-0.5f * offset * offset / s_gaussVariance);
+			}
+			return w;
+		}();
+		return s_weights;
+	}
+
+	// gauss filter in x direction
+	void blurX(const Volume& src, Volume& dst)
+	{
+		const auto& w = getGaussWeights();
+		const int width = int(src.width);
+		float fullWeight = 0.0f;
+		for (auto v : w) fullWeight += v;
+		const __m128 invFullWeight = _mm_set1_ps(1.0f / fullWeight);
+
+		image::parallelRanges(src.numRows(), [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t r = begin; r < end; ++r)
+			{
+				const float* in = src.data.data() + r * src.width;
+				float* out = dst.data.data() + r * dst.width;
+
+				auto filterBorder = [&](int x)
+				{
+					float sum = 0.0f;
+					float weightSum = 0.0f;
+					for (int i = -s_gaussRadius; i <= s_gaussRadius; ++i)
+					{
+						const int pos = x + i;
+						if (pos < 0 || pos >= width) continue;
+						sum += w[i + s_gaussRadius] * in[pos];
+						weightSum += w[i + s_gaussRadius];
+					}
+					out[x] = sum / weightSum;
+				};
+
+				// interior pixels have all taps inside the row
+				const int interiorBegin = std::min(s_gaussRadius, width);
+				const int interiorEnd = std::max(width - s_gaussRadius, interiorBegin);
+
+				int x = 0;
+				for (; x < interiorBegin; ++x)
+					filterBorder(x);
+				for (; x + 4 <= interiorEnd; x += 4)
+				{
+					__m128 sum = _mm_setzero_ps();
+					for (int i = 0; i < int(s_numTaps); ++i)
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[i]), _mm_loadu_ps(in + x + i - s_gaussRadius)));
+					_mm_storeu_ps(out + x, _mm_mul_ps(sum, invFullWeight));
+				}
+				for (; x < width; ++x)
+					filterBorder(x);
+			}
+		}, minRowsPerRange(src.width));
+	}
+
+	// gauss filter in y (axis = 1) or z (axis = 2) direction. Complete rows are processed at once
+	void blurRows(const Volume& src, Volume& dst, int axis)
+	{
+		const auto& w = getGaussWeights();
+		const int axisSize = int(axis == 1 ? src.height : src.depth);
+		const size_t width = src.width;
+
+		image::parallelRanges(src.numRows(), [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t r = begin; r < end; ++r)
+			{
+				const int y = int(r % src.height);
+				const int z = int(r / src.height);
+				const int center = axis == 1 ? y : z;
+
+				const float* taps[s_numTaps];
+				float tapWeights[s_numTaps];
+				size_t numTaps = 0;
+				float weightSum = 0.0f;
+				for (int i = -s_gaussRadius; i <= s_gaussRadius; ++i)
+				{
+					const int pos = center + i;
+					if (pos < 0 || pos >= axisSize) continue;
+					taps[numTaps] = axis == 1 ? src.row(pos, z) : src.row(y, pos);
+					tapWeights[numTaps] = w[i + s_gaussRadius];
+					weightSum += tapWeights[numTaps];
+					++numTaps;
+				}
+				for (size_t i = 0; i < numTaps; ++i)
+					tapWeights[i] /= weightSum;
+
+				float* out = dst.row(y, z);
+				size_t x = 0;
+				for (; x + 4 <= width; x += 4)
+				{
+					__m128 sum = _mm_setzero_ps();
+					for (size_t i = 0; i < numTaps; ++i)
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tapWeights[i]), _mm_loadu_ps(taps[i] + x)));
+					_mm_storeu_ps(out + x, sum);
+				}
+				for (; x < width; ++x)
+				{
+					float sum = 0.0f;
+					for (size_t i = 0; i < numTaps; ++i)
+						sum += tapWeights[i] * taps[i][x];
+					out[x] = sum;
+				}
+			}
+		}, minRowsPerRange(width));
+	}
+
+	// separable gauss filter. tmp must have the same dimension as src
+	Volume blur(const Volume& src, Volume& tmp)
+	{
+		Volume res(src.width, src.height, src.depth);
+		blurX(src, tmp);
+		blurRows(tmp, res, 1);
+		if (src.depth > 1)
+		{
+			std::swap(tmp, res);
+			blurRows(tmp, res, 2);
+		}
+		return res;
+	}
+
+	// ssim components of one scale
+	struct Components
+	{
+		Volume luminance;
+		Volume contrast;
+		Volume structure;
+	};
+
+	Components computeComponents(const Volume& img1, const Volume& img2)
+	{
+		const size_t count = img1.data.size();
+		Volume tmp(img1.width, img1.height, img1.depth);
+
+		const Volume u1 = blur(img1, tmp);
+		const Volume u2 = blur(img2, tmp);
+
+		// the product volume is reused for x1*x1, x2*x2 and x1*x2
+		Volume product(img1.width, img1.height, img1.depth);
+		auto blurProduct = [&](const Volume& a, const Volume& b)
+		{
+			for (size_t i = 0; i < count; ++i)
+				product.data[i] = a.data[i] * b.data[i];
+			return blur(product, tmp);
+		};
+		const Volume s11 = blurProduct(img1, img1);
+		const Volume s22 = blurProduct(img2, img2);
+		const Volume s12 = blurProduct(img1, img2);
+
+		Components res;
+		res.luminance = Volume(img1.width, img1.height, img1.depth);
+		res.contrast = Volume(img1.width, img1.height, img1.depth);
+		res.structure = std::move(product);
+
+		image::parallelRanges(count, [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const float mu1 = u1.data[i];
+				const float mu2 = u2.data[i];
+				const float v1 = std::max(s11.data[i] - mu1 * mu1, 0.0f);
+				const float v2 = std::max(s22.data[i] - mu2 * mu2, 0.0f);
+				const float v12 = s12.data[i] - mu1 * mu2;
+				const float sd12 = std::sqrt(v1) * std::sqrt(v2);
+
+				res.luminance.data[i] = (2.0f * mu1 * mu2 + C1) / (mu1 * mu1 + mu2 * mu2 + C1);
+				res.contrast.data[i] = (2.0f * sd12 + C2) / (v1 + v2 + C2);
+				res.structure.data[i] = (v12 + C3) / (sd12 + C3);
+			}
+		}, 16384);
+
+		return res;
+	}
+
+	// precomputed bilinear sample positions for one axis (clamp to edge)
+	struct LinearAxis
+	{
+		LinearAxis(size_t dstSize, size_t srcSize) :
+			i0(dstSize), i1(dstSize), f(dstSize)
+		{
+			const float maxIndex = float(srcSize - 1);
+			for (size_t i = 0; i < dstSize; ++i)
+			{
+				const float pos = std::min(std::max((float(i) + 0.5f) / float(dstSize) * float(srcSize) - 0.5f, 0.0f), maxIndex);
+				i0[i] = size_t(pos);
+				i1[i] = std::min(i0[i] + 1, srcSize - 1);
+				f[i] = pos - float(i0[i]);
+			}
+		}
+
+		std::vector<size_t> i0;
+		std::vector<size_t> i1;
+		std::vector<float> f;
+	};
+
+	// resamples src to the dimension of dst with a linear filter (same as a gpu texture fetch with MinMagMipLinear)
+	struct LinearSampler
+	{
+		LinearSampler(const Volume& src, size_t width, size_t height, size_t depth) :
+			src(src), x(width, src.width), y(height, src.height), z(depth, src.depth)
+		{}
+
+		float sample(size_t px, size_t py, size_t pz) const
+		{
+			auto sampleRow = [&](const float* row)
+			{
+				return row[x.i0[px]] + x.f[px] * (row[x.i1[px]] - row[x.i0[px]]);
+			};
+			auto samplePlane = [&](size_t sz)
+			{
+				const float top = sampleRow(src.row(y.i0[py], sz));
+				const float bottom = sampleRow(src.row(y.i1[py], sz));
+				return top + y.f[py] * (bottom - top);
+			};
+			const float front = samplePlane(z.i0[pz]);
+			if (z.f[pz] == 0.0f) return front;
+			return front + z.f[pz] * (samplePlane(z.i1[pz]) - front);
+		}
+
+		const Volume& src;
+		LinearAxis x;
+		LinearAxis y;
+		LinearAxis z;
+	};
+
+	float getInvWeightSum(size_t numMipmaps)
+	{
+		switch (numMipmaps)
+		{
+		case 1: return 1.0f / 0.0448f;
+		case 2: return 1.0f / 0.3304f;
+		case 3: return 1.0f / 0.6305f;
+		case 4: return 1.0f / 0.8668f;
+		default: return 1.0f;
+		}
+	}
+
+	// per pixel ssim of one layer
+	Volume computeSSIM(const image::IImage& image1, const image::IImage& image2, uint32_t layer, uint32_t mipmap, size_t numScales, size_t numMipmaps)
+	{
+		std::vector<Components> scales;
+		scales.reserve(numScales);
+		for (size_t s = 0; s < numScales; ++s)
+		{
+			const uint32_t mip = mipmap + uint32_t(s);
+			scales.push_back(computeComponents(loadLuma(image1, layer, mip), loadLuma(image2, layer, mip)));
+		}
+
+		auto& base = scales[0];
+		Volume& res = base.luminance;
+
+		if (numScales == 1)
+		{
+			for (size_t i = 0; i < res.data.size(); ++i)
+				res.data[i] *= base.contrast.data[i] * base.structure.data[i];
+			return std::move(res);
+		}
+
+		// weights of the other scales (see MultiscaleSSIMShader.RunWeighted)
+		const float invWeightSum = getInvWeightSum(numMipmaps);
+		std::vector<LinearSampler> contrast;
+		std::vector<LinearSampler> structure;
+		for (size_t s = 1; s < numScales; ++s)
+		{
+			contrast.emplace_back(scales[s].contrast, res.width, res.height, res.depth);
+			structure.emplace_back(scales[s].structure, res.width, res.height, res.depth);
+		}
+		const LinearSampler luminance(scales.back().luminance, res.width, res.height, res.depth);
+
+		auto weighted = [&](float primary, const std::vector<LinearSampler>& others, size_t x, size_t y, size_t z)
+		{
+			// keep sign of the primary scale (important for structure)
+			const float sign = primary < 0.0f ? -1.0f : 1.0f;
+			float value = std::pow(std::abs(primary), s_scaleWeights[0] * invWeightSum);
+			for (size_t s = 0; s < others.size(); ++s)
+				value *= std::pow(std::abs(others[s].sample(x, y, z)), s_scaleWeights[s + 1] * invWeightSum);
+			return sign * value;
+		};
+
+		image::parallelRanges(res.numRows(), [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t r = begin; r < end; ++r)
+			{
+				const size_t y = r % res.height;
+				const size_t z = r / res.height;
+				float* out = res.row(y, z);
+				const float* cont = base.contrast.row(y, z);
+				const float* struc = base.structure.row(y, z);
+				for (size_t x = 0; x < res.width; ++x)
+				{
+					out[x] = luminance.sample(x, y, z) *
+						weighted(cont[x], contrast, x, y, z) *
+						weighted(struc[x], structure, x, y, z);
+				}
+			}
+		}, minRowsPerRange(res.width));
+
+		return std::move(res);
+	}
+
+	// per pixel squared error (averaged over rgb) of one layer
+	Volume computeSquaredError(const image::IImage& image1, const image::IImage& image2, uint32_t layer, uint32_t mipmap)
+	{
+		const SubresourceRows rows1(image1, layer, mipmap);
+		const SubresourceRows rows2(image2, layer, mipmap);
+		Volume res(image1.getWidth(mipmap), image1.getHeight(mipmap), image1.getDepth(mipmap));
+
+		image::parallelRanges(res.numRows(), [&](size_t begin, size_t end, size_t)
+		{
+			std::vector<float> color1(res.width * 3);
+			std::vector<float> color2(res.width * 3);
+			for (size_t r = begin; r < end; ++r)
+			{
+				rows1.load(r % res.height, r / res.height, color1.data());
+				rows2.load(r % res.height, r / res.height, color2.data());
+				float* dst = res.data.data() + r * res.width;
+				for (size_t x = 0; x < res.width; ++x)
+				{
+					const float dr = color1[3 * x] - color2[3 * x];
+					const float dg = color1[3 * x + 1] - color2[3 * x + 1];
+					const float db = color1[3 * x + 2] - color2[3 * x + 2];
+					dst[x] = (dr * dr + dg * dg + db * db) * (1.0f / 3.0f);
+				}
+			}
+		}, minRowsPerRange(res.width));
+
+		return res;
+	}
+
+	// region that is used for the average (see StatisticsShader.AdjustDim)
+	struct Region
+	{
+		Region(size_t size, size_t offset, bool adjust)
+		{
+			if (!adjust)
+			{
+				begin = 0;
+				end = size;
+				return;
+			}
+			const size_t count = size > 2 * offset ? size - 2 * offset : 1;
+			begin = count == 1 ? size / 2 : offset;
+			end = begin + count;
+		}
+
+		size_t count() const { return end - begin; }
+
+		size_t begin;
+		size_t end;
+	};
+
+	double sumRegion(const Volume& v, const Region& rx, const Region& ry, const Region& rz)
+	{
+		std::vector<double> sums(image::getNumThreads(), 0.0);
+		image::parallelRanges(ry.count() * rz.count(), [&](size_t begin, size_t end, size_t rangeIndex)
+		{
+			double sum = 0.0;
+			for (size_t r = begin; r < end; ++r)
+			{
+				const float* row = v.row(ry.begin + r % ry.count(), rz.begin + r / ry.count());
+				float rowSum = 0.0f;
+				for (size_t x = rx.begin; x < rx.end; ++x)
+					rowSum += row[x];
+				sum += rowSum;
+			}
+			sums[rangeIndex] = sum;
+		}, minRowsPerRange(rx.count()));
+
+		double sum = 0.0;
+		for (auto s : sums) sum += s;
+		return sum;
+	}
+}
+
+float compare_images(const image::IImage& image1, const image::IImage& image2, int layer, uint32_t mipmap, uint32_t metric, bool excludeBorders, std::unique_ptr<image::IImage>* errorMap)
+{
+	if (!image::isSupported(image1.getFormat()) || !image::isSupported(image2.getFormat()))
+		throw std::runtime_error("compare: unsupported image format");
+	if (metric > IMAGE_COMPARE_MSSSIM)
+		throw std::runtime_error("compare: unknown metric");
+	if (mipmap >= image1.getNumMipmaps() || mipmap >= image2.getNumMipmaps())
+		throw std::runtime_error("compare: invalid mipmap");
+	if (image1.getNumLayers() != image2.getNumLayers())
+		throw std::runtime_error("compare: images have a different number of layers");
+	if (layer >= int(image1.getNumLayers()) || layer < -1)
+		throw std::runtime_error("compare: invalid layer");
+	if (image1.getWidth(mipmap) != image2.getWidth(mipmap) || image1.getHeight(mipmap) != image2.getHeight(mipmap) ||
+		image1.getDepth(mipmap) != image2.getDepth(mipmap))
+		throw std::runtime_error("compare: images have different dimensions");
+
+	const uint32_t firstLayer = layer < 0 ? 0 : uint32_t(layer);
+	const uint32_t numLayers = layer < 0 ? image1.getNumLayers() : 1;
+	const size_t width = image1.getWidth(mipmap);
+	const size_t height = image1.getHeight(mipmap);
+	const size_t depth = image1.getDepth(mipmap);
+
+	const bool isSSIM = metric == IMAGE_COMPARE_SSIM || metric == IMAGE_COMPARE_MSSSIM;
+	const size_t numMipmaps = std::min(image1.getNumMipmaps(), image2.getNumMipmaps()) - mipmap;
+	const size_t numScales = metric == IMAGE_COMPARE_MSSSIM ? std::min(numMipmaps, s_maxScales) : 1;
+
+	// don't get values from blur borders
+	const size_t borderOffset = isSSIM && excludeBorders ? s_gaussRadius : 0;
+	const Region rx(width, borderOffset, borderOffset != 0);
+	const Region ry(height, borderOffset, borderOffset != 0);
+	const Region rz(depth, borderOffset, borderOffset != 0 && depth > 1);
+
+	std::unique_ptr<GliImage> map;
+	if (errorMap)
+		map = std::make_unique<GliImage>(gli::FORMAT_RGBA32_SFLOAT_PACK32, numLayers, 1, width, height, depth);
+
+	double sum = 0.0;
+	for (uint32_t i = 0; i < numLayers; ++i)
+	{
+		const Volume v = isSSIM
+			? computeSSIM(image1, image2, firstLayer + i, mipmap, numScales, numMipmaps)
+			: computeSquaredError(image1, image2, firstLayer + i, mipmap);
+
+		sum += sumRegion(v, rx, ry, rz);
+
+		if (map)
+		{
+			size_t size;
+			float* dst = reinterpret_cast<float*>(map->getData(i, 0, size));
+			image::parallelFor(v.data.size(), [&](size_t p)
+			{
+				dst[4 * p] = dst[4 * p + 1] = dst[4 * p + 2] = v.data[p];
+				dst[4 * p + 3] = 1.0f;
+			}, 16384);
+		}
+	}
+
+	const double numElements = double(rx.count() * ry.count() * rz.count() * numLayers);
+	const double avg = sum / numElements;
+
+	if (errorMap) *errorMap = std::move(map);
+
+	if (metric == IMAGE_COMPARE_PSNR)
+	{
+		if (avg <= 0.0) return std::numeric_limits<float>::infinity();
+		return float(10.0 * std::log10(1.0 / avg));
+	}
+	return float(avg);
+}
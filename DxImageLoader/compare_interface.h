@@ -0,0 +1,8 @@
+#pragma once
+#include "Image.h"
+#include "interface.h"
+#include <memory>
+
+// compares layer (-1 = all layers) and mipmap of both images with the given metric (see ImageCompareMetric).
+// if errorMap is not null, it receives a RGBA32 float image with the per pixel squared error (mse, psnr) or similarity (ssim, ms-ssim)
+float compare_images(const image::IImage& image1, const image::IImage& image2, int layer, uint32_t mipmap, uint32_t metric, bool excludeBorders, std::unique_ptr<image::IImage>* errorMap);
@@ -5,6 +5,7 @@
 #include <thread>
 #include <stdexcept>
 #include "interface.h"
+#include "FormatTable.h"
 #include <algorithm>
 
 struct ExFormatInfo
@@ -50,179 +51,31 @@ bool cmp_feedback_proc(float fProgress, CMP_DWORD_PTR pUser1, CMP_DWORD_PTR pUse
 }
 
 CMP_FORMAT get_cmp_format(gli::format format, ExFormatInfo& exInfo, bool isSource)
-{ 
-	switch (format) { 
-		// formats used by the exporter
-	case gli::format::FORMAT_RGBA8_SRGB_PACK8:
-	case gli::format::FORMAT_RGBA8_UNORM_PACK8:
-		exInfo.isCompressed = false;
-		exInfo.widthMultiplier = 4;
-		return CMP_FORMAT_RGBA_8888;
-	
-	case gli::format::FORMAT_RGBA8_SNORM_PACK8:
-		exInfo.isCompressed = false;
-		exInfo.widthMultiplier = 4;
-		return CMP_FORMAT_RGBA_8888_S;
+{
+	const auto& info = image::getFormatInfo(format);
+	if (info.hasFlag(image::FORMAT_FLAG_CMP_UNSUPPORTED))
+		throw std::runtime_error("EAC formats are not supported");
 
-	case gli::format::FORMAT_RGBA32_SFLOAT_PACK32:
+	const auto cmpFormat = CMP_FORMAT(info.cmpFormat);
+	if (cmpFormat == CMP_FORMAT_Unknown)
+	{
 		exInfo.isCompressed = false;
-		exInfo.widthMultiplier = 16;
-		return CMP_FORMAT_RGBA_32F; // not supported by converter
-
-		// compressed formats
-	case gli::format::FORMAT_RGBA_ASTC_10X10_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_10X10_UNORM_BLOCK16:
-		exInfo.bx = 10;
-		exInfo.by = 10;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_10X5_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_10X5_UNORM_BLOCK16:
-		exInfo.bx = 10;
-		exInfo.by = 5;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_10X6_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_10X6_UNORM_BLOCK16:
-		exInfo.bx = 10;
-		exInfo.by = 6;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_10X8_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_10X8_UNORM_BLOCK16:
-		exInfo.bx = 10;
-		exInfo.by = 8;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_12X10_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_12X10_UNORM_BLOCK16:
-		exInfo.bx = 12;
-		exInfo.by = 10;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_12X12_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_12X12_UNORM_BLOCK16:
-		exInfo.bx = 12;
-		exInfo.by = 12;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_4X4_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_4X4_UNORM_BLOCK16:
-		exInfo.bx = 4;
-		exInfo.by = 4;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_5X4_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_5X4_UNORM_BLOCK16:
-		exInfo.bx = 5;
-		exInfo.by = 4;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_5X5_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_5X5_UNORM_BLOCK16:
-		exInfo.bx = 5;
-		exInfo.by = 5;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_6X5_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_6X5_UNORM_BLOCK16:
-		exInfo.bx = 6;
-		exInfo.by = 5;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_6X6_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_6X6_UNORM_BLOCK16:
-		exInfo.bx = 6;
-		exInfo.by = 6;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_8X5_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_8X5_UNORM_BLOCK16:
-		exInfo.bx = 8;
-		exInfo.by = 5;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_8X6_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_8X6_UNORM_BLOCK16:
-		exInfo.bx = 8;
-		exInfo.by = 6;
-		return CMP_FORMAT_ASTC;
-	case gli::format::FORMAT_RGBA_ASTC_8X8_SRGB_BLOCK16:
-	case gli::format::FORMAT_RGBA_ASTC_8X8_UNORM_BLOCK16:
-		exInfo.bx = 8;
-		exInfo.by = 8;
-		return CMP_FORMAT_ASTC;
-
-	case gli::format::FORMAT_RGB_DXT1_UNORM_BLOCK8: // BC 1
-	case gli::format::FORMAT_RGB_DXT1_SRGB_BLOCK8:
-		return CMP_FORMAT_DXT1;
-
-	case gli::format::FORMAT_RGBA_DXT1_UNORM_BLOCK8: // BC 1
-	case gli::format::FORMAT_RGBA_DXT1_SRGB_BLOCK8:
-		exInfo.useDxt1Alpha = true;
-		return CMP_FORMAT_DXT1;
-
-	case gli::format::FORMAT_RGBA_DXT3_SRGB_BLOCK16: // BC 2
-	case gli::format::FORMAT_RGBA_DXT3_UNORM_BLOCK16:
-		return CMP_FORMAT_DXT3;
-
-	case gli::format::FORMAT_RGBA_DXT5_SRGB_BLOCK16: // BC 3
-	case gli::format::FORMAT_RGBA_DXT5_UNORM_BLOCK16:
-		return CMP_FORMAT_DXT5;
-
-	case gli::format::FORMAT_R_ATI1N_UNORM_BLOCK8: // BC 4
-		//if (isSource) exInfo.overwriteAlpha = 255;
-		return CMP_FORMAT_BC4;
-	case gli::format::FORMAT_R_ATI1N_SNORM_BLOCK8:
-		//if (isSource) exInfo.overwriteAlpha = 127;
-		return CMP_FORMAT_BC4_S;
-
-	case gli::format::FORMAT_RG_ATI2N_UNORM_BLOCK16: // BC 5
-		//if (isSource) exInfo.overwriteAlpha = 255;
-		return CMP_FORMAT_BC5;
-	case gli::format::FORMAT_RG_ATI2N_SNORM_BLOCK16:
-		//if (isSource) exInfo.overwriteAlpha = 127; // signed 1
-		return CMP_FORMAT_BC5_S;
-
-	case gli::format::FORMAT_RGB_BP_UFLOAT_BLOCK16: // BC 6
-		return CMP_FORMAT_BC6H;
-
-	case gli::format::FORMAT_RGB_BP_SFLOAT_BLOCK16: // BC 6
-		return CMP_FORMAT_BC6H_SF;
-
-	case gli::format::FORMAT_RGBA_BP_UNORM_BLOCK16: // BC 7
-	case gli::format::FORMAT_RGBA_BP_SRGB_BLOCK16:
-		return CMP_FORMAT_BC7;
-
-	case gli::format::FORMAT_RGB_ATC_UNORM_BLOCK8:
-		return CMP_FORMAT_ATC_RGB;
-	case gli::format::FORMAT_RGBA_ATCI_UNORM_BLOCK16:
-		return CMP_FORMAT_ATC_RGBA_Interpolated;
-	case gli::format::FORMAT_RGBA_ATCA_UNORM_BLOCK16:
-		return CMP_FORMAT_ATC_RGBA_Explicit;
-
-	case gli::format::FORMAT_RGB_ETC_UNORM_BLOCK8:
-		if (isSource) exInfo.swizzleRGB = true;
-		return CMP_FORMAT_ETC_RGB;
-
-	case gli::format::FORMAT_RGB_ETC2_SRGB_BLOCK8:
-		exInfo.swizzleRGB = true;
-		return CMP_FORMAT_ETC2_SRGB;
-	case gli::format::FORMAT_RGB_ETC2_UNORM_BLOCK8:
-		exInfo.swizzleRGB = true;
-		return CMP_FORMAT_ETC2_RGB;
-	case gli::format::FORMAT_RGBA_ETC2_SRGB_BLOCK8:
-		if (isSource) exInfo.swizzleRGB = true;
-		return CMP_FORMAT_ETC2_SRGBA1;
-	case gli::format::FORMAT_RGBA_ETC2_UNORM_BLOCK8:
-		if (isSource) exInfo.swizzleRGB = true;
-		return CMP_FORMAT_ETC2_RGBA1;
-
-	case gli::format::FORMAT_RGBA_ETC2_SRGB_BLOCK16:
-		if (isSource) exInfo.swizzleRGB = true;
-		return CMP_FORMAT_ETC2_SRGBA;
-	case gli::format::FORMAT_RGBA_ETC2_UNORM_BLOCK16:
-		if (isSource) exInfo.swizzleRGB = true;
-		return CMP_FORMAT_ETC2_RGBA;
-		
+		return CMP_FORMAT_Unknown;
+	}
 
-	case gli::format::FORMAT_R_EAC_UNORM_BLOCK8:
-	case gli::format::FORMAT_R_EAC_SNORM_BLOCK8:
-	case gli::format::FORMAT_RG_EAC_UNORM_BLOCK16:
-	case gli::format::FORMAT_RG_EAC_SNORM_BLOCK16:
-		throw std::runtime_error("EAC formats are not supported");
+	if (!info.hasFlag(image::FORMAT_FLAG_COMPRESSED))
+	{
+		// formats used by the exporter
+		exInfo.isCompressed = false;
+		exInfo.widthMultiplier = info.blockSize;
+		return cmpFormat;
 	}
 
-	exInfo.isCompressed = false;
-	return CMP_FORMAT_Unknown;
+	exInfo.bx = info.blockWidth;
+	exInfo.by = info.blockHeight;
+	exInfo.useDxt1Alpha = info.hasFlag(image::FORMAT_FLAG_CMP_DXT1_ALPHA);
+	exInfo.swizzleRGB = info.hasFlag(image::FORMAT_FLAG_CMP_SWIZZLE) || (isSource && info.hasFlag(image::FORMAT_FLAG_CMP_SWIZZLE_SOURCE));
+	return cmpFormat;
 }
 
 // exchanges R and B channels
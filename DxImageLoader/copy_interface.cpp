@@ -0,0 +1,180 @@
+#include "pch.h"
+#include "copy_interface.h"
+#include "interface.h"
+#include "parallel.h"
+#include "ByteTable.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	uint8_t toByte(float c)
+	{
+		if (!(c > 0.0f)) return 0; // includes NaN
+		if (c >= 1.0f) return 255;
+		return uint8_t(c * 255.0f + 0.5f);
+	}
+
+	bool isBgr(gli::format format)
+	{
+		return format == gli::FORMAT_BGRA8_UNORM_PACK8 || format == gli::FORMAT_BGRA8_SRGB_PACK8;
+	}
+
+	// 8 bit formats with the same color space (only the channel order differs)
+	bool isSwizzle(gli::format src, gli::format dst)
+	{
+		if (!isBgr(dst)) return false;
+		if (src == gli::FORMAT_RGBA8_UNORM_PACK8) return dst == gli::FORMAT_BGRA8_UNORM_PACK8;
+		if (src == gli::FORMAT_RGBA8_SRGB_PACK8) return dst == gli::FORMAT_BGRA8_SRGB_PACK8;
+		return false;
+	}
+
+	size_t getDstPixelSize(gli::format format)
+	{
+		switch (format)
+		{
+		case gli::FORMAT_RGBA32_SFLOAT_PACK32: return 16;
+		case gli::FORMAT_RGBA16_SFLOAT_PACK16: return 8;
+		case gli::FORMAT_RGBA8_UNORM_PACK8:
+		case gli::FORMAT_RGBA8_SRGB_PACK8:
+		case gli::FORMAT_BGRA8_UNORM_PACK8:
+		case gli::FORMAT_BGRA8_SRGB_PACK8:
+			return 4;
+		}
+		throw std::runtime_error("copy: unsupported destination format");
+	}
+
+	// converts count pixels of a supported 8 bit format into linear RGBA32 floats
+	void decodeRow(const uint8_t* src, gli::format format, size_t count, float* dst)
+	{
+		const image::ByteTable& table = image::getByteTable(format);
+		for (const auto end = dst + count * 4; dst != end; dst += 4, src += 4)
+		{
+			dst[0] = table.color[src[0]];
+			dst[1] = table.color[src[1]];
+			dst[2] = table.color[src[2]];
+			dst[3] = table.alpha[src[3]];
+		}
+	}
+
+	// converts count linear RGBA32 float pixels into the destination format
+	void encodeRow(const float* src, gli::format format, size_t count, uint8_t* dst)
+	{
+		switch (format)
+		{
+		case gli::FORMAT_RGBA32_SFLOAT_PACK32:
+			std::memcpy(dst, src, count * 16);
+			return;
+		case gli::FORMAT_RGBA16_SFLOAT_PACK16:
+			for (size_t i = 0; i < count; ++i, src += 4, dst += 8)
+			{
+				// the destination might not be 8 byte aligned
+				const uint64_t packed = glm::packHalf4x16(glm::vec4(src[0], src[1], src[2], src[3]));
+				std::memcpy(dst, &packed, sizeof(packed));
+			}
+			return;
+		}
+
+		const bool srgb = gli::is_srgb(format);
+		const int r = isBgr(format) ? 2 : 0;
+		for (size_t i = 0; i < count; ++i, src += 4, dst += 4)
+		{
+			if (srgb)
+			{
+				dst[r] = toByte(image::toSrgb(src[0]));
+				dst[1] = toByte(image::toSrgb(src[1]));
+				dst[2 - r] = toByte(image::toSrgb(src[2]));
+			}
+			else
+			{
+				dst[r] = toByte(src[0]);
+				dst[1] = toByte(src[1]);
+				dst[2 - r] = toByte(src[2]);
+			}
+			dst[3] = toByte(src[3]);
+		}
+	}
+}
+
+void copy_subresource(const image::IImage& image, uint32_t layer, uint32_t mipmap, uint8_t* dst, size_t dstRowPitch, size_t dstSlicePitch, gli::format dstFormat, uint32_t flags)
+{
+	if (layer >= image.getNumLayers())
+		throw std::runtime_error("copy: invalid layer");
+	if (mipmap >= image.getNumMipmaps())
+		throw std::runtime_error("copy: invalid mipmap");
+	if (!dst)
+		throw std::runtime_error("copy: invalid destination");
+
+	const gli::format srcFormat = image.getFormat();
+	if (!image::isSupported(srcFormat))
+		throw std::runtime_error("copy: unsupported image format");
+	const bool identity = dstFormat == srcFormat;
+
+	const size_t width = image.getWidth(mipmap);
+	const size_t height = image.getHeight(mipmap);
+	const size_t depth = image.getDepth(mipmap);
+	const size_t srcRowSize = width * image::pixelSize(srcFormat);
+	const size_t dstRowSize = width * (identity ? image::pixelSize(srcFormat) : getDstPixelSize(dstFormat));
+
+	if (!dstRowPitch) dstRowPitch = dstRowSize;
+	if (!dstSlicePitch) dstSlicePitch = dstRowPitch * height;
+	if (dstRowPitch < dstRowSize)
+		throw std::runtime_error("copy: row pitch is smaller than a row");
+	if (dstSlicePitch < dstRowPitch * (height - 1) + dstRowSize)
+		throw std::runtime_error("copy: slice pitch is smaller than a slice");
+
+	size_t srcSize;
+	const uint8_t* src = image.getData(layer, mipmap, srcSize);
+	if (srcSize < srcRowSize * height * depth)
+		throw std::runtime_error("copy: unexpected mipmap size");
+
+	const bool flip = (flags & IMAGE_COPY_FLIP_Y) != 0;
+	const bool swizzle = isSwizzle(srcFormat, dstFormat);
+	const bool srcFloat = srcFormat == gli::FORMAT_RGBA32_SFLOAT_PACK32;
+	// ranges should be large enough to be worth a thread
+	const size_t minRows = std::max<size_t>(size_t(1 << 16) / std::max<size_t>(srcRowSize, 1), 1);
+
+	image::parallelRanges(height * depth, [&](size_t begin, size_t end, size_t)
+	{
+		std::vector<float> tmp;
+		if (!identity && !swizzle && !srcFloat)
+			tmp.resize(width * 4);
+
+		for (size_t row = begin; row != end; ++row)
+		{
+			const size_t z = row / height;
+			const size_t y = flip ? height - 1 - row % height : row % height;
+			const uint8_t* srcRow = src + row * srcRowSize;
+			uint8_t* dstRow = dst + z * dstSlicePitch + y * dstRowPitch;
+
+			if (identity)
+			{
+				std::memcpy(dstRow, srcRow, srcRowSize);
+			}
+			else if (swizzle)
+			{
+				for (size_t x = 0; x < width; ++x, srcRow += 4, dstRow += 4)
+				{
+					dstRow[0] = srcRow[2];
+					dstRow[1] = srcRow[1];
+					dstRow[2] = srcRow[0];
+					dstRow[3] = srcRow[3];
+				}
+			}
+			else if (srcFloat)
+			{
+				encodeRow(reinterpret_cast<const float*>(srcRow), dstFormat, width, dstRow);
+			}
+			else
+			{
+				decodeRow(srcRow, srcFormat, width, tmp.data());
+				encodeRow(tmp.data(), dstFormat, width, dstRow);
+			}
+		}
+	}, minRows);
+}
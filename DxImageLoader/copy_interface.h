@@ -0,0 +1,6 @@
+#pragma once
+#include "Image.h"
+
+// copies the mipmap of one layer into dst (see image_copy_to). Rows are converted on multiple threads in a single pass.
+// dstFormat must be the format of the image or one of the destination formats of image_copy_to
+void copy_subresource(const image::IImage& image, uint32_t layer, uint32_t mipmap, uint8_t* dst, size_t dstRowPitch, size_t dstSlicePitch, gli::format dstFormat, uint32_t flags);
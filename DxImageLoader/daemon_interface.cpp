@@ -0,0 +1,510 @@
+#include "pch.h"
+#include "daemon_interface.h"
+#include "interface.h"
+#include "GliImage.h"
+#include "parallel.h"
+#include <winsock2.h>
+#include <afunix.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	using ImageFuture = std::shared_future<std::shared_ptr<image::IImage>>;
+
+	// splits the request into arguments. Quoted arguments may contain spaces
+	std::vector<std::string> splitArguments(const std::string& line)
+	{
+		std::vector<std::string> args;
+		size_t i = 0;
+		while (i < line.size())
+		{
+			if (isspace(uint8_t(line[i])))
+			{
+				++i;
+				continue;
+			}
+
+			size_t end;
+			if (line[i] == '"')
+			{
+				end = line.find('"', i + 1);
+				if (end == std::string::npos)
+					throw std::runtime_error("missing closing quote");
+				args.push_back(line.substr(i + 1, end - i - 1));
+				++end;
+			}
+			else
+			{
+				end = i;
+				while (end < line.size() && !isspace(uint8_t(line[end])))
+					++end;
+				args.push_back(line.substr(i, end - i));
+			}
+			i = end;
+		}
+		return args;
+	}
+
+	template<class T>
+	T parseNumber(const std::string& value, const char* name)
+	{
+		size_t pos = 0;
+		T res = T(0);
+		try
+		{
+			if constexpr (std::is_floating_point_v<T>) res = T(std::stod(value, &pos));
+			else res = T(std::stoll(value, &pos));
+		}
+		catch (const std::exception&)
+		{
+			pos = 0;
+		}
+		if (pos == 0 || pos != value.size())
+			throw std::runtime_error(std::string("invalid ") + name + ": " + value);
+		return res;
+	}
+
+	// the internal format that is expected by the exporters for the export format (same as ExportDescription.StagingFormat)
+	gli::format getStagingFormat(gli::format format)
+	{
+		const bool atMost8Bit = gli::is_compressed(format) ? !gli::is_float(format) :
+			!gli::is_packed(format) && gli::block_size(format) <= gli::component_count(format);
+
+		if (!atMost8Bit) return gli::FORMAT_RGBA32_SFLOAT_PACK32;
+		if (gli::is_srgb(format)) return gli::FORMAT_RGBA8_SRGB_PACK8;
+		if (gli::is_snorm(format)) return gli::FORMAT_RGBA8_SNORM_PACK8;
+		return gli::FORMAT_RGBA8_UNORM_PACK8;
+	}
+
+	struct SaveRequest
+	{
+		std::string file;
+		std::string format = "default";
+		int quality = 100;
+		float fps = 0.0f;
+
+		// reads [format] [quality] [fps] starting with args[first]
+		SaveRequest(std::string file, const std::vector<std::string>& args, size_t first)
+			: file(std::move(file))
+		{
+			if (args.size() > first + 3)
+				throw std::runtime_error("too many arguments");
+			if (args.size() > first) format = args[first];
+			if (args.size() > first + 1) quality = parseNumber<int>(args[first + 1], "quality");
+			if (args.size() > first + 2) fps = parseNumber<float>(args[first + 2], "fps");
+		}
+	};
+
+	void saveImage(image::IImage& image, const SaveRequest& request)
+	{
+		const size_t dot = request.file.find_last_of('.');
+		if (dot == std::string::npos || request.file.find_first_of("/\\", dot) != std::string::npos)
+			throw std::runtime_error("missing file extension: " + request.file);
+		std::string ext = request.file.substr(dot + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+		int numFormats = 0;
+		const uint32_t* formats = get_export_formats(ext.c_str(), numFormats);
+		if (numFormats == 0)
+			throw std::runtime_error("file extension not supported: " + ext);
+		const uint32_t* formatsEnd = formats + numFormats;
+
+		uint32_t format;
+		if (request.format == "default")
+		{
+			format = uint32_t(image.getOriginalFormat());
+			if (std::find(formats, formatsEnd, format) == formatsEnd)
+				format = formats[0];
+		}
+		else
+		{
+			format = parseNumber<uint32_t>(request.format, "format");
+			if (std::find(formats, formatsEnd, format) == formatsEnd)
+				throw std::runtime_error("format " + request.format + " is not supported by " + ext);
+		}
+
+		float fps = request.fps;
+		if (fps <= 0.0f) fps = image.getFps();
+		if (fps <= 0.0f) fps = 24.0f;
+
+		const gli::format stagingFormat = getStagingFormat(gli::format(format));
+		if (image.getFormat() == stagingFormat && dynamic_cast<GliImage*>(&image))
+		{
+			save_image(image, request.file.substr(0, dot), ext, format, request.quality, fps);
+			return;
+		}
+
+		auto staged = GliImage::convert(image, stagingFormat, 100);
+		save_image(*staged, request.file.substr(0, dot), ext, format, request.quality, fps);
+	}
+
+	std::string describeImage(const image::IImage& image)
+	{
+		return std::to_string(image.getWidth(0)) + " " + std::to_string(image.getHeight(0)) + " " + std::to_string(image.getDepth(0)) + " " +
+			std::to_string(image.getNumLayers()) + " " + std::to_string(image.getNumMipmaps()) + " " +
+			std::to_string(uint32_t(image.getFormat())) + " " + std::to_string(uint32_t(image.getOriginalFormat()));
+	}
+
+	class Connection
+	{
+	public:
+		explicit Connection(SOCKET socket) : m_socket(socket) {}
+		~Connection() { closesocket(m_socket); }
+		Connection(const Connection&) = delete;
+		Connection& operator=(const Connection&) = delete;
+
+		// reads the next request. Returns false if the client stopped sending
+		bool readLine(std::string& line)
+		{
+			while (true)
+			{
+				const size_t end = m_buffer.find('\n');
+				if (end != std::string::npos)
+				{
+					line = m_buffer.substr(0, end);
+					m_buffer.erase(0, end + 1);
+					if (!line.empty() && line.back() == '\r') line.pop_back();
+					return true;
+				}
+
+				char chunk[4096];
+				const int numRead = recv(m_socket, chunk, int(sizeof(chunk)), 0);
+				if (numRead <= 0) return false;
+				m_buffer.append(chunk, size_t(numRead));
+			}
+		}
+
+		// sends "<request> <text>". Lines of concurrent requests are not interleaved
+		void send(uint64_t request, const std::string& text)
+		{
+			std::string line = std::to_string(request) + " " + text;
+			// one response per line
+			std::replace(line.begin(), line.end(), '\n', ' ');
+			line += '\n';
+
+			std::lock_guard<std::mutex> lock(m_sendMutex);
+			size_t offset = 0;
+			while (offset < line.size() && !m_closed)
+			{
+				const int numSent = ::send(m_socket, line.data() + offset, int(line.size() - offset), 0);
+				if (numSent <= 0) m_closed = true;
+				else offset += size_t(numSent);
+			}
+		}
+
+		// true if the client disconnected (detected when sending)
+		bool isClosed() const { return m_closed; }
+
+		// unblocks readLine
+		void shutdown() { ::shutdown(m_socket, SD_BOTH); }
+
+		// named images of the connection (only used by the thread that reads the requests)
+		std::unordered_map<std::string, ImageFuture> images;
+		uint64_t numRequests = 0;
+
+	private:
+		SOCKET m_socket;
+		std::string m_buffer;
+		std::mutex m_sendMutex;
+		std::atomic<bool> m_closed = false;
+	};
+
+	struct Job
+	{
+		std::shared_ptr<Connection> connection;
+		uint64_t request;
+		// returns the results of the ok response. Throws on failure
+		std::function<std::string()> run;
+	};
+
+	class Server
+	{
+	public:
+		Server(const char* socketPath, uint32_t numWorkers)
+			: m_socketPath(socketPath)
+		{
+			WSADATA wsaData;
+			if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+				throw std::runtime_error("daemon: WSAStartup failed");
+
+			sockaddr_un address = {};
+			address.sun_family = AF_UNIX;
+			if (m_socketPath.size() >= sizeof(address.sun_path))
+			{
+				WSACleanup();
+				throw std::runtime_error("daemon: socket path too long");
+			}
+			std::memcpy(address.sun_path, m_socketPath.c_str(), m_socketPath.size());
+
+			// remove the socket file of a previous daemon
+			std::remove(m_socketPath.c_str());
+
+			m_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (m_listen == INVALID_SOCKET ||
+				bind(m_listen, reinterpret_cast<const sockaddr*>(&address), int(sizeof(address))) == SOCKET_ERROR ||
+				listen(m_listen, SOMAXCONN) == SOCKET_ERROR)
+			{
+				const int error = WSAGetLastError();
+				if (m_listen != INVALID_SOCKET) closesocket(m_listen);
+				WSACleanup();
+				throw std::runtime_error("daemon: cannot listen on " + m_socketPath + " (error " + std::to_string(error) + ")");
+			}
+
+			if (numWorkers == 0) numWorkers = uint32_t(image::getNumThreads());
+			for (uint32_t i = 0; i < numWorkers; ++i)
+				m_workers.emplace_back(&Server::work, this);
+		}
+
+		~Server()
+		{
+			stop();
+
+			// finish all queued requests
+			for (auto& w : m_workers)
+				w.join();
+
+			// disconnect the remaining clients
+			std::unique_lock<std::mutex> lock(m_connectionMutex);
+			for (auto& c : m_connections)
+				c->shutdown();
+			m_connectionsClosed.wait(lock, [this] { return m_connections.empty(); });
+			lock.unlock();
+
+			std::remove(m_socketPath.c_str());
+			WSACleanup();
+		}
+
+		// accepts clients until a client requests a shutdown
+		void run()
+		{
+			while (true)
+			{
+				const SOCKET socket = accept(m_listen, nullptr, nullptr);
+				if (socket == INVALID_SOCKET)
+				{
+					if (m_stopping) return;
+					continue;
+				}
+
+				auto connection = std::make_shared<Connection>(socket);
+				std::lock_guard<std::mutex> lock(m_connectionMutex);
+				m_connections.push_back(connection);
+				std::thread(&Server::read, this, std::move(connection)).detach();
+			}
+		}
+
+	private:
+		void stop()
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			if (m_stopping) return;
+			m_stopping = true;
+			m_jobAvailable.notify_all();
+			// unblocks accept
+			closesocket(m_listen);
+		}
+
+		// reads the requests of one client
+		void read(std::shared_ptr<Connection> connection)
+		{
+			std::string line;
+			while (connection->readLine(line))
+			{
+				if (line.find_first_not_of(" \t") == std::string::npos) continue;
+
+				const uint64_t request = ++connection->numRequests;
+				try
+				{
+					const auto args = splitArguments(line);
+					if (args[0] == "shutdown")
+					{
+						connection->send(request, "ok");
+						stop();
+						continue;
+					}
+
+					push({ connection, request, parse(*connection, args) });
+				}
+				catch (const std::exception& e)
+				{
+					connection->send(request, std::string("error ") + e.what());
+				}
+			}
+
+			// queued requests keep the connection alive until they are finished
+			std::lock_guard<std::mutex> lock(m_connectionMutex);
+			m_connections.remove(connection);
+			connection.reset();
+			m_connectionsClosed.notify_all();
+		}
+
+		std::function<std::string()> parse(Connection& connection, const std::vector<std::string>& args)
+		{
+			const std::string& command = args[0];
+			auto expectArgs = [&args, &command](size_t min, size_t max)
+			{
+				if (args.size() - 1 < min || args.size() - 1 > max)
+					throw std::runtime_error("invalid number of arguments for " + command);
+			};
+			auto takeImage = [&connection](const std::string& name)
+			{
+				auto it = connection.images.find(name);
+				if (it == connection.images.end())
+					throw std::runtime_error("unknown image: " + name);
+				auto image = std::move(it->second);
+				connection.images.erase(it);
+				return image;
+			};
+
+			if (command == "open")
+			{
+				expectArgs(2, 2);
+				auto promise = std::make_shared<std::promise<std::shared_ptr<image::IImage>>>();
+				connection.images[args[1]] = promise->get_future().share();
+				return [promise, file = args[2]]
+				{
+					try
+					{
+						std::shared_ptr<image::IImage> image = load_image(file.c_str());
+						promise->set_value(image);
+						return describeImage(*image);
+					}
+					catch (...)
+					{
+						promise->set_exception(std::current_exception());
+						throw;
+					}
+				};
+			}
+			if (command == "save")
+			{
+				expectArgs(2, 5);
+				SaveRequest request(args[2], args, 3);
+				// the preceding open was queued first, so the image is loaded or being loaded by another worker
+				return [future = takeImage(args[1]), request]
+				{
+					saveImage(*future.get(), request);
+					return std::string();
+				};
+			}
+			if (command == "convert")
+			{
+				expectArgs(2, 5);
+				SaveRequest request(args[2], args, 3);
+				return [src = args[1], request]
+				{
+					auto image = load_image(src.c_str());
+					saveImage(*image, request);
+					return std::string();
+				};
+			}
+			if (command == "release")
+			{
+				expectArgs(1, 1);
+				takeImage(args[1]);
+				return [] { return std::string(); };
+			}
+			if (command == "formats")
+			{
+				expectArgs(1, 1);
+				return [ext = args[1]]
+				{
+					int numFormats = 0;
+					const uint32_t* formats = get_export_formats(ext.c_str(), numFormats);
+					std::string res;
+					for (int i = 0; i < numFormats; ++i)
+						res += (i ? " " : "") + std::to_string(formats[i]);
+					return res;
+				};
+			}
+
+			throw std::runtime_error("unknown request: " + command);
+		}
+
+		void push(Job job)
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			if (m_stopping)
+				throw std::runtime_error("daemon is shutting down");
+			m_jobs.push_back(std::move(job));
+			m_jobAvailable.notify_one();
+		}
+
+		void work()
+		{
+			while (true)
+			{
+				Job job;
+				{
+					std::unique_lock<std::mutex> lock(m_jobMutex);
+					m_jobAvailable.wait(lock, [this] { return !m_jobs.empty() || m_stopping; });
+					if (m_jobs.empty()) return;
+					job = std::move(m_jobs.front());
+					m_jobs.pop_front();
+				}
+
+				// concurrent requests share the cores instead of spawning getNumThreads() threads each
+				const size_t numBusy = ++m_numBusy;
+				image::threadLimit() = std::max<size_t>(image::getNumThreads() / numBusy, 1);
+
+				Connection& connection = *job.connection;
+				const uint64_t request = job.request;
+				const ProgressHandler progress = [&connection, request](uint32_t percent, const char* description)
+				{
+					connection.send(request, "progress " + std::to_string(percent) + " " + description);
+					return connection.isClosed();
+				};
+				set_thread_progress_handler(&progress);
+
+				try
+				{
+					const std::string results = job.run();
+					connection.send(request, results.empty() ? "ok" : "ok " + results);
+				}
+				catch (const std::exception& e)
+				{
+					connection.send(request, std::string("error ") + e.what());
+				}
+
+				set_thread_progress_handler(nullptr);
+				--m_numBusy;
+			}
+		}
+
+		std::string m_socketPath;
+		SOCKET m_listen = INVALID_SOCKET;
+		std::vector<std::thread> m_workers;
+		std::atomic<size_t> m_numBusy = 0;
+
+		std::mutex m_jobMutex;
+		std::condition_variable m_jobAvailable;
+		std::deque<Job> m_jobs;
+		std::atomic<bool> m_stopping = false;
+
+		std::mutex m_connectionMutex;
+		std::condition_variable m_connectionsClosed;
+		std::list<std::shared_ptr<Connection>> m_connections;
+	};
+}
+
+void daemon_serve(const char* socketPath, uint32_t numWorkers)
+{
+	Server server(socketPath, numWorkers);
+	server.run();
+}
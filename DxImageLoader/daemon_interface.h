@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+// conversion daemon: keeps the loader warm (codecs, format tables, export formats) and processes the requests of local clients
+// that are connected to a unix domain socket (AF_UNIX, Windows 10 1803 or later).
+//
+// Clients send one request per line. Arguments are separated by spaces, arguments with spaces must be quoted ("C:/my file.png").
+// Requests are numbered per connection (starting with 1) and are processed concurrently by the worker threads.
+// All responses start with the number of the request:
+//   <request> progress <percent> <description>   (optional, any number of times)
+//   <request> ok [results]
+//   <request> error <message>
+//
+// Requests:
+//   open <name> <file>                             loads the file and stores it under the name (valid for this connection).
+//                                                  results: width height depth layers mipmaps format originalFormat
+//   save <name> <file> [format] [quality] [fps]    saves the image with the extension of file. The image is released afterwards
+//                                                  because the exporters might modify the pixels. Compressed formats (BC, ETC, ASTC...)
+//                                                  are chosen with format. format defaults to the original format of the image
+//                                                  (if supported by the extension) or to the first export format of the extension
+//   convert <src> <dst> [format] [quality] [fps]   open + save without a name
+//   release <name>                                 releases the image
+//   formats <extension>                            results: all export formats of the extension
+//   shutdown                                       finishes all queued requests and stops the daemon
+//
+// Formats are gli::format values. Requests that use a name wait for the preceding open of the same connection.
+// A request is aborted if its client disconnects.
+void daemon_serve(const char* socketPath, uint32_t numWorkers);
@@ -0,0 +1,828 @@
+#include "pch.h"
+#include "equation.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace equation
+{
+	namespace
+	{
+		// same as Token.Type in ImageFramework
+		enum class TokenType
+		{
+			Value,
+			Operation1,
+			Operation2,
+			Operation3,
+			BracketOpen,
+			BracketClose,
+			Seperator,
+			Function
+		};
+
+		struct Token
+		{
+			Token() = default;
+			Token(TokenType type, char symbol = 0) : type(type), symbol(symbol) {}
+			explicit Token(std::unique_ptr<Node> v) : type(TokenType::Value), value(std::move(v)) {}
+
+			TokenType type = TokenType::Value;
+			char symbol = 0; // for operations and seperators
+			std::string name; // function name
+			std::unique_ptr<Node> value;
+		};
+
+		using TokenList = std::vector<Token>;
+
+		std::string toLower(std::string s)
+		{
+			for (auto& c : s) c = char(std::tolower(static_cast<unsigned char>(c)));
+			return s;
+		}
+
+		bool isLetter(char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; }
+		bool isNumber(char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }
+
+		std::unique_ptr<Node> makeNode(Op op, std::unique_ptr<Node> a = nullptr, std::unique_ptr<Node> b = nullptr, std::unique_ptr<Node> c = nullptr)
+		{
+			auto n = std::make_unique<Node>();
+			n->op = op;
+			n->args[0] = std::move(a);
+			n->args[1] = std::move(b);
+			n->args[2] = std::move(c);
+			return n;
+		}
+
+		std::unique_ptr<Node> makeConstant(float value)
+		{
+			auto n = makeNode(Op::Constant);
+			n->value = value;
+			return n;
+		}
+
+		const std::unordered_map<std::string, float>& getConstants()
+		{
+			static const std::unordered_map<std::string, float> s_constants = {
+				{"pi", 3.14159265358979f},
+				{"e", 2.71828182845905f},
+				{"inf", std::numeric_limits<float>::infinity()},
+				{"infinity", std::numeric_limits<float>::infinity()},
+				{"float_max", std::numeric_limits<float>::max()},
+				{"fmax", std::numeric_limits<float>::max()},
+				{"eps", std::numeric_limits<float>::denorm_min()}, // float.Epsilon in C#
+				{"epsilon", std::numeric_limits<float>::denorm_min()},
+				{"nan", std::numeric_limits<float>::quiet_NaN()},
+			};
+			return s_constants;
+		}
+
+		// HlslEquation.HandleVariableString
+		Token handleVariableString(const std::string& identifier)
+		{
+			const auto lower = toLower(identifier);
+			if (lower.length() > 1 && lower[0] == 'i' && isNumber(lower[1]))
+			{
+				// image identifier
+				const auto number = identifier.substr(1);
+				if (!std::all_of(number.begin(), number.end(), isNumber) || number.length() > 9)
+					throw std::runtime_error("Invalid Image Identifier: " + identifier);
+
+				auto n = makeNode(Op::Image);
+				n->index = uint32_t(std::stoi(number));
+				return Token(std::move(n));
+			}
+
+			const auto& constants = getConstants();
+			const auto it = constants.find(lower);
+			if (it == constants.end())
+				throw std::runtime_error("Unknown Identifier: " + identifier);
+
+			return Token(makeConstant(it->second));
+		}
+
+		Token makeTokenFromString(const std::string& identifier)
+		{
+			if (isLetter(identifier[0]))
+				return handleVariableString(identifier);
+
+			// handle digit
+			char* end = nullptr;
+			const double value = std::strtod(identifier.c_str(), &end);
+			if (end != identifier.c_str() + identifier.length())
+				throw std::runtime_error("Invalid Number: " + identifier);
+			return Token(makeConstant(float(value)));
+		}
+
+		// Equation.GetToken
+		TokenList getTokens(const std::string& formula)
+		{
+			TokenList tokens;
+			std::string current;
+			for (const char c : formula)
+			{
+				Token nextToken;
+				bool hasNextToken = true;
+				bool finishCurrent = true;
+				switch (c)
+				{
+				case '^':
+					nextToken = Token(TokenType::Operation1, c);
+					break;
+				case '/':
+				case '*':
+					nextToken = Token(TokenType::Operation2, c);
+					break;
+				case '+':
+					nextToken = Token(TokenType::Operation3, c);
+					break;
+				case '-':
+					// allow - for scientific notation (1e-10)
+					if (current.length() >= 2 && std::tolower(static_cast<unsigned char>(current.back())) == 'e' &&
+						isNumber(current[current.length() - 2]))
+					{
+						current += '-';
+						finishCurrent = false;
+						hasNextToken = false;
+						break;
+					}
+					nextToken = Token(TokenType::Operation3, c);
+					break;
+				case ',':
+					nextToken = Token(TokenType::Seperator, c);
+					break;
+				case '(':
+					if (!current.empty())
+					{
+						// this is a function
+						nextToken = Token(TokenType::Function);
+						nextToken.name = current;
+						current.clear();
+					}
+					else nextToken = Token(TokenType::BracketOpen, c);
+					break;
+				case ')':
+					nextToken = Token(TokenType::BracketClose, c);
+					break;
+				default:
+					hasNextToken = false;
+					if (std::isspace(static_cast<unsigned char>(c))) break;
+
+					current += c;
+					finishCurrent = false;
+					break;
+				}
+
+				if (finishCurrent && !current.empty())
+				{
+					tokens.push_back(makeTokenFromString(current));
+					current.clear();
+				}
+				if (hasNextToken)
+					tokens.push_back(std::move(nextToken));
+			}
+
+			if (!current.empty())
+				tokens.push_back(makeTokenFromString(current));
+
+			return tokens;
+		}
+
+		[[noreturn]] void invalidFunction(const std::string& name)
+		{
+			throw std::runtime_error("invalid string as function name: " + name);
+		}
+
+		// IntrinsicToken
+		std::unique_ptr<Node> makeIntrinsic(const std::string& identifier)
+		{
+			const auto name = toLower(identifier);
+			if (name == "pos") return makeNode(Op::Pos);
+			if (name == "cpos") return makeNode(Op::CPos);
+			if (name == "ipos") return makeNode(Op::IPos);
+			if (name == "size") return makeNode(Op::Size);
+			if (name == "layer") return makeNode(Op::Layer);
+			invalidFunction(name);
+		}
+
+		// UnaryFunctionToken
+		std::unique_ptr<Node> makeUnary(const std::string& funcName, std::unique_ptr<Node> v)
+		{
+			static const std::unordered_map<std::string, Op> s_functions = {
+				{"tosrgb", Op::ToSrgb}, {"srgbasunorm", Op::ToSrgb}, {"fromsrgb", Op::FromSrgb}, {"srgbassnorm", Op::SrgbAsSnorm},
+				{"abs", Op::Abs}, {"sin", Op::Sin}, {"cos", Op::Cos}, {"tan", Op::Tan}, {"asin", Op::Asin}, {"acos", Op::Acos},
+				{"atan", Op::Atan}, {"exp", Op::Exp}, {"exp2", Op::Exp2}, {"sign", Op::Sign}, {"floor", Op::Floor}, {"ceil", Op::Ceil},
+				{"frac", Op::Frac}, {"trunc", Op::Trunc}, {"log", Op::Log}, {"log2", Op::Log2}, {"log10", Op::Log10}, {"sqrt", Op::Sqrt},
+				{"normalize", Op::Normalize}, {"length", Op::Length}, {"all", Op::All}, {"any", Op::Any}, {"radians", Op::Radians},
+				{"countbits", Op::CountBits},
+			};
+			static const std::unordered_map<std::string, uint32_t> s_channels = {
+				{"x", 0}, {"r", 0}, {"red", 0},
+				{"y", 1}, {"g", 1}, {"green", 1},
+				{"z", 2}, {"b", 2}, {"blue", 2},
+				{"w", 3}, {"a", 3}, {"alpha", 3},
+			};
+
+			const auto name = toLower(funcName);
+			const auto channel = s_channels.find(name);
+			if (channel != s_channels.end())
+			{
+				auto n = makeNode(Op::Splat, std::move(v));
+				n->index = channel->second;
+				return n;
+			}
+
+			const auto it = s_functions.find(name);
+			if (it == s_functions.end()) invalidFunction(name);
+			return makeNode(it->second, std::move(v));
+		}
+
+		// BinaryFunctionToken
+		std::unique_ptr<Node> makeBinary(const std::string& funcName, std::unique_ptr<Node> v1, std::unique_ptr<Node> v2)
+		{
+			static const std::unordered_map<std::string, Op> s_functions = {
+				{"min", Op::Min}, {"max", Op::Max}, {"atan2", Op::Atan2}, {"fmod", Op::Fmod}, {"step", Op::Step},
+				{"dot", Op::Dot}, {"cross", Op::Cross}, {"distance", Op::Distance},
+				{"equal", Op::Equal}, {"bigger", Op::Bigger}, {"smaller", Op::Smaller}, {"smallereq", Op::SmallerEq}, {"biggereq", Op::BiggerEq},
+			};
+
+			const auto name = toLower(funcName);
+			if (name == "pow") // max(v1, 0.0) to suppress undefined behaviour
+				return makeNode(Op::Pow, makeNode(Op::Max, std::move(v1), makeConstant(0.0f)), std::move(v2));
+
+			const auto it = s_functions.find(name);
+			if (it == s_functions.end()) invalidFunction(name);
+			return makeNode(it->second, std::move(v1), std::move(v2));
+		}
+
+		// TertiaryFunctionToken
+		std::unique_ptr<Node> makeTertiary(const std::string& funcName, std::unique_ptr<Node> v1, std::unique_ptr<Node> v2, std::unique_ptr<Node> v3)
+		{
+			const auto name = toLower(funcName);
+			if (name == "rgb") return makeNode(Op::Rgb, std::move(v1), std::move(v2), std::move(v3));
+			if (name == "lerp") return makeNode(Op::Lerp, std::move(v1), std::move(v2), std::move(v3));
+			if (name == "clamp") return makeNode(Op::Clamp, std::move(v1), std::move(v2), std::move(v3));
+			invalidFunction(name);
+		}
+
+		// CombinedValueToken
+		std::unique_ptr<Node> makeCombined(std::unique_ptr<Node> left, char symbol, std::unique_ptr<Node> right)
+		{
+			switch (symbol)
+			{
+			case '^': return makeNode(Op::Pow, std::move(left), std::move(right));
+			case '+': return makeNode(Op::Add, std::move(left), std::move(right));
+			case '-': return makeNode(Op::Sub, std::move(left), std::move(right));
+			case '*': return makeNode(Op::Mul, std::move(left), std::move(right));
+			case '/': return makeNode(Op::Div, std::move(left), std::move(right));
+			}
+			throw std::runtime_error(std::string("unknown operator: ") + symbol);
+		}
+
+		// markov rules in the order of HlslEquation.GetRules()
+		enum class Rule
+		{
+			IntrinsicFunction,
+			UnaryFunction,
+			BinaryFunction,
+			TertiaryFunction,
+			Bracket,
+			ValueOperation1Value,
+			DoubleSign,
+			Sign,
+			ValueOperation2Value,
+			ValueOperation3Value,
+		};
+
+		const std::vector<TokenType>& getRuleTokens(Rule rule)
+		{
+			using T = TokenType;
+			static const std::vector<T> s_intrinsic = { T::Function, T::BracketClose };
+			static const std::vector<T> s_unary = { T::Function, T::Value, T::BracketClose };
+			static const std::vector<T> s_binary = { T::Function, T::Value, T::Seperator, T::Value, T::BracketClose };
+			static const std::vector<T> s_tertiary = { T::Function, T::Value, T::Seperator, T::Value, T::Seperator, T::Value, T::BracketClose };
+			static const std::vector<T> s_bracket = { T::BracketOpen, T::Value, T::BracketClose };
+			static const std::vector<T> s_op1 = { T::Value, T::Operation1, T::Value };
+			static const std::vector<T> s_doubleSign = { T::Operation3, T::Operation3 };
+			static const std::vector<T> s_sign = { T::Operation3, T::Value };
+			static const std::vector<T> s_op2 = { T::Value, T::Operation2, T::Value };
+			static const std::vector<T> s_op3 = { T::Value, T::Operation3, T::Value };
+
+			switch (rule)
+			{
+			case Rule::IntrinsicFunction: return s_intrinsic;
+			case Rule::UnaryFunction: return s_unary;
+			case Rule::BinaryFunction: return s_binary;
+			case Rule::TertiaryFunction: return s_tertiary;
+			case Rule::Bracket: return s_bracket;
+			case Rule::ValueOperation1Value: return s_op1;
+			case Rule::DoubleSign: return s_doubleSign;
+			case Rule::Sign: return s_sign;
+			case Rule::ValueOperation2Value: return s_op2;
+			default: return s_op3;
+			}
+		}
+
+		bool tokensMatch(const std::vector<TokenType>& rule, const TokenList& tokens, size_t start)
+		{
+			if (start + rule.size() > tokens.size()) return false;
+			for (size_t i = 0; i < rule.size(); ++i)
+				if (tokens[start + i].type != rule[i]) return false;
+			return true;
+		}
+
+		// applies the rule to the matching tokens m. Returns false if the rule should not be applied
+		bool applyRule(Rule rule, Token* m, const Token* left, Token& result)
+		{
+			switch (rule)
+			{
+			case Rule::IntrinsicFunction:
+				result = Token(makeIntrinsic(m[0].name));
+				return true;
+			case Rule::UnaryFunction:
+				result = Token(makeUnary(m[0].name, std::move(m[1].value)));
+				return true;
+			case Rule::BinaryFunction:
+				result = Token(makeBinary(m[0].name, std::move(m[1].value), std::move(m[3].value)));
+				return true;
+			case Rule::TertiaryFunction:
+				result = Token(makeTertiary(m[0].name, std::move(m[1].value), std::move(m[3].value), std::move(m[5].value)));
+				return true;
+			case Rule::Bracket:
+				// brackets will be implicitly given through the token structure
+				result = std::move(m[1]);
+				return true;
+			case Rule::DoubleSign:
+				// different signs => negative
+				result = Token(TokenType::Operation3, m[0].symbol != m[1].symbol ? '-' : '+');
+				return true;
+			case Rule::Sign:
+				if (left && left->type == TokenType::Value) return false; // don't apply here
+				if (m[0].symbol == '+')
+					result = std::move(m[1]); // the value wont change
+				else
+					result = Token(makeNode(Op::Mul, makeConstant(-1.0f), std::move(m[1].value)));
+				return true;
+			default:
+				result = Token(makeCombined(std::move(m[0].value), m[1].symbol, std::move(m[2].value)));
+				return true;
+			}
+		}
+
+		// MarkovProcess.Resolve
+		void resolve(TokenList& tokens)
+		{
+			static const Rule s_rules[] = {
+				Rule::IntrinsicFunction, Rule::UnaryFunction, Rule::BinaryFunction, Rule::TertiaryFunction, Rule::Bracket,
+				Rule::ValueOperation1Value, Rule::DoubleSign, Rule::Sign, Rule::ValueOperation2Value, Rule::ValueOperation3Value
+			};
+
+			bool foundRule = true;
+			while (foundRule)
+			{
+				foundRule = false;
+				for (const auto rule : s_rules)
+				{
+					const auto& ruleTokens = getRuleTokens(rule);
+					for (size_t i = 0; i < tokens.size() && !foundRule; ++i)
+					{
+						if (!tokensMatch(ruleTokens, tokens, i)) continue;
+
+						Token result;
+						if (!applyRule(rule, &tokens[i], i > 0 ? &tokens[i - 1] : nullptr, result)) continue;
+
+						tokens[i] = std::move(result);
+						tokens.erase(tokens.begin() + i + 1, tokens.begin() + i + ruleTokens.size());
+						foundRule = true;
+					}
+					if (foundRule) break; // and again
+				}
+			}
+
+			if (tokens.size() > 1)
+				throw std::runtime_error("Could not resolve all tokens to an expression");
+		}
+
+		void verifyBrackets(const TokenList& tokens)
+		{
+			int openBrackets = 0;
+			for (const auto& t : tokens)
+			{
+				if (t.type == TokenType::BracketOpen || t.type == TokenType::Function)
+					++openBrackets;
+				if (t.type == TokenType::BracketClose && --openBrackets < 0)
+					throw std::runtime_error("too many closing brackets");
+			}
+			if (openBrackets != 0)
+				throw std::runtime_error("not all brackets were closed");
+		}
+
+		// MarkovProcess.Run
+		void runMarkov(TokenList& tokens)
+		{
+			verifyBrackets(tokens);
+
+			while (tokens.size() > 1)
+			{
+				// find a range of tokens to verify first (tokens inside brackets)
+				size_t startId = 0;
+				size_t endId = tokens.size();
+				for (size_t i = 0; i < tokens.size(); ++i)
+				{
+					if (tokens[i].type == TokenType::BracketOpen || tokens[i].type == TokenType::Function)
+						startId = endId = i;
+
+					if (tokens[i].type == TokenType::BracketClose && startId == endId)
+						endId = i + 1;
+				}
+
+				TokenList range(std::make_move_iterator(tokens.begin() + startId), std::make_move_iterator(tokens.begin() + endId));
+				resolve(range);
+				tokens.erase(tokens.begin() + startId + 1, tokens.begin() + endId);
+				tokens[startId] = std::move(range[0]);
+			}
+		}
+
+		size_t getNumArgs(Op op)
+		{
+			if (op <= Op::Layer) return 0;
+			if (op <= Op::CountBits) return 1;
+			if (op <= Op::SmallerEq) return 2;
+			return 3;
+		}
+	}
+
+	std::unique_ptr<Node> parse(const std::string& formula)
+	{
+		auto tokens = getTokens(formula);
+		if (tokens.empty())
+			throw std::runtime_error("Please enter a formula");
+
+		runMarkov(tokens);
+
+		if (tokens.size() != 1)
+			throw std::runtime_error("Could not resolve all tokens to an expression");
+		if (tokens[0].type != TokenType::Value)
+			throw std::runtime_error("Please enter a valid formula");
+
+		return std::move(tokens[0].value);
+	}
+
+	uint32_t Program::compile(const Node& node)
+	{
+		return compileNode(node).reg;
+	}
+
+	Program::Compiled Program::compileNode(const Node& node)
+	{
+		switch (node.op)
+		{
+		case Op::Constant:
+		{
+			const uint32_t reg = allocate();
+			m_constants.push_back({ node.op, reg, 0, 0, 0, node.value, 0 });
+			return { reg, true };
+		}
+		case Op::Image:
+		{
+			// every image only needs to be loaded once
+			for (const auto& load : m_imageLoads)
+				if (load.image == node.index) return { load.dst, false };
+			const uint32_t reg = allocate();
+			m_imageLoads.push_back({ node.index, reg });
+			return { reg, false };
+		}
+		default:
+			break;
+		}
+
+		Compiled args[3] = {};
+		bool isConstant = node.op > Op::Layer;
+		for (size_t i = 0; i < getNumArgs(node.op); ++i)
+		{
+			args[i] = compileNode(*node.args[i]);
+			isConstant = isConstant && args[i].isConstant;
+		}
+
+		const uint32_t reg = allocate();
+		const Instruction ins = { node.op, reg, args[0].reg, args[1].reg, args[2].reg, node.value, node.index };
+		if (isConstant) m_constants.push_back(ins);
+		else m_instructions.push_back(ins);
+		return { reg, isConstant };
+	}
+
+	namespace
+	{
+		using Register = Registers::Register;
+
+		constexpr float NaNValue = std::numeric_limits<float>::quiet_NaN();
+
+		// hlsl toSrgb of ImageCombineShader (clamps to [0, 1])
+		float toSrgb(float c)
+		{
+			if (c >= 1.0f) return 1.0f;
+			if (c <= 0.0f) return 0.0f;
+			if (c <= 0.0031308f) return 12.92f * c;
+			return 1.055f * std::pow(std::abs(c), 0.41666f) - 0.055f;
+		}
+
+		float fromSrgb(float c)
+		{
+			if (c >= 1.0f) return 1.0f;
+			if (c <= 0.0f) return 0.0f;
+			if (c <= 0.04045f) return c / 12.92f;
+			return std::pow(std::max((c + 0.055f) / 1.055f, 0.0f), 2.4f);
+		}
+
+		float srgbAsSnorm(float c)
+		{
+			// get byte value
+			int32_t byte = int32_t(toSrgb(c) * 255.0f + 0.5f);
+			// according to dx spec. 127 maps to 1.0, -127 (129) and -128 (128) maps to -1.0
+			if (byte <= 127) return float(byte) / 127.0f;
+			byte |= int32_t(0xFFFFFF00); // extend sign
+			return std::max(float(byte) / 127.0f, -1.0f);
+		}
+
+		float powEx(float x, float y)
+		{
+			float r = 1.0f;
+			// handle undefined behaviour
+			if (x < 0.0f && y - std::floor(y) == 0.0f)
+			{
+				// adjust for even or odd y, keep for fractional y (will be converted to NaN)
+				x = -x;
+				if (uint32_t(std::trunc(std::abs(y))) % 2 != 0)
+					r = -1.0f; // negate result for uneven exponent
+			}
+			r *= std::pow(std::abs(x), y);
+
+			// force NaN for x=0 && y=0
+			if (x == 0.0f && y == 0.0f) r = NaNValue;
+			// force NaN for fractional y
+			if (x < 0.0f) r = NaNValue;
+			return r;
+		}
+
+		float countBits(float v)
+		{
+			// float to int conversion of the d3d spec (NaN => 0, clamp to int range)
+			int32_t i = 0;
+			if (std::isnan(v)) i = 0;
+			else if (v >= 2147483647.0f) i = INT_MAX;
+			else if (v <= -2147483648.0f) i = INT_MIN;
+			else i = int32_t(v);
+			return float(std::bitset<32>(uint32_t(i)).count());
+		}
+
+		float fsign(float v)
+		{
+			return float((v > 0.0f) - (v < 0.0f));
+		}
+
+		template<class F>
+		void map1(Register& d, const Register& a, size_t n, F f)
+		{
+			for (size_t ch = 0; ch < 4; ++ch)
+				for (size_t i = 0; i < n; ++i)
+					d.c[ch][i] = f(a.c[ch][i]);
+		}
+
+		template<class F>
+		void map2(Register& d, const Register& a, const Register& b, size_t n, F f)
+		{
+			for (size_t ch = 0; ch < 4; ++ch)
+				for (size_t i = 0; i < n; ++i)
+					d.c[ch][i] = f(a.c[ch][i], b.c[ch][i]);
+		}
+
+		template<class F>
+		void simd2(Register& d, const Register& a, const Register& b, size_t n, F f)
+		{
+			for (size_t ch = 0; ch < 4; ++ch)
+				for (size_t i = 0; i < n; i += 4)
+					_mm_store_ps(d.c[ch] + i, f(_mm_load_ps(a.c[ch] + i), _mm_load_ps(b.c[ch] + i)));
+		}
+
+		// d3d min/max return the other operand if one of them is NaN
+		__m128 selectNotNaN(__m128 res, __m128 a, __m128 b)
+		{
+			const __m128 bIsNaN = _mm_cmpunord_ps(b, b);
+			return _mm_or_ps(_mm_and_ps(bIsNaN, a), _mm_andnot_ps(bIsNaN, res));
+		}
+
+		void fill(Register& d, size_t ch, size_t n, float value)
+		{
+			std::fill(d.c[ch], d.c[ch] + n, value);
+		}
+
+		// rgb = value, a = 1
+		void fillRgbOne(Register& d, size_t n, const float* value)
+		{
+			for (size_t ch = 0; ch < 3; ++ch)
+				std::copy(value, value + n, d.c[ch]);
+			fill(d, 3, n, 1.0f);
+		}
+
+		// executes the instruction for the first n pixels. tile is nullptr for constant instructions
+		void execute(const Program::Instruction& ins, Registers& regs, const Tile* tile, size_t n)
+		{
+			Register& d = regs[ins.dst];
+			const Register& a = regs[ins.a];
+			const Register& b = regs[ins.b];
+			const Register& c = regs[ins.c];
+
+			switch (ins.op)
+			{
+			case Op::Constant:
+				for (size_t ch = 0; ch < 4; ++ch)
+					fill(d, ch, n, ins.value);
+				break;
+			case Op::Image:
+				break; // loaded by the caller
+			case Op::Pos:
+			case Op::CPos:
+			{
+				const float scale = ins.op == Op::CPos ? 2.0f : 1.0f;
+				const float offset = ins.op == Op::CPos ? -1.0f : 0.0f;
+				for (size_t i = 0; i < n; ++i)
+					d.c[0][i] = (float(tile->x + i) + 0.5f) / tile->size[0] * scale + offset;
+				// for 2D images coord.z is set to the layer after fcoord was computed
+				fill(d, 1, n, (float(tile->y) + 0.5f) / tile->size[1] * scale + offset);
+				fill(d, 2, n, (float(tile->is3D ? tile->z : 0) + 0.5f) / tile->size[2] * scale + offset);
+				fill(d, 3, n, 1.0f);
+			} break;
+			case Op::IPos:
+				for (size_t i = 0; i < n; ++i)
+					d.c[0][i] = float(tile->x + i);
+				fill(d, 1, n, float(tile->y));
+				fill(d, 2, n, float(tile->z));
+				fill(d, 3, n, 1.0f);
+				break;
+			case Op::Size:
+				for (size_t ch = 0; ch < 3; ++ch)
+					fill(d, ch, n, tile->size[ch]);
+				fill(d, 3, n, 1.0f);
+				break;
+			case Op::Layer:
+				for (size_t ch = 0; ch < 4; ++ch)
+					fill(d, ch, n, float(tile->layer));
+				break;
+			case Op::Splat:
+				for (size_t ch = 0; ch < 4; ++ch)
+					std::copy(a.c[ins.index], a.c[ins.index] + n, d.c[ch]);
+				break;
+			case Op::ToSrgb:
+			case Op::FromSrgb:
+			case Op::SrgbAsSnorm:
+			{
+				const auto f = ins.op == Op::ToSrgb ? toSrgb : (ins.op == Op::FromSrgb ? fromSrgb : srgbAsSnorm);
+				for (size_t ch = 0; ch < 3; ++ch)
+					for (size_t i = 0; i < n; ++i)
+						d.c[ch][i] = f(a.c[ch][i]);
+				std::copy(a.c[3], a.c[3] + n, d.c[3]);
+			} break;
+			case Op::Abs: map1(d, a, n, [](float v) { return std::abs(v); }); break;
+			case Op::Sin: map1(d, a, n, [](float v) { return std::sin(v); }); break;
+			case Op::Cos: map1(d, a, n, [](float v) { return std::cos(v); }); break;
+			case Op::Tan: map1(d, a, n, [](float v) { return std::tan(v); }); break;
+			case Op::Asin: map1(d, a, n, [](float v) { return std::asin(v); }); break;
+			case Op::Acos: map1(d, a, n, [](float v) { return std::acos(v); }); break;
+			case Op::Atan: map1(d, a, n, [](float v) { return std::atan(v); }); break;
+			case Op::Exp: map1(d, a, n, [](float v) { return std::exp(v); }); break;
+			case Op::Exp2: map1(d, a, n, [](float v) { return std::exp2(v); }); break;
+			case Op::Sign: map1(d, a, n, fsign); break;
+			case Op::Floor: map1(d, a, n, [](float v) { return std::floor(v); }); break;
+			case Op::Ceil: map1(d, a, n, [](float v) { return std::ceil(v); }); break;
+			case Op::Frac: map1(d, a, n, [](float v) { return v - std::floor(v); }); break;
+			case Op::Trunc: map1(d, a, n, [](float v) { return std::trunc(v); }); break;
+			case Op::Log: map1(d, a, n, [](float v) { return v < 0.0f ? NaNValue : std::log(v); }); break;
+			case Op::Log2: map1(d, a, n, [](float v) { return v < 0.0f ? NaNValue : std::log2(v); }); break;
+			case Op::Log10: map1(d, a, n, [](float v) { return v < 0.0f ? NaNValue : std::log10(v); }); break;
+			case Op::Sqrt: map1(d, a, n, [](float v) { return v < 0.0f ? NaNValue : std::sqrt(v); }); break;
+			case Op::CountBits: map1(d, a, n, countBits); break;
+			case Op::Normalize:
+				for (size_t i = 0; i < n; ++i)
+				{
+					const float x = a.c[0][i], y = a.c[1][i], z = a.c[2][i];
+					if (x == 0.0f && y == 0.0f && z == 0.0f)
+					{
+						d.c[0][i] = d.c[1][i] = d.c[2][i] = NaNValue;
+						continue;
+					}
+					const float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+					d.c[0][i] = x * invLength;
+					d.c[1][i] = y * invLength;
+					d.c[2][i] = z * invLength;
+				}
+				fill(d, 3, n, 1.0f);
+				break;
+			case Op::Length:
+				for (size_t i = 0; i < n; ++i)
+					d.c[0][i] = std::sqrt(a.c[0][i] * a.c[0][i] + a.c[1][i] * a.c[1][i] + a.c[2][i] * a.c[2][i]);
+				for (size_t ch = 1; ch < 4; ++ch)
+					std::copy(d.c[0], d.c[0] + n, d.c[ch]);
+				break;
+			case Op::All:
+			case Op::Any:
+				for (size_t i = 0; i < n; ++i)
+				{
+					const bool x = a.c[0][i] != 0.0f, y = a.c[1][i] != 0.0f, z = a.c[2][i] != 0.0f, w = a.c[3][i] != 0.0f;
+					const bool res = ins.op == Op::All ? (x && y && z && w) : (x || y || z || w);
+					d.c[0][i] = res ? 1.0f : 0.0f;
+				}
+				for (size_t ch = 1; ch < 4; ++ch)
+					std::copy(d.c[0], d.c[0] + n, d.c[ch]);
+				break;
+			case Op::Radians:
+				for (size_t i = 0; i < n; ++i)
+					d.c[0][i] = a.c[0][i] * (3.14159265358979f / 180.0f);
+				for (size_t ch = 1; ch < 4; ++ch)
+					std::copy(d.c[0], d.c[0] + n, d.c[ch]);
+				break;
+			case Op::Add: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_add_ps(x, y); }); break;
+			case Op::Sub: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_sub_ps(x, y); }); break;
+			case Op::Mul: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_mul_ps(x, y); }); break;
+			case Op::Div: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_div_ps(x, y); }); break;
+			case Op::Min: simd2(d, a, b, n, [](__m128 x, __m128 y) { return selectNotNaN(_mm_min_ps(x, y), x, y); }); break;
+			case Op::Max: simd2(d, a, b, n, [](__m128 x, __m128 y) { return selectNotNaN(_mm_max_ps(x, y), x, y); }); break;
+			case Op::Equal: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_and_ps(_mm_cmpeq_ps(x, y), _mm_set1_ps(1.0f)); }); break;
+			case Op::Bigger: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_and_ps(_mm_cmpgt_ps(x, y), _mm_set1_ps(1.0f)); }); break;
+			case Op::Smaller: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_and_ps(_mm_cmplt_ps(x, y), _mm_set1_ps(1.0f)); }); break;
+			case Op::BiggerEq: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_and_ps(_mm_cmpge_ps(x, y), _mm_set1_ps(1.0f)); }); break;
+			case Op::SmallerEq: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_and_ps(_mm_cmple_ps(x, y), _mm_set1_ps(1.0f)); }); break;
+			case Op::Step: simd2(d, a, b, n, [](__m128 x, __m128 y) { return _mm_and_ps(_mm_cmpge_ps(y, x), _mm_set1_ps(1.0f)); }); break;
+			case Op::Pow: map2(d, a, b, n, powEx); break;
+			case Op::Atan2: map2(d, a, b, n, [](float y, float x) { return std::atan2(y, x); }); break;
+			case Op::Fmod: map2(d, a, b, n, [](float x, float y) { return std::fmod(x, y); }); break;
+			case Op::Dot:
+			case Op::Distance:
+			{
+				alignas(16) float res[TileSize];
+				for (size_t i = 0; i < n; ++i)
+				{
+					if (ins.op == Op::Dot)
+					{
+						res[i] = a.c[0][i] * b.c[0][i] + a.c[1][i] * b.c[1][i] + a.c[2][i] * b.c[2][i];
+						continue;
+					}
+					const float x = a.c[0][i] - b.c[0][i], y = a.c[1][i] - b.c[1][i], z = a.c[2][i] - b.c[2][i];
+					res[i] = std::sqrt(x * x + y * y + z * z);
+				}
+				fillRgbOne(d, n, res);
+			} break;
+			case Op::Cross:
+				for (size_t i = 0; i < n; ++i)
+				{
+					d.c[0][i] = a.c[1][i] * b.c[2][i] - a.c[2][i] * b.c[1][i];
+					d.c[1][i] = a.c[2][i] * b.c[0][i] - a.c[0][i] * b.c[2][i];
+					d.c[2][i] = a.c[0][i] * b.c[1][i] - a.c[1][i] * b.c[0][i];
+				}
+				fill(d, 3, n, 1.0f);
+				break;
+			case Op::Rgb:
+				std::copy(a.c[0], a.c[0] + n, d.c[0]);
+				std::copy(b.c[0], b.c[0] + n, d.c[1]);
+				std::copy(c.c[0], c.c[0] + n, d.c[2]);
+				fill(d, 3, n, 1.0f);
+				break;
+			case Op::Lerp:
+				for (size_t ch = 0; ch < 4; ++ch)
+					for (size_t i = 0; i < n; i += 4)
+					{
+						const __m128 x = _mm_load_ps(a.c[ch] + i);
+						const __m128 y = _mm_load_ps(b.c[ch] + i);
+						const __m128 s = _mm_load_ps(c.c[0] + i);
+						_mm_store_ps(d.c[ch] + i, _mm_add_ps(x, _mm_mul_ps(s, _mm_sub_ps(y, x))));
+					}
+				break;
+			case Op::Clamp:
+				for (size_t ch = 0; ch < 4; ++ch)
+					for (size_t i = 0; i < n; ++i)
+						d.c[ch][i] = std::fmin(std::fmax(a.c[ch][i], b.c[ch][i]), c.c[ch][i]);
+				break;
+			}
+		}
+	}
+
+	void Program::runConstants(Registers& regs) const
+	{
+		for (const auto& ins : m_constants)
+			execute(ins, regs, nullptr, TileSize);
+	}
+
+	void Program::run(Registers& regs, const Tile& tile) const
+	{
+		// simd instructions process 4 pixels at once
+		const size_t n = (size_t(tile.count) + 3) & ~size_t(3);
+		for (const auto& ins : m_instructions)
+			execute(ins, regs, &tile, n);
+	}
+}
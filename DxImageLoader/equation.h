@@ -0,0 +1,166 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// cpu version of the image combine equations of ImageFramework (see HlslEquation.cs and ImageCombineShader.cs).
+// Formulas are parsed with the same tokens and markov rules and compiled into a register based program.
+// Every register holds float4 values of a whole tile of pixels (structure of arrays),
+// thus every instruction is executed for TileSize pixels at once.
+namespace equation
+{
+	constexpr size_t TileSize = 64;
+
+	enum class Op : uint8_t
+	{
+		// values
+		Constant,
+		Image, // GetTexture{index}(coord)
+		Pos, // float4(fcoord, 1.0)
+		CPos, // float4(fcoord * 2.0 - 1.0, 1.0)
+		IPos, // float4(coord, 1.0)
+		Size, // float4(width, height, depth, 1.0)
+		Layer, // f4(layer)
+		// unary
+		Splat, // (value).rrrr etc., index = channel
+		ToSrgb,
+		FromSrgb,
+		SrgbAsSnorm,
+		Abs,
+		Sin,
+		Cos,
+		Tan,
+		Asin,
+		Acos,
+		Atan,
+		Exp,
+		Exp2,
+		Sign,
+		Floor,
+		Ceil,
+		Frac,
+		Trunc,
+		Log, // negative values are converted to NaN
+		Log2,
+		Log10,
+		Sqrt,
+		Normalize,
+		Length,
+		All,
+		Any,
+		Radians,
+		CountBits,
+		// binary
+		Add,
+		Sub,
+		Mul,
+		Div,
+		Pow, // powEx
+		Min,
+		Max,
+		Atan2,
+		Fmod,
+		Step,
+		Dot,
+		Cross,
+		Distance,
+		Equal,
+		Bigger,
+		Smaller,
+		BiggerEq,
+		SmallerEq,
+		// tertiary
+		Rgb,
+		Lerp,
+		Clamp,
+	};
+
+	// node of the expression tree
+	struct Node
+	{
+		Op op = Op::Constant;
+		float value = 0.0f; // for Op::Constant
+		uint32_t index = 0; // image index for Op::Image, channel for Op::Splat
+		std::unique_ptr<Node> args[3];
+	};
+
+	// parses the formula (e.g. "I0 - I1"). Throws std::runtime_error on syntax errors
+	std::unique_ptr<Node> parse(const std::string& formula);
+
+	// registers of a single thread. One register contains float4 values for TileSize pixels
+	class Registers
+	{
+	public:
+		struct Register
+		{
+			alignas(16) float c[4][TileSize];
+		};
+
+		explicit Registers(size_t count) : m_registers(count) {}
+		Register& operator[](size_t i) { return m_registers[i]; }
+		const Register& operator[](size_t i) const { return m_registers[i]; }
+
+	private:
+		std::vector<Register> m_registers;
+	};
+
+	// position of the tile that is evaluated
+	struct Tile
+	{
+		uint32_t x; // first pixel
+		uint32_t y;
+		uint32_t z; // depth coordinate for 3D images, layer for 2D images
+		uint32_t count; // number of pixels (<= TileSize)
+		uint32_t layer;
+		float size[3]; // width, height, depth (number of layers for 2D images)
+		bool is3D;
+	};
+
+	class Program
+	{
+	public:
+		struct Instruction
+		{
+			Op op;
+			uint32_t dst;
+			uint32_t a;
+			uint32_t b;
+			uint32_t c;
+			float value;
+			uint32_t index;
+		};
+
+		struct ImageLoad
+		{
+			uint32_t image;
+			uint32_t dst;
+		};
+
+		// compiles the expression into the program and returns the register that will contain the result
+		uint32_t compile(const Node& node);
+
+		// initializes registers that only depend on constants. Needs to be called once for new registers
+		void runConstants(Registers& regs) const;
+		// evaluates all tile dependent instructions. The image registers (see getImageLoads) need to be filled beforehand
+		void run(Registers& regs, const Tile& tile) const;
+
+		size_t getNumRegisters() const { return m_numRegisters; }
+		const std::vector<ImageLoad>& getImageLoads() const { return m_imageLoads; }
+
+	private:
+		struct Compiled
+		{
+			uint32_t reg;
+			bool isConstant;
+		};
+
+		Compiled compileNode(const Node& node);
+		uint32_t allocate() { return uint32_t(m_numRegisters++); }
+
+		std::vector<Instruction> m_constants;
+		std::vector<Instruction> m_instructions;
+		std::vector<ImageLoad> m_imageLoads;
+		size_t m_numRegisters = 0;
+	};
+}
@@ -1,10 +1,16 @@
 #include "pch.h"
 #include "exr_interface.h"
+#include "interface.h"
+#include "parallel.h"
 #define TINYEXR_USE_MINIZ 0
+// scanline blocks and tiles are compressed on multiple threads
+#define TINYEXR_USE_THREAD 1
 #define TINYEXR_IMPLEMENTATION
 #include "../dependencies/zlib/zlib.h"
 #include "../dependencies/tinyexr/tinyexr.h"
 
+static constexpr size_t s_minParallelRows = 16;
+
 
 std::unique_ptr<image::IImage> openexr_load(const char* filename)
 {
@@ -13,12 +19,31 @@ std::unique_ptr<image::IImage> openexr_load(const char* filename)
 	int height = 0;
 	const char* err = nullptr;
 
+	// LoadEXR copies a single (luminance) channel into all four channels => alpha is fixed below
+	int numChannels = 0;
+	EXRVersion version;
+	if (ParseEXRVersionFromFile(&version, filename) == TINYEXR_SUCCESS && !version.multipart)
+	{
+		EXRHeader header;
+		InitEXRHeader(&header);
+		if (ParseEXRHeaderFromFile(&header, &version, filename, &err) == TINYEXR_SUCCESS)
+		{
+			numChannels = header.num_channels;
+			FreeEXRHeader(&header);
+		}
+		else if (err)
+		{
+			FreeEXRErrorMessage(err);
+			err = nullptr;
+		}
+	}
+
 	int ret = LoadEXR(&out, &width, &height, filename, &err);
 	if (ret != TINYEXR_SUCCESS)
 		throw std::runtime_error(err);
 
 	auto res = std::make_unique<image::SimpleImage>(
-		gli::format::FORMAT_RGBA32_SFLOAT_PACK32, 
+		numChannels == 1 ? gli::format::FORMAT_R32_SFLOAT_PACK32 : gli::format::FORMAT_RGBA32_SFLOAT_PACK32,
 		gli::format::FORMAT_RGBA32_SFLOAT_PACK32,
 		width, height, 4 * 4
 	);
@@ -30,5 +55,128 @@ std::unique_ptr<image::IImage> openexr_load(const char* filename)
 
 	free(out);
 
+	if (numChannels == 1)
+	{
+		float* pixels = reinterpret_cast<float*>(dst);
+		for (size_t i = 0; i < size_t(width) * size_t(height); ++i)
+			pixels[i * 4 + 3] = 1.0f;
+	}
+
 	return res;
 }
+
+std::vector<uint32_t> openexr_get_export_formats()
+{
+	return {
+		gli::format::FORMAT_RGBA32_SFLOAT_PACK32,
+		gli::format::FORMAT_RGB32_SFLOAT_PACK32,
+		gli::format::FORMAT_R32_SFLOAT_PACK32,
+		gli::format::FORMAT_RGBA16_SFLOAT_PACK16,
+		gli::format::FORMAT_RGB16_SFLOAT_PACK16,
+		gli::format::FORMAT_R16_SFLOAT_PACK16,
+	};
+}
+
+// "exr compression" global parameter => tinyexr compression type
+static int openexr_get_compression()
+{
+	switch (get_global_parameter_i("exr compression", 0))
+	{
+	case 0: return TINYEXR_COMPRESSIONTYPE_ZIP;
+	case 1: return TINYEXR_COMPRESSIONTYPE_PIZ;
+	case 2: return TINYEXR_COMPRESSIONTYPE_ZIPS;
+	case 3: return TINYEXR_COMPRESSIONTYPE_RLE;
+	case 4: return TINYEXR_COMPRESSIONTYPE_NONE;
+	}
+	throw std::runtime_error("exr compression must be 0 (zip), 1 (piz), 2 (zips), 3 (rle) or 4 (none)");
+}
+
+void openexr_save(const char* filename, image::IImage& image, gli::format format)
+{
+	if (image.getFormat() != gli::FORMAT_RGBA32_SFLOAT_PACK32)
+		throw std::runtime_error("expected RGBA32F image format for exr export");
+
+	int numChannels = 0;
+	int pixelType = TINYEXR_PIXELTYPE_FLOAT;
+	switch (format)
+	{
+	case gli::FORMAT_RGBA32_SFLOAT_PACK32: numChannels = 4; break;
+	case gli::FORMAT_RGB32_SFLOAT_PACK32: numChannels = 3; break;
+	case gli::FORMAT_R32_SFLOAT_PACK32: numChannels = 1; break;
+	case gli::FORMAT_RGBA16_SFLOAT_PACK16: numChannels = 4; pixelType = TINYEXR_PIXELTYPE_HALF; break;
+	case gli::FORMAT_RGB16_SFLOAT_PACK16: numChannels = 3; pixelType = TINYEXR_PIXELTYPE_HALF; break;
+	case gli::FORMAT_R16_SFLOAT_PACK16: numChannels = 1; pixelType = TINYEXR_PIXELTYPE_HALF; break;
+	default: throw std::runtime_error("export format not supported for exr");
+	}
+
+	const int compression = openexr_get_compression();
+	const int tileSize = get_global_parameter_i("exr tile size", 0);
+	if (tileSize < 0)
+		throw std::runtime_error("exr tile size must be 0 (scanlines) or positive");
+
+	const size_t width = image.getWidth(0);
+	const size_t height = image.getHeight(0);
+	size_t dataSize = 0;
+	const float* rgba = reinterpret_cast<const float*>(image.getData(0, 0, dataSize));
+
+	// channels are expected in alphabetical order. Y (luminance) stores the red channel
+	static const char* s_names[] = { "A", "B", "G", "R" };
+	static const int s_sources[] = { 3, 2, 1, 0 };
+	const int firstChannel = numChannels == 4 ? 0 : 1;
+
+	std::vector<EXRChannelInfo> channels(numChannels);
+	std::vector<int> pixelTypes(numChannels, TINYEXR_PIXELTYPE_FLOAT); // tinyexr converts the float planes
+	std::vector<int> requestedTypes(numChannels, pixelType);
+	std::vector<int> sources(numChannels);
+	for (int c = 0; c < numChannels; ++c)
+	{
+		const char* name = numChannels == 1 ? "Y" : s_names[firstChannel + c];
+		strncpy(channels[c].name, name, sizeof(channels[c].name) - 1);
+		sources[c] = numChannels == 1 ? 0 : s_sources[firstChannel + c];
+	}
+
+	// tinyexr expects one plane per channel
+	std::vector<std::vector<float>> planes(numChannels, std::vector<float>(width * height));
+	image::parallelRanges(height, [&](size_t begin, size_t end, size_t)
+	{
+		for (size_t i = begin * width; i < end * width; ++i)
+			for (int c = 0; c < numChannels; ++c)
+				planes[c][i] = rgba[i * 4 + sources[c]];
+	}, s_minParallelRows);
+	std::vector<unsigned char*> images(numChannels);
+	for (int c = 0; c < numChannels; ++c)
+		images[c] = reinterpret_cast<unsigned char*>(planes[c].data());
+
+	EXRHeader header;
+	InitEXRHeader(&header);
+	header.num_channels = numChannels;
+	header.channels = channels.data();
+	header.pixel_types = pixelTypes.data();
+	header.requested_pixel_types = requestedTypes.data();
+	header.compression_type = compression;
+	if (tileSize > 0)
+	{
+		header.tiled = 1;
+		header.tile_size_x = tileSize;
+		header.tile_size_y = tileSize;
+		header.tile_level_mode = TINYEXR_TILE_ONE_LEVEL;
+		header.tile_rounding_mode = TINYEXR_TILE_ROUND_DOWN;
+	}
+
+	EXRImage exrImage;
+	InitEXRImage(&exrImage);
+	exrImage.num_channels = numChannels;
+	exrImage.images = images.data();
+	exrImage.width = int(width);
+	exrImage.height = int(height);
+
+	set_progress(0);
+	const char* err = nullptr;
+	// the header and image only reference the vectors above => they must not be freed with FreeEXRHeader/FreeEXRImage
+	if (SaveEXRImageToFile(&exrImage, &header, filename, &err) != TINYEXR_SUCCESS)
+	{
+		std::string msg = err ? err : "could not write exr file";
+		if (err) FreeEXRErrorMessage(err);
+		throw std::runtime_error(msg);
+	}
+}
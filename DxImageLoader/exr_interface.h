@@ -2,4 +2,10 @@
 #include "Image.h"
 #include <memory>
 
-std::unique_ptr<image::IImage> openexr_load(const char* filename);
\ No newline at end of file
+std::unique_ptr<image::IImage> openexr_load(const char* filename);
+
+std::vector<uint32_t> openexr_get_export_formats();
+
+// writes the RGBA32F image with the channels (RGBA, RGB or Y = red channel) and pixel type (half or float) of format.
+// Compression and tiling are controlled by the "exr compression" and "exr tile size" global parameters
+void openexr_save(const char* filename, image::IImage& image, gli::format format);
\ No newline at end of file
@@ -5,6 +5,12 @@
 #include "compress_interface.h"
 #include "ktx_interface.h"
 #include "GliImage.h"
+#include "interface.h"
+#include <algorithm>
+#include <cstring>
+
+// larger previews would take too long to convert
+static constexpr uint32_t s_maxPreviewSize = 512;
 
 
 std::unique_ptr<image::IImage> gli_load(const char* filename)
@@ -13,9 +19,39 @@ std::unique_ptr<image::IImage> gli_load(const char* filename)
 
 	if (image::isSupported(res->getFormat())) return res;
 
+	gli_preview_mipmap(*res, false);
 	return res->convert(image::getSupportedFormat(res->getFormat()), 100);
 }
 
+void gli_preview_mipmap(const GliImage& image, bool flip)
+{
+	if (!wants_preview() || image.getNumMipmaps() < 2) return;
+
+	// largest mipmap (except mip 0) that fits into the preview size
+	uint32_t mip = 1;
+	while (mip + 1 < image.getNumMipmaps() && std::max(image.getWidth(mip), image.getHeight(mip)) > s_maxPreviewSize)
+		++mip;
+
+	// first slice of the first layer
+	GliImage small(image.getFormat(), image.getOriginalFormat(), 1, 1, 1, image.getWidth(mip), image.getHeight(mip), 1);
+	size_t srcSize, dstSize;
+	const uint8_t* src = image.getData(0, mip, srcSize);
+	uint8_t* dst = small.getData(0, 0, dstSize);
+	std::memcpy(dst, src, std::min(srcSize, dstSize));
+
+	auto converted = small.convert(image::getSupportedFormat(small.getFormat()), 100);
+	if (flip) converted->flip();
+
+	ImagePreview preview = {};
+	preview.data = converted->getData(0, 0, dstSize);
+	preview.width = converted->getWidth(0);
+	preview.height = converted->getHeight(0);
+	preview.format = uint32_t(converted->getFormat());
+	preview.numRows = preview.height;
+	preview.stage = IMAGE_PREVIEW_MIPMAP;
+	set_preview(preview);
+}
+
 std::vector<uint32_t> dds_get_export_formats()
 {
 	// note: some bgra formats are disabled because im not sure if the default dds loader or gli stores them incorrectly
@@ -175,14 +211,19 @@ void gli_save_image(const char* filename, GliImage& image, gli::format format, b
 	else res->saveDds(filename);
 }
 
+// gli::gl builds its translation table for all formats in the constructor => create it only once
+static gli::gl& get_gl()
+{
+	static gli::gl s_gl(gli::gl::PROFILE_GL33);
+	return s_gl;
+}
+
 gli::format get_format_from_GL(uint32_t internalFormat, uint32_t externalFormat, uint32_t type)
 {
-	gli::gl GL(gli::gl::PROFILE_GL33);
-	return GL.find(gli::gl::internal_format(internalFormat), gli::gl::external_format(externalFormat), gli::gl::type_format(type));
+	return get_gl().find(gli::gl::internal_format(internalFormat), gli::gl::external_format(externalFormat), gli::gl::type_format(type));
 }
 
 uint32_t get_gl_format(gli::format format)
 {
-	gli::gl GL(gli::gl::PROFILE_GL33);
-	return uint32_t(GL.translate(format, gli::swizzles()).Internal);
+	return uint32_t(get_gl().translate(format, gli::swizzles()).Internal);
 }
\ No newline at end of file
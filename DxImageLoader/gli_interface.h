@@ -5,6 +5,10 @@
 
 std::unique_ptr<image::IImage> gli_load(const char* filename);
 
+// reports a small mipmap of the first layer in a supported format as preview (see image_open_progressive).
+// Used before the full image is converted
+void gli_preview_mipmap(const GliImage& image, bool flip);
+
 std::vector<uint32_t> dds_get_export_formats();
 
 void gli_save_image(const char* filename, GliImage& image, gli::format format, bool ktx, int quality);
@@ -1,40 +1,154 @@
 #include "pch.h"
 #include "hdr_interface.h"
 #include <stdexcept>
+#include <array>
 
-#include "convert.h"
+#include "parallel.h"
 #include "../dependencies/hdr/rgbe.h"
 
+// scanlines per thread. Scanlines of environment maps are usually a few thousand pixels wide
+static constexpr size_t s_minParallelScanlines = 16;
+// scanlines that are decoded between two previews
+static constexpr size_t s_previewBandScanlines = 256;
+// new style run length encoding is only defined for these scanline widths
+static constexpr int s_minRleWidth = 8;
+static constexpr int s_maxRleWidth = 0x7fff;
+
+// location of an encoded scanline within the file data
+struct HdrScanline
+{
+	size_t offset; // offset of the first pixel byte (after the 4 byte header for run length encoded scanlines)
+	bool rle; // new style run length encoding (channels are stored separately). Otherwise flat rgbe pixels
+};
+
+static bool hdr_uses_rle(int width)
+{
+	return width >= s_minRleWidth && width <= s_maxRleWidth;
+}
+
+// reads everything after the header
+static std::vector<uint8_t> hdr_read_remaining(FILE* fp)
+{
+	std::vector<uint8_t> data;
+	constexpr size_t chunkSize = 1 << 20;
+	size_t size = 0;
+	while (true)
+	{
+		data.resize(size + chunkSize);
+		const size_t numRead = fread(data.data() + size, 1, chunkSize, fp);
+		size += numRead;
+		if (numRead < chunkSize) break;
+	}
+	if (ferror(fp))
+		throw rgbe_error(rgbe_read_error, nullptr);
+	data.resize(size);
+	return data;
+}
+
+// first pass: finds the start of each scanline by skipping over the runs without decoding them.
+// Like RGBE_ReadPixels_RLE, all scanlines after the first scanline without the run length header are read as flat pixels
+static std::vector<HdrScanline> hdr_index_scanlines(const std::vector<uint8_t>& data, int width, int height)
+{
+	std::vector<HdrScanline> scanlines(height);
+	const size_t flatSize = size_t(width) * 4;
+	const bool rleWidth = hdr_uses_rle(width);
+	size_t pos = 0;
+	bool rle = rleWidth;
+	for (int y = 0; y < height; ++y)
+	{
+		if (rle)
+		{
+			if (pos + 4 > data.size())
+				throw rgbe_error(rgbe_read_error, nullptr);
+			const uint8_t* header = &data[pos];
+			rle = header[0] == 2 && header[1] == 2 && !(header[2] & 0x80);
+		}
+		if (!rle)
+		{
+			// remaining scanlines are flat
+			if (data.size() - pos < flatSize * size_t(height - y))
+				throw rgbe_error(rgbe_read_error, nullptr);
+			for (; y < height; ++y, pos += flatSize)
+				scanlines[y] = { pos, false };
+			break;
+		}
+
+		if (((int(data[pos + 2]) << 8) | data[pos + 3]) != width)
+			throw rgbe_error(rgbe_format_error, "wrong scanline width");
+		pos += 4;
+		scanlines[y] = { pos, true };
+
+		for (int c = 0; c < 4; ++c)
+		{
+			int remaining = width;
+			while (remaining > 0)
+			{
+				if (pos + 2 > data.size())
+					throw rgbe_error(rgbe_read_error, nullptr);
+				int count = data[pos];
+				const bool run = count > 128;
+				if (run) count -= 128;
+				if (count == 0 || count > remaining)
+					throw rgbe_error(rgbe_format_error, "bad scanline data");
+				pos += run ? 2 : 1 + size_t(count);
+				remaining -= count;
+			}
+		}
+		if (pos > data.size())
+			throw rgbe_error(rgbe_read_error, nullptr);
+	}
+	return scanlines;
+}
+
+// rgbe2float with a table for the exponent (a zero exponent yields black)
+static const std::array<float, 256>& hdr_exponent_table()
+{
+	static const std::array<float, 256> s_table = []()
+	{
+		std::array<float, 256> table;
+		table[0] = 0.0f;
+		for (int e = 1; e < 256; ++e)
+			table[e] = float(ldexp(1.0, e - int(128 + 8)));
+		return table;
+	}();
+	return s_table;
+}
+
+// decodes a run length encoded scanline (that was validated by hdr_index_scanlines) into separate channel planes
+static void hdr_decode_rle(const uint8_t* src, uint8_t* planes, int width)
+{
+	uint8_t* dst = planes;
+	const uint8_t* end = planes + size_t(width) * 4;
+	while (dst < end)
+	{
+		int count = *src++;
+		if (count > 128)
+		{
+			count -= 128;
+			memset(dst, *src++, count);
+		}
+		else
+		{
+			memcpy(dst, src, count);
+			src += count;
+		}
+		dst += count;
+	}
+}
+
 std::unique_ptr<image::IImage> hdr_load(const char* filename)
 {
-	std::unique_ptr<image::IImage> res;
 	FILE* fp = fopen(filename, "rb");
 	if (!fp)
 		throw std::runtime_error("could not open file");
 
-	int width, heigth;
+	int width, height;
 	rgbe_header_info header;
+	std::vector<uint8_t> data;
 	try
 	{
-		RGBE_ReadHeader(fp, &width, &heigth, &header);
-
-		// create file (add alpha channel for staging purposes)
-		res.reset(new image::SimpleImage(
-			gli::format::FORMAT_RGB32_SFLOAT_PACK32,
-			gli::format::FORMAT_RGBA32_SFLOAT_PACK32,
-			width, heigth, 4 * 4
-		));
-
-		
-		size_t dataSize = 0;
-		auto dataPtr = res->getData(0, 0, dataSize);
-		float* floatPtr = reinterpret_cast<float*>(dataPtr);
-		RGBE_ReadPixels_RLE(fp, floatPtr, width, heigth);
-
-		// fix alignment
-		image::expandRGBtoRGBA(floatPtr, width * heigth, 1.0f);
-
-		// TODO handle gamma and exposure parameters
+		RGBE_ReadHeader(fp, &width, &height, &header);
+		data = hdr_read_remaining(fp);
 	}
 	catch(...)
 	{
@@ -43,6 +157,85 @@ std::unique_ptr<image::IImage> hdr_load(const char* filename)
 	}
 	fclose(fp);
 
+	if (width <= 0 || height <= 0)
+		throw rgbe_error(rgbe_format_error, "invalid image size");
+
+	set_progress(0);
+	const auto scanlines = hdr_index_scanlines(data, width, height);
+
+	// rgb data is directly expanded to rgba (alpha channel for staging purposes)
+	std::unique_ptr<image::IImage> res(new image::SimpleImage(
+		gli::format::FORMAT_RGB32_SFLOAT_PACK32,
+		gli::format::FORMAT_RGBA32_SFLOAT_PACK32,
+		width, height, 4 * 4
+	));
+	size_t dataSize = 0;
+	float* dstData = reinterpret_cast<float*>(res->getData(0, 0, dataSize));
+	const auto& exponent = hdr_exponent_table();
+
+	ImagePreview preview = {};
+	preview.data = reinterpret_cast<const uint8_t*>(dstData);
+	preview.width = uint32_t(width);
+	preview.height = uint32_t(height);
+	preview.format = uint32_t(gli::format::FORMAT_RGBA32_SFLOAT_PACK32);
+	preview.stage = IMAGE_PREVIEW_ROWS;
+
+	// the scanlines are decoded in bands (a single band without previews). Each band is decoded in parallel
+	const size_t bandSize = wants_preview() ? s_previewBandScanlines : size_t(height);
+	for (size_t band = 0; band < size_t(height); band += bandSize)
+	{
+		const size_t bandEnd = std::min(band + bandSize, size_t(height));
+		image::parallelRanges(bandEnd - band, [&](size_t rangeBegin, size_t rangeEnd, size_t rangeIndex)
+		{
+			std::vector<uint8_t> planes(size_t(width) * 4);
+			const size_t begin = band + rangeBegin;
+			const size_t end = band + rangeEnd;
+			for (size_t y = begin; y < end; ++y)
+			{
+				const auto& line = scanlines[y];
+				float* dst = dstData + y * size_t(width) * 4;
+				if (line.rle)
+				{
+					hdr_decode_rle(&data[line.offset], planes.data(), width);
+					const uint8_t* r = planes.data();
+					const uint8_t* g = r + width;
+					const uint8_t* b = g + width;
+					const uint8_t* e = b + width;
+					for (int x = 0; x < width; ++x, dst += 4)
+					{
+						const float f = exponent[e[x]];
+						dst[0] = r[x] * f;
+						dst[1] = g[x] * f;
+						dst[2] = b[x] * f;
+						dst[3] = 1.0f;
+					}
+				}
+				else
+				{
+					const uint8_t* src = &data[line.offset];
+					for (int x = 0; x < width; ++x, src += 4, dst += 4)
+					{
+						const float f = exponent[src[3]];
+						dst[0] = src[0] * f;
+						dst[1] = src[1] * f;
+						dst[2] = src[2] * f;
+						dst[3] = 1.0f;
+					}
+				}
+
+				// set_progress is not thread safe => report progress of the first range (scaled to the band)
+				if (rangeIndex == 0)
+					set_progress(uint32_t((band + (y - begin + 1) * (bandEnd - band) / (end - begin)) * 100 / size_t(height)));
+			}
+		}, s_minParallelScanlines);
+
+		preview.numRows = uint32_t(bandEnd);
+		if (bandEnd < size_t(height))
+			set_preview(preview);
+	}
+
+	// TODO handle gamma and exposure parameters
+
 	return res;
 }
 
@@ -53,16 +246,102 @@ std::vector<uint32_t> hdr_get_export_formats()
 	};
 }
 
+// RGBE_WriteBytes_RLE that appends to dst
+static void hdr_encode_rle(const uint8_t* data, int numBytes, std::vector<uint8_t>& dst)
+{
+	constexpr int minRunLength = 4;
+	int cur = 0;
+	while (cur < numBytes)
+	{
+		int begRun = cur;
+		// find next run of length at least 4 if one exists
+		int runCount = 0, oldRunCount = 0;
+		while (runCount < minRunLength && begRun < numBytes)
+		{
+			begRun += runCount;
+			oldRunCount = runCount;
+			runCount = 1;
+			while (begRun + runCount < numBytes && runCount < 127 && data[begRun] == data[begRun + runCount])
+				runCount++;
+		}
+		// if data before next big run is a short run then write it as such
+		if (oldRunCount > 1 && oldRunCount == begRun - cur)
+		{
+			dst.push_back(uint8_t(128 + oldRunCount));
+			dst.push_back(data[cur]);
+			cur = begRun;
+		}
+		// write out bytes until we reach the start of the next run
+		while (cur < begRun)
+		{
+			const int nonRunCount = std::min(begRun - cur, 128);
+			dst.push_back(uint8_t(nonRunCount));
+			dst.insert(dst.end(), data + cur, data + cur + nonRunCount);
+			cur += nonRunCount;
+		}
+		// write out next run if one was found
+		if (runCount >= minRunLength)
+		{
+			dst.push_back(uint8_t(128 + runCount));
+			dst.push_back(data[begRun]);
+			cur += runCount;
+		}
+	}
+}
+
 void hdr_write(image::IImage& image, const char* filename)
 {
 	if(image.getFormat() != gli::FORMAT_RGBA32_SFLOAT_PACK32)
 		throw std::runtime_error("expected RGBA32F image format for hdr export");
 
+	const int width = int(image.getWidth(0));
+	const int height = int(image.getHeight(0));
 	size_t dataSize = 0;
-	auto dataPtr = image.getData(0, 0, dataSize);
+	const float* srcData = reinterpret_cast<const float*>(image.getData(0, 0, dataSize));
+	const bool rle = hdr_uses_rle(width);
+
+	set_progress(0);
+
+	// each range encodes its scanlines into its own buffer. The buffers are written in order afterwards
+	std::vector<std::vector<uint8_t>> encoded(image::getNumThreads());
+	const size_t numRanges = image::parallelRanges(size_t(height), [&](size_t begin, size_t end, size_t rangeIndex)
+	{
+		auto& dst = encoded[rangeIndex];
+		dst.reserve((end - begin) * size_t(width) * 4);
+		std::vector<uint8_t> planes(size_t(width) * 4);
+		uint8_t rgbe[4];
+		for (size_t y = begin; y < end; ++y)
+		{
+			const float* src = srcData + y * size_t(width) * 4;
+			if (rle)
+			{
+				for (int x = 0; x < width; ++x, src += 4)
+				{
+					float2rgbe(rgbe, src[RGBE_DATA_RED], src[RGBE_DATA_GREEN], src[RGBE_DATA_BLUE]);
+					for (int c = 0; c < 4; ++c)
+						planes[x + c * width] = rgbe[c];
+				}
+				const uint8_t header[4] = { 2, 2, uint8_t(width >> 8), uint8_t(width & 0xFF) };
+				dst.insert(dst.end(), header, header + 4);
+				// each of the four channels is run length encoded separately
+				for (int c = 0; c < 4; ++c)
+					hdr_encode_rle(&planes[c * width], width, dst);
+			}
+			else
+			{
+				// run length encoding is not allowed so write flat
+				for (int x = 0; x < width; ++x, src += 4)
+				{
+					float2rgbe(rgbe, src[RGBE_DATA_RED], src[RGBE_DATA_GREEN], src[RGBE_DATA_BLUE]);
+					dst.insert(dst.end(), rgbe, rgbe + 4);
+				}
+			}
 
-	// adjust stride of RGBA float data to RGB float
-	image::changeStride(dataPtr, dataSize, 16, 12);
+			// set_progress is not thread safe => report progress of the first range
+			if (rangeIndex == 0)
+				set_progress(uint32_t(((y - begin + 1) * 100) / (end - begin)));
+		}
+	}, s_minParallelScanlines);
 
 	FILE* fp = fopen(filename, "wb");
 	if (!fp)
@@ -70,15 +349,19 @@ void hdr_write(image::IImage& image, const char* filename)
 
 	try
 	{
-		RGBE_WriteHeader(fp, image.getWidth(0), image.getHeight(0), nullptr);
-
-		auto floatPtr = reinterpret_cast<float*>(dataPtr);
-		RGBE_WritePixels_RLE(fp, floatPtr, image.getWidth(0), image.getHeight(0));
+		RGBE_WriteHeader(fp, width, height, nullptr);
+		for (size_t i = 0; i < numRanges; ++i)
+		{
+			const auto& buffer = encoded[i];
+			if (!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), fp) != buffer.size())
+				throw rgbe_error(rgbe_write_error, nullptr);
+		}
 	}
 	catch(...)
 	{
 		fclose(fp);
 		throw;
 	}
-	fclose(fp);
+	if (fclose(fp) != 0)
+		throw rgbe_error(rgbe_write_error, nullptr);
 }
@@ -0,0 +1,378 @@
+#include "pch.h"
+#include "histogram_interface.h"
+#include "parallel.h"
+#include "ByteTable.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+// percentiles are computed without sorting the image:
+// - 8 bit formats: one pass with exact bins for every byte value
+// - float formats (and luminance): the first pass builds a histogram of the upper 16 bits of an order preserving integer key
+//   of the float values. These bins are log-spaced (sign, exponent and 7 mantissa bits).
+//   The second pass only considers values inside the bins of the requested ranks and histograms the lower 16 bits.
+//   This gives the exact values of the ranks.
+
+namespace
+{
+	constexpr size_t s_numKeyBins = 1 << 16;
+	// coarse bins that are refined by a single pass over the image (4 MB of counters per thread).
+	// Many percentiles in different coarse bins need multiple passes, but the memory stays bounded
+	constexpr size_t s_maxFineBinsPerPass = 16;
+
+	// order preserving mapping of floats to unsigned integers
+	uint32_t toKey(float v)
+	{
+		uint32_t u;
+		std::memcpy(&u, &v, sizeof(u));
+		return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+	}
+
+	float fromKey(uint32_t key)
+	{
+		const uint32_t u = (key & 0x80000000u) ? (key & 0x7FFFFFFFu) : ~key;
+		float v;
+		std::memcpy(&v, &u, sizeof(v));
+		return v;
+	}
+
+	// rows of one mipmap of all selected layers
+	class ChannelRows
+	{
+	public:
+		ChannelRows(const image::IImage& image, int layer, uint32_t mipmap, uint32_t channel) :
+			m_format(image.getFormat()),
+			m_table(image::getByteTable(image.getFormat())),
+			m_channel(channel)
+		{
+			if (!image::isSupported(image.getFormat()))
+				throw std::runtime_error("histogram: unsupported image format");
+			if (mipmap >= image.getNumMipmaps())
+				throw std::runtime_error("histogram: invalid mipmap");
+			if (layer >= int(image.getNumLayers()) || layer < -1)
+				throw std::runtime_error("histogram: invalid layer");
+			if (channel > IMAGE_CHANNEL_LUMINANCE)
+				throw std::runtime_error("histogram: invalid channel");
+
+			const uint32_t firstLayer = layer < 0 ? 0 : uint32_t(layer);
+			const uint32_t numLayers = layer < 0 ? image.getNumLayers() : 1;
+			m_width = image.getWidth(mipmap);
+			m_rowsPerLayer = size_t(image.getHeight(mipmap)) * image.getDepth(mipmap);
+			m_rowSize = m_width * image::pixelSize(m_format);
+
+			// resolve layer pointers upfront, getData does not need to be thread safe
+			for (uint32_t i = 0; i < numLayers; ++i)
+			{
+				size_t size;
+				m_layers.push_back(image.getData(firstLayer + i, mipmap, size));
+			}
+		}
+
+		size_t numRows() const { return m_rowsPerLayer * m_layers.size(); }
+		size_t width() const { return m_width; }
+
+		// true if the channel can be processed with exact byte bins
+		bool hasByteValues() const { return m_format != gli::FORMAT_RGBA32_SFLOAT_PACK32 && m_channel != IMAGE_CHANNEL_LUMINANCE; }
+		// value of the byte bin
+		float byteValue(uint8_t v) const { return m_channel == IMAGE_CHANNEL_ALPHA ? m_table.alpha[v] : m_table.color[v]; }
+
+		const uint8_t* row(size_t r) const
+		{
+			return m_layers[r / m_rowsPerLayer] + (r % m_rowsPerLayer) * m_rowSize;
+		}
+
+		// writes the channel values of the row into dst
+		void load(size_t r, float* dst) const
+		{
+			const uint8_t* src = row(r);
+			if (m_format == gli::FORMAT_RGBA32_SFLOAT_PACK32)
+			{
+				const float* px = reinterpret_cast<const float*>(src);
+				if (m_channel == IMAGE_CHANNEL_LUMINANCE)
+				{
+					for (size_t x = 0; x < m_width; ++x, px += 4)
+						dst[x] = px[3] * (0.2125f * px[0] + 0.7154f * px[1] + 0.0721f * px[2]);
+				}
+				else
+				{
+					for (size_t x = 0; x < m_width; ++x, px += 4)
+						dst[x] = px[m_channel];
+				}
+				return;
+			}
+
+			if (m_channel == IMAGE_CHANNEL_LUMINANCE)
+			{
+				for (size_t x = 0; x < m_width; ++x, src += 4)
+					dst[x] = m_table.alpha[src[3]] * (0.2125f * m_table.color[src[0]] + 0.7154f * m_table.color[src[1]] + 0.0721f * m_table.color[src[2]]);
+				return;
+			}
+
+			for (size_t x = 0; x < m_width; ++x, src += 4)
+				dst[x] = byteValue(src[m_channel]);
+		}
+
+	private:
+		gli::format m_format;
+		const image::ByteTable& m_table;
+		uint32_t m_channel;
+		size_t m_width = 0;
+		size_t m_rowsPerLayer = 0;
+		size_t m_rowSize = 0;
+		std::vector<const uint8_t*> m_layers;
+	};
+
+	size_t minRowsPerRange(size_t width)
+	{
+		return std::max<size_t>(16384 / std::max<size_t>(width, 1), 1);
+	}
+
+	// builds one histogram per thread with bin(value) and merges them. bin returns numBins for values that should be ignored
+	template<class BinFunc>
+	std::vector<uint64_t> buildHistogram(const ChannelRows& rows, size_t numBins, BinFunc bin)
+	{
+		std::vector<std::vector<uint64_t>> histograms(image::getNumThreads());
+		image::parallelRanges(rows.numRows(), [&](size_t begin, size_t end, size_t rangeIndex)
+		{
+			auto& hist = histograms[rangeIndex];
+			hist.assign(numBins + 1, 0);
+			std::vector<float> values(rows.width());
+			for (size_t r = begin; r < end; ++r)
+			{
+				rows.load(r, values.data());
+				for (const float v : values)
+					++hist[bin(v)];
+			}
+		}, minRowsPerRange(rows.width()));
+
+		std::vector<uint64_t> res(numBins + 1, 0);
+		for (const auto& hist : histograms)
+			for (size_t i = 0; i < hist.size(); ++i)
+				res[i] += hist[i];
+		res.pop_back(); // ignored values
+		return res;
+	}
+
+	// ranks that need to be resolved for linear interpolation of the percentiles
+	struct PercentileRanks
+	{
+		uint64_t lower;
+		uint64_t upper;
+		double t;
+	};
+
+	std::vector<PercentileRanks> getRanks(const float* percentiles, size_t numPercentiles, uint64_t count)
+	{
+		std::vector<PercentileRanks> res(numPercentiles);
+		for (size_t i = 0; i < numPercentiles; ++i)
+		{
+			const double p = std::min(std::max(double(percentiles[i]), 0.0), 100.0);
+			const double pos = p / 100.0 * double(count - 1);
+			res[i].lower = uint64_t(pos);
+			res[i].upper = std::min(res[i].lower + 1, count - 1);
+			res[i].t = pos - double(res[i].lower);
+		}
+		return res;
+	}
+
+	float interpolate(float lower, float upper, double t)
+	{
+		if (t == 0.0 || lower == upper) return lower;
+		return float(double(lower) + t * (double(upper) - double(lower)));
+	}
+}
+
+void histogram_compute(const image::IImage& image, int layer, uint32_t mipmap, uint32_t channel, float minValue, float maxValue, bool logarithmic, size_t numBins, uint64_t* bins)
+{
+	const ChannelRows rows(image, layer, mipmap, channel);
+	if (numBins == 0)
+		throw std::runtime_error("histogram: invalid number of bins");
+	if (!(minValue < maxValue))
+		throw std::runtime_error("histogram: invalid value range");
+	if (logarithmic && !(minValue > 0.0f))
+		throw std::runtime_error("histogram: logarithmic bins require a positive minimum");
+
+	const double lastBin = double(numBins - 1);
+	std::vector<uint64_t> res;
+	if (logarithmic)
+	{
+		const double logMin = std::log(double(minValue));
+		const double scale = double(numBins) / (std::log(double(maxValue)) - logMin);
+		res = buildHistogram(rows, numBins, [=](float v)
+		{
+			if (std::isnan(v)) return numBins;
+			if (v <= minValue) return size_t(0);
+			return size_t(std::min((std::log(double(v)) - logMin) * scale, lastBin));
+		});
+	}
+	else
+	{
+		const double scale = double(numBins) / (double(maxValue) - double(minValue));
+		res = buildHistogram(rows, numBins, [=](float v)
+		{
+			if (std::isnan(v)) return numBins;
+			return size_t(std::min(std::max((double(v) - double(minValue)) * scale, 0.0), lastBin));
+		});
+	}
+
+	std::copy(res.begin(), res.end(), bins);
+}
+
+void histogram_percentiles(const image::IImage& image, int layer, uint32_t mipmap, uint32_t channel, const float* percentiles, size_t numPercentiles, float* results)
+{
+	const ChannelRows rows(image, layer, mipmap, channel);
+	if (numPercentiles == 0) return;
+
+	if (rows.hasByteValues())
+	{
+		// exact bins for every byte value
+		std::vector<std::array<uint64_t, 256>> histograms(image::getNumThreads());
+		image::parallelRanges(rows.numRows(), [&](size_t begin, size_t end, size_t rangeIndex)
+		{
+			auto& hist = histograms[rangeIndex];
+			hist.fill(0);
+			for (size_t r = begin; r < end; ++r)
+			{
+				const uint8_t* src = rows.row(r) + channel;
+				for (size_t x = 0; x < rows.width(); ++x)
+					++hist[src[4 * x]];
+			}
+		}, minRowsPerRange(rows.width()));
+
+		std::array<uint64_t, 256> counts = {};
+		for (const auto& hist : histograms)
+			for (size_t i = 0; i < 256; ++i)
+				counts[i] += hist[i];
+
+		// snorm bytes are not ordered by value
+		std::array<uint8_t, 256> order;
+		std::iota(order.begin(), order.end(), uint8_t(0));
+		std::stable_sort(order.begin(), order.end(), [&](uint8_t a, uint8_t b) { return rows.byteValue(a) < rows.byteValue(b); });
+
+		const uint64_t count = std::accumulate(counts.begin(), counts.end(), uint64_t(0));
+		auto valueOfRank = [&](uint64_t rank)
+		{
+			uint64_t sum = 0;
+			for (const auto b : order)
+			{
+				sum += counts[b];
+				if (rank < sum) return rows.byteValue(b);
+			}
+			return rows.byteValue(order.back());
+		};
+
+		const auto ranks = getRanks(percentiles, numPercentiles, std::max<uint64_t>(count, 1));
+		for (size_t i = 0; i < numPercentiles; ++i)
+			results[i] = interpolate(valueOfRank(ranks[i].lower), valueOfRank(ranks[i].upper), ranks[i].t);
+		return;
+	}
+
+	// first pass: log-spaced bins (upper 16 bits of the key)
+	const auto coarse = buildHistogram(rows, s_numKeyBins, [](float v)
+	{
+		if (std::isnan(v)) return s_numKeyBins;
+		return size_t(toKey(v) >> 16);
+	});
+
+	const uint64_t count = std::accumulate(coarse.begin(), coarse.end(), uint64_t(0));
+	if (count == 0)
+	{
+		std::fill(results, results + numPercentiles, std::numeric_limits<float>::quiet_NaN());
+		return;
+	}
+
+	const auto ranks = getRanks(percentiles, numPercentiles, count);
+
+	// find the coarse bins of all ranks
+	struct Target
+	{
+		uint64_t rank; // rank within the coarse bin
+		size_t fineIndex; // index of the fine histogram
+		float value;
+	};
+	std::vector<uint64_t> prefix(s_numKeyBins + 1, 0);
+	std::partial_sum(coarse.begin(), coarse.end(), prefix.begin() + 1);
+
+	std::vector<int32_t> fineIndex(s_numKeyBins, -1);
+	std::vector<uint32_t> fineBins; // coarse bin of each fine histogram
+	auto makeTarget = [&](uint64_t rank)
+	{
+		const size_t bin = size_t(std::upper_bound(prefix.begin() + 1, prefix.end(), rank) - (prefix.begin() + 1));
+		if (fineIndex[bin] < 0)
+		{
+			fineIndex[bin] = int32_t(fineBins.size());
+			fineBins.push_back(uint32_t(bin));
+		}
+		return Target{ rank - prefix[bin], size_t(fineIndex[bin]), 0.0f };
+	};
+	std::vector<Target> lower;
+	std::vector<Target> upper;
+	for (const auto& r : ranks)
+	{
+		lower.push_back(makeTarget(r.lower));
+		upper.push_back(makeTarget(r.upper));
+	}
+
+	// further passes: only values inside the target bins (lower 16 bits of the key).
+	// Each pass refines at most s_maxFineBinsPerPass coarse bins
+	std::vector<std::vector<uint32_t>> fine(image::getNumThreads());
+	std::vector<uint64_t> merged;
+	for (size_t first = 0; first < fineBins.size(); first += s_maxFineBinsPerPass)
+	{
+		const size_t numFine = std::min(s_maxFineBinsPerPass, fineBins.size() - first);
+		image::parallelRanges(rows.numRows(), [&](size_t begin, size_t end, size_t rangeIndex)
+		{
+			auto& hist = fine[rangeIndex];
+			hist.assign(numFine * s_numKeyBins, 0);
+			std::vector<float> values(rows.width());
+			for (size_t r = begin; r < end; ++r)
+			{
+				rows.load(r, values.data());
+				for (const float v : values)
+				{
+					if (std::isnan(v)) continue;
+					const uint32_t key = toKey(v);
+					const size_t idx = size_t(fineIndex[key >> 16]) - first; // wraps around for -1 and earlier passes
+					if (idx < numFine) ++hist[idx * s_numKeyBins + (key & 0xFFFF)];
+				}
+			}
+		}, minRowsPerRange(rows.width()));
+
+		merged.assign(numFine * s_numKeyBins, 0);
+		for (auto& hist : fine)
+		{
+			for (size_t i = 0; i < hist.size(); ++i)
+				merged[i] += hist[i];
+			hist.clear();
+		}
+
+		auto resolve = [&](Target& t)
+		{
+			if (t.fineIndex < first || t.fineIndex >= first + numFine) return;
+			const uint64_t* hist = merged.data() + (t.fineIndex - first) * s_numKeyBins;
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < s_numKeyBins; ++i)
+			{
+				sum += hist[i];
+				if (t.rank < sum)
+				{
+					t.value = fromKey((fineBins[t.fineIndex] << 16) | i);
+					return;
+				}
+			}
+		};
+
+		for (size_t i = 0; i < numPercentiles; ++i)
+		{
+			resolve(lower[i]);
+			resolve(upper[i]);
+		}
+	}
+
+	for (size_t i = 0; i < numPercentiles; ++i)
+		results[i] = interpolate(lower[i].value, upper[i].value, ranks[i].t);
+}
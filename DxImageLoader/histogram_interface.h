@@ -0,0 +1,12 @@
+#pragma once
+#include "Image.h"
+#include "interface.h"
+
+// computes numBins bins between minValue and maxValue of the channel (see ImageChannel).
+// values outside of the range are counted in the first/last bin, NaNs are ignored.
+// logarithmic spacing requires minValue > 0, values <= minValue are counted in the first bin
+void histogram_compute(const image::IImage& image, int layer, uint32_t mipmap, uint32_t channel, float minValue, float maxValue, bool logarithmic, size_t numBins, uint64_t* bins);
+
+// computes the percentiles ([0, 100]) of the channel (see ImageChannel) with linear interpolation between the closest ranks.
+// NaNs are ignored. layer = -1 uses all layers of the mipmap
+void histogram_percentiles(const image::IImage& image, int layer, uint32_t mipmap, uint32_t channel, const float* percentiles, size_t numPercentiles, float* results);
@@ -4,6 +4,7 @@
 #include <memory>
 #include <algorithm>
 #include <fstream>
+#include <chrono>
 #include "Image.h"
 #include "stbi_interface.h"
 #include "gli_interface.h"
@@ -18,13 +19,43 @@
 #include "numpy_interface.h"
 #include "threadsafe_unordered_map.h"
 #include "webp_interface.h"
+#include "statistics_interface.h"
+#include "compare_interface.h"
+#include "histogram_interface.h"
+#include "combine_interface.h"
+#include "thumbnail_interface.h"
+#include "daemon_interface.h"
+#include "copy_interface.h"
+#include "watch_interface.h"
+#include "prefetch_interface.h"
+#include "jpeg_interface.h"
+#include "parallel.h"
 
 static std::atomic<int> s_currentID = 1;
 static threadsafe_unordered_map<int, image::IImage> s_resources;
 
-std::string s_error;
-static ProgressCallback s_progress_callback = nullptr;
-static uint32_t s_last_progress = -1;
+struct ImageWatch
+{
+	int imageId;
+	std::string filename;
+	ImageLoadOptions options;
+	std::vector<uint64_t> hashes; // subresource hashes of the last reload
+	std::mutex mutex; // serializes reloads
+	std::unique_ptr<FileWatcher> watcher;
+};
+static threadsafe_unordered_map<int, ImageWatch> s_watches;
+
+// the error and the progress deduplication are per thread: the exports may be called concurrently (e.g. image_save of exported frames)
+static thread_local std::string s_error;
+static std::atomic<ProgressCallback> s_progress_callback = nullptr;
+static thread_local uint32_t s_last_progress = -1;
+// number of running image_save calls
+static std::atomic<size_t> s_numSaving = 0;
+static thread_local uint32_t s_thread_last_progress = -1;
+static thread_local PreviewCallback s_thread_preview_callback = nullptr;
+static thread_local std::chrono::steady_clock::time_point s_thread_last_preview;
+// the viewer should not be busy with uploading row previews
+static constexpr std::chrono::milliseconds s_rowPreviewInterval(30);
 
 // key = extension (e.g. png), value = DXGI formats
 static std::map<std::string, std::vector<uint32_t>> s_exportFormats;
@@ -53,63 +84,60 @@ inline void assertSingleLayerMip(const image::IImage& image)
 		throw std::runtime_error("expected 2D texture (depth = 1)");
 }
 
-int image_open(const char* filename)
+std::unique_ptr<image::IImage> load_image(const char* filename, const ImageLoadOptions& options)
 {
-	// try loading the resource
 	// transform filename to lowercase for file extension check
-	s_last_progress = -1;
 	std::string fname = filename;
 	std::transform(fname.begin(), fname.end(), fname.begin(), ::tolower);
 
 	std::unique_ptr<image::IImage> res;
 
-	try
-	{
-		if (!file_exists(filename))
-			throw std::exception("unable to open file");
+	if (!file_exists(filename))
+		throw std::runtime_error("unable to open file");
 
-		if (hasEnding(fname, ".pfm"))
-		{
-			res = pfm_load(filename);
-		}
-		else if(hasEnding(fname, ".ktx") || hasEnding(fname, ".ktx2"))
-		{
-			res = ktx_load(filename);
-		}
-		else if (hasEnding(fname, ".dds"))
-		{
-			res = gli_load(filename);
-		}
-		else if (hasEnding(fname, ".exr"))
-		{
-			res = openexr_load(filename);
-		}
-		else if(hasEnding(fname, ".png"))
-		{
-			res = png_load(filename);
-		}
-		else if(hasEnding(fname, ".hdr"))
-		{
-			res = hdr_load(filename);
-		}
-		else if(hasEnding(fname, ".npy"))
-		{
-			res = numpy_load(filename);
-		}
-		else if (hasEnding(fname, ".webp"))
-		{
-			res = webp_load(filename);
-		}
-		else
-		{
-			res = stb_image_load(filename);
-		}
+	if (hasEnding(fname, ".pfm"))
+	{
+		res = pfm_load(filename);
 	}
-	catch (const std::exception& e)
+	else if(hasEnding(fname, ".ktx") || hasEnding(fname, ".ktx2"))
 	{
-		set_error(e.what());
+		res = ktx_load(filename);
 	}
-	if (!res) return 0;
+	else if (hasEnding(fname, ".dds"))
+	{
+		res = gli_load(filename);
+	}
+	else if (hasEnding(fname, ".exr"))
+	{
+		res = openexr_load(filename);
+	}
+	else if(hasEnding(fname, ".png"))
+	{
+		res = png_load(filename);
+	}
+	else if(hasEnding(fname, ".hdr"))
+	{
+		res = hdr_load(filename);
+	}
+	else if(hasEnding(fname, ".npy"))
+	{
+		res = numpy_load(filename, options);
+	}
+	else if (hasEnding(fname, ".webp"))
+	{
+		res = webp_load(filename);
+	}
+	else if (hasEnding(fname, ".jpg") || hasEnding(fname, ".jpeg"))
+	{
+		res = jpeg_load(filename);
+	}
+	else
+	{
+		res = stb_image_load(filename);
+	}
+
+	if (!res)
+		throw std::runtime_error("unable to open file");
 
 	if(res->requiresGrayscalePostprocess())
 	{
@@ -128,12 +156,157 @@ int image_open(const char* filename)
 	if (res->requiresBGRPostprocess())
 		res->applyBGRPostprocess();
 
+	if (options.format && gli::format(options.format) != res->getFormat())
+	{
+		if (!image::isSupported(gli::format(options.format)))
+			throw std::runtime_error("image format is not supported for open");
+		res = GliImage::convert(*res, gli::format(options.format), 100);
+	}
+
+	return res;
+}
+
+ImageLoadOptions get_global_load_options()
+{
+	ImageLoadOptions options = {};
+	options.npyLayout = get_global_parameter_i("npy is3D", 0) ? IMAGE_NPY_VOLUME : IMAGE_NPY_LAYERS;
+	options.npyChannels = get_global_parameter_i("npy useChannel", 1) ? IMAGE_NPY_CHANNELS_AUTO : IMAGE_NPY_CHANNELS_NONE;
+	options.firstLayer = uint32_t(get_global_parameter_i("npy firstLayer", 0));
+	const int lastLayer = get_global_parameter_i("npy lastLayer", -1);
+	if (lastLayer >= 0)
+		options.numLayers = uint32_t(lastLayer) + 1 - options.firstLayer;
+	return options;
+}
+
+std::unique_ptr<image::IImage> load_image(const char* filename)
+{
+	return load_image(filename, get_global_load_options());
+}
+
+int image_open(const char* filename)
+{
+	// try loading the resource
+	s_last_progress = -1;
+
+	std::unique_ptr<image::IImage> res;
+
+	try
+	{
+		const auto options = get_global_load_options();
+		res = prefetch_take(filename, options);
+		if (!res) res = load_image(filename, options);
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+	}
+	if (!res) return 0;
+
+	const int id = s_currentID++;
+	s_resources.insert(id, move(res));
+
+	return id;
+}
+
+int image_open_with_options(const char* filename, const ImageLoadOptions* options)
+{
+	s_last_progress = -1;
+
+	std::unique_ptr<image::IImage> res;
+
+	try
+	{
+		const ImageLoadOptions opt = options ? *options : ImageLoadOptions{};
+		res = prefetch_take(filename, opt);
+		if (!res) res = load_image(filename, opt);
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+	}
+	if (!res) return 0;
+
+	const int id = s_currentID++;
+	s_resources.insert(id, move(res));
+
+	return id;
+}
+
+int image_open_progressive(const char* filename, const ImageLoadOptions* options, PreviewCallback callback)
+{
+	s_last_progress = -1;
+	s_thread_last_preview = {};
+
+	std::unique_ptr<image::IImage> res;
+
+	try
+	{
+		// prefetched images are complete => no previews
+		const ImageLoadOptions opt = options ? *options : ImageLoadOptions{};
+		res = prefetch_take(filename, opt);
+		if (!res)
+		{
+			s_thread_preview_callback = callback;
+			res = load_image(filename, opt);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+	}
+	s_thread_preview_callback = nullptr;
+	if (!res) return 0;
+
 	const int id = s_currentID++;
 	s_resources.insert(id, move(res));
 
 	return id;
 }
 
+void image_prefetch_set_files(const char* const* filenames, int count)
+{
+	std::vector<std::string> files;
+	files.reserve(std::max(count, 0));
+	for (int i = 0; i < count; ++i)
+		files.emplace_back(filenames[i]);
+
+	prefetch_set_files(std::move(files));
+}
+
+void image_prefetch_set_cursor(int cursor, int radius, uint64_t memoryBudget)
+{
+	prefetch_set_cursor(cursor, radius, memoryBudget);
+}
+
+bool image_thumbnail(const char* filename, int maxSize, uint8_t* outRGBA, int& outWidth, int& outHeight)
+{
+	outWidth = 0;
+	outHeight = 0;
+	s_last_progress = -1;
+
+	try
+	{
+		if (maxSize <= 0)
+			throw std::runtime_error("thumbnail: invalid size");
+
+		// jpegs can be decoded at a reduced size
+		std::string fname = filename;
+		std::transform(fname.begin(), fname.end(), fname.begin(), ::tolower);
+		const auto img = hasEnding(fname, ".jpg") || hasEnding(fname, ".jpeg") ? jpeg_load_scaled(filename, uint32_t(maxSize)) : load_image(filename);
+		uint32_t width, height;
+		thumbnail_create(*img, uint32_t(maxSize), outRGBA, width, height);
+		outWidth = int(width);
+		outHeight = int(height);
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return false;
+	}
+
+	return true;
+}
+
 int image_allocate(uint32_t format, int width, int height, int depth, int layer, int mipmaps)
 {
 	auto res = std::make_unique<GliImage>(gli::format(format), layer, mipmaps, width, height, depth);
@@ -200,7 +373,114 @@ unsigned char* image_get_mipmap(int id, int layer, int mipmap, uint64_t& size)
 	if (unsigned(mipmap) >= img->getNumMipmaps())
 		return nullptr;
 
-	return img->getData(layer, mipmap, size);
+	// const getData: the caller usually only reads (uploads). Lazily decoded layers are pinned only by internal writes (image_reload)
+	return const_cast<unsigned char*>(static_cast<const image::IImage&>(*img).getData(layer, mipmap, size));
+}
+
+void image_release_mipmap(int id, int layer, int mipmap)
+{
+	auto img = s_resources.find(id);
+	if (!img)
+		return;
+
+	if (unsigned(layer) >= img->getNumLayers() || unsigned(mipmap) >= img->getNumMipmaps())
+		return;
+
+	img->releaseData(layer, mipmap);
+}
+
+bool image_copy_to(int id, int layer, int mipmap, uint8_t* dst, uint64_t dstRowPitch, uint64_t dstSlicePitch, uint32_t dstFormat, uint32_t flags)
+{
+	auto img = s_resources.find(id);
+	if (!img)
+	{
+		set_error("invalid image id");
+		return false;
+	}
+
+	try
+	{
+		const gli::format format = dstFormat ? gli::format(dstFormat) : img->getFormat();
+		copy_subresource(*img, uint32_t(layer), uint32_t(mipmap), dst, size_t(dstRowPitch), size_t(dstSlicePitch), format, flags);
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return false;
+	}
+
+	return true;
+}
+
+int image_watch(int id, const char* filename, const ImageLoadOptions* options, WatchCallback callback)
+{
+	auto img = s_resources.find(id);
+	if (!img)
+	{
+		set_error("invalid image id");
+		return 0;
+	}
+
+	const int watchId = s_currentID++;
+	try
+	{
+		auto watch = std::make_shared<ImageWatch>();
+		watch->imageId = id;
+		watch->filename = filename;
+		watch->options = options ? *options : get_global_load_options();
+		watch->hashes = watch_hash_subresources(*img);
+		if (callback)
+			watch->watcher = std::make_unique<FileWatcher>(filename, [callback, watchId]() { callback(watchId); });
+		s_watches.insert(watchId, std::move(watch));
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return 0;
+	}
+
+	return watchId;
+}
+
+void image_unwatch(int watchId)
+{
+	auto watch = s_watches.find(watchId);
+	if (!watch) return;
+	s_watches.erase(watchId);
+	// stop the thread now, a running reload might still hold a reference
+	watch->watcher.reset();
+}
+
+bool image_reload(int watchId, uint32_t* dirty, int& numDirty)
+{
+	numDirty = 0;
+	auto watch = s_watches.find(watchId);
+	if (!watch)
+	{
+		set_error("invalid watch id");
+		return false;
+	}
+
+	try
+	{
+		std::lock_guard<std::mutex> lock(watch->mutex);
+		auto img = s_resources.find(watch->imageId);
+		if (!img)
+			throw std::runtime_error("the watched image was released");
+
+		s_last_progress = -1;
+		const auto loaded = load_image(watch->filename.c_str(), watch->options);
+		const auto changed = watch_update_subresources(*img, *loaded, watch->hashes);
+		std::copy(changed.begin(), changed.end(), dirty);
+		numDirty = int(changed.size());
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return false;
+	}
+
+	return true;
 }
 
 float image_get_fps(int id)
@@ -214,6 +494,101 @@ float image_get_fps(int id)
 	return img->getFps();
 }
 
+void save_image(image::IImage& img, const std::string& filename, const std::string& ext, uint32_t format, int quality, float fps)
+{
+	const std::string fullName = filename + "." + ext;
+	if (ext == "dds")
+		gli_save_image(fullName.c_str(), dynamic_cast<GliImage&>(img), gli::format(format), false, quality);
+	else if (ext == "ktx")
+		//gli_save_image(fullName.c_str(), dynamic_cast<GliImage&>(img), gli::format(format), true, quality);
+		ktx1_save_image(fullName.c_str(), dynamic_cast<GliImage&>(img), gli::format(format), quality);
+	else if (ext == "ktx2")
+		ktx2_save_image(fullName.c_str(), dynamic_cast<GliImage&>(img), gli::format(format), quality);
+	else if(ext == "hdr")
+	{
+		assertSingleLayerMip(img);
+		hdr_write(img, fullName.c_str());
+	}
+	else if (ext == "exr")
+	{
+		assertSingleLayerMip(img);
+		openexr_save(fullName.c_str(), img, gli::format(format));
+	}
+	else if (ext == "pfm")
+	{
+		assertSingleLayerMip(img);
+		if (img.getFormat() != gli::FORMAT_RGBA32_SFLOAT_PACK32)
+			throw std::runtime_error ("expected RGBA32F image format for pfm export");
+
+		size_t mipSize;
+		auto mip = img.getData(0, 0, mipSize);
+		auto width = img.getWidth(0);
+		auto height = img.getHeight(0);
+		int nComponents = 0;
+
+		// only 2 possible formats
+		if (format == gli::FORMAT_RGB32_SFLOAT_PACK32 || format == gli::FORMAT_RGB8E8_UFLOAT_PACK32)
+			nComponents = 3;
+		else if (format == gli::FORMAT_R32_SFLOAT_PACK32)
+			nComponents = 1;
+		else throw std::runtime_error("export format not supported for pfm, hdr");
+
+		// pfm_save extracts the components while writing the rows
+		pfm_save(fullName.c_str(), width, height, nComponents, reinterpret_cast<const float*>(mip));
+	}
+	else if(ext == "png")
+	{
+		assertSingleLayerMip(img);
+		png_write(img, fullName.c_str(), gli::format(format), quality);
+	}
+	else if (ext == "jpg")
+	{
+		assertSingleLayerMip(img);
+		jpeg_write(img, fullName.c_str(), gli::format(format), quality);
+	}
+	else if (ext == "bmp" || ext == "tga")
+	{
+		assertSingleLayerMip(img);
+		if (img.getFormat() != gli::FORMAT_RGBA8_SRGB_PACK8 &&
+			img.getFormat() != gli::FORMAT_RGBA8_UNORM_PACK8 &&
+			img.getFormat() != gli::FORMAT_RGBA8_SNORM_PACK8)
+			throw std::runtime_error("unexpected image format. Expected one of FORMAT_RGBA8_SRGB_PACK8, FORMAT_RGBA8_UNORM_PACK8, FORMAT_RGBA8_SNORM_PACK8");
+
+		size_t mipSize;
+		auto mip = img.getData(0, 0, mipSize);
+		auto width = img.getWidth(0);
+		auto height = img.getHeight(0);
+		int nComponents = stb_ldr_get_num_components(gli::format(format));
+
+		if (nComponents == 3)
+		{
+			image::changeStride(mip, mipSize, 4, 3);
+		}
+		else if (nComponents == 1)
+		{
+			image::changeStride(mip, mipSize, 4, 1);
+		}
+
+		if (ext == "bmp")
+			stb_save_bmp(fullName.c_str(), width, height, nComponents, mip);
+		else if (ext == "tga")
+			stb_save_tga(fullName.c_str(), width, height, nComponents, mip);
+		else assert(false);
+	}
+	else if (ext == "npy")
+	{
+		if (img.getNumMipmaps() != 1)
+			throw std::runtime_error("expected single mipmap image");
+
+		numpy_save(fullName.c_str(), &img, format);
+	}
+	else if (ext == "webp")
+	{
+		webp_save_image(fullName.c_str(), img, gli::format(format), quality, fps);
+	}
+	else throw std::runtime_error("file extension not supported");
+}
+
 bool image_save(int id, const char* filename, const char* extension, uint32_t format, int quality, float fps)
 {
 	s_last_progress = -1;
@@ -224,99 +599,170 @@ bool image_save(int id, const char* filename, const char* extension, uint32_t fo
 		return false;
 	}
 
-	const std::string ext = extension;
-	const std::string fullName = filename + std::string(".") + extension;
+	// concurrent saves share the cores instead of spawning getNumThreads() threads each
+	const size_t numSaving = ++s_numSaving;
+	const size_t prevLimit = image::threadLimit();
+	image::threadLimit() = std::max<size_t>(image::getNumThreads() / numSaving, 1);
+
+	bool success = true;
 	try
 	{
-		if (ext == "dds")
-			gli_save_image(fullName.c_str(), dynamic_cast<GliImage&>(*img), gli::format(format), false, quality);
-		else if (ext == "ktx")
-			//gli_save_image(fullName.c_str(), dynamic_cast<GliImage&>(*img), gli::format(format), true, quality);
-			ktx1_save_image(fullName.c_str(), dynamic_cast<GliImage&>(*img), gli::format(format), quality);
-		else if (ext == "ktx2")
-			ktx2_save_image(fullName.c_str(), dynamic_cast<GliImage&>(*img), gli::format(format), quality);
-		else if(ext == "hdr")
-		{
-			assertSingleLayerMip(*img);
-			hdr_write(*img, fullName.c_str());
-		}
-		else if (ext == "pfm")
-		{
-			assertSingleLayerMip(*img);
-			if (img->getFormat() != gli::FORMAT_RGBA32_SFLOAT_PACK32)
-				throw std::runtime_error ("expected RGBA32F image format for pfm export");
-
-			size_t mipSize;
-			auto mip = img->getData(0, 0, mipSize);
-			auto width = img->getWidth(0);
-			auto height = img->getHeight(0);
-			int nComponents = 0;
-
-			// only 2 possible formats
-			if (format == gli::FORMAT_RGB32_SFLOAT_PACK32 || format == gli::FORMAT_RGB8E8_UFLOAT_PACK32)
-			{
-				image::changeStride(mip, mipSize, 16, 12);
-				nComponents = 3;
-			}
-			else if (format == gli::FORMAT_R32_SFLOAT_PACK32)
-			{
-				image::changeStride(mip, mipSize, 16, 4);
-				nComponents = 1;
-			}
-			else throw std::runtime_error("export format not supported for pfm, hdr");
+		save_image(*img, filename, extension, format, quality, fps);
+	}
+	catch(const std::exception& e)
+	{
+		set_error(e.what());
+		success = false;
+	}
 
-			pfm_save(fullName.c_str(), width, height, nComponents, mip);
-		}
-		else if(ext == "png")
+	image::threadLimit() = prevLimit;
+	--s_numSaving;
+	return success;
+}
+
+bool image_compute_statistics(int id, int layer, int mipmap, ImageStatistics& out)
+{
+	auto img = s_resources.find(id);
+	if (!img)
+	{
+		set_error("invalid image id");
+		return false;
+	}
+
+	try
+	{
+		statistics_compute(*img, layer, uint32_t(mipmap), out);
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return false;
+	}
+
+	return true;
+}
+
+bool image_compute_histogram(int id, int layer, int mipmap, uint32_t channel, float minValue, float maxValue, bool logarithmic, int numBins, uint64_t* bins)
+{
+	auto img = s_resources.find(id);
+	if (!img)
+	{
+		set_error("invalid image id");
+		return false;
+	}
+
+	try
+	{
+		if (numBins <= 0 || !bins)
+			throw std::runtime_error("histogram: invalid number of bins");
+		histogram_compute(*img, layer, uint32_t(mipmap), channel, minValue, maxValue, logarithmic, size_t(numBins), bins);
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return false;
+	}
+
+	return true;
+}
+
+bool image_compute_percentiles(int id, int layer, int mipmap, uint32_t channel, const float* percentiles, int numPercentiles, float* results)
+{
+	auto img = s_resources.find(id);
+	if (!img)
+	{
+		set_error("invalid image id");
+		return false;
+	}
+
+	try
+	{
+		if (numPercentiles < 0 || (numPercentiles > 0 && (!percentiles || !results)))
+			throw std::runtime_error("histogram: invalid percentiles");
+		histogram_percentiles(*img, layer, uint32_t(mipmap), channel, percentiles, size_t(numPercentiles), results);
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return false;
+	}
+
+	return true;
+}
+
+bool image_compare(int id1, int id2, int layer, int mipmap, uint32_t metric, uint32_t flags, float& result, int& errorMapId)
+{
+	errorMapId = 0;
+	auto img1 = s_resources.find(id1);
+	auto img2 = s_resources.find(id2);
+	if (!img1 || !img2)
+	{
+		set_error("invalid image id");
+		return false;
+	}
+
+	try
+	{
+		std::unique_ptr<image::IImage> errorMap;
+		result = compare_images(*img1, *img2, layer, uint32_t(mipmap), metric,
+			(flags & IMAGE_COMPARE_EXCLUDE_BORDERS) != 0, (flags & IMAGE_COMPARE_ERROR_MAP) ? &errorMap : nullptr);
+
+		if (errorMap)
 		{
-			assertSingleLayerMip(*img);
-			png_write(*img, fullName.c_str(), gli::format(format), quality);
+			errorMapId = s_currentID++;
+			s_resources.insert(errorMapId, std::move(errorMap));
 		}
-		else if (ext == "jpg" || ext == "bmp" || ext == "tga")
-		{
-			assertSingleLayerMip(*img);
-			if (img->getFormat() != gli::FORMAT_RGBA8_SRGB_PACK8 &&
-				img->getFormat() != gli::FORMAT_RGBA8_UNORM_PACK8 &&
-				img->getFormat() != gli::FORMAT_RGBA8_SNORM_PACK8)
-				throw std::runtime_error("unexpected image format. Expected one of FORMAT_RGBA8_SRGB_PACK8, FORMAT_RGBA8_UNORM_PACK8, FORMAT_RGBA8_SNORM_PACK8");
-
-			size_t mipSize;
-			auto mip = img->getData(0, 0, mipSize);
-			auto width = img->getWidth(0);
-			auto height = img->getHeight(0);
-			int nComponents = stb_ldr_get_num_components(gli::format(format));
-
-			if (nComponents == 3)
-			{
-				image::changeStride(mip, mipSize, 4, 3);
-			}
-			else if (nComponents == 1)
-			{
-				image::changeStride(mip, mipSize, 4, 1);
-			}
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return false;
+	}
 
-			if (ext == "bmp")
-				stb_save_bmp(fullName.c_str(), width, height, nComponents, mip);
-			else if (ext == "jpg")
-				stb_save_jpg(fullName.c_str(), width, height, nComponents, mip, quality);
-			else if (ext == "tga")
-				stb_save_tga(fullName.c_str(), width, height, nComponents, mip);
-			else assert(false);
-		}
-		else if (ext == "npy")
-		{
-			if (img->getNumMipmaps() != 1)
-				throw std::runtime_error("expected single mipmap image");
+	return true;
+}
 
-			numpy_save(fullName.c_str(), img.get(), format);
-		}
-		else if (ext == "webp")
+int image_combine(const char* colorFormula, const char* alphaFormula, const int* imageIds, int numImages)
+{
+	std::vector<std::shared_ptr<image::IImage>> images;
+	for (int i = 0; i < numImages; ++i)
+	{
+		auto img = s_resources.find(imageIds[i]);
+		if (!img)
 		{
-			webp_save_image(fullName.c_str(), *img, gli::format(format), quality, fps);
+			set_error("invalid image id");
+			return 0;
 		}
-		else throw std::runtime_error("file extension not supported");
+		images.push_back(std::move(img));
 	}
-	catch(const std::exception& e)
+
+	std::unique_ptr<image::IImage> res;
+	try
+	{
+		res = combine_images(colorFormula, alphaFormula, images);
+	}
+	catch (const std::exception& e)
+	{
+		set_error(e.what());
+		return 0;
+	}
+
+	const int id = s_currentID++;
+	s_resources.insert(id, std::move(res));
+	return id;
+}
+
+bool daemon_run(const char* socketPath, int numWorkers)
+{
+	try
+	{
+		// initialize the export formats before they are queried by concurrent requests
+		int numFormats;
+		get_export_formats("dds", numFormats);
+
+		daemon_serve(socketPath, uint32_t(std::max(numWorkers, 0)));
+	}
+	catch (const std::exception& e)
 	{
 		set_error(e.what());
 		return false;
@@ -333,6 +779,7 @@ const uint32_t* get_export_formats(const char* extension, int& numFormats)
 		s_exportFormats["ktx"] = ktx_get_export_formats();
 		s_exportFormats["pfm"] = pfm_get_export_formats();
 		s_exportFormats["hdr"] = hdr_get_export_formats();
+		s_exportFormats["exr"] = openexr_get_export_formats();
 		s_exportFormats["jpg"] = stb_image_get_export_formats("jpg");
 		s_exportFormats["png"] = png_get_export_formats();
 		s_exportFormats["bmp"] = stb_image_get_export_formats("bmp");
@@ -400,15 +847,52 @@ void set_error(const std::string& str)
 
 void set_progress(uint32_t progress, const char* description)
 {
-	if (!s_progress_callback) return;
+	const ProgressHandler* handler = image::threadContext().progressHandler;
+	if (handler)
+	{
+		progress = std::min(uint32_t(100), progress);
+		if (progress == s_thread_last_progress) return;
+		s_thread_last_progress = progress;
+
+		if ((*handler)(progress, description ? description : ""))
+			throw abort_error();
+		return;
+	}
+
+	const ProgressCallback callback = s_progress_callback;
+	if (!callback) return;
 	progress = std::min(uint32_t(100), progress);
 
 	if (progress == s_last_progress) return;
 	s_last_progress = progress;
 	if (description == nullptr) description = "";
 
-	if (s_progress_callback(progress / 100.0f, description))
-		throw std::runtime_error("aborted by user");
+	if (callback(progress / 100.0f, description))
+		throw abort_error();
+}
+
+void set_thread_progress_handler(const ProgressHandler* handler)
+{
+	image::threadContext().progressHandler = handler;
+	s_thread_last_progress = -1;
+}
+
+bool wants_preview()
+{
+	return s_thread_preview_callback != nullptr;
+}
+
+void set_preview(const ImagePreview& preview)
+{
+	if (!s_thread_preview_callback) return;
+
+	const auto now = std::chrono::steady_clock::now();
+	if (preview.stage == IMAGE_PREVIEW_ROWS && now - s_thread_last_preview < s_rowPreviewInterval)
+		return;
+	s_thread_last_preview = now;
+
+	if (s_thread_preview_callback(&preview))
+		throw abort_error();
 }
 
 int noise_generate_white(int width, int height, int depth, int layer, int mipmaps, int seed)
@@ -1,6 +1,9 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include <memory>
+#include <functional>
+#include <stdexcept>
 
 #define EXPORT(rtype) extern "C" __declspec(dllexport) rtype __cdecl
 
@@ -10,6 +13,99 @@
 /// The error can be retrieved with get_error on failure.
 EXPORT(int) image_open(const char* filename);
 
+/// \brief layout of numpy arrays for ImageLoadOptions. The first dimension is used for layers or depth
+enum ImageNpyLayout : uint32_t
+{
+	IMAGE_NPY_LAYERS = 0, // 2D texture array
+	IMAGE_NPY_VOLUME = 1, // single 3D texture
+};
+
+/// \brief channel handling of numpy arrays for ImageLoadOptions
+enum ImageNpyChannels : uint32_t
+{
+	IMAGE_NPY_CHANNELS_AUTO = 0, // the last dimension is used for the channels if it is at most 4
+	IMAGE_NPY_CHANNELS_NONE = 1, // all dimensions are spatial, the array is loaded as grayscale
+};
+
+/// \brief options for image_open_with_options. The options are applied once while loading.
+/// A zero initialized struct uses the defaults
+struct ImageLoadOptions
+{
+	uint32_t npyLayout; // one of ImageNpyLayout
+	uint32_t npyChannels; // one of ImageNpyChannels
+	uint32_t firstLayer; // first layer (first slice for IMAGE_NPY_VOLUME) that is loaded from numpy arrays
+	uint32_t numLayers; // number of loaded layers (slices) starting with firstLayer. 0 = all remaining layers
+	uint32_t format; // format that the image is converted to after loading (must be one of the compatible formats, see Image.h). 0 = keep the loader format
+};
+
+/// \brief tries to open the file like image_open with explicit load options instead of the numpy global parameters
+/// \param filename absolute or relative path
+/// \param options load options or nullptr for the defaults
+/// \return returns a non zero integer on success.
+/// The error can be retrieved with get_error on failure.
+EXPORT(int) image_open_with_options(const char* filename, const ImageLoadOptions* options);
+
+/// \brief kind of intermediate result for image_open_progressive
+enum ImagePreviewStage : uint32_t
+{
+	IMAGE_PREVIEW_MIPMAP = 0, // a smaller mipmap of the first layer (dds and ktx files that need a format conversion, dct scaled jpg)
+	IMAGE_PREVIEW_PASS = 1, // full size image with reduced detail (interlaced png: Adam7 pass, pixels are replicated into blocks. progressive jpg: scans)
+	IMAGE_PREVIEW_ROWS = 2, // the rows [firstRow, numRows) are decoded (png, webp, hdr, pfm)
+};
+// exr, npy and the stb_image formats (bmp, tga, ...) are decoded by a single library call and never report previews
+
+/// \brief intermediate result for image_open_progressive
+struct ImagePreview
+{
+	const uint8_t* data; // pixels of the first layer with tightly packed rows. Only valid during the callback
+	uint32_t width;
+	uint32_t height;
+	uint32_t format; // one of the compatible formats (see Image.h) or FORMAT_RGBA16_UNORM_PACK16 (passes of interlaced 16 bit png)
+	uint32_t numRows; // rows [firstRow, numRows) contain valid pixels
+	uint32_t stage; // one of ImagePreviewStage
+	uint32_t pass; // index of the interlace pass (png) or of the preview (jpg) for IMAGE_PREVIEW_PASS
+	uint32_t firstRow; // 0 except for IMAGE_PREVIEW_ROWS of files that start with the bottom row (pfm)
+};
+
+/// \brief receives intermediate results on the loading thread. Returns non zero if loading should be aborted
+typedef uint32_t(__stdcall* PreviewCallback)(const ImagePreview*);
+
+/// \brief opens the file like image_open_with_options and reports intermediate results while the file is decoded.
+/// Row previews are limited to one every 30 ms. Previews are only available for the formats that are listed in ImagePreviewStage
+/// Prefetched images (see image_prefetch_set_cursor) are complete and are returned without previews
+/// \param filename absolute or relative path
+/// \param options load options or nullptr for the defaults
+/// \param callback receives the previews. The final image is not reported
+/// \return returns a non zero integer on success.
+/// The error can be retrieved with get_error on failure.
+EXPORT(int) image_open_progressive(const char* filename, const ImageLoadOptions* options, PreviewCallback callback);
+
+/// \brief registers the ordered files of a directory for prefetching (see image_prefetch_set_cursor).
+/// Replaces the previous list and releases all prefetched images. An empty list stops the background workers
+/// \param filenames paths in the same notation that will be passed to image_open
+/// \param count number of filenames
+EXPORT(void) image_prefetch_set_files(const char* const* filenames, int count);
+
+/// \brief sets the file that is currently displayed. The files [cursor - radius, cursor + radius] are decoded in the background
+/// (nearest first, low thread priority) with the current global parameters. image_open, image_open_with_options and image_open_progressive
+/// return prefetched images without decoding them again and wait for running decodes of the same file.
+/// Prefetched images outside of the window are released and their decodes are aborted
+/// \param cursor index into the file list of image_prefetch_set_files
+/// \param radius number of files before and after the cursor
+/// \param memoryBudget maximum number of bytes of the prefetched images. Images that are farther away are released first
+EXPORT(void) image_prefetch_set_cursor(int cursor, int radius, uint64_t memoryBudget);
+
+/// \brief loads the file and creates a thumbnail on the cpu without keeping the image (no gpu or ImageConsole required).
+/// The longer side of the thumbnail is maxSize, the aspect ratio is preserved (same dimensions as the -thumbnail command).
+/// Only the first layer (center slice for 3D images) is used
+/// \param filename absolute or relative path
+/// \param maxSize maximum width and height of the thumbnail
+/// \param outRGBA receives the srgb encoded RGBA8 pixels. Must be able to hold maxSize * maxSize * 4 bytes
+/// \param outWidth receives the thumbnail width
+/// \param outHeight receives the thumbnail height
+/// \return false on failure. The error can be retrieved with get_error
+EXPORT(bool) image_thumbnail(const char* filename, int maxSize, uint8_t* outRGBA, int& outWidth, int& outHeight);
+
 /// \brief allocates a texture with the given amount of layers and levels
 /// \param format dxgi texture format (must be one of the compatible formats, see Image.h)
 /// \param width width in pixels
@@ -33,6 +129,50 @@ EXPORT(void) image_info_mipmap(int id, int mipmap, int& width, int& height, int&
 /// \return mipmap data. Can also be used to write mipmap data
 EXPORT(unsigned char*) image_get_mipmap(int id, int layer, int mipmap, uint64_t& size);
 
+/// \brief indicates that the pointer from image_get_mipmap is no longer used (e.g. after it was uploaded).
+/// Images that decode layers on demand (webp animations) may free the layer and decode it again on the next image_get_mipmap call.
+/// Changes that were written to the layer through image_get_mipmap are lost in this case (layers updated by image_reload are kept)
+EXPORT(void) image_release_mipmap(int id, int layer, int mipmap);
+
+/// \brief flags for image_copy_to
+enum ImageCopyFlags : uint32_t
+{
+	IMAGE_COPY_FLIP_Y = 1, // rows of each slice are written from bottom to top
+};
+
+/// \brief copies mipmap bytes directly into caller memory (e.g. a mapped upload buffer) and optionally converts them.
+/// Rows are processed on multiple threads in a single pass. Padding bytes of dst are not written
+/// \param dst receives the pixels. Must be able to hold (depth - 1) * dstSlicePitch + (height - 1) * dstRowPitch + width * pixel size bytes
+/// \param dstRowPitch bytes between the starts of two rows (e.g. 256 byte aligned for d3d12). 0 = width * pixel size
+/// \param dstSlicePitch bytes between the starts of two depth slices. 0 = height * dstRowPitch
+/// \param dstFormat 0 keeps the image format. Otherwise one of: FORMAT_RGBA32_SFLOAT_PACK32, FORMAT_RGBA16_SFLOAT_PACK16 (linear colors),
+/// FORMAT_RGBA8_UNORM_PACK8, FORMAT_RGBA8_SRGB_PACK8, FORMAT_BGRA8_UNORM_PACK8, FORMAT_BGRA8_SRGB_PACK8 (clamped to [0, 1])
+/// \param flags combination of ImageCopyFlags
+/// \return false on failure. The error can be retrieved with get_error
+EXPORT(bool) image_copy_to(int id, int layer, int mipmap, uint8_t* dst, uint64_t dstRowPitch, uint64_t dstSlicePitch, uint32_t dstFormat, uint32_t flags);
+
+/// \brief called on the watcher thread after the watched file was modified (see image_watch)
+typedef void(__stdcall* WatchCallback)(int watchId);
+
+/// \brief watches the file of an image for modifications. The file can then be reloaded with image_reload,
+/// which only updates the layers and mipmaps whose pixels changed.
+/// \param id valid image id
+/// \param filename file that was used to open the image
+/// \param options load options that were used to open the image or nullptr for the current global parameters (image_open)
+/// \param callback is called after the file was modified and no further modification happened for 200 ms. Can be nullptr
+/// \return non zero watch id on success. The error can be retrieved with get_error on failure
+EXPORT(int) image_watch(int id, const char* filename, const ImageLoadOptions* options, WatchCallback callback);
+
+/// \brief stops watching the file. Must not be called from the WatchCallback
+EXPORT(void) image_unwatch(int watchId);
+
+/// \brief reloads the watched file and overwrites the layers and mipmaps of the image that changed since the last reload (or image_watch)
+/// \param dirty receives the indices (layer * nMipmaps + mipmap) of the updated subresources. Must be able to hold nLayer * nMipmaps entries
+/// \param numDirty receives the number of updated subresources
+/// \return false on failure. The error can be retrieved with get_error.
+/// The image is not modified if the format, number of layers, number of mipmaps or size changed (the file has to be opened again)
+EXPORT(bool) image_reload(int watchId, uint32_t* dirty, int& numDirty);
+
 /// \brief retrieves desired fps for 2D arrays (webp videos)
 /// \return average fps or 0 if no preference is given
 EXPORT(float) image_get_fps(int id);
@@ -42,19 +182,124 @@ EXPORT(float) image_get_fps(int id);
 /// \param filename filename without extension
 /// \param extension file format extension (without dot)
 /// \param format format that must be compatible with the extension. Can by queried with image_get_export_formats
-/// \param quality quality for compressed formats or .jpg. range: [0, 100]
+/// \param quality quality for compressed formats or .jpg. range: [0, 100].
 /// \param fps video fps (for webp export). 0 defaults to 24 fps. Ignored for non video formats.
 /// \warning the image data might be changed by calling this function. Thus, the image should no longer be used after a call to save
-/// \remarks for pfm and hdr export: the image format must be FORMAT_RGBA32_SFLOAT_PACK32.
+/// \remarks for pfm, hdr and exr export: the image format must be FORMAT_RGBA32_SFLOAT_PACK32.
 ///          for png, jpg and bmp export the image format must be one of: FORMAT_RGBA8_SRGB_PACK8, FORMAT_RGBA8_UNORM_PACK8, FORMAT_RGBA8_SNORM_PACK8
 EXPORT(bool) image_save(int id, const char* filename, const char* extension, uint32_t format, int quality, float fps);
 
+/// \brief result of image_compute_statistics.
+/// Arrays are indexed with the statistic type (same order as DefaultStatistics.Types in ImageFramework):
+/// 0 = luminance, 1 = average, 2 = luma, 3 = lightness, 4 = alpha, 5 = grayscale (1 for grayscale pixels, 0 for colored pixels)
+struct ImageStatistics
+{
+	float min[6];
+	float max[6];
+	float avg[6];
+};
+
+/// \brief computes min, max and avg of all statistic types on the cpu (no gpu required)
+/// \param layer layer index or -1 to compute the statistics over all layers
+/// \param mipmap mipmap index
+/// \return false on failure. The error can be retrieved with get_error
+EXPORT(bool) image_compute_statistics(int id, int layer, int mipmap, ImageStatistics& out);
+
+/// \brief metrics for image_compare.
+/// All metrics operate on premultiplied srgb colors (a * toSrgb(rgb)), ssim and ms-ssim use the luma of those colors
+enum ImageCompareMetric : uint32_t
+{
+	IMAGE_COMPARE_MSE = 0, // mean squared error of the rgb channels
+	IMAGE_COMPARE_PSNR = 1, // peak signal to noise ratio in dB (peak = 1.0)
+	IMAGE_COMPARE_SSIM = 2, // same parameters as SSIMModel in ImageFramework
+	IMAGE_COMPARE_MSSSIM = 3, // uses the next 4 mipmaps of the images (if available)
+};
+
+/// \brief flags for image_compare
+enum ImageCompareFlags : uint32_t
+{
+	IMAGE_COMPARE_EXCLUDE_BORDERS = 1, // ignore the 5 pixel border of the gauss window for ssim and ms-ssim
+	IMAGE_COMPARE_ERROR_MAP = 2, // create an image with the per pixel error or similarity
+};
+
+/// \brief compares two images with the same dimensions on the cpu (no gpu required)
+/// \param layer layer index or -1 to compare all layers
+/// \param mipmap mipmap index
+/// \param metric one of ImageCompareMetric
+/// \param flags combination of ImageCompareFlags
+/// \param result the computed metric
+/// \param errorMapId receives the id of a RGBA32 float image with one layer per compared layer if IMAGE_COMPARE_ERROR_MAP is set (0 otherwise).
+/// The image contains the per pixel squared error for mse and psnr or the per pixel similarity for ssim and ms-ssim
+/// \return false on failure. The error can be retrieved with get_error
+EXPORT(bool) image_compare(int id1, int id2, int layer, int mipmap, uint32_t metric, uint32_t flags, float& result, int& errorMapId);
+
+/// \brief evaluates image combine formulas (same syntax as the equations of ImageFramework) on the cpu
+/// \param colorFormula formula for the rgb channels, e.g. "I0 - I1"
+/// \param alphaFormula formula for the alpha channel
+/// \param imageIds ids of the images that are referenced with I0, I1, ... All images need the same dimensions
+/// \param numImages number of ids in imageIds
+/// \return id of a new RGBA32 float image with the layers and mipmaps of the input images or 0 on failure.
+/// The error can be retrieved with get_error
+EXPORT(int) image_combine(const char* colorFormula, const char* alphaFormula, const int* imageIds, int numImages);
+
+/// \brief channels for image_compute_histogram and image_compute_percentiles.
+/// Values are the texture fetch values (linear colors for srgb formats)
+enum ImageChannel : uint32_t
+{
+	IMAGE_CHANNEL_RED = 0,
+	IMAGE_CHANNEL_GREEN = 1,
+	IMAGE_CHANNEL_BLUE = 2,
+	IMAGE_CHANNEL_ALPHA = 3,
+	IMAGE_CHANNEL_LUMINANCE = 4, // a * dot(rgb, (0.2125, 0.7154, 0.0721)) like the luminance statistics
+};
+
+/// \brief computes a histogram of one channel on the cpu (no gpu required). NaNs are ignored
+/// \param layer layer index or -1 to use all layers
+/// \param mipmap mipmap index
+/// \param channel one of ImageChannel
+/// \param minValue lower bound of the first bin. Smaller values are counted in the first bin
+/// \param maxValue upper bound of the last bin. Bigger values are counted in the last bin
+/// \param logarithmic use logarithmically spaced bins (requires minValue > 0)
+/// \param numBins number of bins
+/// \param bins array with numBins elements that receives the counts
+/// \return false on failure. The error can be retrieved with get_error
+EXPORT(bool) image_compute_histogram(int id, int layer, int mipmap, uint32_t channel, float minValue, float maxValue, bool logarithmic, int numBins, uint64_t* bins);
+
+/// \brief computes exact percentiles of one channel on the cpu (no gpu required).
+/// Results are linearly interpolated between the closest ranks (like numpy.percentile). NaNs are ignored
+/// \param layer layer index or -1 to use all layers
+/// \param mipmap mipmap index
+/// \param channel one of ImageChannel
+/// \param percentiles array with numPercentiles percentiles in [0, 100] (quantile * 100)
+/// \param results array with numPercentiles elements that receives the values (NaN if the image only contains NaNs)
+/// \return false on failure. The error can be retrieved with get_error
+EXPORT(bool) image_compute_percentiles(int id, int layer, int mipmap, uint32_t channel, const float* percentiles, int numPercentiles, float* results);
+
+/// \brief runs a conversion daemon that processes open, convert and save requests of local clients over a unix domain socket.
+/// Blocks until a client sends "shutdown". The protocol is described in daemon_interface.h
+/// \param socketPath path of the socket file. An existing file will be replaced
+/// \param numWorkers number of requests that are processed concurrently. 0 uses the number of hardware threads
+/// \return false on failure. The error can be retrieved with get_error
+EXPORT(bool) daemon_run(const char* socketPath, int numWorkers);
+
 /// \brief retrieves an array with all supported dxgi formats that are available for export with the extension
 EXPORT(const uint32_t*) get_export_formats(const char* extension, int& numFormats);
 
 /// List of global parameters:
 /// "uastc srgb" - for .ktx2 export => use uastc for srgb compression (otherwise etc1 is used). Valid for srgb uastc compressable textures
 /// "normalmap" - for .ktx2 export => indicate that the exporter/compressor should optimize data for normal maps. Valid for linear (non-srgb) uastc compressable textures
+/// "npy is3D", "npy useChannel", "npy firstLayer", "npy lastLayer" - for .npy import with image_open => see ImageLoadOptions. Read once when the file is opened
+/// "jpg progressive" - for .jpg export => write a progressive jpeg instead of a baseline jpeg
+/// "jpg parallel pixels" - for .jpg import => images with at least this many pixels are decoded on multiple threads (also on single core machines).
+///                         0 = 2097152 pixels and more than one core (default)
+/// "webp anim decoder" - for .webp import => 1 = animations are decoded completely on load with the WebPAnimDecoder of libwebp instead of on demand (more memory)
+/// "webp mixed" - for lossy .webp animation export => 1 = every frame is encoded lossy or lossless, whichever is smaller. 0 = only lossy (default)
+/// "webp preset" - for .webp export => 0 = balanced (default), 1 = fast, 2 = small (slowest). Long animations are split into segments
+///                 that start with a keyframe and are encoded in parallel
+/// "exr compression" - for .exr export => 0 = zip (default), 1 = piz, 2 = zips, 3 = rle, 4 = none
+/// "exr tile size" - for .exr export => 0 = scanlines (default), otherwise the width and height of the tiles
+/// "png preset" - for .png export => 0 = default (zlib level 6 like libpng), 1 = fast, 2 = small (slowest)
+/// "png stripe rows" - for .png export => rows per independently compressed stripe. 0 = one stripe per thread of at least 1 MB (default)
 
 /// \brief returns the value of the parameter if found. Throws an exception otherwise
 int get_global_parameter_i(const char* name);
@@ -67,19 +312,56 @@ EXPORT(void) set_global_parameter_i(const char* name, int value);
 
 typedef uint32_t(__stdcall* ProgressCallback)(float, const char*);
 
-/// \brief sets the progress report callback
+/// \brief sets the progress report callback. The callback is called from the threads of the exports and must be thread safe
 EXPORT(void) set_progress_callback(ProgressCallback cb);
 
-/// \brief get last error
+/// \brief get last error of the calling thread
 EXPORT(const char*) get_error(int& length);
 
 /// \brief set current error (for internal use only) 
 void set_error(const std::string& str);
 
+/// \brief thrown by set_progress and set_preview if the action should be aborted (for internal use only).
+/// Loaders must not fall back to another loader when they catch it
+struct abort_error : std::runtime_error
+{
+	abort_error() : std::runtime_error("aborted by user") {}
+};
+
 /// \brief set current progress (for internal use only)
-/// throws an error if the action should be aborted
+/// throws an abort_error if the action should be aborted
 void set_progress(uint32_t progress, const char* description = nullptr);
 
+/// \brief progress handler for the current thread. Returns true if the action should be aborted
+using ProgressHandler = std::function<bool(uint32_t progress, const char* description)>;
+
+/// \brief redirects set_progress calls of the current thread to the handler instead of the progress callback (for internal use only).
+/// nullptr restores the progress callback. The threads of image::parallelRanges inherit the handler
+void set_thread_progress_handler(const ProgressHandler* handler);
+
+/// \brief returns true if the image that is loaded on the current thread was opened with image_open_progressive (for internal use only).
+/// Loaders use it to skip the extra work for previews
+bool wants_preview();
+
+/// \brief reports an intermediate result of the image that is loaded on the current thread (for internal use only).
+/// Does nothing if wants_preview() is false. Throws an abort_error if the action should be aborted
+void set_preview(const ImagePreview& preview);
+
+namespace image { class IImage; }
+
+/// \brief load options that match the numpy global parameters (used by image_open)
+ImageLoadOptions get_global_load_options();
+
+/// \brief loads the image with the loader of the file extension (for internal use only). Throws on failure
+std::unique_ptr<image::IImage> load_image(const char* filename, const ImageLoadOptions& options);
+
+/// \brief loads the image with get_global_load_options (for internal use only). Throws on failure
+std::unique_ptr<image::IImage> load_image(const char* filename);
+
+/// \brief saves the image like image_save (for internal use only). Throws on failure
+/// \param filename filename without extension
+void save_image(image::IImage& img, const std::string& filename, const std::string& extension, uint32_t format, int quality, float fps);
+
 /// \brief returns a pointer to the shape and stores the number if dimensions in dim. Returns nullptr on failure.
 /// WARNING: the return value is not thread safe and should be guarded!
 EXPORT(unsigned int*) npy_get_shape(const char* filename, unsigned int* dim);
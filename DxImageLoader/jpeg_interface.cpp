@@ -0,0 +1,758 @@
+#include "pch.h"
+#include "jpeg_interface.h"
+#include "interface.h"
+#include "stbi_interface.h"
+#include "parallel.h"
+#include <turbojpeg.h>
+#include <algorithm>
+#include <chrono>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+// the libjpeg api of libjpeg-turbo (part of turbojpeg-static.lib) for the buffered image mode. Needs stdio.h
+#include <jpeglib.h>
+
+namespace
+{
+	// longer side of the dct scaled preview
+	constexpr uint32_t s_maxPreviewSize = 512;
+	// smaller images are decoded with a single turbojpeg call (can be overridden with "jpg parallel pixels")
+	constexpr size_t s_minParallelPixels = size_t(1) << 21;
+	// minimum time between two scan previews. Every preview is a full size idct => at least twice the time of the last one
+	constexpr std::chrono::milliseconds s_scanPreviewInterval(250);
+
+	// owns a turbojpeg instance
+	class TurboHandle
+	{
+	public:
+		explicit TurboHandle(int initType) : m_handle(tj3Init(initType))
+		{
+			if (!m_handle) throw std::runtime_error("jpeg: could not initialize libjpeg-turbo");
+		}
+		~TurboHandle()
+		{
+			tj3Destroy(m_handle);
+		}
+		TurboHandle(const TurboHandle&) = delete;
+		TurboHandle& operator=(const TurboHandle&) = delete;
+
+		operator tjhandle() const { return m_handle; }
+
+		// throws on fatal errors. Warnings (e.g. a few corrupt blocks) are ignored like in stb_image
+		void check(int res) const
+		{
+			if (res != 0 && tj3GetErrorCode(m_handle) == TJERR_FATAL)
+				throw std::runtime_error(std::string("jpeg: ") + tj3GetErrorStr(m_handle));
+		}
+
+	private:
+		tjhandle m_handle;
+	};
+
+	std::vector<uint8_t> readFile(const char* filename)
+	{
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		if (!file) throw std::runtime_error("could not open file");
+		const auto size = size_t(file.tellg());
+		file.seekg(0, std::ios::beg);
+		std::vector<uint8_t> res(size);
+		if (!file.read(reinterpret_cast<char*>(res.data()), size))
+			throw std::runtime_error("could not read file");
+		return res;
+	}
+
+	// decompressor with the parsed header of the file
+	struct JpegHeader
+	{
+		TurboHandle tj{ TJINIT_DECOMPRESS };
+		int width = 0;
+		int height = 0;
+		gli::format original = gli::FORMAT_RGB8_SRGB_PACK8;
+
+		explicit JpegHeader(const std::vector<uint8_t>& file)
+		{
+			tj.check(tj3DecompressHeader(tj, file.data(), file.size()));
+			width = tj3Get(tj, TJPARAM_JPEGWIDTH);
+			height = tj3Get(tj, TJPARAM_JPEGHEIGHT);
+			if (tj3Get(tj, TJPARAM_COLORSPACE) == TJCS_GRAY)
+				original = gli::FORMAT_R8_SRGB_PACK8;
+		}
+	};
+
+	int scaledSize(const JpegHeader& header, const tjscalingfactor& factor)
+	{
+		return std::max(TJSCALED(header.width, factor), TJSCALED(header.height, factor));
+	}
+
+	// smallest downscaling factor whose longer side is at least minSize (TJUNSCALED if there is none)
+	tjscalingfactor findScalingFactor(const JpegHeader& header, uint32_t minSize)
+	{
+		int numFactors = 0;
+		const tjscalingfactor* factors = tj3GetScalingFactors(&numFactors);
+		tjscalingfactor res = TJUNSCALED;
+		for (int i = 0; i < numFactors; ++i)
+		{
+			const auto& f = factors[i];
+			if (f.num >= f.denom) continue; // upscaling
+			if (scaledSize(header, f) >= int(minSize) && scaledSize(header, f) < scaledSize(header, res))
+				res = f;
+		}
+		return res;
+	}
+
+	// decodes the image with the scaling factor into RGBA8
+	std::unique_ptr<image::IImage> decode(JpegHeader& header, const std::vector<uint8_t>& file, tjscalingfactor factor)
+	{
+		header.tj.check(tj3SetScalingFactor(header.tj, factor));
+		const int width = TJSCALED(header.width, factor);
+		const int height = TJSCALED(header.height, factor);
+
+		auto res = std::make_unique<image::SimpleImage>(header.original, gli::FORMAT_RGBA8_SRGB_PACK8, width, height, 4);
+		size_t size;
+		header.tj.check(tj3Decompress8(header.tj, file.data(), file.size(), res->getData(0, 0, size), width * 4, TJPF_RGBA));
+		return res;
+	}
+
+	uint32_t readU16(const uint8_t* p)
+	{
+		return uint32_t(p[0]) << 8 | p[1];
+	}
+
+	// byte layout of a single scan sequential jpeg with restart markers
+	struct RestartIndex
+	{
+		size_t headerSize = 0; // SOI up to and including the SOS segment
+		size_t heightOffset = 0; // position of the image height in the SOF segment
+		size_t dataEnd = 0; // position of the EOI marker
+		uint32_t height = 0;
+		uint32_t mcuHeight = 8; // in pixels
+		uint32_t mcusPerRow = 0;
+		uint32_t restartInterval = 0; // in mcus
+		bool verticalSubsampling = false; // chroma upsampling needs the neighbouring mcu rows
+		// start of the entropy coded data of every restart interval that begins with a new mcu row (rows[i] = mcu row of starts[i])
+		std::vector<size_t> starts;
+		std::vector<uint32_t> rows;
+	};
+
+	// finds all restart intervals that start with a new mcu row.
+	// Returns false if the file cannot be split (progressive or arithmetic coding, multiple scans, no restart markers...)
+	bool indexRestartIntervals(const std::vector<uint8_t>& file, RestartIndex& index)
+	{
+		const uint8_t* data = file.data();
+		const size_t size = file.size();
+		if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+
+		uint32_t width = 0;
+		uint32_t numComponents = 0;
+		uint32_t maxH = 1, maxV = 1;
+		size_t pos = 2;
+		while (true)
+		{
+			if (pos + 4 > size || data[pos] != 0xFF) return false;
+			const uint8_t marker = data[pos + 1];
+			if (marker == 0xFF) // fill byte
+			{
+				++pos;
+				continue;
+			}
+			const size_t length = readU16(data + pos + 2);
+			if (length < 2 || pos + 2 + length > size) return false;
+			const uint8_t* segment = data + pos + 4;
+
+			if (marker == 0xC0 || marker == 0xC1) // baseline or extended sequential with huffman coding
+			{
+				if (length < 8) return false;
+				index.height = readU16(segment + 1);
+				width = readU16(segment + 3);
+				numComponents = segment[5];
+				if (length < 8 + 3 * numComponents) return false;
+				for (uint32_t c = 0; c < numComponents; ++c)
+				{
+					maxH = std::max<uint32_t>(maxH, segment[7 + 3 * c] >> 4);
+					maxV = std::max<uint32_t>(maxV, segment[7 + 3 * c] & 0xF);
+				}
+				index.heightOffset = pos + 5;
+			}
+			else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+				return false; // progressive, lossless or arithmetic coding
+			else if (marker == 0xDD) // DRI
+			{
+				if (length < 4) return false;
+				index.restartInterval = readU16(segment);
+			}
+			else if (marker == 0xDA) // SOS
+			{
+				// a single scan with all components
+				if (numComponents == 0 || segment[0] != numComponents) return false;
+				index.headerSize = pos + 2 + length;
+				break;
+			}
+			pos += 2 + length;
+		}
+		// height 0 = height is defined by a DNL marker
+		if (!index.restartInterval || !width || !index.height) return false;
+
+		// a scan with a single component is not interleaved (mcu = one 8x8 block)
+		const uint32_t mcuWidth = numComponents == 1 ? 8 : 8 * maxH;
+		index.mcuHeight = numComponents == 1 ? 8 : 8 * maxV;
+		index.verticalSubsampling = index.mcuHeight > 8;
+		index.mcusPerRow = (width + mcuWidth - 1) / mcuWidth;
+		const uint32_t numMcuRows = (index.height + index.mcuHeight - 1) / index.mcuHeight;
+
+		// restart markers in the entropy coded data
+		index.starts.assign(1, index.headerSize);
+		index.rows.assign(1, 0);
+		uint64_t numIntervals = 1;
+		pos = index.headerSize;
+		while (true)
+		{
+			const auto next = static_cast<const uint8_t*>(memchr(data + pos, 0xFF, size - pos));
+			if (!next || next + 1 >= data + size) return false;
+			pos = size_t(next - data);
+			const uint8_t marker = data[pos + 1];
+			if (marker == 0x00) // stuffed byte
+			{
+				pos += 2;
+				continue;
+			}
+			if (marker == 0xFF) // fill byte
+			{
+				pos += 1;
+				continue;
+			}
+			if (marker >= 0xD0 && marker <= 0xD7) // RSTn
+			{
+				pos += 2;
+				const uint64_t firstMcu = numIntervals * index.restartInterval;
+				if (firstMcu % index.mcusPerRow == 0 && firstMcu / index.mcusPerRow < numMcuRows)
+				{
+					index.starts.push_back(pos);
+					index.rows.push_back(uint32_t(firstMcu / index.mcusPerRow));
+				}
+				++numIntervals;
+				continue;
+			}
+			if (marker != 0xD9) return false; // DNL or another scan
+			index.dataEnd = pos;
+			break;
+		}
+
+		// corrupt files are decoded by libjpeg-turbo directly (it can resync and recover some of the data)
+		const uint64_t numMcus = uint64_t(index.mcusPerRow) * numMcuRows;
+		if (numIntervals != (numMcus + index.restartInterval - 1) / index.restartInterval) return false;
+		return index.starts.size() > 1;
+	}
+
+	// builds a jpeg that contains the restart intervals [starts[first], starts[last]) of the original file
+	std::vector<uint8_t> buildSegment(const std::vector<uint8_t>& file, const RestartIndex& index, size_t first, size_t last, uint32_t height)
+	{
+		const size_t begin = index.starts[first];
+		// the restart marker in front of starts[last] is not part of the segment
+		const size_t end = last < index.starts.size() ? index.starts[last] - 2 : index.dataEnd;
+
+		std::vector<uint8_t> res;
+		res.reserve(index.headerSize + (end - begin) + 2);
+		res.insert(res.end(), file.begin(), file.begin() + index.headerSize);
+		res[index.heightOffset] = uint8_t(height >> 8);
+		res[index.heightOffset + 1] = uint8_t(height);
+		res.insert(res.end(), file.begin() + begin, file.begin() + end);
+		res.push_back(0xFF);
+		res.push_back(0xD9);
+
+		// the decoder expects RST0 after the first interval of the segment
+		const uint64_t firstInterval = uint64_t(index.rows[first]) * index.mcusPerRow / index.restartInterval;
+		const uint8_t shift = uint8_t(firstInterval % 8);
+		if (shift)
+		{
+			for (size_t i = index.headerSize; i + 3 < res.size(); ++i)
+			{
+				if (res[i] != 0xFF || res[i + 1] < 0xD0 || res[i + 1] > 0xD7) continue;
+				res[i + 1] = uint8_t(0xD0 + (res[i + 1] - 0xD0 + 8 - shift) % 8);
+				++i;
+			}
+		}
+		return res;
+	}
+
+	uint32_t segmentRow(const RestartIndex& index, size_t i)
+	{
+		return i < index.starts.size() ? std::min(index.rows[i] * index.mcuHeight, index.height) : index.height;
+	}
+
+	// decodes the restart intervals [first, last) with their own decompressor into dst (RGBA8 with the full image width)
+	void decodeSegment(const std::vector<uint8_t>& file, const RestartIndex& index, size_t first, size_t last, int width, uint8_t* dst)
+	{
+		const uint32_t rowBegin = segmentRow(index, first);
+		const uint32_t rowEnd = segmentRow(index, last);
+		const size_t pitch = size_t(width) * 4;
+
+		// fancy upsampling of vertically subsampled chroma interpolates between mcu rows
+		// => decode one additional interval group above and below and discard its rows
+		size_t decodeFirst = first, decodeLast = last;
+		if (index.verticalSubsampling)
+		{
+			if (decodeFirst > 0) --decodeFirst;
+			if (decodeLast < index.starts.size()) ++decodeLast;
+		}
+		const uint32_t decodeBegin = segmentRow(index, decodeFirst);
+		const uint32_t decodeHeight = segmentRow(index, decodeLast) - decodeBegin;
+
+		const auto segment = buildSegment(file, index, decodeFirst, decodeLast, decodeHeight);
+		TurboHandle tj(TJINIT_DECOMPRESS);
+		tj.check(tj3DecompressHeader(tj, segment.data(), segment.size()));
+		if (tj3Get(tj, TJPARAM_JPEGWIDTH) != width || tj3Get(tj, TJPARAM_JPEGHEIGHT) != int(decodeHeight))
+			throw std::runtime_error("jpeg: invalid restart interval segment");
+
+		if (decodeFirst == first && decodeLast == last)
+		{
+			tj.check(tj3Decompress8(tj, segment.data(), segment.size(), dst + rowBegin * pitch, int(pitch), TJPF_RGBA));
+			return;
+		}
+
+		std::vector<uint8_t> rows(decodeHeight * pitch);
+		tj.check(tj3Decompress8(tj, segment.data(), segment.size(), rows.data(), int(pitch), TJPF_RGBA));
+		memcpy(dst + rowBegin * pitch, rows.data() + (rowBegin - decodeBegin) * pitch, (rowEnd - rowBegin) * pitch);
+	}
+
+	// ycbcr to rgb tables of libjpeg (jdcolor.c) with 16 bit fixed point precision
+	struct YccTables
+	{
+		int crR[256];
+		int cbB[256];
+		int crG[256];
+		int cbG[256];
+
+		YccTables()
+		{
+			auto fix = [](double x) { return int(x * 65536.0 + 0.5); };
+			for (int i = 0; i < 256; ++i)
+			{
+				const int x = i - 128;
+				crR[i] = (fix(1.40200) * x + 32768) >> 16;
+				cbB[i] = (fix(1.77200) * x + 32768) >> 16;
+				crG[i] = -fix(0.71414) * x;
+				cbG[i] = -fix(0.34414) * x + 32768;
+			}
+		}
+	};
+
+	uint8_t clampByte(int v)
+	{
+		return uint8_t(std::min(std::max(v, 0), 255));
+	}
+
+	// fancy (triangle filter) upsampling of a horizontally subsampled row like libjpeg (h2v1_fancy_upsample)
+	void upsampleH2V1(const uint8_t* src, int srcWidth, uint8_t* dst)
+	{
+		if (srcWidth == 1)
+		{
+			dst[0] = dst[1] = src[0];
+			return;
+		}
+		dst[0] = src[0];
+		dst[1] = uint8_t((src[0] * 3 + src[1] + 2) >> 2);
+		for (int i = 1; i < srcWidth - 1; ++i)
+		{
+			const int v = src[i] * 3;
+			dst[2 * i] = uint8_t((v + src[i - 1] + 1) >> 2);
+			dst[2 * i + 1] = uint8_t((v + src[i + 1] + 2) >> 2);
+		}
+		const int last = srcWidth - 1;
+		dst[2 * last] = uint8_t((src[last] * 3 + src[last - 1] + 1) >> 2);
+		dst[2 * last + 1] = src[last];
+	}
+
+	// fancy upsampling of a horizontally and vertically subsampled row like libjpeg (h2v2_fancy_upsample).
+	// near is the chroma row of the output row, far the neighbouring chroma row in the direction of the output row
+	void upsampleH2V2(const uint8_t* near, const uint8_t* far, int srcWidth, uint8_t* dst)
+	{
+		auto colsum = [&](int i) { return near[i] * 3 + far[i]; };
+		if (srcWidth == 1)
+		{
+			dst[0] = uint8_t((colsum(0) * 4 + 8) >> 4);
+			dst[1] = uint8_t((colsum(0) * 4 + 7) >> 4);
+			return;
+		}
+		int last = colsum(0);
+		int cur = colsum(1);
+		dst[0] = uint8_t((last * 4 + 8) >> 4);
+		dst[1] = uint8_t((last * 3 + cur + 7) >> 4);
+		for (int i = 1; i < srcWidth - 1; ++i)
+		{
+			const int next = colsum(i + 1);
+			dst[2 * i] = uint8_t((cur * 3 + last + 8) >> 4);
+			dst[2 * i + 1] = uint8_t((cur * 3 + next + 7) >> 4);
+			last = cur;
+			cur = next;
+		}
+		const int i = srcWidth - 1;
+		dst[2 * i] = uint8_t((cur * 3 + last + 8) >> 4);
+		dst[2 * i + 1] = uint8_t((cur * 4 + 7) >> 4);
+	}
+
+	// jpegs without restart markers: serial entropy decoding and idct into yuv planes (libjpeg-turbo does not expose them separately),
+	// followed by parallel chroma upsampling and color conversion. Returns nullptr for unsupported subsampling modes
+	std::unique_ptr<image::IImage> decodePlanar(JpegHeader& header, const std::vector<uint8_t>& file)
+	{
+		const int subsamp = tj3Get(header.tj, TJPARAM_SUBSAMP);
+		if (tj3Get(header.tj, TJPARAM_COLORSPACE) != TJCS_YCbCr ||
+			(subsamp != TJSAMP_444 && subsamp != TJSAMP_422 && subsamp != TJSAMP_420))
+			return nullptr;
+
+		const int width = header.width;
+		const int height = header.height;
+		std::vector<uint8_t> planes[3];
+		unsigned char* planePtrs[3];
+		int strides[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			strides[c] = tj3YUVPlaneWidth(c, width, subsamp);
+			planes[c].resize(size_t(strides[c]) * tj3YUVPlaneHeight(c, height, subsamp));
+			planePtrs[c] = planes[c].data();
+		}
+		const int chromaWidth = strides[1];
+		const int chromaHeight = tj3YUVPlaneHeight(1, height, subsamp);
+
+		header.tj.check(tj3SetScalingFactor(header.tj, TJUNSCALED));
+		header.tj.check(tj3DecompressToYUVPlanes8(header.tj, file.data(), file.size(), planePtrs, strides));
+
+		auto res = std::make_unique<image::SimpleImage>(header.original, gli::FORMAT_RGBA8_SRGB_PACK8, width, height, 4);
+		size_t size;
+		uint8_t* dst = res->getData(0, 0, size);
+		static const YccTables s_tables;
+
+		image::parallelRanges(size_t(height), [&](size_t begin, size_t end, size_t)
+		{
+			std::vector<uint8_t> cbRow(size_t(chromaWidth) * 2);
+			std::vector<uint8_t> crRow(size_t(chromaWidth) * 2);
+			for (size_t y = begin; y != end; ++y)
+			{
+				const uint8_t* luma = planes[0].data() + y * strides[0];
+				const uint8_t* cb = cbRow.data();
+				const uint8_t* cr = crRow.data();
+				if (subsamp == TJSAMP_444)
+				{
+					cb = planes[1].data() + y * strides[1];
+					cr = planes[2].data() + y * strides[2];
+				}
+				else if (subsamp == TJSAMP_422)
+				{
+					upsampleH2V1(planes[1].data() + y * strides[1], chromaWidth, cbRow.data());
+					upsampleH2V1(planes[2].data() + y * strides[2], chromaWidth, crRow.data());
+				}
+				else // 420: the neighbour is the chroma row above for even rows and below for odd rows (edge rows are replicated)
+				{
+					const size_t nearRow = y / 2;
+					const size_t farRow = y % 2 ? std::min(nearRow + 1, size_t(chromaHeight - 1)) : (nearRow ? nearRow - 1 : 0);
+					upsampleH2V2(planes[1].data() + nearRow * strides[1], planes[1].data() + farRow * strides[1], chromaWidth, cbRow.data());
+					upsampleH2V2(planes[2].data() + nearRow * strides[2], planes[2].data() + farRow * strides[2], chromaWidth, crRow.data());
+				}
+
+				uint8_t* out = dst + y * size_t(width) * 4;
+				for (int x = 0; x < width; ++x)
+				{
+					const int l = luma[x];
+					out[4 * x + 0] = clampByte(l + s_tables.crR[cr[x]]);
+					out[4 * x + 1] = clampByte(l + ((s_tables.cbG[cb[x]] + s_tables.crG[cr[x]]) >> 16));
+					out[4 * x + 2] = clampByte(l + s_tables.cbB[cb[x]]);
+					out[4 * x + 3] = 255;
+				}
+			}
+		}, 64);
+		return res;
+	}
+
+	// full resolution decode. Large images are decoded in parallel:
+	// files with restart markers are split into independent jpegs at mcu rows, other files run the color conversion in parallel
+	std::unique_ptr<image::IImage> decodeFull(JpegHeader& header, const std::vector<uint8_t>& file)
+	{
+		const size_t numPixels = size_t(header.width) * header.height;
+		const int minPixels = get_global_parameter_i("jpg parallel pixels", 0);
+		if (minPixels > 0 ? numPixels < size_t(minPixels) : numPixels < s_minParallelPixels || image::getNumThreads() == 1)
+			return decode(header, file, TJUNSCALED);
+
+		const int colorspace = tj3Get(header.tj, TJPARAM_COLORSPACE);
+		RestartIndex index;
+		if ((colorspace == TJCS_YCbCr || colorspace == TJCS_GRAY || colorspace == TJCS_RGB) && indexRestartIntervals(file, index))
+		{
+			auto res = std::make_unique<image::SimpleImage>(header.original, gli::FORMAT_RGBA8_SRGB_PACK8, header.width, header.height, 4);
+			size_t size;
+			uint8_t* dst = res->getData(0, 0, size);
+			try
+			{
+				image::parallelRanges(index.starts.size(), [&](size_t begin, size_t end, size_t)
+				{
+					decodeSegment(file, index, begin, end, header.width, dst);
+				});
+				return res;
+			}
+			catch (const abort_error&)
+			{
+				throw;
+			}
+			catch (const std::exception&)
+			{
+				// decode the whole file below (libjpeg-turbo recovers from broken intervals)
+			}
+		}
+
+		if (auto res = decodePlanar(header, file))
+			return res;
+
+		return decode(header, file, TJUNSCALED);
+	}
+
+	// libjpeg calls exit() on errors by default => jump back into decodeScans instead
+	struct JpegErrorManager
+	{
+		jpeg_error_mgr pub;
+		jmp_buf jump;
+	};
+
+	void jpegErrorExit(j_common_ptr cinfo)
+	{
+		longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+	}
+
+	// warnings (e.g. a few corrupt blocks) are ignored like in stb_image
+	void jpegOutputMessage(j_common_ptr) {}
+
+	// runs an output pass for the scans that were consumed so far.
+	// Previews use the fast idct without block smoothing, the final pass uses the same settings as turbojpeg
+	void outputScans(jpeg_decompress_struct& cinfo, uint8_t* dst, bool final)
+	{
+		cinfo.dct_method = final ? JDCT_ISLOW : JDCT_IFAST;
+		cinfo.do_block_smoothing = final;
+		jpeg_start_output(&cinfo, cinfo.input_scan_number);
+		while (cinfo.output_scanline < cinfo.output_height)
+		{
+			JSAMPROW row = dst + size_t(cinfo.output_scanline) * cinfo.output_width * 4;
+			jpeg_read_scanlines(&cinfo, &row, 1);
+		}
+		jpeg_finish_output(&cinfo);
+	}
+
+	// progressive jpegs: the scans are decoded with the buffered image mode of libjpeg. The image is reported as IMAGE_PREVIEW_PASS
+	// after the first scans that contain the dc coefficients of all components and then at most every s_scanPreviewInterval.
+	// Returns nullptr if libjpeg cannot decode the file
+	std::unique_ptr<image::IImage> decodeScans(const JpegHeader& header, const std::vector<uint8_t>& file)
+	{
+		// no objects with destructors may be created after setjmp (longjmp skips them)
+		auto res = std::make_unique<image::SimpleImage>(header.original, gli::FORMAT_RGBA8_SRGB_PACK8, header.width, header.height, 4);
+		size_t size;
+		uint8_t* dst = res->getData(0, 0, size);
+
+		jpeg_decompress_struct cinfo = {};
+		JpegErrorManager err;
+		cinfo.err = jpeg_std_error(&err.pub);
+		err.pub.error_exit = jpegErrorExit;
+		err.pub.output_message = jpegOutputMessage;
+		struct DecompressGuard
+		{
+			jpeg_decompress_struct* cinfo;
+			~DecompressGuard() { jpeg_destroy_decompress(cinfo); }
+		} guard = { &cinfo };
+
+		if (setjmp(err.jump))
+			return nullptr;
+
+		jpeg_create_decompress(&cinfo);
+		jpeg_mem_src(&cinfo, file.data(), static_cast<unsigned long>(file.size()));
+		jpeg_read_header(&cinfo, TRUE);
+		if (!cinfo.progressive_mode) return nullptr; // coef_bits are only available for progressive files
+		cinfo.out_color_space = JCS_EXT_RGBA;
+		cinfo.buffered_image = TRUE;
+		jpeg_start_decompress(&cinfo);
+		if (int(cinfo.output_width) != header.width || int(cinfo.output_height) != header.height || cinfo.output_components != 4)
+			return nullptr;
+
+		ImagePreview preview = {};
+		preview.data = dst;
+		preview.width = uint32_t(header.width);
+		preview.height = uint32_t(header.height);
+		preview.format = uint32_t(gli::FORMAT_RGBA8_SRGB_PACK8);
+		preview.numRows = preview.height;
+		preview.stage = IMAGE_PREVIEW_PASS;
+		std::chrono::steady_clock::time_point lastPreview;
+		std::chrono::steady_clock::duration interval = s_scanPreviewInterval;
+
+		// the whole file is in memory => jpeg_consume_input never suspends
+		int status;
+		while ((status = jpeg_consume_input(&cinfo)) != JPEG_REACHED_EOI)
+		{
+			if (status != JPEG_SCAN_COMPLETED) continue;
+			set_progress(uint32_t((cinfo.src->next_input_byte - file.data()) * 100 / file.size()));
+
+			bool hasDc = true;
+			for (int c = 0; c < cinfo.num_components; ++c)
+				hasDc = hasDc && cinfo.coef_bits[c][0] >= 0;
+			const auto now = std::chrono::steady_clock::now();
+			if (!hasDc || (preview.pass && now - lastPreview < interval))
+				continue;
+
+			outputScans(cinfo, dst, false);
+			lastPreview = std::chrono::steady_clock::now();
+			interval = std::max<std::chrono::steady_clock::duration>(s_scanPreviewInterval, 2 * (lastPreview - now));
+			set_preview(preview);
+			++preview.pass;
+		}
+
+		outputScans(cinfo, dst, true);
+		jpeg_finish_decompress(&cinfo);
+		return res;
+	}
+
+	// reports a dct scaled version of the image (fastest decode path of libjpeg-turbo)
+	void reportPreview(JpegHeader& header, const std::vector<uint8_t>& file)
+	{
+		// largest factor that fits into the preview size (1/8 for very large images)
+		int numFactors = 0;
+		const tjscalingfactor* factors = tj3GetScalingFactors(&numFactors);
+		tjscalingfactor factor = { 1, 8 };
+		for (int i = 0; i < numFactors; ++i)
+		{
+			const auto& f = factors[i];
+			if (f.num >= f.denom) continue;
+			if (scaledSize(header, f) <= int(s_maxPreviewSize) && scaledSize(header, f) > scaledSize(header, factor))
+				factor = f;
+		}
+
+		std::unique_ptr<image::IImage> small;
+		try
+		{
+			small = decode(header, file, factor);
+		}
+		catch (const std::exception&)
+		{
+			return; // the full decode reports the error
+		}
+
+		size_t size;
+		ImagePreview preview = {};
+		preview.data = small->getData(0, 0, size);
+		preview.width = small->getWidth(0);
+		preview.height = small->getHeight(0);
+		preview.format = uint32_t(small->getFormat());
+		preview.numRows = preview.height;
+		preview.stage = IMAGE_PREVIEW_MIPMAP;
+		set_preview(preview);
+	}
+}
+
+std::unique_ptr<image::IImage> jpeg_load(const char* filename)
+{
+	const auto file = readFile(filename);
+	std::unique_ptr<JpegHeader> header;
+	try
+	{
+		header = std::make_unique<JpegHeader>(file);
+	}
+	catch (const std::exception&)
+	{
+		// not a jpeg or a header that libjpeg-turbo does not support
+		return stb_image_load(filename);
+	}
+
+	// images that are smaller than the preview are decoded quickly anyways.
+	// Progressive files report their scans instead (a dct scaled decode has to read all scans as well)
+	if (wants_preview() && uint32_t(std::max(header->width, header->height)) > s_maxPreviewSize)
+	{
+		if (tj3Get(header->tj, TJPARAM_PROGRESSIVE) == 1)
+		{
+			if (auto res = decodeScans(*header, file))
+				return res;
+		}
+		else reportPreview(*header, file);
+	}
+
+	set_progress(0, "decoding jpeg");
+	try
+	{
+		return decodeFull(*header, file);
+	}
+	catch (const abort_error&)
+	{
+		throw;
+	}
+	catch (const std::exception&)
+	{
+		// e.g. CMYK images
+		return stb_image_load(filename);
+	}
+}
+
+std::unique_ptr<image::IImage> jpeg_load_scaled(const char* filename, uint32_t minSize)
+{
+	const auto file = readFile(filename);
+	try
+	{
+		JpegHeader header(file);
+		return decode(header, file, findScalingFactor(header, minSize));
+	}
+	catch (const std::exception&)
+	{
+		return stb_image_load(filename);
+	}
+}
+
+void jpeg_write(const image::IImage& image, const char* filename, gli::format format, int quality)
+{
+	if (image.getFormat() != gli::FORMAT_RGBA8_SRGB_PACK8 &&
+		image.getFormat() != gli::FORMAT_RGBA8_UNORM_PACK8 &&
+		image.getFormat() != gli::FORMAT_RGBA8_SNORM_PACK8)
+		throw std::runtime_error("unexpected image format. Expected one of FORMAT_RGBA8_SRGB_PACK8, FORMAT_RGBA8_UNORM_PACK8, FORMAT_RGBA8_SNORM_PACK8");
+
+	const int nComponents = stb_ldr_get_num_components(format);
+	const int width = int(image.getWidth(0));
+	const int height = int(image.getHeight(0));
+	size_t size;
+	const uint8_t* data = image.getData(0, 0, size);
+
+	if (quality < 1 || quality > 100)
+		throw std::out_of_range("quality must be between 1 and 100");
+
+	TurboHandle tj(TJINIT_COMPRESS);
+	tj.check(tj3Set(tj, TJPARAM_QUALITY, quality));
+	tj.check(tj3Set(tj, TJPARAM_OPTIMIZE, 1));
+	tj.check(tj3Set(tj, TJPARAM_PROGRESSIVE, get_global_parameter_i("jpg progressive", 0) ? 1 : 0));
+
+	unsigned char* jpeg = nullptr;
+	size_t jpegSize = 0;
+	int res;
+	if (nComponents == 1)
+	{
+		// red channel (same as the other 8 bit exporters)
+		std::vector<uint8_t> gray(size_t(width) * height);
+		for (size_t i = 0; i < gray.size(); ++i)
+			gray[i] = data[i * 4];
+
+		tj.check(tj3Set(tj, TJPARAM_SUBSAMP, TJSAMP_GRAY));
+		res = tj3Compress8(tj, gray.data(), width, width, height, TJPF_GRAY, &jpeg, &jpegSize);
+	}
+	else
+	{
+		// chroma subsampling for lower qualities (like stb_image_write)
+		tj.check(tj3Set(tj, TJPARAM_SUBSAMP, quality <= 90 ? TJSAMP_420 : TJSAMP_444));
+		// the alpha channel is ignored
+		res = tj3Compress8(tj, data, width, width * 4, height, TJPF_RGBX, &jpeg, &jpegSize);
+	}
+
+	try
+	{
+		tj.check(res);
+		std::ofstream file(filename, std::ios::binary);
+		if (!file) throw std::runtime_error("could not open file");
+		file.write(reinterpret_cast<const char*>(jpeg), jpegSize);
+		if (!file) throw std::runtime_error("could not write file");
+	}
+	catch (...)
+	{
+		tj3Free(jpeg);
+		throw;
+	}
+	tj3Free(jpeg);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <memory>
+#include "Image.h"
+
+// jpeg import and export with libjpeg-turbo. Files that libjpeg-turbo cannot decode are loaded with stb_image
+
+// decodes the file into RGBA8 srgb. Reports a dct scaled preview for image_open_progressive (progressive files report their scans).
+// Large files with restart markers are decoded in parallel (one decompressor per group of mcu rows)
+std::unique_ptr<image::IImage> jpeg_load(const char* filename);
+
+// decodes a dct scaled version (1/2 to 1/8) of the file whose longer side is at least minSize (for thumbnails)
+std::unique_ptr<image::IImage> jpeg_load_scaled(const char* filename, uint32_t minSize);
+
+// exports the RGBA8 image as FORMAT_R8_SRGB_PACK8 (red channel) or FORMAT_RGB8_SRGB_PACK8 with optimized huffman tables.
+// The global parameter "jpg progressive" enables progressive encoding
+void jpeg_write(const image::IImage& image, const char* filename, gli::format format, int quality);
@@ -39,30 +39,11 @@ unsigned* npy_get_shape(const char* filename, unsigned int* dim)
 	return s_shape.data();
 }
 
-static bool NumpyIs3D()
-{
-	return get_global_parameter_i("npy is3D", 0) != 0;
-}
-
-static bool NumpyUseChannels()
-{
-	return get_global_parameter_i("npy useChannel", 1) != 0;
-}
-
-static int NumpyFirstLayer()
-{
-	return get_global_parameter_i("npy firstLayer", 0);
-}
-
-static int NumpyLastLayer()
-{
-	return get_global_parameter_i("npy lastLayer", -1);
-}
-
 class NumpyImage final : public image::IImage
 {
 public:
-	NumpyImage(const char* filename)
+	NumpyImage(const char* filename, const ImageLoadOptions& options)
+		: m_is3D(options.npyLayout == IMAGE_NPY_VOLUME)
 	{
 		// load numpy file
 		std::vector<unsigned long> shape;
@@ -73,7 +54,7 @@ public:
 		auto nComponents = 1; // for now nComponents is always 1
 
 		// last dimension is usually the channel size. Try to use it as channel size if it is small enough (and texture is at least 2D)
-		if (NumpyUseChannels() && shape.back() <= 4)
+		if (options.npyChannels == IMAGE_NPY_CHANNELS_AUTO && shape.back() <= 4)
 		{
 			nComponents = shape.back();
 			shape.pop_back(); // remove from list
@@ -111,13 +92,13 @@ public:
 		}
 
 		// determine if data needs to be cropped
-		uint32_t firstLayer = NumpyFirstLayer();
-		uint32_t lastLayer = NumpyLastLayer();
-		if (lastLayer == unsigned(-1))
-			lastLayer = m_depth - 1u;
+		const uint32_t firstLayer = options.firstLayer;
+		if (firstLayer >= m_depth || options.numLayers > m_depth - firstLayer)
+			throw std::runtime_error("layer range exceeds the array shape");
+		const uint32_t lastLayer = options.numLayers ? firstLayer + options.numLayers - 1u : m_depth - 1u;
 
 		// crop data if required
-		if(firstLayer != 0 || unsigned(lastLayer) != (m_depth - 1u))
+		if(firstLayer != 0 || lastLayer != (m_depth - 1u))
 		{
 			size_t sliceSize = size_t(m_width) * size_t(m_height) * 4;
 
@@ -128,16 +109,16 @@ public:
 		}
 	}
 
-	uint32_t getNumLayers() const override { return NumpyIs3D() ? 1 : m_depth; }
+	uint32_t getNumLayers() const override { return m_is3D ? 1 : m_depth; }
 	uint32_t getNumMipmaps() const override { return 1; }
 	uint32_t getWidth(uint32_t mipmap) const override { return m_width; }
 	uint32_t getHeight(uint32_t mipmap) const override { return m_height; }
-	uint32_t getDepth(uint32_t mipmap) const override { return NumpyIs3D() ? m_depth : 1; }
+	uint32_t getDepth(uint32_t mipmap) const override { return m_is3D ? m_depth : 1; }
 	gli::format getFormat() const override { return gli::FORMAT_RGBA32_SFLOAT_PACK32; }
 	gli::format getOriginalFormat() const override { return m_originalFormat; }
 	uint8_t* getData(uint32_t layer, uint32_t mipmap, size_t& size) override
 	{
-		if (NumpyIs3D())
+		if (m_is3D)
 		{
 			assert(layer == 0);
 			assert(mipmap == 0);
@@ -310,11 +291,12 @@ private:
 	uint32_t m_width = 1;
 	uint32_t m_height = 1;
 	uint32_t m_depth = 1;
+	const bool m_is3D; // layout is fixed when the file is opened
 };
 
-std::unique_ptr<image::IImage> numpy_load(const char* filename)
+std::unique_ptr<image::IImage> numpy_load(const char* filename, const ImageLoadOptions& options)
 {
-	return std::make_unique<NumpyImage>(filename);
+	return std::make_unique<NumpyImage>(filename, options);
 }
 
 std::vector<uint32_t> numpy_get_export_formats()
@@ -0,0 +1,108 @@
+#pragma once
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace image
+{
+	// number of threads that should be used for parallel work
+	inline size_t getNumThreads()
+	{
+		static const size_t s_numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		return s_numThreads;
+	}
+
+	// state of the current thread that is passed on to the threads of parallelRanges
+	struct ThreadContext
+	{
+		// upper bound for the number of ranges of parallelRanges calls (0 = no limit).
+		// Used by the conversion daemon: concurrent requests already keep the other cores busy
+		size_t limit = 0;
+		// receives the set_progress calls instead of the progress callback (see set_thread_progress_handler)
+		const std::function<bool(uint32_t progress, const char* description)>* progressHandler = nullptr;
+	};
+
+	inline ThreadContext& threadContext()
+	{
+		thread_local ThreadContext s_context;
+		return s_context;
+	}
+
+	// upper bound for the number of ranges of parallelRanges calls on the current thread (0 = no limit)
+	inline size_t& threadLimit()
+	{
+		return threadContext().limit;
+	}
+
+	// splits [0, count) into at most getNumThreads() (or threadLimit()) contiguous ranges and calls func(begin, end, rangeIndex) for each range.
+	// ranges will contain at least minRangeSize elements (except for the last one).
+	// the calling thread processes the first range, the other threads inherit its ThreadContext. The first exception of any range is rethrown after all ranges finished.
+	// returns the number of ranges that were used
+	template<class Func>
+	size_t parallelRanges(size_t count, Func func, size_t minRangeSize = 1)
+	{
+		if (count == 0) return 0;
+
+		minRangeSize = std::max<size_t>(minRangeSize, 1);
+		const size_t maxRanges = threadLimit() ? std::min(threadLimit(), getNumThreads()) : getNumThreads();
+		const size_t numRanges = std::max<size_t>(std::min(maxRanges, (count + minRangeSize - 1) / minRangeSize), 1);
+		const size_t rangeSize = (count + numRanges - 1) / numRanges;
+
+		if (numRanges == 1)
+		{
+			func(size_t(0), count, size_t(0));
+			return 1;
+		}
+
+		std::vector<std::exception_ptr> errors(numRanges);
+		std::vector<std::thread> threads;
+		threads.reserve(numRanges - 1);
+
+		auto runRange = [&](size_t rangeIndex)
+		{
+			const size_t begin = std::min(rangeIndex * rangeSize, count);
+			const size_t end = std::min(begin + rangeSize, count);
+			if (begin == end) return;
+			try
+			{
+				func(begin, end, rangeIndex);
+			}
+			catch (...)
+			{
+				errors[rangeIndex] = std::current_exception();
+			}
+		};
+
+		const ThreadContext context = threadContext();
+		for (size_t i = 1; i < numRanges; ++i)
+			threads.emplace_back([&runRange, &context, i]
+			{
+				threadContext() = context;
+				runRange(i);
+			});
+
+		runRange(0);
+
+		for (auto& t : threads)
+			t.join();
+
+		for (const auto& e : errors)
+			if (e) std::rethrow_exception(e);
+
+		return numRanges;
+	}
+
+	// calls func(i) for all i in [0, count) on multiple threads
+	template<class Func>
+	void parallelFor(size_t count, Func func, size_t minRangeSize = 1)
+	{
+		parallelRanges(count, [&func](size_t begin, size_t end, size_t)
+		{
+			for (size_t i = begin; i < end; ++i)
+				func(i);
+		}, minRangeSize);
+	}
+}
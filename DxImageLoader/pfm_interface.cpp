@@ -3,25 +3,140 @@
 #include <fstream>
 #include <memory>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <emmintrin.h>
 #include "convert.h"
 #include "interface.h"
+#include "parallel.h"
 
-using uchar = unsigned char;
+// rows are read, converted and written in blocks of this size
+static constexpr size_t s_blockSize = size_t(32) << 20;
+static constexpr size_t s_minParallelRows = 8;
+// smaller blocks are used when row previews are requested
+static constexpr size_t s_previewBlockRows = 256;
 
-void swapBytes(float* fptr)
+static __m128 swapBytes(__m128 v)
 { // if endianness doesn't agree, swap bytes
-	uchar* ptr = reinterpret_cast<uchar*>(fptr);
-	uchar tmp = 0;
-	tmp = ptr[0]; ptr[0] = ptr[3]; ptr[3] = tmp;
-	tmp = ptr[1]; ptr[1] = ptr[2]; ptr[2] = tmp;
+	__m128i i = _mm_castps_si128(v);
+	i = _mm_or_si128(_mm_slli_epi16(i, 8), _mm_srli_epi16(i, 8));
+	i = _mm_shufflehi_epi16(_mm_shufflelo_epi16(i, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+	return _mm_castsi128_ps(i);
 }
 
-struct Pixel
+static float swapBytes(float f)
 {
-	float r, g, b;
-};
+	uint32_t i;
+	memcpy(&i, &f, sizeof(i));
+	i = (i >> 24) | ((i >> 8) & 0xFF00) | ((i << 8) & 0xFF0000) | (i << 24);
+	memcpy(&f, &i, sizeof(i));
+	return f;
+}
+
+// loads 4 floats from the file and applies the byte swap and scale
+template<bool Swap>
+static __m128 loadFile(const float* src, __m128 scale)
+{
+	__m128 v = _mm_loadu_ps(src);
+	if (Swap) v = swapBytes(v);
+	return _mm_mul_ps(v, scale);
+}
+
+template<bool Swap>
+static float loadFile(const float* src, float scale)
+{
+	return (Swap ? swapBytes(*src) : *src) * scale;
+}
+
+// converts a row of the file (components = 1 or 3) to RGBA (alpha = 1)
+template<bool Swap>
+static void convertRow(const float* src, float* dst, int width, int components, float scale)
+{
+	const __m128 scale4 = _mm_set1_ps(scale);
+	const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 alpha = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	auto setAlpha = [&](__m128 v) { return _mm_or_ps(_mm_and_ps(v, rgbMask), alpha); };
+
+	int x = 0;
+	if (components == 3)
+	{
+		// 4 pixels = 3 vectors: (r0 g0 b0 r1) (g1 b1 r2 g2) (b2 r3 g3 b3)
+		for (; x + 4 <= width; x += 4, src += 12, dst += 16)
+		{
+			const __m128 a = loadFile<Swap>(src, scale4);
+			const __m128 b = loadFile<Swap>(src + 4, scale4);
+			const __m128 c = loadFile<Swap>(src + 8, scale4);
+			const __m128 ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 3, 3)); // r1 r1 g1 b1
+			_mm_storeu_ps(dst, setAlpha(a));
+			_mm_storeu_ps(dst + 4, setAlpha(_mm_shuffle_ps(ab, ab, _MM_SHUFFLE(3, 3, 2, 1))));
+			_mm_storeu_ps(dst + 8, setAlpha(_mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 0, 3, 2))));
+			_mm_storeu_ps(dst + 12, setAlpha(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 2, 1))));
+		}
+		for (; x < width; ++x, src += 3, dst += 4)
+		{
+			dst[0] = loadFile<Swap>(src, scale);
+			dst[1] = loadFile<Swap>(src + 1, scale);
+			dst[2] = loadFile<Swap>(src + 2, scale);
+			dst[3] = 1.0f; // alpha
+		}
+	}
+	else
+	{
+		// grayscale => repeat on each channel
+		for (; x + 4 <= width; x += 4, src += 4, dst += 16)
+		{
+			const __m128 v = loadFile<Swap>(src, scale4);
+			_mm_storeu_ps(dst, setAlpha(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0))));
+			_mm_storeu_ps(dst + 4, setAlpha(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+			_mm_storeu_ps(dst + 8, setAlpha(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+			_mm_storeu_ps(dst + 12, setAlpha(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+		}
+		for (; x < width; ++x, ++src, dst += 4)
+		{
+			const float v = loadFile<Swap>(src, scale);
+			dst[0] = v;
+			dst[1] = v;
+			dst[2] = v;
+			dst[3] = 1.0f; // alpha
+		}
+	}
+}
+
+// extracts the first components (1 or 3) of each RGBA pixel
+static void assembleRow(const float* src, float* dst, int width, int components)
+{
+	int x = 0;
+	if (components == 3)
+	{
+		// 4 pixels => (r0 g0 b0 r1) (g1 b1 r2 g2) (b2 r3 g3 b3)
+		for (; x + 4 <= width; x += 4, src += 16, dst += 12)
+		{
+			const __m128 p0 = _mm_loadu_ps(src);
+			const __m128 p1 = _mm_loadu_ps(src + 4);
+			const __m128 p2 = _mm_loadu_ps(src + 8);
+			const __m128 p3 = _mm_loadu_ps(src + 12);
+			const __m128 b0r1 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0, 0, 2, 2)); // b0 b0 r1 r1
+			const __m128 g1b1 = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1, 0, 2, 1)); // g1 b1 r2 g2
+			const __m128 b2 = _mm_shuffle_ps(p2, p3, _MM_SHUFFLE(0, 0, 2, 2)); // b2 b2 r3 r3
+			_mm_storeu_ps(dst, _mm_shuffle_ps(p0, b0r1, _MM_SHUFFLE(2, 0, 1, 0)));
+			_mm_storeu_ps(dst + 4, g1b1);
+			_mm_storeu_ps(dst + 8, _mm_shuffle_ps(b2, p3, _MM_SHUFFLE(2, 1, 2, 0)));
+		}
+		for (; x < width; ++x, src += 4, dst += 3)
+		{
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+		}
+	}
+	else
+	{
+		for (; x < width; ++x, src += 4)
+			*dst++ = src[0];
+	}
+}
 
-void skipNewlines(std::fstream& file)
+static void skipNewlines(std::fstream& file)
 {
 	while (file.peek() == '\n' || file.peek() == 0 || file.peek() == ' ' || file.peek() == '\r' || file.peek() == '\t')
 		file.get();
@@ -37,8 +152,7 @@ std::unique_ptr<image::IImage> pfm_load(const char* filename)
 
 	//                          "PF" = color        (3-band)
 	int width, height;      // width and height of the image
-	float scalef, fvalue;   // scale factor and temp value to hold pixel value
-	Pixel vfvalue;          // temp value to hold 3-band pixel value
+	float scalef;           // scale factor
 
 							// extract header information, skips whitespace 
 	//file >> bands;
@@ -71,55 +185,62 @@ std::unique_ptr<image::IImage> pfm_load(const char* filename)
 		throw std::exception("invalid header - whitespace expected");
 	}
 
-	bool grayscale = (bands == "Pf");
+	int components = 0;
+	if (bands == "Pf") components = 1;      // 1-band image
+	else if (bands == "PF") components = 3; // 3-band image
+	else
+		throw std::exception("invalid header - unknown bands description");
+
+	if (width <= 0 || height <= 0)
+		throw std::runtime_error("invalid header - invalid image size");
 
 	auto res = std::make_unique<image::SimpleImage>(
-		grayscale ? gli::FORMAT_R32_SFLOAT_PACK32 : gli::FORMAT_RGB32_SFLOAT_PACK32,
+		components == 1 ? gli::FORMAT_R32_SFLOAT_PACK32 : gli::FORMAT_RGB32_SFLOAT_PACK32,
 		gli::format::FORMAT_RGBA32_SFLOAT_PACK32,
 		width, height, 4 * 4);
 
 	size_t size;
 	auto data = reinterpret_cast<float*>(res->getData(0, 0, size));
 
-	if (bands == "Pf") {          // handle 1-band image 
-
-		for (int i = 0; i < height; ++i) {
-			for (int j = 0; j < width; ++j) {
-				file.read(reinterpret_cast<char*>(&fvalue), sizeof(fvalue));
-				if (needSwap) {
-					swapBytes(&fvalue);
-				}
-				auto offset = data + ((height - i - 1) * width + j) * 4;
-				fvalue *= absScale; // apply scale
-				offset[0] = fvalue; // grayscale => repeat on each channel
-				offset[1] = fvalue;
-				offset[2] = fvalue;
-				offset[3] = 1.0f; // alpha
-			}
-			set_progress(i * 100 / height);
-		}
-	}
-	else if (bands == "PF") {    // handle 3-band image
-
-		for (int i = 0; i < height; ++i) {
-			for (int j = 0; j < width; ++j) {
-				file.read(reinterpret_cast<char*>(&vfvalue), sizeof(vfvalue));
-				if (needSwap) {
-					swapBytes(&vfvalue.r);
-					swapBytes(&vfvalue.g);
-					swapBytes(&vfvalue.b);
-				}
-				auto offset = data + ((height - i - 1) * width + j) * 4;
-				offset[0] = vfvalue.r * absScale;
-				offset[1] = vfvalue.g * absScale;
-				offset[2] = vfvalue.b * absScale;
-				offset[3] = 1.0f; // alpha
+	ImagePreview preview = {};
+	preview.data = reinterpret_cast<const uint8_t*>(data);
+	preview.width = uint32_t(width);
+	preview.height = uint32_t(height);
+	preview.format = uint32_t(gli::format::FORMAT_RGBA32_SFLOAT_PACK32);
+	preview.numRows = uint32_t(height);
+	preview.stage = IMAGE_PREVIEW_ROWS;
+
+	// the rows are read in large blocks and converted in parallel (the file starts with the bottom row)
+	const size_t rowFloats = size_t(width) * components;
+	size_t blockRows = std::max<size_t>(s_blockSize / (rowFloats * sizeof(float)), 1);
+	if (wants_preview())
+		blockRows = std::min(blockRows, s_previewBlockRows);
+	std::vector<float> block(std::min(blockRows, size_t(height)) * rowFloats);
+	for (size_t firstRow = 0; firstRow < size_t(height); firstRow += blockRows)
+	{
+		const size_t numRows = std::min(blockRows, size_t(height) - firstRow);
+		file.read(reinterpret_cast<char*>(block.data()), std::streamsize(numRows * rowFloats * sizeof(float)));
+		if (!file)
+			throw std::runtime_error("unexpected end of file");
+
+		image::parallelRanges(numRows, [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const float* src = block.data() + i * rowFloats;
+				float* dst = data + (size_t(height) - firstRow - i - 1) * size_t(width) * 4;
+				if (needSwap) convertRow<true>(src, dst, width, components, absScale);
+				else convertRow<false>(src, dst, width, components, absScale);
 			}
-			set_progress(i * 100 / height);
-		}
+		}, s_minParallelRows);
+
+		set_progress(uint32_t((firstRow + numRows) * 100 / height));
+
+		// the decoded rows grow from the bottom of the image
+		preview.firstRow = uint32_t(size_t(height) - firstRow - numRows);
+		if (preview.firstRow != 0)
+			set_preview(preview);
 	}
-	else
-		throw std::exception("invalid header - unknown bands description");
 
 	return res;
 }
@@ -132,7 +253,7 @@ std::vector<uint32_t> pfm_get_export_formats()
 	};
 }
 
-void pfm_save(const char* filename, int width, int height, int components, const void* data)
+void pfm_save(const char* filename, int width, int height, int components, const float* rgba)
 {
 	if (components != 1 && components != 3) 
 		throw std::runtime_error("pfm supports either 1 or 3 components");
@@ -146,14 +267,26 @@ void pfm_save(const char* filename, int width, int height, int components, const
 
 	file.write("-1.000000\n", sizeof(char) * 10);
 
-	const float* v = reinterpret_cast<const float*>(data);
-	for (int y = 0; y < height; ++y)
+	// rows are assembled in parallel (bottom row first) and written in large blocks
+	const size_t rowFloats = size_t(width) * components;
+	const size_t blockRows = std::max<size_t>(s_blockSize / (rowFloats * sizeof(float)), 1);
+	std::vector<float> block(std::min(blockRows, size_t(height)) * rowFloats);
+	for (size_t firstRow = 0; firstRow < size_t(height); firstRow += blockRows)
 	{
-		for (int x = 0; x < width; ++x)
+		const size_t numRows = std::min(blockRows, size_t(height) - firstRow);
+		image::parallelRanges(numRows, [&](size_t begin, size_t end, size_t)
 		{
-			for (int c = 0; c < components; ++c)
-				file.write(reinterpret_cast<const char*>(&v[c + components * (x + (height - y - 1) * width)]), sizeof(float));
-		}
-		set_progress(y * 100 / height);
+			for (size_t i = begin; i < end; ++i)
+			{
+				const float* src = rgba + (size_t(height) - firstRow - i - 1) * size_t(width) * 4;
+				assembleRow(src, block.data() + i * rowFloats, width, components);
+			}
+		}, s_minParallelRows);
+
+		file.write(reinterpret_cast<const char*>(block.data()), std::streamsize(numRows * rowFloats * sizeof(float)));
+		if (!file)
+			throw std::runtime_error("Writing hdr image to " + std::string(filename) + ". write failed");
+
+		set_progress(uint32_t((firstRow + numRows) * 100 / height));
 	}
-}
\ No newline at end of file
+}
@@ -6,4 +6,5 @@ std::unique_ptr<image::IImage> pfm_load(const char* filename);
 
 std::vector<uint32_t> pfm_get_export_formats();
 
-void pfm_save(const char* filename, int width, int height, int components, const void* data);
\ No newline at end of file
+// writes the first components (1 or 3) of the RGBA32F data
+void pfm_save(const char* filename, int width, int height, int components, const float* rgba);
\ No newline at end of file
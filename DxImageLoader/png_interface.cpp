@@ -6,8 +6,13 @@
 #include <string>
 #include "convert.h"
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <emmintrin.h>
 #include "interface.h"
 #include "stbi_interface.h"
+#include "parallel.h"
+#include "../dependencies/zlib/zlib.h"
 
 struct ImportFormatInfo
 {
@@ -232,12 +237,111 @@ std::vector<uint32_t> png_get_export_formats()
 	};
 }
 
-static uint32_t s_num_rows = 0;
+// the progress callback of libpng is called on the thread that reads or writes the file
+static thread_local uint32_t s_num_rows = 0;
 void png_progress(png_structp pPng, png_uint_32 row, int pass)
 {
 	set_progress(row * 100 / s_num_rows);
 }
 
+// rows that are decoded between two previews of non interlaced images
+static constexpr uint32_t s_previewRowBand = 16;
+
+// converts 16 bit unorm values to [0, 1] floats
+static void png_unorm16_to_float(const uint16_t* src, float* dst, size_t count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 65535.0f);
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), scale));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), scale));
+	}
+	for (; i < count; ++i)
+		dst[i] = float(src[i]) * (1.0f / 65535.0f);
+}
+
+// reads the rows [y, y + count) of a non interlaced image. 16 bit rows are decoded into the row sized scratch buffer
+// and converted to float while libpng produces them
+static void png_read_converted_rows(png_structp pPng, const ImportFormatInfo& info, uint8_t* data, uint32_t y, uint32_t count, std::vector<uint16_t>& scratch)
+{
+	const size_t numValues = size_t(info.width) * 4;
+	for (const uint32_t end = y + count; y < end; ++y)
+	{
+		if (info.bitDepth <= 8)
+		{
+			png_read_row(pPng, data + y * numValues, nullptr);
+			continue;
+		}
+		png_read_row(pPng, reinterpret_cast<png_bytep>(scratch.data()), nullptr);
+		png_unorm16_to_float(scratch.data(), reinterpret_cast<float*>(data) + y * numValues, numValues);
+	}
+}
+
+// converts the packed 16 bit rows of an interlaced image to float rows (in place, back to front)
+static void png_convert_rows_inplace(const ImportFormatInfo& info, uint8_t* data)
+{
+	const size_t numValues = size_t(info.width) * 4;
+	std::vector<uint16_t> scratch(numValues);
+	for (uint32_t y = info.height; y-- > 0;)
+	{
+		// the float row overlaps its own 16 bit row
+		std::memcpy(scratch.data(), data + y * numValues * sizeof(uint16_t), numValues * sizeof(uint16_t));
+		png_unorm16_to_float(scratch.data(), reinterpret_cast<float*>(data) + y * numValues, numValues);
+	}
+}
+
+// reads the interlaced image like png_read_image and reports the passes as previews
+static void png_read_passes(png_structp pPng, const ImportFormatInfo& info, std::vector<png_bytep>& rows, int numPasses)
+{
+	ImagePreview preview = {};
+	preview.data = rows[0];
+	preview.width = info.width;
+	preview.height = info.height;
+	// 16 bit values are converted to float after the last pass
+	preview.format = info.bitDepth <= 8 ? uint32_t(info.staging) : uint32_t(gli::format::FORMAT_RGBA16_UNORM_PACK16);
+	preview.stage = IMAGE_PREVIEW_PASS;
+	preview.numRows = info.height;
+	for (int pass = 0; pass < numPasses; ++pass)
+	{
+		// display rows: libpng replicates the pixels of the pass into the rows and columns that are still missing
+		png_read_rows(pPng, nullptr, rows.data(), info.height);
+		preview.pass = uint32_t(pass);
+		if (pass + 1 < numPasses)
+			set_preview(preview);
+	}
+}
+
+// reads the non interlaced image and reports the decoded rows as previews
+static void png_read_row_previews(png_structp pPng, const ImportFormatInfo& info, uint8_t* data, std::vector<uint16_t>& scratch)
+{
+	ImagePreview preview = {};
+	preview.data = data;
+	preview.width = info.width;
+	preview.height = info.height;
+	preview.format = uint32_t(info.staging);
+	preview.stage = IMAGE_PREVIEW_ROWS;
+	for (uint32_t y = 0; y < info.height; y += s_previewRowBand)
+	{
+		const uint32_t count = std::min(s_previewRowBand, info.height - y);
+		png_read_converted_rows(pPng, info, data, y, count, scratch);
+		preview.numRows = y + count;
+		if (preview.numRows < info.height)
+			set_preview(preview);
+	}
+}
+
+static void png_destroy_read(png_structp& pPng, png_infop& pInfo)
+{
+	if (!pPng) return;
+	if (pInfo)
+		png_destroy_read_struct(&pPng, &pInfo, nullptr);
+	else
+		png_destroy_read_struct(&pPng, nullptr, nullptr);
+}
+
 std::unique_ptr<image::IImage> png_load(const char* filename)
 {
 	FILE* fp = fopen(filename, "rb");
@@ -332,6 +436,9 @@ std::unique_ptr<image::IImage> png_load(const char* filename)
 		if((info.colorType & PNG_COLOR_MASK_ALPHA) == 0)
 			png_set_filler(pPng, 0xFFFF, PNG_FILLER_AFTER);
 
+		// Adam7 passes are combined by libpng (1 = not interlaced)
+		const int numPasses = png_set_interlace_handling(pPng);
+
 		png_read_update_info(pPng, pInfo);
 		complete_import_info(info);
 
@@ -342,46 +449,49 @@ std::unique_ptr<image::IImage> png_load(const char* filename)
 			info.bitDepth <= 8 ? 4 : 4 * 4
 		));
 
-		std::vector<png_bytep> rows;
-		rows.resize(info.height);
 		s_num_rows = info.height;
 		size_t dataSize;
-		auto data = res->getData(0, 0, dataSize);
-		auto rowStride = info.width * (info.bitDepth <= 8 ? 4 : 2 * 4);
-		for(auto& r:  rows)
-		{
-			r = data;
-			data += rowStride;
-		}
+		uint8_t* data = res->getData(0, 0, dataSize);
 
-		png_read_image(pPng, rows.data());
-		png_read_end(pPng, pInfo);
+		if (numPasses > 1)
+		{
+			// libpng combines the passes in the final rows => 16 bit images are converted after the last pass
+			std::vector<png_bytep> rows(info.height);
+			const size_t rowStride = size_t(info.width) * (info.bitDepth <= 8 ? 4 : 2 * 4);
+			for (uint32_t y = 0; y < info.height; ++y)
+				rows[y] = data + y * rowStride;
+
+			if (wants_preview())
+				png_read_passes(pPng, info, rows, numPasses);
+			else
+				png_read_image(pPng, rows.data());
 
-		// fix image stride
-		if(info.bitDepth == 16)
+			if (info.bitDepth == 16)
+				png_convert_rows_inplace(info, data);
+		}
+		else
 		{
-			// do conversion to 32 bit (from back to front to do this inplace)
-			auto buffer = res->getData(0, 0, dataSize);
-			const uint16_t* src = reinterpret_cast<uint16_t*>(buffer) + info.width * info.height * 4 - 1;
-			const uint16_t* end = reinterpret_cast<uint16_t*>(buffer) - 1;
-			float* dst = reinterpret_cast<float*>(buffer) + info.width * info.height * 4 - 1;
-			float invMax = 1.0f / float(std::numeric_limits<uint16_t>::max());
-
-			for (; src != end; --src, --dst)
-			{
-				*dst = float(*src) * invMax;
-			}
+			std::vector<uint16_t> scratch(info.bitDepth == 16 ? size_t(info.width) * 4 : 0);
+			if (wants_preview())
+				png_read_row_previews(pPng, info, data, scratch);
+			else
+				png_read_converted_rows(pPng, info, data, 0, info.height, scratch);
 		}
+		png_read_end(pPng, pInfo);
+	}
+	catch (const abort_error&)
+	{
+		// the progress or preview callback aborted the load => no stb fallback
+		fclose(fp);
+		png_destroy_read(pPng, pInfo);
+		throw;
 	}
 	catch (...)
 	{
 		fclose(fp);
 		if(pPng)
 		{
-			if (pInfo)
-				png_destroy_read_struct(&pPng, &pInfo, nullptr);
-			else
-				png_destroy_read_struct(&pPng, nullptr, nullptr);
+			png_destroy_read(pPng, pInfo);
 
 			// try to open it with stb. sometimes files are saved with .png but are actually jpeg etc.
 			try
@@ -399,10 +509,289 @@ std::unique_ptr<image::IImage> png_load(const char* filename)
 	return res;
 }
 
+// zlib settings of the "png preset" global parameter
+struct PngCompression
+{
+	int level;
+	bool adaptiveFilter; // chooses the filter with the smallest sum of absolute differences for each row. Otherwise up is used
+};
+
+static const PngCompression& png_get_compression()
+{
+	static const PngCompression s_presets[] = {
+		{ 6, true }, // 0 = default (zlib level of libpng)
+		{ 1, false }, // 1 = fast
+		{ 9, true }, // 2 = small
+	};
+	const int preset = get_global_parameter_i("png preset", 0);
+	if (preset < 0 || preset > 2)
+		throw std::runtime_error("png preset must be 0 (default), 1 (fast) or 2 (small)");
+	return s_presets[preset];
+}
+
+// applies the png filter to the row and writes the filtered bytes to dst. prev is the unfiltered previous row (zeros for the first row)
+static void png_filter_row(uint8_t filter, const uint8_t* row, const uint8_t* prev, size_t size, size_t bpp, uint8_t* dst)
+{
+	switch (filter)
+	{
+	case 0: // none
+		std::memcpy(dst, row, size);
+		break;
+	case 1: // sub
+		for (size_t i = 0; i < size; ++i)
+			dst[i] = uint8_t(row[i] - (i >= bpp ? row[i - bpp] : 0));
+		break;
+	case 2: // up
+		for (size_t i = 0; i < size; ++i)
+			dst[i] = uint8_t(row[i] - prev[i]);
+		break;
+	case 3: // average
+		for (size_t i = 0; i < size; ++i)
+			dst[i] = uint8_t(row[i] - ((i >= bpp ? row[i - bpp] : 0) + prev[i]) / 2);
+		break;
+	case 4: // paeth
+		for (size_t i = 0; i < size; ++i)
+		{
+			const int a = i >= bpp ? row[i - bpp] : 0;
+			const int b = prev[i];
+			const int c = i >= bpp ? prev[i - bpp] : 0;
+			const int pa = std::abs(b - c);
+			const int pb = std::abs(a - c);
+			const int pc = std::abs(a + b - 2 * c);
+			const int pred = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+			dst[i] = uint8_t(row[i] - pred);
+		}
+		break;
+	}
+}
+
+// converts a row of the RGBA8 or RGBA32F image to the png pixel layout (channels of the bitmask, 16 bit big endian).
+// Returns src if the layouts are identical, otherwise the converted row in dst
+static const uint8_t* png_export_row(const uint8_t* src, uint32_t width, const ExportFormatInfo& info, uint8_t* dst)
+{
+	if (info.bitDepth <= 8)
+	{
+		if (info.bitmask == 0b1111) return src;
+		uint8_t* d = dst;
+		for (uint32_t x = 0; x < width; ++x, src += 4)
+			for (uint32_t c = 0; c < 4; ++c)
+				if (info.bitmask & (1u << c)) *d++ = src[c];
+		return dst;
+	}
+
+	// float => 16 bit unorm (rounded), two pixels per iteration
+	const float* s = reinterpret_cast<const float*>(src);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(65535.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128i bias = _mm_set1_epi32(32768);
+	auto toUnorm = [&](const float* pixel)
+	{
+		const __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pixel), zero), one);
+		// sse2 has no unsigned 32 => 16 bit pack => shift the range to signed
+		return _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half)), bias);
+	};
+
+	const bool allChannels = info.bitmask == 0b11111111;
+	alignas(16) uint8_t pixels[16];
+	uint8_t* d = dst;
+	for (uint32_t x = 0; x < width; x += 2, s += 8)
+	{
+		const __m128i lo = toUnorm(s);
+		const __m128i hi = x + 1 < width ? toUnorm(s + 4) : lo;
+		__m128i v = _mm_xor_si128(_mm_packs_epi32(lo, hi), _mm_set1_epi16(short(0x8000)));
+		// big endian
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+		const uint32_t numPixels = x + 1 < width ? 2 : 1;
+		if (allChannels && numPixels == 2)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(d), v);
+			d += 16;
+			continue;
+		}
+		_mm_store_si128(reinterpret_cast<__m128i*>(pixels), v);
+		for (uint32_t i = 0; i < numPixels * 8; ++i)
+			if (info.bitmask & (1u << (i % 8))) *d++ = pixels[i];
+	}
+	return dst;
+}
+
+// filters the rows of the image and compresses them as independent deflate stripes on multiple threads.
+// Each stripe is primed with the last 32 KB of the previous stripe and ends with a sync flush, so the concatenation
+// of all stripes (+ zlib header and combined adler32) is a single valid zlib stream that is written as IDAT chunks
+static void png_write_striped(png_structp pPng, const uint8_t* data, uint32_t width, uint32_t height, const ExportFormatInfo& info, const PngCompression& compression)
+{
+	const size_t bpp = info.pixelSize;
+	const size_t rowSize = bpp * width;
+	const size_t srcRowSize = size_t(width) * (info.bitDepth <= 8 ? 4 : 4 * sizeof(float));
+	const size_t filteredSize = rowSize + 1;
+	constexpr size_t dictSize = 32 * 1024;
+	const size_t dictRows = (dictSize + filteredSize - 1) / filteredSize;
+	// one stripe per thread. Stripes should be large enough to not hurt the compression ratio.
+	// "png stripe rows" overrides the number of rows per stripe
+	const int forcedRows = get_global_parameter_i("png stripe rows", 0);
+	const size_t stripeRows = forcedRows > 0 ? size_t(forcedRows) : std::max<size_t>({
+		(1 << 20) / filteredSize, (height + image::getNumThreads() - 1) / image::getNumThreads(), 1 });
+	const size_t numStripes = (height + stripeRows - 1) / stripeRows;
+
+	struct Stripe
+	{
+		std::vector<uint8_t> compressed;
+		uLong adler = 1;
+		size_t size = 0; // uncompressed size
+	};
+	std::vector<Stripe> stripes(numStripes);
+
+	// each thread compresses a range of stripes
+	image::parallelRanges(numStripes, [&](size_t firstStripe, size_t lastStripe, size_t rangeIndex)
+	{
+		const std::vector<uint8_t> zeros(rowSize, 0);
+		// converted rows alternate between two buffers => the previous row stays valid
+		std::vector<uint8_t> converted[2] = { std::vector<uint8_t>(rowSize + 16), std::vector<uint8_t>(rowSize + 16) };
+		size_t nextConverted = 0;
+		// candidates of the adaptive filter (filter type byte + filtered bytes)
+		std::vector<uint8_t> filtered(filteredSize * 5);
+
+		// returns the unfiltered png row
+		auto getRow = [&](size_t y) -> const uint8_t*
+		{
+			auto& buffer = converted[nextConverted];
+			nextConverted ^= 1;
+			return png_export_row(data + y * srcRowSize, width, info, buffer.data());
+		};
+
+		// filters the next row and returns the filter type byte + filtered bytes
+		const uint8_t* prev = nullptr;
+		auto filterNext = [&](size_t y) -> const uint8_t*
+		{
+			const uint8_t* row = getRow(y);
+			uint8_t* best = filtered.data();
+			if (!compression.adaptiveFilter)
+			{
+				best[0] = 2;
+				png_filter_row(2, row, prev, rowSize, bpp, best + 1);
+			}
+			else
+			{
+				uint64_t bestSum = UINT64_MAX;
+				for (uint8_t f = 0; f < 5; ++f)
+				{
+					uint8_t* dst = filtered.data() + f * filteredSize;
+					dst[0] = f;
+					png_filter_row(f, row, prev, rowSize, bpp, dst + 1);
+					uint64_t sum = 0;
+					for (size_t i = 1; i <= rowSize; ++i)
+						sum += std::abs(int(int8_t(dst[i])));
+					if (sum < bestSum)
+					{
+						bestSum = sum;
+						best = dst;
+					}
+				}
+			}
+			prev = row;
+			return best;
+		};
+
+		const size_t firstRow = firstStripe * stripeRows;
+		const size_t lastRow = std::min(lastStripe * stripeRows, size_t(height));
+		for (size_t stripeIndex = firstStripe; stripeIndex < lastStripe; ++stripeIndex)
+		{
+			const size_t begin = stripeIndex * stripeRows;
+			const size_t end = std::min(begin + stripeRows, size_t(height));
+			prev = zeros.data();
+
+			z_stream z = {};
+			if (deflateInit2(&z, compression.level, Z_DEFLATED, -15, 8, compression.adaptiveFilter ? Z_FILTERED : Z_DEFAULT_STRATEGY) != Z_OK)
+				throw std::runtime_error("png: deflateInit failed");
+
+			Stripe& stripe = stripes[stripeIndex];
+			auto compress = [&](const uint8_t* src, size_t size, int flush)
+			{
+				z.next_in = const_cast<Bytef*>(src);
+				z.avail_in = uInt(size);
+				do
+				{
+					const size_t used = stripe.compressed.size() - z.avail_out;
+					if (z.avail_out == 0)
+					{
+						stripe.compressed.resize(used + std::max<size_t>(size, 64 * 1024));
+						z.avail_out = uInt(stripe.compressed.size() - used);
+					}
+					z.next_out = stripe.compressed.data() + used;
+					const int res = deflate(&z, flush);
+					if (res != Z_OK && res != Z_STREAM_END && res != Z_BUF_ERROR)
+						throw std::runtime_error("png: deflate failed");
+				} while (z.avail_out == 0);
+			};
+
+			try
+			{
+				// prime the dictionary with the end of the previous stripe
+				if (begin > 0)
+				{
+					const size_t first = begin - std::min(begin, dictRows);
+					if (first > 0) prev = getRow(first - 1);
+					std::vector<uint8_t> dict;
+					for (size_t y = first; y < begin; ++y)
+					{
+						const uint8_t* f = filterNext(y);
+						dict.insert(dict.end(), f, f + filteredSize);
+					}
+					const size_t size = std::min(dict.size(), dictSize);
+					deflateSetDictionary(&z, dict.data() + dict.size() - size, uInt(size));
+				}
+
+				for (size_t y = begin; y < end; ++y)
+				{
+					const uint8_t* f = filterNext(y);
+					stripe.adler = adler32(stripe.adler, f, uInt(filteredSize));
+					const int flush = y + 1 < end ? Z_NO_FLUSH : (end == height ? Z_FINISH : Z_SYNC_FLUSH);
+					compress(f, filteredSize, flush);
+
+					if (rangeIndex == 0 && (y - firstRow) % 64 == 0)
+						set_progress(uint32_t((y - firstRow) * 100 / (lastRow - firstRow)), "compressing png");
+				}
+			}
+			catch (...)
+			{
+				deflateEnd(&z);
+				throw;
+			}
+			stripe.compressed.resize(stripe.compressed.size() - z.avail_out);
+			stripe.size = (end - begin) * filteredSize;
+			deflateEnd(&z);
+		}
+	});
+
+	// zlib header (32K window, deflate) with the level hint and check bits
+	const uint8_t cmf = 0x78;
+	uint8_t flg = uint8_t((compression.level < 2 ? 0 : compression.level < 6 ? 1 : compression.level == 6 ? 2 : 3) << 6);
+	flg = uint8_t(flg + 31 - (cmf * 256 + flg) % 31);
+	const uint8_t header[] = { cmf, flg };
+	png_write_chunk(pPng, reinterpret_cast<png_const_bytep>("IDAT"), header, sizeof(header));
+
+	uLong adler = 1;
+	constexpr size_t maxChunkSize = 1 << 30;
+	for (const auto& s : stripes)
+	{
+		if (s.size == 0) continue;
+		adler = adler32_combine(adler, s.adler, z_off_t(s.size));
+		for (size_t offset = 0; offset < s.compressed.size(); offset += maxChunkSize)
+			png_write_chunk(pPng, reinterpret_cast<png_const_bytep>("IDAT"), s.compressed.data() + offset, std::min(maxChunkSize, s.compressed.size() - offset));
+	}
+
+	const uint8_t trailer[] = { uint8_t(adler >> 24), uint8_t(adler >> 16), uint8_t(adler >> 8), uint8_t(adler) };
+	png_write_chunk(pPng, reinterpret_cast<png_const_bytep>("IDAT"), trailer, sizeof(trailer));
+}
+
 void png_write(image::IImage& image, const char* filename, gli::format format, int quality)
 {
 	// bit depth info etc.
 	const auto info = get_export_info(format);
+	const auto& compression = png_get_compression();
 
 	if (image.getHeight(0) > PNG_SIZE_MAX / (image.getWidth(0) * info.pixelSize))
 		throw std::runtime_error("image too large");
@@ -424,9 +813,6 @@ void png_write(image::IImage& image, const char* filename, gli::format format, i
 		if (!pInfo)
 			throw std::runtime_error("could not create info struct");
 
-		s_num_rows = image.getHeight(0);
-		png_set_write_status_fn(pPng, png_progress);
-
 		png_init_io(pPng, fp);
 
 		png_set_IHDR(pPng, pInfo, 
@@ -446,53 +832,14 @@ void png_write(image::IImage& image, const char* filename, gli::format format, i
 		
 		png_write_info(pPng, pInfo);
 
-		if(info.bitDepth == 16 && image::littleendian())
-			png_set_swap(pPng);
-
+		// 16 bit formats are exported from float images
+		assert(info.bitDepth <= 8 || image.getFormat() == gli::format::FORMAT_RGBA32_SFLOAT_PACK32);
 		size_t dataSize;
-		auto data = image.getData(0, 0, dataSize);
-
-		if(info.bitDepth == 16)
-		{
-			// transform to 16 bit unorm
-			assert(image.getFormat() == gli::format::FORMAT_RGBA32_SFLOAT_PACK32);
-
-			const float* src = reinterpret_cast<float*>(data);
-			const float* end = reinterpret_cast<float*>(data + dataSize);
-			uint16_t* dst = reinterpret_cast<uint16_t*>(data);
-
-			uint32_t progress = 0;
-			uint32_t divisor = std::max<uint32_t>(4 * image.getWidth(0) * image.getHeight(0) / 100, 1);
-			for (; src != end; ++src, ++dst)
-			{
-				*dst = uint16_t(glm::round(glm::clamp(*src, 0.0f, 1.0f) * 65535.0f));
-				++progress;
-
-				if (progress % 256 == 0) set_progress(progress / divisor, "converting float to unorm");
-			}
-				
-			// change stride if required
-			if (info.bitmask != 0b11111111)
-				image::changeStrideEx(data, dataSize / 2, 4 * 2, info.bitmask);
-		}
-		else if(info.bitmask != 0b1111)
-		{
-			// change stride
-			image::changeStrideEx(data, dataSize, 4, info.bitmask);
-		}
-
-		// set row pointers
-		std::vector<png_bytep> rows;
-		rows.resize(image.getHeight(0));
-		const auto rowStride = info.pixelSize * image.getWidth(0);
-		for (auto& r : rows)
-		{
-			r = data;
-			data += rowStride;
-		}
+		const uint8_t* data = image.getData(0, 0, dataSize);
 
-		png_write_image(pPng, rows.data());
-		png_write_end(pPng, pInfo);
+		// the image data is converted row by row and written directly as IDAT chunks, libpng only writes the header chunks
+		png_write_striped(pPng, data, image.getWidth(0), image.getHeight(0), info, compression);
+		png_write_chunk(pPng, reinterpret_cast<png_const_bytep>("IEND"), nullptr, 0);
 	}
 	catch(...) // error handling
 	{
@@ -0,0 +1,309 @@
+#include "pch.h"
+#include "prefetch_interface.h"
+#include "interface.h"
+#include "parallel.h"
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+	constexpr size_t s_numWorkers = 2;
+
+	uint64_t getWriteTime(const std::string& filename)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &attributes))
+			return 0;
+		return (uint64_t(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+	}
+
+	uint64_t getByteSize(const image::IImage& image)
+	{
+		uint64_t res = 0;
+		for (uint32_t layer = 0; layer < image.getNumLayers(); ++layer)
+			for (uint32_t mip = 0; mip < image.getNumMipmaps(); ++mip)
+			{
+				size_t size;
+				image.getData(layer, mip, size);
+				res += size;
+			}
+		return res;
+	}
+
+	class Prefetcher
+	{
+	public:
+		void setFiles(std::vector<std::string> files)
+		{
+			std::vector<std::thread> workers;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_files = std::move(files);
+				m_indices.clear();
+				for (int i = 0; i < int(m_files.size()); ++i)
+					m_indices[m_files[i]] = i;
+				m_entries.clear();
+				m_used = 0;
+				m_cursor = -1;
+				++m_generation;
+
+				if (m_files.empty())
+				{
+					m_stop = true;
+					workers = std::move(m_workers);
+				}
+				else if (m_workers.empty())
+				{
+					m_stop = false;
+					for (size_t i = 0; i < s_numWorkers; ++i)
+						m_workers.emplace_back(&Prefetcher::work, this);
+				}
+			}
+			m_workAvailable.notify_all();
+			m_entryChanged.notify_all();
+			for (auto& w : workers)
+				w.join();
+		}
+
+		void setCursor(int cursor, int radius, uint64_t budget)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_cursor = cursor;
+				m_radius = std::max(radius, 0);
+				m_budget = budget;
+
+				// release everything outside of the window. Skipped entries are reconsidered with the new window.
+				// Running decodes are cancelled instead: they abort with their next progress update and remove their entry afterwards,
+				// so a file that moves back into the window is not decoded twice
+				for (auto it = m_entries.begin(); it != m_entries.end();)
+				{
+					if (it->second.state == Entry::Loading)
+					{
+						if (distance(it->first) > m_radius)
+							it->second.cancelled = true;
+						++it;
+					}
+					else if (distance(it->first) > m_radius || it->second.state == Entry::Skipped)
+					{
+						m_used -= it->second.size;
+						it = m_entries.erase(it);
+					}
+					else ++it;
+				}
+			}
+			m_workAvailable.notify_all();
+			m_entryChanged.notify_all();
+		}
+
+		std::unique_ptr<image::IImage> take(const char* filename, const ImageLoadOptions& options)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			const auto index = m_indices.find(filename);
+			if (index == m_indices.end()) return nullptr;
+
+			const uint64_t generation = m_generation;
+			auto it = m_entries.find(index->second);
+			while (it != m_entries.end() && it->second.state == Entry::Loading)
+			{
+				// the caller waits for the decode => the worker must not be starved by threads with a higher priority
+				if (it->second.worker)
+					SetThreadPriority(it->second.worker, GetThreadPriority(GetCurrentThread()));
+				m_entryChanged.wait(lock);
+				if (generation != m_generation) return nullptr;
+				it = m_entries.find(index->second);
+			}
+			if (it == m_entries.end() || it->second.state != Entry::Ready)
+				return nullptr;
+
+			Entry& e = it->second;
+			auto res = std::move(e.image);
+			m_used -= e.size;
+			e.size = 0;
+			// stays in the cache so it will not be decoded again
+			e.state = Entry::Taken;
+			m_workAvailable.notify_all();
+
+			if (std::memcmp(&e.options, &options, sizeof(options)) != 0 || e.writeTime != getWriteTime(filename))
+				return nullptr;
+
+			return res;
+		}
+
+	private:
+		struct Entry
+		{
+			enum State
+			{
+				Loading,
+				Ready,
+				Taken, // moved to image_open
+				Skipped, // failed or did not fit into the memory budget
+			} state = Loading;
+			bool cancelled = false; // left the window while loading
+			HANDLE worker = nullptr; // thread that decodes the image (Loading)
+			std::unique_ptr<image::IImage> image;
+			uint64_t size = 0;
+			ImageLoadOptions options = {};
+			uint64_t writeTime = 0;
+		};
+
+		int distance(int index) const
+		{
+			return std::abs(index - m_cursor);
+		}
+
+		// nearest file in the window that was not handled yet. -1 if there is none or the budget is used up
+		int findJob() const
+		{
+			if (m_stop || m_cursor < 0 || m_used >= m_budget) return -1;
+			for (int d = 1; d <= m_radius; ++d)
+			{
+				for (int index : { m_cursor + d, m_cursor - d })
+				{
+					if (index >= 0 && index < int(m_files.size()) && !m_entries.count(index))
+						return index;
+				}
+			}
+			return -1;
+		}
+
+		// releases the farthest images until the budget is met
+		void enforceBudget()
+		{
+			while (m_used > m_budget)
+			{
+				auto farthest = m_entries.end();
+				for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+				{
+					if (it->second.state != Entry::Ready) continue;
+					if (farthest == m_entries.end() || distance(it->first) > distance(farthest->first))
+						farthest = it;
+				}
+				if (farthest == m_entries.end()) return;
+
+				m_used -= farthest->second.size;
+				farthest->second.size = 0;
+				farthest->second.image.reset();
+				farthest->second.state = Entry::Skipped;
+			}
+		}
+
+		void work()
+		{
+			// real handle for take() (GetCurrentThread() only works on the calling thread)
+			const HANDLE thread = OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, GetCurrentThreadId());
+			// the images are decoded concurrently => one thread per decode
+			image::threadLimit() = 1;
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (true)
+			{
+				// take() might have raised the priority for the previous image
+				SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+
+				int index = -1;
+				m_workAvailable.wait(lock, [&]() { return m_stop || (index = findJob()) >= 0; });
+				if (m_stop)
+				{
+					if (thread) CloseHandle(thread);
+					return;
+				}
+
+				const uint64_t generation = m_generation;
+				const std::string filename = m_files[index];
+				Entry& entry = m_entries[index];
+				entry.state = Entry::Loading;
+				entry.worker = thread;
+				entry.options = get_global_load_options();
+				entry.writeTime = getWriteTime(filename);
+				const ImageLoadOptions options = entry.options;
+				lock.unlock();
+
+				// aborts the decode when the file leaves the window
+				const ProgressHandler handler = [&](uint32_t, const char*)
+				{
+					std::lock_guard<std::mutex> g(m_mutex);
+					return m_stop || generation != m_generation || m_entries.at(index).cancelled;
+				};
+				set_thread_progress_handler(&handler);
+				std::unique_ptr<image::IImage> image;
+				try
+				{
+					image = load_image(filename.c_str(), options);
+				}
+				catch (const std::exception&)
+				{
+					// the error will be reported by image_open
+				}
+				set_thread_progress_handler(nullptr);
+
+				lock.lock();
+				if (generation != m_generation) continue;
+				// the entry is only removed by this thread while it is loading
+				auto it = m_entries.find(index);
+				it->second.worker = nullptr;
+				if (it->second.cancelled)
+				{
+					// left the window. The file might be in the window again
+					m_entries.erase(it);
+					m_entryChanged.notify_all();
+					m_workAvailable.notify_all();
+					continue;
+				}
+
+				if (image)
+				{
+					it->second.size = getByteSize(*image);
+					it->second.image = std::move(image);
+					it->second.state = Entry::Ready;
+					m_used += it->second.size;
+					enforceBudget();
+				}
+				else it->second.state = Entry::Skipped;
+				m_entryChanged.notify_all();
+			}
+		}
+
+		std::mutex m_mutex;
+		std::condition_variable m_workAvailable;
+		std::condition_variable m_entryChanged; // an entry stopped loading or the cache was cleared
+		std::vector<std::thread> m_workers;
+		bool m_stop = false;
+
+		std::vector<std::string> m_files;
+		std::unordered_map<std::string, int> m_indices;
+		std::unordered_map<int, Entry> m_entries; // file index => entry
+		uint64_t m_generation = 0; // incremented when the file list changes
+		int m_cursor = -1;
+		int m_radius = 0;
+		uint64_t m_budget = 0;
+		uint64_t m_used = 0; // bytes of the ready images
+	};
+
+	// never destroyed: joining the workers during dll unload would deadlock
+	Prefetcher& getPrefetcher()
+	{
+		static Prefetcher* s_prefetcher = new Prefetcher();
+		return *s_prefetcher;
+	}
+}
+
+void prefetch_set_files(std::vector<std::string> files)
+{
+	getPrefetcher().setFiles(std::move(files));
+}
+
+void prefetch_set_cursor(int cursor, int radius, uint64_t memoryBudget)
+{
+	getPrefetcher().setCursor(cursor, radius, memoryBudget);
+}
+
+std::unique_ptr<image::IImage> prefetch_take(const char* filename, const ImageLoadOptions& options)
+{
+	return getPrefetcher().take(filename, options);
+}
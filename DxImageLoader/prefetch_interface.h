@@ -0,0 +1,21 @@
+#pragma once
+#include "Image.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ImageLoadOptions;
+
+// prefetching of the neighbours of the current file (directory browsing).
+// Files are decoded by low priority background workers with the global load options that are active when the decode starts.
+
+// replaces the file list and releases all prefetched images. An empty list stops the workers
+void prefetch_set_files(std::vector<std::string> files);
+
+// files [cursor - radius, cursor + radius] (except for the cursor) are decoded, nearest first, until memoryBudget bytes are in use.
+// Prefetched images and decodes outside of the window are released/aborted
+void prefetch_set_cursor(int cursor, int radius, uint64_t memoryBudget);
+
+// removes the prefetched image of the file from the cache. Waits if the file is being decoded.
+// Returns nullptr if the file was not prefetched, was modified afterwards or was decoded with different options
+std::unique_ptr<image::IImage> prefetch_take(const char* filename, const ImageLoadOptions& options);
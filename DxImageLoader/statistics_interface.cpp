@@ -0,0 +1,281 @@
+#include "pch.h"
+#include "statistics_interface.h"
+#include "parallel.h"
+#include "ByteTable.h"
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+// mirrors the statistics shaders of ImageFramework (StatisticsShader.cs) on the cpu:
+// luminance = dot(a * rgb, (0.2125, 0.7154, 0.0721))
+// average   = dot(a * rgb, 1/3)
+// luma      = dot(a * toSrgb(rgb), (0.299, 0.587, 0.114))
+// lightness = max(116 * cbrt(max(luminance, 0)) - 16, 0)
+// alpha     = a
+// grayscale = (r == g && r == b) ? 1 : 0
+// nans are replaced by zero before evaluation
+
+namespace
+{
+	enum Stat
+	{
+		Luminance,
+		Average,
+		Luma,
+		Lightness,
+		Alpha,
+		Grayscale,
+		NumStats
+	};
+
+	// 4 pixels in structure of arrays layout
+	struct PixelQuad
+	{
+		__m128 r, g, b, a;
+		__m128 sr, sg, sb; // toSrgb(r, g, b)
+	};
+
+	// per thread accumulator. sums are accumulated in float lanes for a short while and are then
+	// transferred into double precision kahan sums
+	class Accumulator
+	{
+	public:
+		Accumulator()
+		{
+			for (size_t i = 0; i < NumStats; ++i)
+			{
+				m_min[i] = _mm_set1_ps(std::numeric_limits<float>::max());
+				m_max[i] = _mm_set1_ps(std::numeric_limits<float>::lowest());
+				m_lane[i] = _mm_setzero_ps();
+			}
+		}
+
+		// mask selects the valid lanes (all bits set for valid pixels)
+		void add(const PixelQuad& p, __m128 mask)
+		{
+			const __m128 lum = _mm_mul_ps(p.a, _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(p.r, _mm_set1_ps(0.2125f)),
+				_mm_mul_ps(p.g, _mm_set1_ps(0.7154f))),
+				_mm_mul_ps(p.b, _mm_set1_ps(0.0721f))));
+
+			const __m128 avg = _mm_mul_ps(p.a, _mm_mul_ps(_mm_add_ps(_mm_add_ps(p.r, p.g), p.b), _mm_set1_ps(1.0f / 3.0f)));
+
+			const __m128 luma = _mm_mul_ps(p.a, _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(p.sr, _mm_set1_ps(0.299f)),
+				_mm_mul_ps(p.sg, _mm_set1_ps(0.587f))),
+				_mm_mul_ps(p.sb, _mm_set1_ps(0.114f))));
+
+			// cube root has no sse equivalent
+			alignas(16) float lumLanes[4];
+			_mm_store_ps(lumLanes, lum);
+			for (auto& l : lumLanes)
+				l = std::max(116.0f * std::cbrt(std::max(l, 0.0f)) - 16.0f, 0.0f);
+			const __m128 lightness = _mm_load_ps(lumLanes);
+
+			const __m128 gray = _mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(p.r, p.g), _mm_cmpeq_ps(p.r, p.b)), _mm_set1_ps(1.0f));
+
+			addValue(Luminance, lum, mask);
+			addValue(Average, avg, mask);
+			addValue(Luma, luma, mask);
+			addValue(Lightness, lightness, mask);
+			addValue(Alpha, p.a, mask);
+			addValue(Grayscale, gray, mask);
+
+			if (++m_laneCount == 256) flushLanes();
+		}
+
+		void merge(Accumulator& other)
+		{
+			other.flushLanes();
+			flushLanes();
+			for (size_t i = 0; i < NumStats; ++i)
+			{
+				m_min[i] = _mm_min_ps(m_min[i], other.m_min[i]);
+				m_max[i] = _mm_max_ps(m_max[i], other.m_max[i]);
+				addKahan(i, other.m_sum[i]);
+				addKahan(i, -other.m_compensation[i]);
+			}
+		}
+
+		void store(ImageStatistics& out, size_t numElements)
+		{
+			flushLanes();
+			for (size_t i = 0; i < NumStats; ++i)
+			{
+				alignas(16) float mins[4];
+				alignas(16) float maxs[4];
+				_mm_store_ps(mins, m_min[i]);
+				_mm_store_ps(maxs, m_max[i]);
+				out.min[i] = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+				out.max[i] = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+				out.avg[i] = numElements ? float(m_sum[i] / double(numElements)) : 0.0f;
+			}
+		}
+
+	private:
+		void addValue(size_t stat, __m128 value, __m128 mask)
+		{
+			// invalid lanes contain duplicates of valid pixels => min/max are not affected
+			m_min[stat] = _mm_min_ps(m_min[stat], value);
+			m_max[stat] = _mm_max_ps(m_max[stat], value);
+			m_lane[stat] = _mm_add_ps(m_lane[stat], _mm_and_ps(value, mask));
+		}
+
+		void flushLanes()
+		{
+			for (size_t i = 0; i < NumStats; ++i)
+			{
+				alignas(16) float lanes[4];
+				_mm_store_ps(lanes, m_lane[i]);
+				addKahan(i, double(lanes[0]) + double(lanes[1]) + double(lanes[2]) + double(lanes[3]));
+				m_lane[i] = _mm_setzero_ps();
+			}
+			m_laneCount = 0;
+		}
+
+		void addKahan(size_t stat, double value)
+		{
+			const double y = value - m_compensation[stat];
+			const double t = m_sum[stat] + y;
+			m_compensation[stat] = (t - m_sum[stat]) - y;
+			m_sum[stat] = t;
+		}
+
+		__m128 m_min[NumStats];
+		__m128 m_max[NumStats];
+		__m128 m_lane[NumStats];
+		double m_sum[NumStats] = {};
+		double m_compensation[NumStats] = {};
+		uint32_t m_laneCount = 0;
+	};
+
+	__m128 laneMask(size_t numValid)
+	{
+		static const __m128 s_masks[5] = {
+			_mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, 0)),
+			_mm_castsi128_ps(_mm_setr_epi32(-1, 0, 0, 0)),
+			_mm_castsi128_ps(_mm_setr_epi32(-1, -1, 0, 0)),
+			_mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)),
+			_mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, -1)),
+		};
+		return s_masks[std::min<size_t>(numValid, 4)];
+	}
+
+	__m128 zeroNans(__m128 v)
+	{
+		return _mm_and_ps(v, _mm_cmpord_ps(v, v));
+	}
+
+	void processRowFloat(const float* row, size_t width, Accumulator& acc)
+	{
+		for (size_t x = 0; x < width; x += 4)
+		{
+			const size_t numValid = std::min<size_t>(width - x, 4);
+			// duplicate the first pixel for missing lanes
+			const float* px[4];
+			for (size_t i = 0; i < 4; ++i)
+				px[i] = row + 4 * (x + (i < numValid ? i : 0));
+
+			PixelQuad q;
+			q.r = zeroNans(_mm_loadu_ps(px[0]));
+			q.g = zeroNans(_mm_loadu_ps(px[1]));
+			q.b = zeroNans(_mm_loadu_ps(px[2]));
+			q.a = zeroNans(_mm_loadu_ps(px[3]));
+			_MM_TRANSPOSE4_PS(q.r, q.g, q.b, q.a);
+
+			alignas(16) float srgb[3][4];
+			_mm_store_ps(srgb[0], q.r);
+			_mm_store_ps(srgb[1], q.g);
+			_mm_store_ps(srgb[2], q.b);
+			for (auto& c : srgb)
+				for (auto& v : c)
+					v = image::toSrgb(v);
+			q.sr = _mm_load_ps(srgb[0]);
+			q.sg = _mm_load_ps(srgb[1]);
+			q.sb = _mm_load_ps(srgb[2]);
+
+			acc.add(q, laneMask(numValid));
+		}
+	}
+
+	void processRowByte(const uint8_t* row, size_t width, const image::ByteTable& table, Accumulator& acc)
+	{
+		for (size_t x = 0; x < width; x += 4)
+		{
+			const size_t numValid = std::min<size_t>(width - x, 4);
+			alignas(16) float c[7][4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				const uint8_t* p = row + 4 * (x + (i < numValid ? i : 0));
+				c[0][i] = table.color[p[0]];
+				c[1][i] = table.color[p[1]];
+				c[2][i] = table.color[p[2]];
+				c[3][i] = table.alpha[p[3]];
+				c[4][i] = table.srgb[p[0]];
+				c[5][i] = table.srgb[p[1]];
+				c[6][i] = table.srgb[p[2]];
+			}
+
+			PixelQuad q;
+			q.r = _mm_load_ps(c[0]);
+			q.g = _mm_load_ps(c[1]);
+			q.b = _mm_load_ps(c[2]);
+			q.a = _mm_load_ps(c[3]);
+			q.sr = _mm_load_ps(c[4]);
+			q.sg = _mm_load_ps(c[5]);
+			q.sb = _mm_load_ps(c[6]);
+
+			acc.add(q, laneMask(numValid));
+		}
+	}
+}
+
+void statistics_compute(const image::IImage& image, int layer, uint32_t mipmap, ImageStatistics& out)
+{
+	if (!image::isSupported(image.getFormat()))
+		throw std::runtime_error("statistics: unsupported image format");
+	if (mipmap >= image.getNumMipmaps())
+		throw std::runtime_error("statistics: invalid mipmap");
+	if (layer >= int(image.getNumLayers()) || layer < -1)
+		throw std::runtime_error("statistics: invalid layer");
+
+	const uint32_t firstLayer = layer < 0 ? 0 : uint32_t(layer);
+	const uint32_t numLayers = layer < 0 ? image.getNumLayers() : 1;
+	const size_t width = image.getWidth(mipmap);
+	const size_t height = image.getHeight(mipmap);
+	const size_t depth = image.getDepth(mipmap);
+	const size_t rowsPerLayer = height * depth;
+	const bool isFloat = image.getFormat() == gli::FORMAT_RGBA32_SFLOAT_PACK32;
+	const size_t rowSize = width * image::pixelSize(image.getFormat());
+	const image::ByteTable& table = image::getByteTable(image.getFormat());
+
+	// resolve layer pointers upfront, getData does not need to be thread safe
+	std::vector<const uint8_t*> layerData(numLayers);
+	for (uint32_t i = 0; i < numLayers; ++i)
+	{
+		size_t size;
+		layerData[i] = image.getData(firstLayer + i, mipmap, size);
+	}
+
+	std::vector<Accumulator> accumulators(image::getNumThreads());
+
+	image::parallelRanges(rowsPerLayer * numLayers, [&](size_t begin, size_t end, size_t rangeIndex)
+	{
+		auto& acc = accumulators[rangeIndex];
+		for (size_t row = begin; row < end; ++row)
+		{
+			const uint8_t* data = layerData[row / rowsPerLayer] + (row % rowsPerLayer) * rowSize;
+
+			if (isFloat) processRowFloat(reinterpret_cast<const float*>(data), width, acc);
+			else processRowByte(data, width, table, acc);
+		}
+	}, std::max<size_t>(16384 / std::max<size_t>(width, 1), 1));
+
+	for (size_t i = 1; i < accumulators.size(); ++i)
+		accumulators[0].merge(accumulators[i]);
+
+	accumulators[0].store(out, width * rowsPerLayer * numLayers);
+}
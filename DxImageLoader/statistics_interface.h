@@ -0,0 +1,7 @@
+#pragma once
+#include "Image.h"
+#include "interface.h"
+
+// computes min, max and avg of all default statistic types (see ImageStatistics) in a single pass.
+// layer = -1 computes the statistics over all layers of the mipmap
+void statistics_compute(const image::IImage& image, int layer, uint32_t mipmap, ImageStatistics& out);
@@ -0,0 +1,38 @@
+#include "pch.h"
+#include "thumbnail_interface.h"
+#include "thumbnail_resample.h"
+#include "ByteTable.h"
+#include <algorithm>
+#include <stdexcept>
+
+void thumbnail_create(const image::IImage& image, uint32_t maxSize, uint8_t* dst, uint32_t& width, uint32_t& height)
+{
+	if (!image::isSupported(image.getFormat()))
+		throw std::runtime_error("thumbnail: unsupported image format");
+	if (maxSize == 0)
+		throw std::runtime_error("thumbnail: invalid size");
+
+	const uint32_t srcWidth = image.getWidth(0);
+	const uint32_t srcHeight = image.getHeight(0);
+	const uint32_t srcDepth = image.getDepth(0);
+	image::getThumbnailSize(srcWidth, srcHeight, maxSize, width, height);
+
+	// ThumbnailModel samples 3D textures at z = 0.49
+	const uint32_t slice = std::min(uint32_t(0.49f * float(srcDepth)), srcDepth - 1);
+	size_t size;
+	image::ThumbnailSource src;
+	src.rowSize = size_t(srcWidth) * image::pixelSize(image.getFormat());
+	src.data = image.getData(0, 0, size) + size_t(slice) * srcHeight * src.rowSize;
+	src.width = srcWidth;
+	src.height = srcHeight;
+	src.color = nullptr;
+	src.alpha = nullptr;
+	if (image.getFormat() != gli::FORMAT_RGBA32_SFLOAT_PACK32)
+	{
+		const image::ByteTable& table = image::getByteTable(image.getFormat());
+		src.color = table.color.data();
+		src.alpha = table.alpha.data();
+	}
+
+	image::resampleThumbnail(src, width, height, dst);
+}
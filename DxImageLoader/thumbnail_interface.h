@@ -0,0 +1,8 @@
+#pragma once
+#include "Image.h"
+
+// creates a thumbnail of the first layer (the center slice for 3D images) with the same dimensions as ThumbnailModel.CreateThumbnail:
+// the longer side is maxSize, the aspect ratio is preserved.
+// The image is resampled with an area (box) filter in linear color space and written as srgb encoded RGBA8 into dst (width * height * 4 bytes).
+// dst must be able to hold maxSize * maxSize * 4 bytes
+void thumbnail_create(const image::IImage& image, uint32_t maxSize, uint8_t* dst, uint32_t& width, uint32_t& height);
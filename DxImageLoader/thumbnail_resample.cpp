@@ -0,0 +1,152 @@
+#include "thumbnail_resample.h"
+#include "parallel.h"
+#include "ByteTable.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	uint8_t toByte(float c)
+	{
+		if (!(c > 0.0f)) return 0; // includes NaN
+		if (c >= 1.0f) return 255;
+		return uint8_t(c * 255.0f + 0.5f);
+	}
+
+	// source pixels and weights of every destination pixel for a 1D area filter
+	struct Taps
+	{
+		std::vector<uint32_t> first; // first source pixel
+		std::vector<uint32_t> offset; // offset into weights (size dst + 1)
+		std::vector<float> weights;
+
+		Taps(uint32_t srcSize, uint32_t dstSize)
+		{
+			const double scale = double(srcSize) / double(dstSize);
+			first.resize(dstSize);
+			offset.resize(dstSize + 1);
+			for (uint32_t i = 0; i < dstSize; ++i)
+			{
+				const double start = double(i) * scale;
+				const double end = std::min(double(i + 1) * scale, double(srcSize));
+				const uint32_t begin = std::min(uint32_t(start), srcSize - 1);
+				const uint32_t last = std::max(begin + 1, std::min(uint32_t(std::ceil(end)), srcSize));
+				first[i] = begin;
+				offset[i] = uint32_t(weights.size());
+				double sum = 0.0;
+				for (uint32_t j = begin; j < last; ++j)
+				{
+					const double w = std::max(std::min(end, double(j + 1)) - std::max(start, double(j)), 0.0);
+					weights.push_back(float(w));
+					sum += w;
+				}
+				// normalize
+				for (size_t j = offset[i]; j < weights.size(); ++j)
+					weights[j] = sum > 0.0 ? float(weights[j] / sum) : 1.0f / float(weights.size() - offset[i]);
+			}
+			offset[dstSize] = uint32_t(weights.size());
+		}
+
+		uint32_t count(uint32_t i) const { return offset[i + 1] - offset[i]; }
+		const float* weight(uint32_t i) const { return weights.data() + offset[i]; }
+	};
+}
+
+void image::getThumbnailSize(uint32_t srcWidth, uint32_t srcHeight, uint32_t maxSize, uint32_t& width, uint32_t& height)
+{
+	if (srcWidth > srcHeight)
+	{
+		width = maxSize;
+		height = uint32_t((uint64_t(srcHeight) * maxSize) / srcWidth);
+	}
+	else
+	{
+		height = maxSize;
+		width = uint32_t((uint64_t(srcWidth) * maxSize) / srcHeight);
+	}
+	width = std::max(width, 1u);
+	height = std::max(height, 1u);
+}
+
+void image::resampleThumbnail(const ThumbnailSource& src, uint32_t width, uint32_t height, uint8_t* dst)
+{
+	const uint32_t srcWidth = src.width;
+	const uint32_t srcHeight = src.height;
+	const bool isFloat = src.color == nullptr;
+	const Taps tapsX(srcWidth, width);
+	const Taps tapsY(srcHeight, height);
+
+	// horizontal pass (linear colors): srcHeight x width
+	std::vector<float> tmp(size_t(srcHeight) * width * 4);
+	image::parallelRanges(srcHeight, [&](size_t begin, size_t end, size_t)
+	{
+		std::vector<float> row(size_t(srcWidth) * 4);
+		for (size_t y = begin; y < end; ++y)
+		{
+			const uint8_t* srcRow = src.data + y * src.rowSize;
+			if (isFloat)
+			{
+				std::copy_n(reinterpret_cast<const float*>(srcRow), row.size(), row.data());
+				// ignore NaNs like the byte conversion of the gpu
+				for (auto& v : row)
+					if (std::isnan(v)) v = 0.0f;
+			}
+			else
+			{
+				for (size_t x = 0; x < srcWidth; ++x)
+				{
+					row[4 * x + 0] = src.color[srcRow[4 * x + 0]];
+					row[4 * x + 1] = src.color[srcRow[4 * x + 1]];
+					row[4 * x + 2] = src.color[srcRow[4 * x + 2]];
+					row[4 * x + 3] = src.alpha[srcRow[4 * x + 3]];
+				}
+			}
+
+			float* dstRow = tmp.data() + y * width * 4;
+			for (uint32_t x = 0; x < width; ++x, dstRow += 4)
+			{
+				const float* px = row.data() + size_t(tapsX.first[x]) * 4;
+				const float* w = tapsX.weight(x);
+				float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+				for (uint32_t i = 0; i < tapsX.count(x); ++i, px += 4)
+				{
+					r += w[i] * px[0];
+					g += w[i] * px[1];
+					b += w[i] * px[2];
+					a += w[i] * px[3];
+				}
+				dstRow[0] = r;
+				dstRow[1] = g;
+				dstRow[2] = b;
+				dstRow[3] = a;
+			}
+		}
+	}, std::max<size_t>(16384 / std::max<size_t>(srcWidth, 1), 1));
+
+	// vertical pass and srgb conversion
+	image::parallelRanges(height, [&](size_t begin, size_t end, size_t)
+	{
+		std::vector<float> row(size_t(width) * 4);
+		for (size_t y = begin; y < end; ++y)
+		{
+			std::fill(row.begin(), row.end(), 0.0f);
+			const float* w = tapsY.weight(uint32_t(y));
+			for (uint32_t i = 0; i < tapsY.count(uint32_t(y)); ++i)
+			{
+				const float* srcRow = tmp.data() + size_t(tapsY.first[y] + i) * width * 4;
+				for (size_t x = 0; x < row.size(); ++x)
+					row[x] += w[i] * srcRow[x];
+			}
+
+			uint8_t* dstRow = dst + y * width * 4;
+			for (size_t x = 0; x < width; ++x)
+			{
+				dstRow[4 * x + 0] = toByte(image::toSrgb(row[4 * x + 0]));
+				dstRow[4 * x + 1] = toByte(image::toSrgb(row[4 * x + 1]));
+				dstRow[4 * x + 2] = toByte(image::toSrgb(row[4 * x + 2]));
+				dstRow[4 * x + 3] = toByte(row[4 * x + 3]);
+			}
+		}
+	}, std::max<size_t>(16384 / std::max<size_t>(size_t(width) * tapsY.count(0), 1), 1));
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// resampling core of thumbnail_create. Does not depend on the precompiled header (windows.h) or the image classes
+namespace image
+{
+	struct ThumbnailSource
+	{
+		const uint8_t* data; // first row of the RGBA8 or RGBA32F slice
+		size_t rowSize; // in bytes
+		uint32_t width;
+		uint32_t height;
+		const float* color; // 256 linear values of the rgb channels for RGBA8 data. nullptr for RGBA32F data
+		const float* alpha; // 256 alpha values for RGBA8 data. nullptr for RGBA32F data
+	};
+
+	// same dimensions as ThumbnailModel.CreateThumbnail: the longer side is maxSize, the aspect ratio is preserved
+	void getThumbnailSize(uint32_t srcWidth, uint32_t srcHeight, uint32_t maxSize, uint32_t& width, uint32_t& height);
+
+	// resamples src with an area (box) filter in linear color space and writes srgb encoded RGBA8 into dst (width * height * 4 bytes)
+	void resampleThumbnail(const ThumbnailSource& src, uint32_t width, uint32_t height, uint8_t* dst);
+}
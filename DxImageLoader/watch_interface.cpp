@@ -0,0 +1,186 @@
+#include "pch.h"
+#include "watch_interface.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace
+{
+	// time without modifications before a change is reported
+	constexpr DWORD s_quietPeriod = 200;
+
+	constexpr uint64_t s_prime1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t s_prime2 = 0xC2B2AE3D27D4EB4Full;
+
+	uint64_t rotl(uint64_t x, int r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	// xxhash64 like hash with four independent lanes
+	uint64_t hashBytes(const uint8_t* data, size_t size)
+	{
+		uint64_t lanes[4] = { s_prime1 + s_prime2, s_prime2, 0, 0 - s_prime1 };
+		size_t i = 0;
+		for (; i + 32 <= size; i += 32)
+		{
+			for (int l = 0; l < 4; ++l)
+			{
+				uint64_t v;
+				std::memcpy(&v, data + i + l * 8, sizeof(v));
+				lanes[l] = rotl(lanes[l] + v * s_prime2, 31) * s_prime1;
+			}
+		}
+
+		uint64_t h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+		h += uint64_t(size);
+		for (; i < size; ++i)
+			h = rotl(h ^ (data[i] * s_prime1), 11) * s_prime2;
+
+		// avalanche
+		h ^= h >> 33;
+		h *= s_prime2;
+		h ^= h >> 29;
+		h *= s_prime1;
+		h ^= h >> 32;
+		return h;
+	}
+
+	void assertSameLayout(const image::IImage& a, const image::IImage& b)
+	{
+		if (a.getFormat() != b.getFormat() || a.getNumLayers() != b.getNumLayers() || a.getNumMipmaps() != b.getNumMipmaps() ||
+			a.getWidth(0) != b.getWidth(0) || a.getHeight(0) != b.getHeight(0) || a.getDepth(0) != b.getDepth(0))
+			throw std::runtime_error("reload: the image layout changed (format, layers, mipmaps or size)");
+	}
+}
+
+FileWatcher::FileWatcher(const std::string& filename, std::function<void()> onChange)
+	: m_onChange(std::move(onChange))
+{
+	const auto path = std::filesystem::absolute(std::filesystem::u8path(filename));
+	m_name = path.filename().wstring();
+
+	m_directory = CreateFileW(path.parent_path().wstring().c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (m_directory == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("watch: could not open the directory of " + filename);
+
+	m_stop = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!m_stop)
+	{
+		CloseHandle(m_directory);
+		throw std::runtime_error("watch: CreateEvent failed");
+	}
+
+	m_thread = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+	SetEvent(m_stop);
+	m_thread.join();
+	CloseHandle(m_stop);
+	CloseHandle(m_directory);
+}
+
+void FileWatcher::run()
+{
+	alignas(DWORD) uint8_t buffer[16 * 1024];
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!overlapped.hEvent) return;
+
+	bool reading = false;
+	bool changed = false; // waiting for the quiet period
+	while (true)
+	{
+		if (!reading)
+		{
+			ResetEvent(overlapped.hEvent);
+			if (!ReadDirectoryChangesW(m_directory, buffer, sizeof(buffer), FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr, &overlapped, nullptr))
+				break;
+			reading = true;
+		}
+
+		const HANDLE handles[] = { m_stop, overlapped.hEvent };
+		const DWORD res = WaitForMultipleObjects(2, handles, FALSE, changed ? s_quietPeriod : INFINITE);
+		if (res == WAIT_TIMEOUT)
+		{
+			changed = false;
+			m_onChange();
+			continue;
+		}
+		if (res != WAIT_OBJECT_0 + 1) break; // stop event or error
+
+		reading = false;
+		DWORD numBytes = 0;
+		if (!GetOverlappedResult(m_directory, &overlapped, &numBytes, FALSE))
+			break;
+
+		// 0 bytes => too many changes for the buffer, the file might be one of them
+		if (numBytes == 0) changed = true;
+
+		for (DWORD offset = 0; numBytes != 0;)
+		{
+			const auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer + offset);
+			if (CompareStringOrdinal(info->FileName, int(info->FileNameLength / sizeof(WCHAR)), m_name.c_str(), int(m_name.size()), TRUE) == CSTR_EQUAL)
+				changed = true;
+			if (info->NextEntryOffset == 0) break;
+			offset += info->NextEntryOffset;
+		}
+	}
+
+	if (reading)
+	{
+		DWORD numBytes = 0;
+		CancelIoEx(m_directory, &overlapped);
+		GetOverlappedResult(m_directory, &overlapped, &numBytes, TRUE);
+	}
+	CloseHandle(overlapped.hEvent);
+}
+
+std::vector<uint64_t> watch_hash_subresources(const image::IImage& image)
+{
+	const uint32_t numMipmaps = image.getNumMipmaps();
+	std::vector<uint64_t> hashes(size_t(image.getNumLayers()) * numMipmaps);
+	image::parallelFor(hashes.size(), [&](size_t i)
+	{
+		size_t size;
+		const uint8_t* data = image.getData(uint32_t(i / numMipmaps), uint32_t(i % numMipmaps), size);
+		hashes[i] = hashBytes(data, size);
+	});
+	return hashes;
+}
+
+std::vector<uint32_t> watch_update_subresources(image::IImage& dst, const image::IImage& src, std::vector<uint64_t>& hashes)
+{
+	assertSameLayout(dst, src);
+	const uint32_t numMipmaps = src.getNumMipmaps();
+	if (hashes.size() != size_t(src.getNumLayers()) * numMipmaps)
+		throw std::runtime_error("reload: invalid number of hashes");
+
+	std::vector<uint8_t> dirty(hashes.size(), 0);
+	image::parallelFor(hashes.size(), [&](size_t i)
+	{
+		const uint32_t layer = uint32_t(i / numMipmaps);
+		const uint32_t mip = uint32_t(i % numMipmaps);
+		size_t srcSize, dstSize;
+		const uint8_t* srcData = src.getData(layer, mip, srcSize);
+		const uint64_t hash = hashBytes(srcData, srcSize);
+		if (hash == hashes[i]) return;
+
+		uint8_t* dstData = dst.getData(layer, mip, dstSize);
+		std::memcpy(dstData, srcData, std::min(srcSize, dstSize));
+		hashes[i] = hash;
+		dirty[i] = 1;
+	});
+
+	std::vector<uint32_t> res;
+	for (size_t i = 0; i < dirty.size(); ++i)
+		if (dirty[i]) res.push_back(uint32_t(i));
+	return res;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Image.h"
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// watches a single file with ReadDirectoryChangesW and calls onChange on the watcher thread after the file was modified.
+// The change is reported once the file was not modified for a short time (exporters often write a file in multiple steps)
+class FileWatcher
+{
+public:
+	FileWatcher(const std::string& filename, std::function<void()> onChange);
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+private:
+	void run();
+
+	std::wstring m_name; // filename without directory
+	std::function<void()> m_onChange;
+	HANDLE m_directory = INVALID_HANDLE_VALUE;
+	HANDLE m_stop = nullptr;
+	std::thread m_thread;
+};
+
+// 64 bit hash of every subresource. Index = layer * numMipmaps + mipmap
+std::vector<uint64_t> watch_hash_subresources(const image::IImage& image);
+
+// copies the subresources of src that do not match the hashes into dst and updates the hashes.
+// Returns the indices (layer * numMipmaps + mipmap) of the copied subresources.
+// Throws if the format, number of layers, number of mipmaps or size of src and dst differ
+std::vector<uint32_t> watch_update_subresources(image::IImage& dst, const image::IImage& src, std::vector<uint64_t>& hashes);
@@ -1,14 +1,207 @@
 #include "pch.h"
 #include "webp_interface.h"
 #include "interface.h"
+#include "parallel.h"
 #include <webp/decode.h>
 #include <webp/encode.h>
 #include <webp/demux.h>
 #include <webp/mux.h>
 #include <fstream>
 #include <vector>
+#include <list>
+#include <mutex>
+#include <cstring>
 #include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <emmintrin.h>
+
+// bytes that are passed to the incremental decoder between two previews
+static constexpr size_t s_previewChunkSize = 64 * 1024;
+// frames with fewer rows are blended on the calling thread
+static constexpr size_t s_minBlendRows = 64;
+// animations with fewer layers are encoded with a single encoder (every segment starts with a keyframe)
+static constexpr uint32_t s_minSegmentLayers = 8;
+
+// decodes a still image with the incremental decoder into dst and reports the decoded rows as previews
+static void webp_decode_progressive(const uint8_t* data, size_t size, int width, int height, uint8_t* dst)
+{
+    WebPIDecoder* idec = WebPINewRGB(MODE_RGBA, dst, size_t(width) * size_t(height) * 4, width * 4);
+    if (!idec)
+        throw std::runtime_error("WebPINewRGB failed");
+
+    ImagePreview preview = {};
+    preview.data = dst;
+    preview.width = uint32_t(width);
+    preview.height = uint32_t(height);
+    preview.format = gli::format::FORMAT_RGBA8_SRGB_PACK8;
+    preview.stage = IMAGE_PREVIEW_ROWS;
+
+    try
+    {
+        VP8StatusCode status = VP8_STATUS_SUSPENDED;
+        for (size_t available = 0; available < size;)
+        {
+            available = std::min(size, available + s_previewChunkSize);
+            // the data is already in memory => WebPIUpdate does not copy it
+            status = WebPIUpdate(idec, data, available);
+            if (status != VP8_STATUS_OK && status != VP8_STATUS_SUSPENDED)
+                throw std::runtime_error("WebP frame decode failed");
+
+            int lastY = 0;
+            if (status == VP8_STATUS_SUSPENDED && WebPIDecGetRGB(idec, &lastY, nullptr, nullptr, nullptr) && lastY > 0)
+            {
+                preview.numRows = uint32_t(lastY);
+                set_preview(preview);
+            }
+        }
+        if (status != VP8_STATUS_OK)
+            throw std::runtime_error("WebP frame decode failed: incomplete file");
+    }
+    catch (...)
+    {
+        WebPIDelete(idec);
+        throw;
+    }
+    WebPIDelete(idec);
+}
+
+// frame of an animation. The compressed data points into the file buffer of the image
+struct WebpFrame
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int x = 0, y = 0, width = 0, height = 0;
+    bool blend = false; // alpha blend with the previous canvas (otherwise overwrite)
+    bool disposeBackground = false; // clear the frame rectangle before the next frame is drawn
+    bool hasAlpha = false;
+    uint32_t keyframe = 0; // closest frame <= this frame that starts from a cleared canvas
+};
+
+// 2^24 / alpha for the division by the blended alpha
+static const uint32_t* webp_alpha_scales()
+{
+    static const auto s_scales = []
+    {
+        std::array<uint32_t, 256> res = {};
+        for (uint32_t a = 1; a < 256; ++a)
+            res[a] = (1u << 24) / a;
+        return res;
+    }();
+    return s_scales.data();
+}
+
+// blends a straight alpha pixel over dst with the integer arithmetic of WebPAnimDecoder:
+// colors are premultiplied, added and divided by the blended alpha (multiplication with 2^24 / alpha)
+static void webp_blend_pixel(const uint8_t* src, uint8_t* dst, const uint32_t* scales)
+{
+    const uint32_t srcA = src[3];
+    if (srcA == 255) {
+        std::memcpy(dst, src, 4);
+        return;
+    }
+    if (srcA == 0) return;
+
+    const uint32_t dstA = (dst[3] * (256 - srcA)) >> 8;
+    const uint32_t outA = srcA + dstA;
+    const uint32_t scale = scales[outA];
+    for (int c = 0; c < 3; ++c)
+        dst[c] = uint8_t(((src[c] * srcA + dst[c] * dstA) * scale) >> 24);
+    dst[3] = uint8_t(outA);
+}
+
+// 32 bit multiplication of the lanes (SSE2 only has _mm_mul_epu32 for the even lanes)
+static __m128i webp_mullo_epi32(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// webp_blend_pixel for four pixels
+static __m128i webp_blend_4(__m128i src, __m128i dst, const uint32_t* scales)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i srcAlpha32 = _mm_srli_epi32(src, 24);
+    const __m128i opaque = _mm_cmpeq_epi32(srcAlpha32, _mm_set1_epi32(255));
+    const __m128i transparent = _mm_cmpeq_epi32(srcAlpha32, zero);
+
+    // 16 bit lanes with two pixels per register
+    auto broadcastAlpha = [](__m128i v) { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF); };
+    const __m128i c256 = _mm_set1_epi16(256);
+    __m128i outAlpha[2];
+    __m128i blended[4];
+    for (int half = 0; half < 2; ++half)
+    {
+        const __m128i s = half ? _mm_unpackhi_epi8(src, zero) : _mm_unpacklo_epi8(src, zero);
+        const __m128i d = half ? _mm_unpackhi_epi8(dst, zero) : _mm_unpacklo_epi8(dst, zero);
+        const __m128i srcA = broadcastAlpha(s);
+        const __m128i dstA = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlpha(d), _mm_sub_epi16(c256, srcA)), 8);
+        outAlpha[half] = _mm_add_epi16(srcA, dstA);
+        // <= 255 * outAlpha => fits into 16 bit
+        const __m128i premultiplied = _mm_add_epi16(_mm_mullo_epi16(s, srcA), _mm_mullo_epi16(d, dstA));
+
+        const __m128i scale0 = _mm_set1_epi32(int(scales[_mm_extract_epi16(outAlpha[half], 0)]));
+        const __m128i scale1 = _mm_set1_epi32(int(scales[_mm_extract_epi16(outAlpha[half], 4)]));
+        blended[half * 2 + 0] = _mm_srli_epi32(webp_mullo_epi32(_mm_unpacklo_epi16(premultiplied, zero), scale0), 24);
+        blended[half * 2 + 1] = _mm_srli_epi32(webp_mullo_epi32(_mm_unpackhi_epi16(premultiplied, zero), scale1), 24);
+    }
+
+    const __m128i color = _mm_packus_epi16(_mm_packs_epi32(blended[0], blended[1]), _mm_packs_epi32(blended[2], blended[3]));
+    const __m128i alpha = _mm_packus_epi16(outAlpha[0], outAlpha[1]);
+    const __m128i alphaMask = _mm_set1_epi32(int(0xFF000000));
+    __m128i res = _mm_or_si128(_mm_andnot_si128(alphaMask, color), _mm_and_si128(alphaMask, alpha));
+
+    res = _mm_or_si128(_mm_and_si128(opaque, src), _mm_andnot_si128(opaque, res));
+    return _mm_or_si128(_mm_and_si128(transparent, dst), _mm_andnot_si128(transparent, res));
+}
+
+// blends the decoded frame (straight alpha) over the canvas. Rows are processed in parallel
+static void webp_blend(const uint8_t* src, size_t srcPitch, uint8_t* dst, size_t dstPitch, int width, int height)
+{
+    const uint32_t* scales = webp_alpha_scales();
+    image::parallelRanges(size_t(height), [&](size_t begin, size_t end, size_t)
+    {
+        for (size_t y = begin; y != end; ++y)
+        {
+            const uint8_t* srcRow = src + y * srcPitch;
+            uint8_t* dstRow = dst + y * dstPitch;
+            int x = 0;
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow + x * 4));
+                const int alphaBits = _mm_movemask_epi8(_mm_cmpeq_epi8(s, _mm_set1_epi8(char(0xFF)))) & 0x8888;
+                if (alphaBits == 0x8888) // opaque
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dstRow + x * 4), s);
+                    continue;
+                }
+                if ((_mm_movemask_epi8(_mm_cmpeq_epi8(s, _mm_setzero_si128())) & 0x8888) == 0x8888) // transparent
+                    continue;
+
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstRow + x * 4));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dstRow + x * 4), webp_blend_4(s, d, scales));
+            }
+            for (; x < width; ++x)
+                webp_blend_pixel(srcRow + x * 4, dstRow + x * 4, scales);
+        }
+    }, s_minBlendRows);
+}
 
+// clears the frame rectangle (WEBP_MUX_DISPOSE_BACKGROUND)
+static void webp_dispose(const WebpFrame& frame, uint8_t* canvas, uint32_t canvasWidth, uint32_t canvasHeight)
+{
+    const int x0 = std::max(frame.x, 0);
+    const int x1 = std::min(frame.x + frame.width, int(canvasWidth));
+    if (x1 <= x0) return;
+    for (int y = std::max(frame.y, 0); y < std::min(frame.y + frame.height, int(canvasHeight)); ++y)
+        std::memset(canvas + (size_t(y) * canvasWidth + x0) * 4, 0, size_t(x1 - x0) * 4);
+}
+
+// animations are decoded lazily: the constructor only indexes the frames and decodes the first one.
+// Other layers are composited on the first getData call by replaying the frames from the closest keyframe
+// or from a checkpoint canvas. getData is thread safe
 class WebpImage : public image::IImage
 {
 public:
@@ -41,93 +234,88 @@ public:
         if (!demux)
             throw std::runtime_error("WebPDemux failed");
 
-        m_frameCount = WebPDemuxGetI(demux, WEBP_FF_FRAME_COUNT);
         m_width = WebPDemuxGetI(demux, WEBP_FF_CANVAS_WIDTH);
         m_height = WebPDemuxGetI(demux, WEBP_FF_CANVAS_HEIGHT);
 
-        m_frames.reserve(m_frameCount);
-        std::vector<uint8_t> prevFrame(m_width * m_height * 4, 0);
-
         WebPIterator iter;
         if (!WebPDemuxGetFrame(demux, 1, &iter))
+        {
+            WebPDemuxDelete(demux);
             throw std::runtime_error("WebPDemuxGetFrame failed");
+        }
 
+        // index the frames. The fragments point into m_buffer and stay valid after the demuxer was deleted
         size_t totalDurationMs = 0;
-
         do {
-            int decodeWidth = 0, decodeHeight = 0;
-            uint8_t* decoded = WebPDecodeRGBA(iter.fragment.bytes, iter.fragment.size, &decodeWidth, &decodeHeight);
-            if (!decoded)
-                throw std::runtime_error("WebP frame decode failed");
-
-            totalDurationMs += size_t(iter.duration);
-
-            // Start with previous frame (or clear for first frame)
-            std::vector<uint8_t> frame(prevFrame);
-
-            // Composite the decoded region into the frame at the correct offset
-			auto frameIndex = m_frames.size();
-            for (int y = 0; y < decodeHeight; ++y) {
-                set_progress((uint32_t)((frameIndex * m_height + y) * 100) / (m_frameCount * m_height));
-                
-                int destY = iter.y_offset + y;
-                if (destY < 0 || destY >= int(m_height)) continue;
-                for (int x = 0; x < decodeWidth; ++x) {
-                    int destX = iter.x_offset + x;
-                    if (destX < 0 || destX >= int(m_width)) continue;
-                    size_t dstIdx = (destY * m_width + destX) * 4;
-                    size_t srcIdx = (y * decodeWidth + x) * 4;
-
-                    if (iter.blend_method == WEBP_MUX_BLEND && decoded[srcIdx + 3] < 255) {
-                        // Alpha blend with previous frame
-                        float srcA = decoded[srcIdx + 3] / 255.0f;
-                        float dstA = frame[dstIdx + 3] / 255.0f;
-                        float outA = srcA + dstA * (1 - srcA);
-                        for (int c = 0; c < 4; ++c) {
-                            float srcC = decoded[srcIdx + c] / 255.0f;
-                            float dstC = frame[dstIdx + c] / 255.0f;
-                            float outC = (srcC * srcA + dstC * dstA * (1 - srcA)) / (outA > 0 ? outA : 1);
-                            frame[dstIdx + c] = static_cast<uint8_t>(outC * 255.0f + 0.5f);
-                        }
-                    }
-                    else {
-                        // No blend, just copy
-                        std::memcpy(&frame[dstIdx], &decoded[srcIdx], 4);
-                    }
-                }
-            }
-
-            // Handle dispose method
-            if (iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND) {
-                // If the next frame needs a cleared region, clear it in prevFrame
-                for (int y = 0; y < decodeHeight; ++y) {
-                    int destY = iter.y_offset + y;
-                    if (destY < 0 || destY >= int(m_height)) continue;
-                    for (int x = 0; x < decodeWidth; ++x) {
-                        int destX = iter.x_offset + x;
-                        if (destX < 0 || destX >= int(m_width)) continue;
-                        size_t dstIdx = (destY * m_width + destX) * 4;
-                        prevFrame[dstIdx + 0] = 0;
-                        prevFrame[dstIdx + 1] = 0;
-                        prevFrame[dstIdx + 2] = 0;
-                        prevFrame[dstIdx + 3] = 0;
-                    }
-                }
-            }
-            else {
-                // Otherwise, next frame starts from this one
-                prevFrame = frame;
+            WebpFrame frame;
+            frame.data = iter.fragment.bytes;
+            frame.size = iter.fragment.size;
+            frame.x = iter.x_offset;
+            frame.y = iter.y_offset;
+            frame.width = iter.width;
+            frame.height = iter.height;
+            frame.blend = iter.blend_method == WEBP_MUX_BLEND;
+            frame.disposeBackground = iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND;
+            frame.hasAlpha = iter.has_alpha != 0;
+
+            // same keyframe rules as the WebPAnimDecoder
+            const uint32_t index = uint32_t(m_index.size());
+            bool isKeyframe = index == 0;
+            if (!isKeyframe && (!frame.hasAlpha || !frame.blend) && isFullFrame(frame))
+                isKeyframe = true;
+            if (!isKeyframe)
+            {
+                const auto& prev = m_index.back();
+                isKeyframe = prev.disposeBackground && (isFullFrame(prev) || prev.keyframe == index - 1);
             }
+            frame.keyframe = isKeyframe ? index : m_index.back().keyframe;
 
-            m_frames.push_back(std::move(frame));
-            WebPFree(decoded);
+            totalDurationMs += size_t(iter.duration);
+            m_index.push_back(frame);
         } while (WebPDemuxNextFrame(&iter));
 
         WebPDemuxReleaseIterator(&iter);
         WebPDemuxDelete(demux);
 
         if (totalDurationMs > 0)
-            m_fps = (1000.0f * float(m_frameCount)) / float(totalDurationMs);
+            m_fps = (1000.0f * float(m_index.size())) / float(totalDurationMs);
+
+        m_frames.resize(m_index.size());
+        m_pinned.resize(m_index.size(), 0);
+        m_maxCheckpoints = std::max<size_t>(s_checkpointBudget / canvasSize(), 2);
+
+        if (m_index.size() > 1 && get_global_parameter_i("webp anim decoder", 0))
+        {
+            decodeAnimation();
+            return;
+        }
+
+        if (m_index.size() == 1)
+        {
+            // still image: decode now (with previews) and release the file
+            std::vector<uint8_t> canvas(canvasSize(), 0);
+            const auto& frame = m_index[0];
+            if (wants_preview())
+            {
+                std::vector<uint8_t> decoded(size_t(frame.width) * size_t(frame.height) * 4);
+                webp_decode_progressive(frame.data, frame.size, frame.width, frame.height, decoded.data());
+                for (int y = 0; y < frame.height; ++y)
+                    std::memcpy(canvas.data() + ((size_t(frame.y) + y) * m_width + frame.x) * 4, decoded.data() + size_t(y) * frame.width * 4, size_t(frame.width) * 4);
+            }
+            else if (!drawFrame(frame, true, canvas.data()))
+                throw std::runtime_error("WebP frame decode failed");
+
+            m_frames[0] = std::move(canvas);
+            m_index.clear();
+            m_buffer = std::vector<uint8_t>();
+            return;
+        }
+
+        // the first frame validates the file
+        std::vector<uint8_t> canvas(canvasSize(), 0);
+        if (!drawFrame(m_index[0], true, canvas.data()))
+            throw std::runtime_error("WebP frame decode failed");
+        m_frames[0] = std::move(canvas);
     }
 
     ~WebpImage() override = default;
@@ -140,23 +328,179 @@ public:
     gli::format getFormat() const override { return gli::format::FORMAT_RGBA8_SRGB_PACK8; }
     gli::format getOriginalFormat() const override { return m_originalFormat; }
 
-    uint8_t* getData(uint32_t layer, uint32_t mipmap, size_t& size) override {
-        size = m_width * m_height * 4;
-        return m_frames[layer].data();
+    // the layer may be written (e.g. by image_reload) => it no longer matches the file and stays in memory
+    uint8_t* getData(uint32_t layer, uint32_t /*mipmap*/, size_t& size) override {
+        return getLayer(layer, true, size);
     }
-    const uint8_t* getData(uint32_t layer, uint32_t mipmap, size_t& size) const override {
-        size = m_width * m_height * 4;
-        return m_frames[layer].data();
+    const uint8_t* getData(uint32_t layer, uint32_t /*mipmap*/, size_t& size) const override {
+        return getLayer(layer, false, size);
     }
 
     virtual float getFps() const override {
         return m_fps;
 	}
 
+    // the released layer becomes a checkpoint: the memory is bounded by the checkpoint budget,
+    // and layers that are requested in order (uploads) are still composited from their predecessor
+    void releaseData(uint32_t layer, uint32_t /*mipmap*/) const override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& frame = m_frames[layer];
+        if (m_index.empty() || frame.empty() || m_pinned[layer])
+            return; // still images and written layers cannot be decoded again
+        addCheckpoint(layer, std::move(frame));
+        frame = std::vector<uint8_t>();
+    }
+
 private:
-    std::vector<uint8_t> m_buffer;
-    std::vector<std::vector<uint8_t>> m_frames;
-    uint32_t m_width = 0, m_height = 0, m_frameCount = 0;
+    // canvases of replayed frames that are kept for seeking (in bytes)
+    static constexpr size_t s_checkpointBudget = size_t(256) << 20;
+    // number of replayed frames between two checkpoints
+    static constexpr uint32_t s_checkpointDistance = 16;
+
+    struct Checkpoint
+    {
+        uint32_t frame;
+        std::vector<uint8_t> canvas; // canvas after the frame was drawn
+    };
+
+    size_t canvasSize() const { return size_t(m_width) * size_t(m_height) * 4; }
+
+    // decoded layers stay in memory until releaseData: callers may keep the pointers of all layers at the same time.
+    // Layers that are returned writable (e.g. to image_reload) may no longer match the file and are pinned
+    uint8_t* getLayer(uint32_t layer, bool pin, size_t& size) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& frame = m_frames[layer];
+        if (frame.empty())
+            frame = composeFrame(layer);
+        if (pin)
+            m_pinned[layer] = 1;
+        size = frame.size();
+        return frame.data();
+    }
+
+    // decodes all frames with the WebPAnimDecoder of libwebp and releases the file (reference for the lazy compositing)
+    void decodeAnimation()
+    {
+        WebPAnimDecoderOptions options;
+        if (!WebPAnimDecoderOptionsInit(&options))
+            throw std::runtime_error("WebPAnimDecoderOptionsInit failed");
+        options.color_mode = MODE_RGBA;
+
+        WebPData webp_data;
+        webp_data.bytes = m_buffer.data();
+        webp_data.size = m_buffer.size();
+        struct DecoderDeleter { void operator()(WebPAnimDecoder* dec) const { WebPAnimDecoderDelete(dec); } };
+        std::unique_ptr<WebPAnimDecoder, DecoderDeleter> dec(WebPAnimDecoderNew(&webp_data, &options));
+        if (!dec)
+            throw std::runtime_error("WebPAnimDecoderNew failed");
+
+        for (size_t i = 0; i < m_frames.size(); ++i)
+        {
+            set_progress(uint32_t(i * 100 / m_frames.size()));
+            uint8_t* canvas = nullptr;
+            int timestamp = 0;
+            if (!WebPAnimDecoderGetNext(dec.get(), &canvas, &timestamp))
+                throw std::runtime_error("WebP frame decode failed");
+            m_frames[i].assign(canvas, canvas + canvasSize());
+        }
+
+        m_index.clear();
+        m_buffer = std::vector<uint8_t>();
+    }
+
+    bool isFullFrame(const WebpFrame& frame) const
+    {
+        return uint32_t(frame.width) == m_width && uint32_t(frame.height) == m_height;
+    }
+
+    // decodes the frame and draws it onto the canvas. Returns false if the frame could not be decoded.
+    // Frames that overwrite their rectangle (keyframes, no blending or no alpha) are decoded directly into the canvas.
+    // Not thread safe (scratch buffer)
+    bool drawFrame(const WebpFrame& frame, bool isKeyframe, uint8_t* canvas) const
+    {
+        // the demuxer only accepts frames that are inside the canvas
+        if (frame.x < 0 || frame.y < 0 || uint32_t(frame.x + frame.width) > m_width || uint32_t(frame.y + frame.height) > m_height)
+            return false;
+
+        const size_t pitch = size_t(m_width) * 4;
+        uint8_t* dst = canvas + size_t(frame.y) * pitch + size_t(frame.x) * 4;
+        if (isKeyframe || !frame.blend || !frame.hasAlpha)
+            return WebPDecodeRGBAInto(frame.data, frame.size, dst, canvasSize() - size_t(dst - canvas), int(pitch)) != nullptr;
+
+        const size_t framePitch = size_t(frame.width) * 4;
+        if (m_scratch.size() < framePitch * frame.height)
+            m_scratch.resize(framePitch * frame.height);
+        if (!WebPDecodeRGBAInto(frame.data, frame.size, m_scratch.data(), m_scratch.size(), int(framePitch)))
+            return false;
+
+        webp_blend(m_scratch.data(), framePitch, dst, pitch, frame.width, frame.height);
+        return true;
+    }
+
+    // canvas after the frame was drawn (nullptr if it is neither decoded nor a checkpoint). Pinned layers are skipped. m_mutex must be locked
+    const std::vector<uint8_t>* findCanvas(uint32_t frame) const
+    {
+        if (!m_frames[frame].empty() && !m_pinned[frame])
+            return &m_frames[frame];
+        for (auto it = m_checkpoints.begin(); it != m_checkpoints.end(); ++it)
+        {
+            if (it->frame != frame) continue;
+            m_checkpoints.splice(m_checkpoints.begin(), m_checkpoints, it); // most recently used
+            return &m_checkpoints.front().canvas;
+        }
+        return nullptr;
+    }
+
+    void addCheckpoint(uint32_t frame, std::vector<uint8_t> canvas) const
+    {
+        m_checkpoints.remove_if([frame](const Checkpoint& c) { return c.frame == frame; });
+        m_checkpoints.push_front(Checkpoint{ frame, std::move(canvas) });
+        if (m_checkpoints.size() > m_maxCheckpoints)
+            m_checkpoints.pop_back();
+    }
+
+    // replays the frames from the closest keyframe or known canvas. m_mutex must be locked
+    std::vector<uint8_t> composeFrame(uint32_t layer) const
+    {
+        const uint32_t keyframe = m_index[layer].keyframe;
+        uint32_t first = keyframe;
+        std::vector<uint8_t> canvas;
+        for (uint32_t i = layer; i > keyframe; --i)
+        {
+            if (const auto prev = findCanvas(i - 1))
+            {
+                canvas = *prev;
+                first = i;
+                break;
+            }
+        }
+        if (canvas.empty())
+            canvas.assign(canvasSize(), 0); // keyframes start with a cleared canvas
+
+        for (uint32_t i = first; i <= layer; ++i)
+        {
+            if (i > keyframe && m_index[i - 1].disposeBackground)
+                webp_dispose(m_index[i - 1], canvas.data(), m_width, m_height);
+
+            // broken frames are skipped (getData cannot report errors)
+            drawFrame(m_index[i], i == keyframe, canvas.data());
+
+            if (i != layer && (i - keyframe + 1) % s_checkpointDistance == 0)
+                addCheckpoint(i, canvas);
+        }
+        return canvas;
+    }
+
+    std::vector<uint8_t> m_buffer; // compressed file (released for still images)
+    std::vector<WebpFrame> m_index;
+    mutable std::vector<std::vector<uint8_t>> m_frames; // decoded layers (empty if not decoded yet)
+    mutable std::vector<uint8_t> m_pinned; // layers that were returned writable. They are never released or replayed from
+    mutable std::list<Checkpoint> m_checkpoints; // least recently used at the back
+    mutable std::vector<uint8_t> m_scratch; // decoded frames that are blended
+    size_t m_maxCheckpoints = 2;
+    mutable std::mutex m_mutex;
+    uint32_t m_width = 0, m_height = 0;
     bool m_hasAlpha = false;
     gli::format m_originalFormat = gli::format::FORMAT_RGBA8_SRGB_PACK8;
     float m_fps = 0.0f;
@@ -175,95 +519,296 @@ std::vector<uint32_t> webp_get_export_formats()
     };
 }
 
-void webp_save_image(const char* filename, image::IImage& image, gli::format format, int quality, float fps)
+// encoder settings of the "webp preset" global parameter
+struct WebpPreset
+{
+    int method; // 0 (fast) - 6 (slow)
+    int pass; // entropy analysis passes
+    int minimizeSize; // WebPAnimEncoderOptions::minimize_size (tries all keyframe options, slow)
+};
+
+static const WebpPreset& webp_get_preset()
+{
+    static const WebpPreset s_presets[] = {
+        { 4, 1, 0 }, // 0 = balanced
+        { 1, 1, 0 }, // 1 = fast
+        { 6, 3, 1 }, // 2 = small
+    };
+    const int preset = get_global_parameter_i("webp preset", 0);
+    if (preset < 0 || preset > 2)
+        throw std::runtime_error("webp preset must be 0 (balanced), 1 (fast) or 2 (small)");
+    return s_presets[preset];
+}
+
+// owns the output of libwebp
+class WebpBuffer
+{
+public:
+    WebpBuffer() { WebPDataInit(&m_data); }
+    ~WebpBuffer() { WebPDataClear(&m_data); }
+    WebpBuffer(WebpBuffer&& o) noexcept : m_data(o.m_data) { WebPDataInit(&o.m_data); }
+    WebpBuffer& operator=(WebpBuffer&& o) noexcept { std::swap(m_data, o.m_data); return *this; }
+    WebpBuffer(const WebpBuffer&) = delete;
+    WebpBuffer& operator=(const WebpBuffer&) = delete;
+
+    WebPData* get() { return &m_data; }
+    const WebPData* get() const { return &m_data; }
+
+private:
+    WebPData m_data;
+};
+
+// progress of all segments. Only the calling thread reports the progress (set_progress is not thread safe)
+struct WebpProgress
+{
+    std::atomic<uint32_t> encodedLayers{ 0 };
+    std::atomic<bool> aborted{ false };
+    uint32_t numLayers = 1;
+};
+
+struct WebpProgressHook
+{
+    WebpProgress* progress;
+    bool report;
+};
+
+// true if the layer is not cropped when it is the first frame of a WebPAnimEncoder.
+// The encoder crops the first frame to the pixels that differ from a transparent canvas => every border needs an opaque pixel
+static bool webp_can_start_segment(const image::IImage& image, uint32_t layer)
 {
-    const uint32_t numLayers = image.getNumLayers();
     const uint32_t width = image.getWidth(0);
     const uint32_t height = image.getHeight(0);
+    size_t size;
+    const uint8_t* data = image.getData(layer, 0, size);
+    auto opaque = [&](uint32_t x, uint32_t y) { return data[(size_t(y) * width + x) * 4 + 3] == 255; };
 
-    image.applyBGRPostprocess(); // WebP expect BGRA order (argb)
+    bool top = false, bottom = false, left = false, right = false;
+    for (uint32_t x = 0; x < width && !(top && bottom); ++x)
+    {
+        top = top || opaque(x, 0);
+        bottom = bottom || opaque(x, height - 1);
+    }
+    for (uint32_t y = 0; y < height && !(left && right); ++y)
+    {
+        left = left || opaque(0, y);
+        right = right || opaque(width - 1, y);
+    }
+    return top && bottom && left && right;
+}
 
-    std::vector<uint8_t> webp_data; // For static image
-
-    if (fps < 0.0f) fps = 24.0f; // default to 24 fps 
-	float msFrame = 1000 / fps;
-    WebPAnimEncoderOptions enc_opts = {};
-	enc_opts.minimize_size = 1;
-    enc_opts.allow_mixed = 1;
-    enc_opts.kmin = 1;
-	enc_opts.kmax = 2048;
-    auto ret = WebPAnimEncoderOptionsInit(&enc_opts);
-    assert(ret);
-
-	WebPConfig config = {};
-	config.lossless = quality >= 100 ? 1 : 0;
-	config.quality = float(quality);
-	config.method = 5; // second slowest
-	config.segments = 4;
-    config.alpha_compression = 1;
-	config.alpha_quality = quality;
-    config.pass = 3;
-    config.near_lossless = config.lossless ? 100 : 0;
-    config.partition_limit = 0; // best quality
-    config.sns_strength = 50; // default
-    config.filter_strength = 60; // default
-    config.filter_sharpness = 0; // default
-    config.alpha_filtering = 1; // default
-    config.exact = 0; // default
-    config.use_sharp_yuv = 0; // default
-    config.qmin = 0; config.qmax = 100;
-    config.thread_level = 1;
+// first layers of the segments that are encoded independently.
+// Segments have at least s_minSegmentLayers layers and start with a layer that is not cropped by the encoder
+static std::vector<uint32_t> webp_find_segments(const image::IImage& image, size_t maxSegments)
+{
+    const uint32_t numLayers = image.getNumLayers();
+    const size_t numSegments = std::min<size_t>(maxSegments, std::max<size_t>(numLayers / s_minSegmentLayers, 1));
+    std::vector<uint32_t> res = { 0 };
+    for (size_t i = 1; i < numSegments; ++i)
+    {
+        uint32_t start = std::max(uint32_t(size_t(numLayers) * i / numSegments), res.back() + s_minSegmentLayers);
+        while (start + s_minSegmentLayers <= numLayers && !webp_can_start_segment(image, start))
+            ++start;
+        if (start + s_minSegmentLayers > numLayers) break;
+        res.push_back(start);
+    }
+    return res;
+}
 
-    WebPAnimEncoder* enc = WebPAnimEncoderNew(width, height, &enc_opts);
+// encodes the layers [first, last) with an own animation encoder.
+// Timestamps are global => the frame durations do not depend on the segmentation
+static WebpBuffer webp_encode_segment(image::IImage& image, uint32_t first, uint32_t last, float msFrame,
+    const WebPConfig& config, const WebPAnimEncoderOptions& options, WebpProgressHook hook)
+{
+    struct EncoderDeleter { void operator()(WebPAnimEncoder* enc) const { WebPAnimEncoderDelete(enc); } };
+    std::unique_ptr<WebPAnimEncoder, EncoderDeleter> enc(WebPAnimEncoderNew(int(image.getWidth(0)), int(image.getHeight(0)), &options));
+    if (!enc)
+        throw std::runtime_error("WebPAnimEncoderNew failed");
 
-    for (uint32_t layer = 0; layer < image.getNumLayers(); ++layer) 
+    auto checkResult = [&](int ret)
     {
-        WebPPicture pic = {};
-        ret = WebPPictureInit(&pic);
-        assert(ret);
-        pic.width = width;
-        pic.height = height;
+        if (ret) return;
+        if (hook.progress->aborted)
+            throw abort_error();
+        throw std::runtime_error(std::string("webp: ") + WebPAnimEncoderGetError(enc.get()));
+    };
+
+    for (uint32_t layer = first; layer < last; ++layer)
+    {
+        WebPPicture pic;
+        if (!WebPPictureInit(&pic))
+            throw std::runtime_error("WebPPictureInit failed");
+        pic.width = int(image.getWidth(0));
+        pic.height = int(image.getHeight(0));
         pic.use_argb = 1;
-		size_t dataSize;
+        size_t dataSize;
         pic.argb = reinterpret_cast<uint32_t*>(image.getData(layer, 0, dataSize));
-        pic.argb_stride = width;
-        std::pair<uint32_t, uint32_t> curLayer = { layer, image.getNumLayers() };
-        pic.user_data = &curLayer;
-		pic.progress_hook = [](int percent, const WebPPicture* pic) -> int {
-            auto curLayer = *reinterpret_cast<std::pair<uint32_t, uint32_t>*>(pic->user_data);
+        pic.argb_stride = pic.width;
+        pic.user_data = &hook;
+        pic.progress_hook = [](int percent, const WebPPicture* pic) -> int {
+            const auto& hook = *static_cast<const WebpProgressHook*>(pic->user_data);
+            if (hook.progress->aborted) return 0;
+            if (!hook.report) return 1;
             try
             {
-                set_progress((curLayer.first * 100 + percent) / curLayer.second);
+                set_progress((hook.progress->encodedLayers * 100 + uint32_t(percent)) / hook.progress->numLayers);
             }
             catch (...)
             {
+                hook.progress->aborted = true;
                 return 0; // abort
             }
-			return 1;
-		};
+            return 1;
+        };
 
         // timestamp_ms = cumulative display duration
-        ret = WebPAnimEncoderAdd(enc, &pic, int(msFrame * float(layer)), &config);
-        assert(ret);
+        const int ret = WebPAnimEncoderAdd(enc.get(), &pic, int(msFrame * float(layer)), &config);
         WebPPictureFree(&pic);
-        if(!ret) break;
+        checkResult(ret);
+        ++hook.progress->encodedLayers;
     }
 
-	if (ret) // finalize if all frames were added successfully
+    // last call to set final timestamp
+    checkResult(WebPAnimEncoderAdd(enc.get(), nullptr, int(msFrame * float(last)), &config));
+    WebpBuffer res;
+    checkResult(WebPAnimEncoderAssemble(enc.get(), res.get()));
+    return res;
+}
+
+// joins the segments into a single animation. Returns false if a segment does not start with a full canvas frame
+static bool webp_mux_segments(const std::vector<WebpBuffer>& segments, const std::vector<uint32_t>& firstLayers, uint32_t numLayers,
+    float msFrame, uint32_t width, uint32_t height, WebpBuffer& dst)
+{
+    struct MuxDeleter { void operator()(WebPMux* mux) const { WebPMuxDelete(mux); } };
+    std::unique_ptr<WebPMux, MuxDeleter> mux(WebPMuxNew());
+    if (!mux)
+        throw std::runtime_error("WebPMuxNew failed");
+
+    for (size_t s = 0; s < segments.size(); ++s)
     {
-        // last call to set final timestamp
-        WebPAnimEncoderAdd(enc, nullptr, int(msFrame * float(numLayers)), &config);
+        std::unique_ptr<WebPMux, MuxDeleter> segment(WebPMuxCreate(segments[s].get(), 0));
+        if (!segment)
+            throw std::runtime_error("WebPMuxCreate failed");
+
+        // segments whose frames were merged into one are assembled as still images
+        int numFrames = 0;
+        if (WebPMuxNumChunks(segment.get(), WEBP_CHUNK_ANMF, &numFrames) != WEBP_MUX_OK)
+            throw std::runtime_error("WebPMuxNumChunks failed");
+        const bool isStill = numFrames == 0;
+        if (isStill) numFrames = 1;
+
+        for (int i = 1; i <= numFrames; ++i)
+        {
+            WebPMuxFrameInfo frame;
+            if (WebPMuxGetFrame(segment.get(), uint32_t(i), &frame) != WEBP_MUX_OK)
+                throw std::runtime_error("WebPMuxGetFrame failed");
+            WebpBuffer bitstream;
+            *bitstream.get() = frame.bitstream; // WebPMuxGetFrame copies the bitstream
+
+            if (isStill)
+            {
+                const uint32_t end = s + 1 < segments.size() ? firstLayers[s + 1] : numLayers;
+                frame.duration = int(msFrame * float(end)) - int(msFrame * float(firstLayers[s]));
+                frame.x_offset = frame.y_offset = 0;
+                frame.dispose_method = WEBP_MUX_DISPOSE_NONE;
+                frame.blend_method = WEBP_MUX_NO_BLEND;
+                frame.id = WEBP_CHUNK_ANMF;
+            }
+            if (i == 1 && s > 0)
+            {
+                // the first frame must not depend on the canvas of the previous segment
+                int frameWidth = 0, frameHeight = 0;
+                if (!WebPGetInfo(frame.bitstream.bytes, frame.bitstream.size, &frameWidth, &frameHeight) ||
+                    frame.x_offset != 0 || frame.y_offset != 0 || uint32_t(frameWidth) != width || uint32_t(frameHeight) != height)
+                    return false;
+                frame.blend_method = WEBP_MUX_NO_BLEND;
+            }
 
-        WebPData out_data;
-        WebPDataInit(&out_data);
-        ret = WebPAnimEncoderAssemble(enc, &out_data);
-        assert(ret);
+            if (WebPMuxPushFrame(mux.get(), &frame, 1) != WEBP_MUX_OK)
+                throw std::runtime_error("WebPMuxPushFrame failed");
+        }
+    }
 
-        std::ofstream out(filename, std::ios::binary);
-        out.write(reinterpret_cast<const char*>(out_data.bytes), out_data.size);
-        out.close();
+    WebPMuxAnimParams params;
+    params.bgcolor = 0xFFFFFFFF; // same defaults as WebPAnimEncoder
+    params.loop_count = 0;
+    if (WebPMuxSetAnimationParams(mux.get(), &params) != WEBP_MUX_OK ||
+        WebPMuxSetCanvasSize(mux.get(), int(width), int(height)) != WEBP_MUX_OK ||
+        WebPMuxAssemble(mux.get(), dst.get()) != WEBP_MUX_OK)
+        throw std::runtime_error("WebPMuxAssemble failed");
+    return true;
+}
+
+void webp_save_image(const char* filename, image::IImage& image, gli::format format, int quality, float fps)
+{
+    const uint32_t numLayers = image.getNumLayers();
+    const uint32_t width = image.getWidth(0);
+    const uint32_t height = image.getHeight(0);
+    const auto& preset = webp_get_preset();
+
+    image.applyBGRPostprocess(); // WebP expect BGRA order (argb)
+
+    if (fps <= 0.0f) fps = 24.0f; // default to 24 fps
+    const float msFrame = 1000 / fps;
+
+    WebPAnimEncoderOptions encOptions;
+    if (!WebPAnimEncoderOptionsInit(&encOptions))
+        throw std::runtime_error("WebPAnimEncoderOptionsInit failed");
+    encOptions.minimize_size = preset.minimizeSize;
+    // mixed mode may encode frames of lossless exports lossy => only on request
+    encOptions.allow_mixed = quality < 100 && get_global_parameter_i("webp mixed", 0) ? 1 : 0;
+
+    WebPConfig config;
+    if (!WebPConfigInit(&config))
+        throw std::runtime_error("WebPConfigInit failed");
+    config.lossless = quality >= 100 ? 1 : 0;
+    config.quality = float(quality);
+    config.method = preset.method;
+    config.pass = preset.pass;
+    config.segments = 4;
+    config.alpha_compression = 1;
+    config.alpha_quality = quality;
+    config.near_lossless = config.lossless ? 100 : 0;
+    config.partition_limit = 0; // best quality
+    config.sns_strength = 50; // default
+    config.filter_strength = 60; // default
+    config.filter_sharpness = 0; // default
+    config.alpha_filtering = 1; // default
+    config.exact = 0; // default
+    config.use_sharp_yuv = 0; // default
+    config.qmin = 0; config.qmax = 100;
+
+    // long animations are split into segments that are encoded on multiple threads
+    const size_t maxSegments = image::threadLimit() ? std::min(image::threadLimit(), image::getNumThreads()) : image::getNumThreads();
+    const auto firstLayers = webp_find_segments(image, maxSegments);
+    // libwebp can use an additional thread for the alpha plane
+    config.thread_level = firstLayers.size() == 1 ? 1 : 0;
+
+    WebpProgress progress;
+    progress.numLayers = numLayers;
+    std::vector<WebpBuffer> segments(firstLayers.size());
+    image::parallelRanges(firstLayers.size(), [&](size_t begin, size_t end, size_t rangeIndex)
+    {
+        for (size_t s = begin; s < end; ++s)
+        {
+            const uint32_t last = s + 1 < firstLayers.size() ? firstLayers[s + 1] : numLayers;
+            segments[s] = webp_encode_segment(image, firstLayers[s], last, msFrame, config, encOptions, { &progress, rangeIndex == 0 });
+        }
+    });
+
+    WebpBuffer muxed;
+    if (segments.size() > 1 && !webp_mux_segments(segments, firstLayers, numLayers, msFrame, width, height, muxed))
+    {
+        // the encoder cropped a segment start => encode everything with a single encoder
+        progress.encodedLayers = 0;
+        segments.resize(1);
+        segments[0] = webp_encode_segment(image, 0, numLayers, msFrame, config, encOptions, { &progress, true });
     }
-    
-    // cleanup
-    WebPAnimEncoderDelete(enc);
+    const WebPData* out = segments.size() > 1 ? muxed.get() : segments[0].get();
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("could not open file");
+    file.write(reinterpret_cast<const char*>(out->bytes), out->size);
+    if (!file)
+        throw std::runtime_error("could not write file");
 }
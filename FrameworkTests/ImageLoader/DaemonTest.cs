@@ -0,0 +1,195 @@
+﻿using System;
+using System.IO;
+using System.Linq;
+using System.Net;
+using System.Net.Sockets;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using ImageFramework.DirectX;
+using ImageFramework.ImageLoader;
+using ImageFramework.Utility;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+namespace FrameworkTests.ImageLoader
+{
+    [TestClass]
+    public class DaemonTest
+    {
+        private static readonly string ExportDir = TestData.Directory + "daemon/";
+        // sun_path is limited to 108 characters => temp directory instead of the test directory
+        private static readonly string SocketPath = Path.Combine(Path.GetTempPath(), "imageviewer_daemon_test.sock");
+
+        // AF_UNIX address (UnixDomainSocketEndPoint is not available in .NET Framework)
+        private class UnixEndPoint : EndPoint
+        {
+            private readonly string path;
+
+            public UnixEndPoint(string path)
+            {
+                this.path = path;
+            }
+
+            public override AddressFamily AddressFamily => AddressFamily.Unix;
+
+            public override SocketAddress Serialize()
+            {
+                // sockaddr_un: 2 bytes family + 108 bytes path
+                var address = new SocketAddress(AddressFamily.Unix, 2 + 108);
+                var bytes = Encoding.UTF8.GetBytes(path);
+                for (int i = 0; i < bytes.Length; ++i)
+                    address[2 + i] = bytes[i];
+                return address;
+            }
+
+            public override EndPoint Create(SocketAddress socketAddress)
+            {
+                return new UnixEndPoint(path);
+            }
+        }
+
+        private class Client : IDisposable
+        {
+            private readonly Socket socket;
+            private readonly StreamReader reader;
+            private readonly StreamWriter writer;
+            private int numRequests = 0;
+
+            public Client()
+            {
+                // the daemon might not listen yet
+                for (int i = 0; socket == null; ++i)
+                {
+                    var s = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified);
+                    try
+                    {
+                        s.Connect(new UnixEndPoint(SocketPath));
+                        socket = s;
+                    }
+                    catch (SocketException)
+                    {
+                        s.Dispose();
+                        if (i == 100) throw;
+                        Thread.Sleep(50);
+                    }
+                }
+
+                var stream = new NetworkStream(socket, true);
+                reader = new StreamReader(stream, new UTF8Encoding(false));
+                writer = new StreamWriter(stream, new UTF8Encoding(false)) { NewLine = "\n", AutoFlush = true };
+            }
+
+            // sends the request and returns the number of the request
+            public int Send(string request)
+            {
+                writer.WriteLine(request);
+                return ++numRequests;
+            }
+
+            // returns the response of the request without the request number ("ok ..." or "error ...", optionally "progress ...")
+            public string Receive(int request, bool stopAtProgress = false)
+            {
+                while (true)
+                {
+                    var line = reader.ReadLine();
+                    Assert.IsNotNull(line, "daemon closed the connection");
+                    var space = line.IndexOf(' ');
+                    Assert.AreEqual(request, int.Parse(line.Substring(0, space)));
+                    var response = line.Substring(space + 1);
+                    if (stopAtProgress || !response.StartsWith("progress ")) return response;
+                }
+            }
+
+            public string Request(string request)
+            {
+                return Receive(Send(request));
+            }
+
+            public void Dispose()
+            {
+                writer.Dispose();
+                reader.Dispose();
+            }
+        }
+
+        private static string Quote(string file)
+        {
+            return "\"" + Path.GetFullPath(file) + "\"";
+        }
+
+        [TestInitialize]
+        public void Init()
+        {
+            TestData.CreateOutputDirectory(ExportDir);
+        }
+
+        [TestMethod]
+        public void RoundTrip()
+        {
+            var daemon = Task.Run(() => IO.RunConversionDaemon(SocketPath, 2));
+
+            using (var client = new Client())
+            {
+                var pngFormats = string.Join(" ", IO.GetExportFormats("png").Select(f => ((int) f).ToString()));
+                Assert.AreEqual("ok " + pngFormats, client.Request("formats png"));
+
+                Assert.IsTrue(client.Request($"open a {Quote(TestData.Directory + "small.png")}").StartsWith("ok 3 3 1 1 1 "));
+                Assert.AreEqual("ok", client.Request($"save a {Quote(ExportDir + "save.png")}"));
+                // save released the image
+                Assert.IsTrue(client.Request("release a").StartsWith("error"));
+
+                Assert.AreEqual("ok", client.Request($"convert {Quote(TestData.Directory + "small.png")} {Quote(ExportDir + "convert.pfm")}"));
+
+                Assert.IsTrue(client.Request($"open b {Quote(TestData.Directory + "missing.png")}").StartsWith("error"));
+                Assert.IsTrue(client.Request("unknown").StartsWith("error"));
+                Assert.IsTrue(client.Request("open \"unterminated").StartsWith("error"));
+
+                Assert.AreEqual("ok", client.Request("shutdown"));
+            }
+
+            Assert.IsTrue(daemon.Wait(10000));
+
+            using (var image = IO.LoadImage(ExportDir + "save.png"))
+                TestData.CompareWithSmall(image, Color.Channel.Rgb);
+            using (var image = IO.LoadImage(ExportDir + "convert.pfm"))
+                TestData.CompareWithSmall(image, Color.Channel.Rgb);
+        }
+
+        [TestMethod]
+        public void AbortOnDisconnect()
+        {
+            // noise compresses slowly and reports progress from the first png stripe
+            const int size = 2048;
+            var noise = new byte[size * size * 4];
+            new Random(1).NextBytes(noise);
+            using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA8_SRGB), new Size3(size, size), LayerMipmapCount.One))
+            {
+                Marshal.Copy(noise, 0, image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, noise.Length);
+                IO.SaveImage(image, ExportDir + "noise", "bmp", GliFormat.RGB8_SRGB);
+            }
+
+            var daemon = Task.Run(() => IO.RunConversionDaemon(SocketPath, 2));
+
+            using (var client = new Client())
+            {
+                var request = client.Send($"convert {Quote(ExportDir + "noise.bmp")} {Quote(ExportDir + "aborted.png")}");
+                var response = client.Receive(request, true);
+                Assert.IsTrue(response.StartsWith("progress"));
+            }
+
+            // the daemon keeps serving other clients
+            using (var client = new Client())
+            {
+                Assert.AreEqual("ok", client.Request($"convert {Quote(TestData.Directory + "small.png")} {Quote(ExportDir + "after.png")}"));
+                Assert.AreEqual("ok", client.Request("shutdown"));
+            }
+
+            // the daemon finishes all requests before it stops. The aborted request must not compress the entire image
+            Assert.IsTrue(daemon.Wait(10000));
+
+            using (var image = IO.LoadImage(ExportDir + "after.png"))
+                TestData.CompareWithSmall(image, Color.Channel.Rgb);
+        }
+    }
+}
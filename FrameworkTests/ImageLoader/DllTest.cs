@@ -2,11 +2,14 @@
 using System.Collections.Generic;
 using System.IO;
 using System.Linq;
+using System.Runtime.InteropServices;
 using System.Text;
+using System.Threading;
 using System.Threading.Tasks;
 using ImageFramework.DirectX;
 using ImageFramework.ImageLoader;
 using ImageFramework.Model.Shader;
+using ImageFramework.Model.Statistics;
 using ImageFramework.Utility;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using SharpDX.DXGI;
@@ -74,6 +77,67 @@ namespace FrameworkTests.ImageLoader
             VerifySmallHdr(IO.LoadImage(TestData.Directory + "small_g.pfm"), Color.Channel.R);
         }
 
+        [TestMethod]
+        public void PfmBigEndian()
+        {
+            // 13x5 with a positive scale of 2: value = 2 * (x * 0.5 + y * 8 + channel * 0.125)
+            foreach (var gray in new[] { false, true })
+            {
+                using (var image = IO.LoadImage(TestData.Directory + (gray ? "bigendian_g.pfm" : "bigendian.pfm")))
+                {
+                    Assert.AreEqual(13, image.Size.Width);
+                    Assert.AreEqual(5, image.Size.Height);
+                    var actual = new float[13 * 5 * 4];
+                    Marshal.Copy(image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, actual, 0, actual.Length);
+                    for (int i = 0; i < actual.Length; ++i)
+                    {
+                        int c = i % 4;
+                        int x = (i / 4) % 13;
+                        int y = i / (4 * 13);
+                        var expected = c == 3 ? 1.0f : 2.0f * (x * 0.5f + y * 8 + (gray ? 0 : c) * 0.125f);
+                        Assert.AreEqual(expected, actual[i]);
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void PfmRoundTrip()
+        {
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "roundtrip";
+            // wide enough for the 4 pixel loops and a remainder
+            const int width = 13;
+            const int height = 9;
+            var rnd = new Random(5);
+            var floats = new float[width * height * 4];
+            for (int i = 0; i < floats.Length; ++i)
+                floats[i] = i % 4 == 3 ? 1.0f : (float)(rnd.NextDouble() * 200.0 - 100.0);
+
+            foreach (var format in new[] { GliFormat.RGB32_SFLOAT, GliFormat.R32_SFLOAT })
+            {
+                using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA32_SFLOAT), new Size3(width, height), LayerMipmapCount.One))
+                {
+                    Marshal.Copy(floats, 0, image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, floats.Length);
+                    IO.SaveImage(image, filename, "pfm", format);
+                }
+
+                using (var image = IO.LoadImage(filename + ".pfm"))
+                {
+                    Assert.AreEqual(width, image.Size.Width);
+                    Assert.AreEqual(height, image.Size.Height);
+                    var actual = new float[floats.Length];
+                    Marshal.Copy(image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, actual, 0, actual.Length);
+                    for (int i = 0; i < floats.Length; ++i)
+                    {
+                        // grayscale files repeat red on each channel
+                        var expected = format == GliFormat.R32_SFLOAT && i % 4 != 3 ? floats[i - i % 4] : floats[i];
+                        Assert.AreEqual(expected, actual[i]);
+                    }
+                }
+            }
+        }
+
         [TestMethod]
         public void DDSSimple()
         {
@@ -135,5 +199,776 @@ namespace FrameworkTests.ImageLoader
             Assert.IsTrue(tex.GetPixelColors(LayerMipmapSlice.Mip5)[0].Equals(new Color(0.0f, 1.0f, 1.0f), Color.Channel.Rgb));
             Assert.IsTrue(tex.GetPixelColors(LayerMipmapSlice.Mip6)[0].Equals(new Color(1.0f, 0.0f, 1.0f), Color.Channel.Rgb));
         }
+
+        [TestMethod]
+        public void NativeStatistics()
+        {
+            // same expectations as StatisticsTest.Checkers (gpu statistics)
+            using (var image = IO.LoadImage(TestData.Directory + "checkers.dds"))
+            {
+                Assert.IsTrue(Dll.image_compute_statistics(image.Resource.Id, -1, 0, out var stats), Dll.GetError());
+
+                var luminance = (int)DefaultStatistics.Types.Luminance;
+                var luma = (int)DefaultStatistics.Types.Luma;
+                var average = (int)DefaultStatistics.Types.Average;
+                var lightness = (int)DefaultStatistics.Types.Lightness;
+                var alpha = (int)DefaultStatistics.Types.Alpha;
+
+                Assert.AreEqual(1.0f, stats.Min[alpha]);
+                Assert.AreEqual(1.0f, stats.Max[alpha]);
+                Assert.AreEqual(1.0f, stats.Avg[alpha], 0.01f);
+
+                Assert.AreEqual(0.0f, stats.Min[luminance]);
+                Assert.AreEqual(1.0f, stats.Max[luminance], 0.01f);
+                Assert.AreEqual(0.5f, stats.Avg[luminance], 0.01f);
+
+                Assert.AreEqual(0.0f, stats.Min[luma]);
+                Assert.AreEqual(1.0f, stats.Max[luma], 0.01f);
+                Assert.AreEqual(0.5f, stats.Avg[luma], 0.01f);
+
+                Assert.AreEqual(0.0f, stats.Min[average]);
+                Assert.AreEqual(1.0f, stats.Max[average], 0.01f);
+                Assert.AreEqual(0.5f, stats.Avg[average], 0.01f);
+
+                Assert.AreEqual(0.0f, stats.Min[lightness]);
+                Assert.AreEqual(100.0f, stats.Max[lightness], 0.5f);
+                Assert.AreEqual(50.0f, stats.Avg[lightness], 0.5f);
+
+                // black and white checkers => grayscale
+                Assert.AreEqual(1.0f, stats.Min[5]);
+            }
+        }
+
+        [TestMethod]
+        public void NativeCompare()
+        {
+            // same expectations as StatisticsTest.SSIMEinsteinTest (gpu ssim)
+            using (var einstein = IO.LoadImage(TestData.Directory + "einstein/ref.jpg"))
+            using (var einstein0662 = IO.LoadImage(TestData.Directory + "einstein/ssim0662.jpg"))
+            using (var einstein0988 = IO.LoadImage(TestData.Directory + "einstein/ssim0988.jpg"))
+            {
+                var id = einstein.Resource.Id;
+
+                Assert.IsTrue(Dll.image_compare(id, einstein0662.Resource.Id, 0, 0, Dll.CompareMetric.Ssim, Dll.CompareFlags.ExcludeBorders, out var ssim, out _), Dll.GetError());
+                Assert.AreEqual(0.71071f, ssim, 0.01f);
+
+                Assert.IsTrue(Dll.image_compare(id, einstein0988.Resource.Id, 0, 0, Dll.CompareMetric.Ssim, Dll.CompareFlags.ExcludeBorders, out ssim, out _), Dll.GetError());
+                Assert.AreEqual(0.98780f, ssim, 0.01f);
+
+                // identical images
+                Assert.IsTrue(Dll.image_compare(id, id, 0, 0, Dll.CompareMetric.Mse, Dll.CompareFlags.None, out var mse, out _), Dll.GetError());
+                Assert.AreEqual(0.0f, mse);
+                Assert.IsTrue(Dll.image_compare(id, id, 0, 0, Dll.CompareMetric.Psnr, Dll.CompareFlags.None, out var psnr, out _), Dll.GetError());
+                Assert.IsTrue(float.IsPositiveInfinity(psnr));
+
+                // error map has the dimensions of the compared mipmap
+                Assert.IsTrue(Dll.image_compare(id, einstein0662.Resource.Id, 0, 0, Dll.CompareMetric.Ssim, Dll.CompareFlags.ErrorMap, out _, out var errorMap), Dll.GetError());
+                Assert.AreNotEqual(0, errorMap);
+                Dll.image_info_mipmap(errorMap, 0, out var width, out var height, out var depth);
+                Assert.AreEqual(einstein.Size.Width, width);
+                Assert.AreEqual(einstein.Size.Height, height);
+                Dll.image_release(errorMap);
+            }
+        }
+
+        [TestMethod]
+        public void NativeOpenWithOptions()
+        {
+            var options = new ImageLoadOptions { Format = GliFormat.RGBA32_SFLOAT };
+            using (var image = IO.LoadImage(TestData.Directory + "small.png", options))
+            {
+                VerifySmallHdr(image, Color.Channel.Rgb);
+            }
+
+            // only compatible formats can be requested
+            options.Format = GliFormat.RGB_DXT1_SRGB;
+            Assert.AreEqual(0, Dll.image_open_with_options(TestData.Directory + "small.png", ref options));
+        }
+
+        [TestMethod]
+        public void NativeOpenProgressive()
+        {
+            // rgb32 float with 3 mipmaps => mipmap 1 is converted first
+            var previews = new List<ImagePreview>();
+            using (var image = IO.LoadImage(TestData.Directory + "cubemap.dds", new ImageLoadOptions(), previews.Add))
+            {
+                Assert.AreEqual(6, image.LayerMipmap.Layers);
+                Assert.AreEqual(1, previews.Count);
+                Assert.AreEqual(ImagePreview.Stages.Mipmap, previews[0].Stage);
+                Assert.AreEqual(2u, previews[0].Width);
+                Assert.AreEqual(2u, previews[0].Height);
+                Assert.AreEqual(GliFormat.RGBA32_SFLOAT, previews[0].Format);
+            }
+
+            // supported formats are available immediately
+            previews.Clear();
+            using (var image = IO.LoadImage(TestData.Directory + "small.png", new ImageLoadOptions(), previews.Add))
+            {
+                VerifySmallLdr(image, Color.Channel.Rgb);
+                Assert.AreEqual(0, previews.Count);
+            }
+        }
+
+        [TestMethod]
+        public void NativeOpenProgressiveAbort()
+        {
+            // png with more than one preview row band (16 rows)
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "abort";
+            using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA8_SRGB), new Size3(8, 64), LayerMipmapCount.One))
+                IO.SaveImage(image, filename, "png", GliFormat.RGBA8_SRGB);
+
+            int numPreviews = 0;
+            Dll.PreviewDelegate abort = (ref ImagePreview preview) =>
+            {
+                ++numPreviews;
+                return 1;
+            };
+            var options = new ImageLoadOptions();
+            // the png loader must not fall back to stb_image after the abort
+            var id = Dll.image_open_progressive(filename + ".png", ref options, abort);
+            GC.KeepAlive(abort);
+            if (id != 0) Dll.image_release(id);
+
+            Assert.AreEqual(0, id);
+            Assert.AreEqual(1, numPreviews);
+            Assert.AreEqual("aborted by user", Dll.GetError());
+        }
+
+        [TestMethod]
+        public void NativeOpenProgressiveRows()
+        {
+            // more than one preview band (256 rows)
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "rows";
+            const int height = 600;
+            using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA32_SFLOAT), new Size3(8, height), LayerMipmapCount.One))
+            {
+                IO.SaveImage(image, filename, "hdr", GliFormat.RGB8E8_UFLOAT);
+                IO.SaveImage(image, filename, "pfm", GliFormat.RGB32_SFLOAT);
+            }
+
+            // the first row preview is never throttled
+            var previews = new List<ImagePreview>();
+            using (var image = IO.LoadImage(filename + ".hdr", new ImageLoadOptions(), previews.Add))
+                Assert.AreEqual(height, image.Size.Height);
+            Assert.IsTrue(previews.Count >= 1);
+            Assert.IsTrue(previews.All(p => p.Stage == ImagePreview.Stages.Rows && p.FirstRow == 0));
+            Assert.AreEqual(256u, previews[0].NumRows);
+            Assert.AreEqual(GliFormat.RGBA32_SFLOAT, previews[0].Format);
+
+            // pfm files start with the bottom row
+            previews.Clear();
+            using (var image = IO.LoadImage(filename + ".pfm", new ImageLoadOptions(), previews.Add))
+                Assert.AreEqual(height, image.Size.Height);
+            Assert.IsTrue(previews.Count >= 1);
+            Assert.IsTrue(previews.All(p => p.Stage == ImagePreview.Stages.Rows && p.NumRows == height));
+            Assert.AreEqual((uint)(height - 256), previews[0].FirstRow);
+        }
+
+        [TestMethod]
+        public void NativeCopyTo()
+        {
+            using (var image = IO.LoadImage(TestData.Directory + "small.png"))
+            {
+                // 3x3 pixels with 4 bytes padding per row
+                const int rowPitch = 16;
+                var dst = Enumerable.Repeat((byte)0xCD, rowPitch * 3).ToArray();
+                var handle = GCHandle.Alloc(dst, GCHandleType.Pinned);
+                try
+                {
+                    image.CopyTo(LayerMipmapSlice.Mip0, handle.AddrOfPinnedObject(), rowPitch, 0, GliFormat.BGRA8_SRGB, true);
+                    // first row of small.png is red, green, blue and is written last
+                    CollectionAssert.AreEqual(new byte[] { 0, 0, 255 }, dst.Skip(2 * rowPitch).Take(3).ToArray());
+                    CollectionAssert.AreEqual(new byte[] { 0, 255, 0 }, dst.Skip(2 * rowPitch + 4).Take(3).ToArray());
+                    CollectionAssert.AreEqual(new byte[] { 255, 0, 0 }, dst.Skip(2 * rowPitch + 8).Take(3).ToArray());
+                    // padding is not written
+                    Assert.AreEqual(0xCD, dst[12]);
+                    Assert.AreEqual(0xCD, dst[rowPitch * 3 - 1]);
+
+                    // row pitch is too small
+                    Assert.IsFalse(Dll.image_copy_to(image.Resource.Id, 0, 0, handle.AddrOfPinnedObject(), 8, 0, 0, Dll.CopyFlags.None));
+                }
+                finally
+                {
+                    handle.Free();
+                }
+
+                // tightly packed half floats (8 bytes per pixel): red = (1, 0, 0, 1), small.png has no alpha channel
+                var tight = Enumerable.Repeat((byte)0xCD, 3 * 3 * 8 + 1).ToArray();
+                handle = GCHandle.Alloc(tight, GCHandleType.Pinned);
+                try
+                {
+                    image.CopyTo(LayerMipmapSlice.Mip0, handle.AddrOfPinnedObject(), 0, 0, GliFormat.RGBA16_SFLOAT);
+                    Assert.AreEqual(0x3C00, BitConverter.ToUInt16(tight, 0));
+                    Assert.AreEqual(0, BitConverter.ToUInt16(tight, 2));
+                    Assert.AreEqual(0, BitConverter.ToUInt16(tight, 4));
+                    Assert.AreEqual(0x3C00, BitConverter.ToUInt16(tight, 6));
+                    // nothing is written past the last pixel
+                    Assert.AreEqual(0xCD, tight[3 * 3 * 8]);
+                }
+                finally
+                {
+                    handle.Free();
+                }
+            }
+        }
+
+        private static byte[] GetBytes(DllImageData image)
+        {
+            var mip = image.GetMipmap(LayerMipmapSlice.Mip0);
+            var res = new byte[mip.ByteSize];
+            Marshal.Copy(mip.Bytes, res, 0, res.Length);
+            return res;
+        }
+
+        [TestMethod]
+        public void NativeWatchReload()
+        {
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "watched.png";
+            File.Copy(TestData.Directory + "checkers_left.png", filename, true);
+
+            using (var image = IO.LoadImage(filename))
+            using (var watch = new ImageWatch(image))
+            {
+                // unchanged file
+                Assert.AreEqual(0, watch.Reload().Count);
+
+                // same layout, different pixels
+                File.Copy(TestData.Directory + "checkers_right.png", filename, true);
+                var dirty = watch.Reload();
+                Assert.AreEqual(1, dirty.Count);
+                Assert.AreEqual(LayerMipmapSlice.Mip0, dirty[0]);
+                using (var expected = IO.LoadImage(TestData.Directory + "checkers_right.png"))
+                {
+                    CollectionAssert.AreEqual(GetBytes(expected), GetBytes(image));
+                }
+
+                // different size => the image is not modified
+                File.Copy(TestData.Directory + "small.png", filename, true);
+                Assert.IsFalse(Dll.image_reload(watch.Id, new uint[1], out _));
+                Assert.AreEqual(4, image.Size.Width);
+            }
+        }
+
+        [TestMethod]
+        public void NativeWatchReloadWebp()
+        {
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "watched_animation";
+            const int numLayers = 6;
+            const int changedLayer = 2;
+
+            // opaque frames that only differ in a moving square => the frames after the first one are sub frames
+            List<byte[]> CreateFrames(byte squareColor)
+            {
+                var frames = new List<byte[]>();
+                for (int layer = 0; layer < numLayers; ++layer)
+                {
+                    var bytes = new byte[16 * 8 * 4];
+                    for (int i = 0; i < bytes.Length; ++i)
+                    {
+                        int x = (i / 4) % 16;
+                        int y = i / (4 * 16);
+                        bool square = x >= layer * 2 && x < layer * 2 + 4 && y >= 2 && y < 6;
+                        bytes[i] = i % 4 == 3 ? (byte)255 : square ? (byte)(layer == changedLayer ? squareColor : 200) : (byte)(x * 8 + y);
+                    }
+                    frames.Add(bytes);
+                }
+                return frames;
+            }
+
+            void Save(List<byte[]> frames)
+            {
+                using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA8_SRGB), new Size3(16, 8), new LayerMipmapCount(numLayers, 1)))
+                {
+                    foreach (var lm in image.LayerMipmap.Range)
+                        Marshal.Copy(frames[lm.Layer], 0, image.GetMipmap(lm).Bytes, frames[lm.Layer].Length);
+                    IO.SaveImage(image, filename, "webp", GliFormat.RGBA8_SRGB, 100, 10.0f);
+                }
+            }
+
+            Save(CreateFrames(200));
+            var expected = CreateFrames(50);
+
+            using (var image = IO.LoadImage(filename + ".webp"))
+            using (var watch = new ImageWatch(image))
+            {
+                // the reload writes the new pixels of the changed layer into the lazily decoded image
+                Save(expected);
+                var dirty = watch.Reload();
+                Assert.AreEqual(1, dirty.Count);
+                Assert.AreEqual(new LayerMipmapSlice(changedLayer, 0), dirty[0]);
+
+                // released layers are decoded again from the old file. The changed layer must stay and must not be replayed from
+                foreach (var lm in image.LayerMipmap.Range)
+                    image.ReleaseMipmap(lm);
+                foreach (var layer in new[] { 3, changedLayer, 5, 0 })
+                {
+                    var mip = image.GetMipmap(new LayerMipmapSlice(layer, 0));
+                    var bytes = new byte[mip.ByteSize];
+                    Marshal.Copy(mip.Bytes, bytes, 0, bytes.Length);
+                    CollectionAssert.AreEqual(expected[layer], bytes, $"layer {layer}");
+                }
+            }
+        }
+
+        [TestMethod]
+        public void NativeWebpAnimation()
+        {
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "animation";
+            const int numLayers = 20;
+            var expected = new List<byte[]>();
+            using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA8_SRGB), new Size3(8, 4), new LayerMipmapCount(numLayers, 1)))
+            {
+                foreach (var lm in image.LayerMipmap.Range)
+                {
+                    var mip = image.GetMipmap(lm);
+                    var bytes = new byte[mip.ByteSize];
+                    // opaque pixels, only the first rows change between frames
+                    for (int i = 0; i < bytes.Length; ++i)
+                        bytes[i] = i % 4 == 3 ? (byte)255 : (byte)(i < 32 ? lm.Layer * 10 + i : i);
+                    Marshal.Copy(bytes, 0, mip.Bytes, bytes.Length);
+                    expected.Add(bytes);
+                }
+                IO.SaveImage(image, filename, "webp", GliFormat.RGBA8_SRGB, 100, 10.0f);
+            }
+
+            using (var image = IO.LoadImage(filename + ".webp"))
+            {
+                Assert.AreEqual(numLayers, image.LayerMipmap.Layers);
+                // frames are decoded on demand => request them out of order
+                foreach (var layer in new[] { 17, 3, 18, 0, 19, 9, 4 })
+                {
+                    var mip = image.GetMipmap(new LayerMipmapSlice(layer, 0));
+                    var bytes = new byte[mip.ByteSize];
+                    Marshal.Copy(mip.Bytes, bytes, 0, bytes.Length);
+                    CollectionAssert.AreEqual(expected[layer], bytes);
+                }
+
+                // released layers are decoded again
+                foreach (var lm in image.LayerMipmap.Range)
+                    image.ReleaseMipmap(lm);
+                foreach (var layer in new[] { 5, 19, 0, 6 })
+                {
+                    var mip = image.GetMipmap(new LayerMipmapSlice(layer, 0));
+                    var bytes = new byte[mip.ByteSize];
+                    Marshal.Copy(mip.Bytes, bytes, 0, bytes.Length);
+                    CollectionAssert.AreEqual(expected[layer], bytes);
+                }
+            }
+        }
+
+        [TestMethod]
+        public void NativeWebpBlend()
+        {
+            // semi transparent lossless and lossy sub frames with alpha blending, one disposed and one frame without blending
+            var filename = TestData.Directory + "blend.webp";
+            var expected = new List<byte[]>();
+            IO.SetGlobalParameter("webp anim decoder", 1);
+            try
+            {
+                using (var image = IO.LoadImage(filename))
+                {
+                    foreach (var lm in image.LayerMipmap.Range)
+                    {
+                        var mip = image.GetMipmap(lm);
+                        var bytes = new byte[mip.ByteSize];
+                        Marshal.Copy(mip.Bytes, bytes, 0, bytes.Length);
+                        expected.Add(bytes);
+                    }
+                }
+            }
+            finally
+            {
+                IO.SetGlobalParameter("webp anim decoder", 0);
+            }
+
+            using (var image = IO.LoadImage(filename))
+            {
+                Assert.AreEqual(7, image.LayerMipmap.Layers);
+                foreach (var layer in new[] { 6, 2, 3, 0, 5, 1, 4 })
+                {
+                    var mip = image.GetMipmap(new LayerMipmapSlice(layer, 0));
+                    var bytes = new byte[mip.ByteSize];
+                    Marshal.Copy(mip.Bytes, bytes, 0, bytes.Length);
+                    CollectionAssert.AreEqual(expected[layer], bytes, $"layer {layer}");
+                }
+            }
+        }
+
+        [TestMethod]
+        public void NativeHdrScanlines()
+        {
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "scanlines";
+            const int width = 300;
+            const int height = 70;
+            // multiples of 0.25 below 16 are exact in rgbe. Runs of 8 pixels are run length encoded
+            var expected = new float[width * height * 4];
+            for (int i = 0; i < width * height; ++i)
+            {
+                int x = i % width;
+                int y = i / width;
+                for (int c = 0; c < 3; ++c)
+                    expected[i * 4 + c] = ((x / 8 + y * 3 + c * 5) % 64) * 0.25f;
+                expected[i * 4 + 3] = 1.0f;
+            }
+
+            using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA32_SFLOAT), new Size3(width, height), LayerMipmapCount.One))
+            {
+                var mip = image.GetMipmap(LayerMipmapSlice.Mip0);
+                Marshal.Copy(expected, 0, mip.Bytes, expected.Length);
+                IO.SaveImage(image, filename, "hdr", GliFormat.RGB8E8_UFLOAT);
+            }
+
+            using (var image = IO.LoadImage(filename + ".hdr"))
+            {
+                Assert.AreEqual(width, image.Size.Width);
+                Assert.AreEqual(height, image.Size.Height);
+                var mip = image.GetMipmap(LayerMipmapSlice.Mip0);
+                var actual = new float[expected.Length];
+                Marshal.Copy(mip.Bytes, actual, 0, actual.Length);
+                CollectionAssert.AreEqual(expected, actual);
+            }
+        }
+
+        [TestMethod]
+        public void NativePngStripes()
+        {
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "stripes";
+            const int width = 37;
+            const int height = 3001;
+            var rnd = new Random(3);
+            // smooth gradients (filtered well) and noise
+            var bytes = new byte[width * height * 4];
+            for (int i = 0; i < bytes.Length; ++i)
+                bytes[i] = i % 8 < 4 ? (byte)(i / (width * 4) + i % 4) : (byte)rnd.Next(256);
+            var floats = new float[width * height * 4];
+            for (int i = 0; i < floats.Length; ++i)
+                floats[i] = rnd.Next(65536) / 65535.0f;
+
+            // 7 rows per stripe: the stripes do not line up with the 32 KB dictionary of the previous stripe
+            IO.SetGlobalParameter("png stripe rows", 7);
+            try
+            {
+                // default, fast and small
+                foreach (var preset in new[] { 0, 1, 2 })
+                {
+                    IO.SetGlobalParameter("png preset", preset);
+                    using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA8_SRGB), new Size3(width, height), LayerMipmapCount.One))
+                    {
+                        Marshal.Copy(bytes, 0, image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, bytes.Length);
+                        IO.SaveImage(image, filename, "png", GliFormat.RGBA8_SRGB);
+                    }
+                    using (var image = IO.LoadImage(filename + ".png"))
+                    {
+                        Assert.AreEqual(height, image.Size.Height);
+                        CollectionAssert.AreEqual(bytes, GetBytes(image));
+                    }
+
+                    using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA32_SFLOAT), new Size3(width, height), LayerMipmapCount.One))
+                    {
+                        Marshal.Copy(floats, 0, image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, floats.Length);
+                        IO.SaveImage(image, filename + "16", "png", GliFormat.RGBA16_UNORM);
+                    }
+                    using (var image = IO.LoadImage(filename + "16.png"))
+                    {
+                        var actual = new float[floats.Length];
+                        Marshal.Copy(image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, actual, 0, actual.Length);
+                        for (int i = 0; i < floats.Length; ++i)
+                            Assert.AreEqual(floats[i], actual[i], 1e-6f);
+                    }
+                }
+            }
+            finally
+            {
+                IO.SetGlobalParameter("png stripe rows", 0);
+                IO.SetGlobalParameter("png preset", 0);
+            }
+        }
+
+        [TestMethod]
+        public void NativeJpegParallel()
+        {
+            // restart*: odd sizes with restart intervals that do not end at MCU rows (5, 7 and 11 MCUs). subsampling*: no restart markers
+            var files = new[] { "restart420", "restart422", "restart444", "subsampling420", "subsampling422", "subsampling444" };
+            // the images are too small for the parallel decoder => reference from a single tj3Decompress8 call
+            var expected = files.Select(file =>
+            {
+                using (var image = IO.LoadImage(TestData.Directory + file + ".jpg"))
+                    return GetBytes(image);
+            }).ToList();
+
+            IO.SetGlobalParameter("jpg parallel pixels", 1);
+            try
+            {
+                for (int i = 0; i < files.Length; ++i)
+                {
+                    using (var image = IO.LoadImage(TestData.Directory + files[i] + ".jpg"))
+                        CollectionAssert.AreEqual(expected[i], GetBytes(image), files[i]);
+                }
+            }
+            finally
+            {
+                IO.SetGlobalParameter("jpg parallel pixels", 0);
+            }
+        }
+
+        [TestMethod]
+        public void NativeJpegScanPreviews()
+        {
+            // progressive and larger than the dct scaled preview (512)
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            var filename = KtxSamples.ExportDir + "scans";
+            const int width = 600;
+            const int height = 520;
+            var bytes = new byte[width * height * 4];
+            for (int i = 0; i < bytes.Length; ++i)
+                bytes[i] = i % 4 == 3 ? (byte)255 : (byte)((i / 4 % width) * 3 + (i / 4 / width) * 5 + i % 4 * 40);
+
+            IO.SetGlobalParameter("jpg progressive", 1);
+            try
+            {
+                using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA8_SRGB), new Size3(width, height), LayerMipmapCount.One))
+                {
+                    Marshal.Copy(bytes, 0, image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, bytes.Length);
+                    IO.SaveImage(image, filename, "jpg", GliFormat.RGB8_SRGB, 90);
+                }
+            }
+            finally
+            {
+                IO.SetGlobalParameter("jpg progressive", 0);
+            }
+
+            byte[] expected;
+            using (var image = IO.LoadImage(filename + ".jpg"))
+                expected = GetBytes(image);
+
+            // the first complete dc scan is always reported. The final pass matches the turbojpeg decode
+            var previews = new List<ImagePreview>();
+            using (var image = IO.LoadImage(filename + ".jpg", new ImageLoadOptions(), previews.Add))
+                CollectionAssert.AreEqual(expected, GetBytes(image));
+            Assert.IsTrue(previews.Count >= 1);
+            Assert.IsTrue(previews.All(p => p.Stage == ImagePreview.Stages.Pass && p.Width == width && p.Height == height && p.NumRows == height));
+            Assert.AreEqual(0u, previews[0].Pass);
+            Assert.AreEqual(GliFormat.RGBA8_SRGB, previews[0].Format);
+        }
+
+        [TestMethod]
+        public void NativeConcurrentSave()
+        {
+            // frame exports save concurrently: every thread must get its own error message
+            TestData.CreateOutputDirectory(KtxSamples.ExportDir);
+            const int size = 64;
+            var bytes = new byte[size * size * 4];
+            for (int i = 0; i < bytes.Length; ++i)
+                bytes[i] = i % 4 == 3 ? (byte)255 : (byte)(i * 7 + i / 256);
+
+            // png and lossless webp
+            string Filename(int i) => KtxSamples.ExportDir + "concurrent" + i;
+            string Extension(int i) => i % 4 == 1 ? "png" : "webp";
+
+            Parallel.For(0, 16, i =>
+            {
+                if (i % 2 == 0)
+                {
+                    Assert.IsFalse(Dll.image_save(-1, Filename(i), "png", (uint)GliFormat.RGBA8_SRGB, 100, 0.0f));
+                    Assert.AreEqual("invalid image id", Dll.GetError());
+                    return;
+                }
+
+                // saving modifies the image (webp swaps red and blue) => one image per save
+                using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA8_SRGB), new Size3(size, size), LayerMipmapCount.One))
+                {
+                    Marshal.Copy(bytes, 0, image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, bytes.Length);
+                    IO.SaveImage(image, Filename(i), Extension(i), GliFormat.RGBA8_SRGB, 100);
+                }
+            });
+
+            for (int i = 1; i < 16; i += 2)
+            {
+                using (var image = IO.LoadImage(Filename(i) + "." + Extension(i)))
+                    CollectionAssert.AreEqual(bytes, GetBytes(image));
+            }
+        }
+
+        [TestMethod]
+        public void NativePrefetch()
+        {
+            var files = new[] { "small.png", "checkers_left.png", "checkers_right.png", "checkers_2x1.png" }
+                .Select(f => TestData.Directory + f).ToList();
+
+            IO.SetPrefetchFiles(files);
+            try
+            {
+                IO.SetPrefetchCursor(0, 2);
+                // checkers_left.png and checkers_right.png are decoded in the background (or waited for)
+                using (var left = IO.LoadImage(files[1]))
+                using (var right = IO.LoadImage(files[2]))
+                {
+                    IO.SetPrefetchCursor(1, 2);
+                    using (var small = IO.LoadImage(files[0]))
+                    {
+                        VerifySmallLdr(small, Color.Channel.Rgb);
+                    }
+
+                    // the prefetched image was handed out => the second open decodes again
+                    using (var right2 = IO.LoadImage(files[2]))
+                    {
+                        CollectionAssert.AreEqual(GetBytes(right2), GetBytes(right));
+                    }
+
+                    Assert.AreEqual(4, left.Size.Width);
+                }
+            }
+            finally
+            {
+                IO.SetPrefetchFiles(new List<string>());
+            }
+        }
+
+        [TestMethod]
+        public void NativePrefetchProgressive()
+        {
+            // cubemap.dds reports a mipmap preview when it is decoded (see NativeOpenProgressive)
+            var files = new[] { "small.png", "cubemap.dds" }.Select(f => TestData.Directory + f).ToList();
+
+            IO.SetPrefetchFiles(files);
+            try
+            {
+                IO.SetPrefetchCursor(0, 1);
+                // give an idle worker time to start the decode (take() waits for running decodes only)
+                Thread.Sleep(200);
+                // the prefetched image is complete => no previews
+                var previews = new List<ImagePreview>();
+                using (var image = IO.LoadImage(files[1], new ImageLoadOptions(), previews.Add))
+                    Assert.AreEqual(6, image.LayerMipmap.Layers);
+                Assert.AreEqual(0, previews.Count);
+            }
+            finally
+            {
+                IO.SetPrefetchFiles(new List<string>());
+            }
+        }
+
+        [TestMethod]
+        public void NativeCombine()
+        {
+            using (var image = IO.LoadImage(TestData.Directory + "checkers.dds"))
+            {
+                var ids = new[] { image.Resource.Id };
+
+                // inverted checkers
+                var id = Dll.image_combine("1 - I0", "I0", ids, ids.Length);
+                Assert.AreNotEqual(0, id, Dll.GetError());
+                Assert.IsTrue(Dll.image_compute_statistics(id, -1, 0, out var stats), Dll.GetError());
+                var luminance = (int)DefaultStatistics.Types.Luminance;
+                Assert.AreEqual(0.0f, stats.Min[luminance]);
+                Assert.AreEqual(1.0f, stats.Max[luminance], 0.01f);
+                Assert.AreEqual(0.5f, stats.Avg[luminance], 0.01f);
+                Dll.image_release(id);
+
+                // constant color
+                id = Dll.image_combine("rgb(1, 0, 0)", "1", ids, ids.Length);
+                Assert.AreNotEqual(0, id, Dll.GetError());
+                Assert.IsTrue(Dll.image_compute_statistics(id, -1, 0, out stats), Dll.GetError());
+                Assert.AreEqual(0.2125f, stats.Avg[luminance], 0.0001f);
+                Dll.image_release(id);
+
+                // intrinsics are case insensitive like the other identifiers
+                id = Dll.image_combine("I0 * 0 + x(Size) / X(SIZE)", "1", ids, ids.Length);
+                Assert.AreNotEqual(0, id, Dll.GetError());
+                Assert.IsTrue(Dll.image_compute_statistics(id, -1, 0, out stats), Dll.GetError());
+                Assert.AreEqual(1.0f, stats.Avg[luminance], 0.01f);
+                Dll.image_release(id);
+
+                // I1 is not available
+                Assert.AreEqual(0, Dll.image_combine("I0 + I1", "I0", ids, ids.Length));
+            }
+        }
+
+        [TestMethod]
+        public void NativePercentiles()
+        {
+            using (var image = IO.LoadImage(TestData.Directory + "checkers.dds"))
+            {
+                var id = image.Resource.Id;
+                var percentiles = new[] { 0.0f, 100.0f };
+                var results = new float[percentiles.Length];
+                Assert.IsTrue(Dll.image_compute_percentiles(id, -1, 0, Dll.ImageChannel.Luminance, percentiles, percentiles.Length, results), Dll.GetError());
+                Assert.AreEqual(0.0f, results[0]);
+                Assert.AreEqual(1.0f, results[1], 0.01f);
+
+                Assert.IsTrue(Dll.image_compute_percentiles(id, -1, 0, Dll.ImageChannel.Alpha, percentiles, percentiles.Length, results), Dll.GetError());
+                Assert.AreEqual(1.0f, results[0]);
+                Assert.AreEqual(1.0f, results[1]);
+
+                // half black, half white
+                var bins = new ulong[2];
+                Assert.IsTrue(Dll.image_compute_histogram(id, -1, 0, Dll.ImageChannel.Red, 0.0f, 1.0f, false, bins.Length, bins), Dll.GetError());
+                var numPixels = (ulong)(image.Size.Width * image.Size.Height * image.LayerMipmap.Layers);
+                Assert.AreEqual(numPixels, bins[0] + bins[1]);
+                Assert.AreEqual(bins[0], bins[1]);
+
+                Assert.IsFalse(Dll.image_compute_histogram(id, -1, 0, Dll.ImageChannel.Red, 0.0f, 1.0f, true, bins.Length, bins));
+            }
+        }
+
+        [TestMethod]
+        public void NativePercentilesWide()
+        {
+            // values over many orders of magnitude => every percentile lands in a different coarse bin
+            const int size = 64;
+            var pixels = new float[size * size * 4];
+            var values = new float[size * size];
+            var rnd = new Random(7);
+            for (int i = 0; i < values.Length; ++i)
+            {
+                values[i] = (float)(Math.Exp(rnd.NextDouble() * 60.0 - 30.0) * (rnd.Next(2) == 0 ? 1.0 : -1.0));
+                pixels[i * 4] = values[i];
+                pixels[i * 4 + 3] = 1.0f;
+            }
+            Array.Sort(values);
+
+            using (var image = IO.CreateImage(new ImageFormat(GliFormat.RGBA32_SFLOAT), new Size3(size, size), LayerMipmapCount.One))
+            {
+                Marshal.Copy(pixels, 0, image.GetMipmap(LayerMipmapSlice.Mip0).Bytes, pixels.Length);
+
+                var percentiles = Enumerable.Range(0, 101).Select(i => (float)i).ToArray();
+                var results = new float[percentiles.Length];
+                Assert.IsTrue(Dll.image_compute_percentiles(image.Resource.Id, 0, 0, Dll.ImageChannel.Red, percentiles, percentiles.Length, results), Dll.GetError());
+                for (int i = 0; i < percentiles.Length; ++i)
+                {
+                    var pos = percentiles[i] / 100.0 * (values.Length - 1);
+                    var lower = (int)pos;
+                    var upper = Math.Min(lower + 1, values.Length - 1);
+                    var expected = values[lower] + (pos - lower) * (values[upper] - values[lower]);
+                    Assert.AreEqual(expected, results[i], Math.Abs(expected) * 1e-5 + 1e-30);
+                }
+            }
+        }
+
+        [TestMethod]
+        public void NativeThumbnail()
+        {
+            // same expectations as ThumbnailTest.MinifyCheckers (gpu thumbnail)
+            var rgba = new byte[2 * 2 * 4];
+            Assert.IsTrue(Dll.image_thumbnail(TestData.Directory + "checkers.dds", 2, rgba, out var width, out var height), Dll.GetError());
+            Assert.AreEqual(2, width);
+            Assert.AreEqual(2, height);
+
+            var black = new byte[] { 0, 0, 0, 255 };
+            var white = new byte[] { 255, 255, 255, 255 };
+            CollectionAssert.AreEqual(black, rgba.Skip(0).Take(4).ToArray());
+            CollectionAssert.AreEqual(white, rgba.Skip(4).Take(4).ToArray());
+            CollectionAssert.AreEqual(white, rgba.Skip(8).Take(4).ToArray());
+            CollectionAssert.AreEqual(black, rgba.Skip(12).Take(4).ToArray());
+
+            Assert.IsFalse(Dll.image_thumbnail(TestData.Directory + "does_not_exist.dds", 2, rgba, out _, out _));
+        }
     }
 }
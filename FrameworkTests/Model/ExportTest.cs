@@ -215,6 +215,20 @@ namespace FrameworkTests.Model
             TryExportAllFormatsAndCompareGray("jpg", true);
         }
 
+        [TestMethod]
+        public void GrayTestAllJpgProgressive()
+        {
+            IO.SetGlobalParameter("jpg progressive", 1);
+            try
+            {
+                TryExportAllFormatsAndCompareGray("jpg", true);
+            }
+            finally
+            {
+                IO.SetGlobalParameter("jpg progressive", 0);
+            }
+        }
+
         [TestMethod]
         public void GrayTestAllNpy()
         {
@@ -251,12 +265,54 @@ namespace FrameworkTests.Model
             TryExportAllFormatsAndCompareColor("png");
         }
 
+        [TestMethod]
+        public void ColorTestAllPngFast()
+        {
+            IO.SetGlobalParameter("png preset", 1);
+            try
+            {
+                TryExportAllFormatsAndCompareColor("png");
+            }
+            finally
+            {
+                IO.SetGlobalParameter("png preset", 0);
+            }
+        }
+
+        [TestMethod]
+        public void ColorTestAllPngSmall()
+        {
+            IO.SetGlobalParameter("png preset", 2);
+            try
+            {
+                TryExportAllFormatsAndCompareColor("png");
+            }
+            finally
+            {
+                IO.SetGlobalParameter("png preset", 0);
+            }
+        }
+
         [TestMethod]
         public void ColorTestAllWebp()
         {
             TryExportAllFormatsAndCompareColor("webp");
         }
 
+        [TestMethod]
+        public void ColorTestAllWebpSmall()
+        {
+            IO.SetGlobalParameter("webp preset", 2);
+            try
+            {
+                TryExportAllFormatsAndCompareColor("webp");
+            }
+            finally
+            {
+                IO.SetGlobalParameter("webp preset", 0);
+            }
+        }
+
         [TestMethod]
         public void ColorTestAllNpy()
         {
@@ -335,6 +391,40 @@ namespace FrameworkTests.Model
             TryExportAllFormatsAndCompareColor("hdr");
         }
 
+        [TestMethod]
+        public void ExportAllExr()
+        {
+            TryExportAllFormats(TestData.Directory + "small.pfm", ExportDir + "tmp", "exr");
+        }
+
+        [TestMethod]
+        public void GrayTestAllExr()
+        {
+            TryExportAllFormatsAndCompareGray("exr");
+        }
+
+        [TestMethod]
+        public void ColorTestAllExr()
+        {
+            TryExportAllFormatsAndCompareColor("exr");
+        }
+
+        [TestMethod]
+        public void ColorTestAllExrPizTiled()
+        {
+            IO.SetGlobalParameter("exr compression", 1);
+            IO.SetGlobalParameter("exr tile size", 32);
+            try
+            {
+                TryExportAllFormatsAndCompareColor("exr");
+            }
+            finally
+            {
+                IO.SetGlobalParameter("exr compression", 0);
+                IO.SetGlobalParameter("exr tile size", 0);
+            }
+        }
+
         [TestMethod]
         public void ExportDds()
         {
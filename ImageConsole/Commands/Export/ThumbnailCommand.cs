@@ -32,10 +32,7 @@ namespace ImageConsole.Commands.Export
                 Console.Out.WriteLine(width);
                 Console.Out.WriteLine(heigth);
 
-                using (var stream = Console.OpenStandardOutput())
-                {
-                    stream.Write(bytes, 0, bytes.Length);
-                }
+                ImageConsole.Program.WriteBinary(bytes, tex.Format.ToString());
             }
         }
     }
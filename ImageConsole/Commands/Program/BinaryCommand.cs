@@ -0,0 +1,25 @@
+﻿using System.Collections.Generic;
+using ImageFramework.Model;
+
+namespace ImageConsole.Commands.Program
+{
+    class BinaryCommand : Command
+    {
+        private readonly ImageConsole.Program program;
+
+        public BinaryCommand(ImageConsole.Program program)
+            : base("-binary", "", "keeps the console open to retrieve length prefixed command batches via cin. " +
+                                  "Each batch is answered with a status, the length and the output of the commands")
+        {
+            this.program = program;
+        }
+
+        public override void Execute(List<string> arguments, Models model)
+        {
+            var reader = new ParameterReader(arguments);
+            reader.ExpectNoMoreArgs();
+
+            this.program.ReadBinary = true;
+        }
+    }
+}
@@ -0,0 +1,26 @@
+﻿using System.Collections.Generic;
+using ImageFramework.ImageLoader;
+using ImageFramework.Model;
+
+namespace ImageConsole.Commands.Program
+{
+    class DaemonCommand : Command
+    {
+        public DaemonCommand()
+            : base("-daemon", "\"socket\" [workers]", "runs a conversion daemon on the unix domain socket until a client sends \"shutdown\". " +
+                                                     "Clients send open, save, convert, release and formats requests (see DxImageLoader/daemon_interface.h). " +
+                                                     "workers = number of concurrent requests (0 = number of cores)")
+        {
+        }
+
+        public override void Execute(List<string> arguments, Models model)
+        {
+            var reader = new ParameterReader(arguments);
+            var socket = reader.ReadString("socket");
+            var workers = reader.ReadInt("workers", 0);
+            reader.ExpectNoMoreArgs();
+
+            IO.RunConversionDaemon(socket, workers);
+        }
+    }
+}
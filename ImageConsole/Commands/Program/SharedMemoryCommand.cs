@@ -0,0 +1,26 @@
+﻿using System.Collections.Generic;
+using ImageFramework.Model;
+
+namespace ImageConsole.Commands.Program
+{
+    class SharedMemoryCommand : Command
+    {
+        public SharedMemoryCommand()
+            : base("-sharedmemory", "\"name\" size", "opens the shared memory section with the given name and size (created by the client). " +
+                                                    "Binary results are written into the shared memory and only \"offset size format\" is printed")
+        {
+        }
+
+        public override void Execute(List<string> arguments, Models model)
+        {
+            var reader = new ParameterReader(arguments);
+            var name = reader.ReadString("name");
+            var size = reader.ReadInt("size");
+            reader.ExpectNoMoreArgs();
+
+            ImageConsole.Program.SharedMemory?.Dispose();
+            ImageConsole.Program.SharedMemory = null;
+            ImageConsole.Program.SharedMemory = new SharedMemoryChannel(name, size);
+        }
+    }
+}
@@ -3,6 +3,7 @@ using System.Collections.Generic;
 using System.ComponentModel;
 using System.Diagnostics;
 using System.Globalization;
+using System.IO;
 using System.Linq;
 using System.Text;
 using System.Threading.Tasks;
@@ -22,6 +23,7 @@ namespace ImageConsole
     {
         private readonly Dictionary<string, Command> commands = new Dictionary<string, Command>();
         public bool ReadCin { get; set; } = false;
+        public bool ReadBinary { get; set; } = false;
         public bool Close { get; set; } = false;
 
         public bool ShowProgress { get; set; } = true;
@@ -41,6 +43,9 @@ namespace ImageConsole
             AddCommand(new TellSizeCommand());
 
             AddCommand(new CinCommand(this));
+            AddCommand(new BinaryCommand(this));
+            AddCommand(new SharedMemoryCommand());
+            AddCommand(new DaemonCommand());
             AddCommand(new CloseCommand(this));
             AddCommand(new SilentCommand(this));
 
@@ -94,12 +99,19 @@ namespace ImageConsole
                     Console.Error.WriteLine("Use -help to view all commands");
                 }
 
+                if (ReadBinary)
+                {
+                    RunBinary(model);
+                    return;
+                }
+
                 // handle cin input
                 while (ReadCin && !Close)
                 {
                     try
                     {
                         var line = Console.ReadLine();
+                        SharedMemory?.BeginRequest();
                         var moreArgs = SplitToArgs(line);
                         InterpretArgs(moreArgs, model);
                     }
@@ -111,6 +123,101 @@ namespace ImageConsole
             }
         }
 
+        /// <summary>
+        /// shared memory for binary command output (set with -sharedmemory)
+        /// </summary>
+        public static SharedMemoryChannel SharedMemory { get; set; } = null;
+
+        /// <summary>
+        /// writes binary command output (e.g. thumbnail pixels).
+        /// With shared memory, the data is written into the shared memory and the line "offset size format" is printed
+        /// (offset = -1 => the data did not fit and follows the line).
+        /// Without shared memory, the data is written to stdout (part of the result frame in binary mode)
+        /// </summary>
+        public static void WriteBinary(byte[] bytes, string format)
+        {
+            if (SharedMemory != null)
+            {
+                var offset = SharedMemory.Write(bytes);
+                Console.Out.WriteLine($"{offset} {bytes.Length} {format}");
+                if (offset >= 0) return;
+            }
+
+            Console.Out.Flush();
+            var stream = binaryResults ?? Console.OpenStandardOutput();
+            stream.Write(bytes, 0, bytes.Length);
+            stream.Flush();
+        }
+
+        private static MemoryStream binaryResults = null;
+
+        /// <summary>
+        /// request: uint32 length, command lines (utf8).
+        /// response: uint32 status (0 = success, 1 = error), uint32 length, output of the commands or the error message (utf8)
+        /// </summary>
+        private void RunBinary(Models model)
+        {
+            var input = new BinaryReader(Console.OpenStandardInput());
+            var output = new BinaryWriter(Console.OpenStandardOutput());
+            var stdout = Console.Out;
+            // errors are reported in the response
+            Console.SetError(TextWriter.Null);
+
+            while (!Close)
+            {
+                byte[] request;
+                try
+                {
+                    var length = input.ReadInt32();
+                    request = input.ReadBytes(length);
+                    if (request.Length != length) break;
+                }
+                catch (EndOfStreamException)
+                {
+                    break;
+                }
+
+                var results = new MemoryStream();
+                binaryResults = results;
+                SharedMemory?.BeginRequest();
+                Console.SetOut(new StreamWriter(results, new UTF8Encoding(false)) { AutoFlush = true });
+                string error = null;
+                try
+                {
+                    foreach (var line in Encoding.UTF8.GetString(request).Split('\n'))
+                    {
+                        var args = SplitToArgs(line.TrimEnd('\r'));
+                        if (args.Length == 0) continue;
+                        InterpretArgs(args, model);
+                    }
+                }
+                catch (Exception e)
+                {
+                    error = e.Message;
+                }
+                finally
+                {
+                    Console.SetOut(stdout);
+                    binaryResults = null;
+                }
+
+                if (error == null)
+                {
+                    output.Write(0);
+                    output.Write((int)results.Length);
+                    output.Write(results.GetBuffer(), 0, (int)results.Length);
+                }
+                else
+                {
+                    var bytes = Encoding.UTF8.GetBytes(error);
+                    output.Write(1);
+                    output.Write(bytes.Length);
+                    output.Write(bytes);
+                }
+                output.Flush();
+            }
+        }
+
         private void ProgressOnPropertyChanged(object sender, PropertyChangedEventArgs e)
         {
             if (!ShowProgress) return;
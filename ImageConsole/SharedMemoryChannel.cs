@@ -0,0 +1,59 @@
+﻿using System;
+using System.IO.MemoryMappedFiles;
+
+namespace ImageConsole
+{
+    /// <summary>
+    /// ring buffer in a shared memory section that was created by the client (see ConsoleTest/SharedMemory.h).
+    /// Binary results are written into the ring buffer and only a descriptor (offset, size, format) is sent through the pipe
+    /// </summary>
+    public class SharedMemoryChannel : IDisposable
+    {
+        private readonly MemoryMappedFile file;
+        private readonly MemoryMappedViewAccessor view;
+        private readonly long capacity;
+        private long writePos = 0;
+        // bytes that were used since BeginRequest(). Results of one request must not overwrite each other
+        private long used = 0;
+
+        public SharedMemoryChannel(string name, long capacity)
+        {
+            if (capacity <= 0) throw new Exception("shared memory size must be positive");
+            this.capacity = capacity;
+            file = MemoryMappedFile.OpenExisting(name, MemoryMappedFileRights.ReadWrite);
+            view = file.CreateViewAccessor(0, capacity, MemoryMappedFileAccess.ReadWrite);
+        }
+
+        /// <summary>
+        /// the client has read all results of the previous request
+        /// </summary>
+        public void BeginRequest()
+        {
+            used = 0;
+        }
+
+        /// <summary>
+        /// copies the data into the ring buffer
+        /// </summary>
+        /// <returns>offset of the data or -1 if there is not enough space left for this request</returns>
+        public long Write(byte[] data)
+        {
+            var offset = writePos;
+            // data is not split at the end of the ring
+            if (offset + data.Length > capacity) offset = 0;
+            var required = data.Length + (offset == writePos ? 0 : capacity - writePos);
+            if (used + required > capacity) return -1;
+
+            view.WriteArray(offset, data, 0, data.Length);
+            used += required;
+            writePos = offset + data.Length;
+            return offset;
+        }
+
+        public void Dispose()
+        {
+            view?.Dispose();
+            file?.Dispose();
+        }
+    }
+}
@@ -37,5 +37,8 @@ namespace ImageFramework.DirectX
         public float Fps { get; }
 
         public abstract MipInfo GetMipmap(LayerMipmapSlice lm);
+
+        // the bytes of GetMipmap are no longer used (e.g. after they were uploaded). GetMipmap may return a new pointer afterwards
+        public virtual void ReleaseMipmap(LayerMipmapSlice lm) {}
     }
 }
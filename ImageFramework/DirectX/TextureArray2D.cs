@@ -48,6 +48,10 @@ namespace ImageFramework.DirectX
 
             handle = new Texture2D(Device.Get().Handle, CreateTextureDescription(false, true), data);
 
+            // the texture has its own copy
+            foreach (var lm in LayerMipmap.Range)
+                image.ReleaseMipmap(lm);
+
             CreateTextureViews(false, true);
         }
 
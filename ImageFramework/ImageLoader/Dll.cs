@@ -14,6 +14,25 @@ namespace ImageFramework.ImageLoader
         [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
         public static extern int image_open(string filename);
 
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int image_open_with_options(string filename, ref ImageLoadOptions options);
+
+        [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+        public delegate uint PreviewDelegate(ref ImagePreview preview);
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int image_open_progressive(string filename, ref ImageLoadOptions options, [MarshalAs(UnmanagedType.FunctionPtr)] PreviewDelegate callback);
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool image_thumbnail(string filename, int maxSize, [Out] byte[] rgba, out int width, out int height);
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void image_prefetch_set_files(string[] filenames, int count);
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void image_prefetch_set_cursor(int cursor, int radius, ulong memoryBudget);
+
         [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
         public static extern int image_allocate(uint format, int width, int height, int depth, int layer, int mipmap);
 
@@ -30,6 +49,35 @@ namespace ImageFramework.ImageLoader
         [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
         public static extern IntPtr image_get_mipmap(int id, int layer, int mipmap, out ulong size);
 
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void image_release_mipmap(int id, int layer, int mipmap);
+
+        // see ImageCopyFlags in interface.h
+        [Flags]
+        public enum CopyFlags : uint
+        {
+            None = 0,
+            FlipY = 1
+        }
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool image_copy_to(int id, int layer, int mipmap, IntPtr dst, ulong dstRowPitch, ulong dstSlicePitch, uint dstFormat, CopyFlags flags);
+
+        [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+        public delegate void WatchDelegate(int watchId);
+
+        // options = IntPtr.Zero uses the global parameters (same as image_open)
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int image_watch(int id, string filename, IntPtr options, [MarshalAs(UnmanagedType.FunctionPtr)] WatchDelegate callback);
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void image_unwatch(int watchId);
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool image_reload(int watchId, [Out] uint[] dirty, out int numDirty);
+
         [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
         public static extern float image_get_fps(int id);
 
@@ -40,6 +88,68 @@ namespace ImageFramework.ImageLoader
         [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
         public static extern IntPtr get_export_formats(string extension, out int nFormats);
 
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool daemon_run(string socketPath, int numWorkers);
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct ImageStatistics
+        {
+            // indexed with DefaultStatistics.Types, index 5 is grayscale
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = 6)]
+            public float[] Min;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = 6)]
+            public float[] Max;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = 6)]
+            public float[] Avg;
+        }
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool image_compute_statistics(int id, int layer, int mipmap, out ImageStatistics stats);
+
+        // see ImageCompareMetric and ImageCompareFlags in interface.h
+        public enum CompareMetric : uint
+        {
+            Mse = 0,
+            Psnr = 1,
+            Ssim = 2,
+            MultiscaleSsim = 3
+        }
+
+        [Flags]
+        public enum CompareFlags : uint
+        {
+            None = 0,
+            ExcludeBorders = 1,
+            ErrorMap = 2
+        }
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool image_compare(int id1, int id2, int layer, int mipmap, CompareMetric metric, CompareFlags flags, out float result, out int errorMapId);
+
+        // see ImageChannel in interface.h
+        public enum ImageChannel : uint
+        {
+            Red = 0,
+            Green = 1,
+            Blue = 2,
+            Alpha = 3,
+            Luminance = 4
+        }
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool image_compute_histogram(int id, int layer, int mipmap, ImageChannel channel, float minValue, float maxValue, [MarshalAs(UnmanagedType.I1)] bool logarithmic, int numBins, [Out] ulong[] bins);
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool image_compute_percentiles(int id, int layer, int mipmap, ImageChannel channel, float[] percentiles, int numPercentiles, [Out] float[] results);
+
+        [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int image_combine(string colorFormula, string alphaFormula, int[] imageIds, int numImages);
+
         [DllImport(DllFilePath, CallingConvention = CallingConvention.Cdecl)]
         public static extern IntPtr get_error(out int length);
 
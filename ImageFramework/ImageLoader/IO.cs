@@ -39,7 +39,25 @@ namespace ImageFramework.ImageLoader
         /// <returns></returns>
         public static DllImageData LoadImage(string file)
         {
-            var res = new Resource(file);
+            return LoadImage(file, new Resource(file));
+        }
+
+        /// <inheritdoc cref="LoadImage(string)"/>
+        /// <param name="options">load options that are used instead of the numpy global parameters</param>
+        public static DllImageData LoadImage(string file, ImageLoadOptions options)
+        {
+            return LoadImage(file, new Resource(file, options));
+        }
+
+        /// <inheritdoc cref="LoadImage(string, ImageLoadOptions)"/>
+        /// <param name="onPreview">receives intermediate results on the loading thread while the file is decoded (see ImagePreview.Stages)</param>
+        public static DllImageData LoadImage(string file, ImageLoadOptions options, Action<ImagePreview> onPreview)
+        {
+            return LoadImage(file, new Resource(file, options, onPreview));
+        }
+
+        private static DllImageData LoadImage(string file, Resource res)
+        {
             Dll.image_info(res.Id, out var gliFormat, out var originalFormat, out var nLayer, out var nMipmaps);
 
             return new DllImageData(res, file, new LayerMipmapCount(nLayer, nMipmaps), new ImageFormat((GliFormat)gliFormat), (GliFormat)originalFormat);
@@ -128,6 +146,37 @@ namespace ImageFramework.ImageLoader
                 throw new Exception(Dll.GetError());
         }
 
+        /// <summary>
+        /// registers the ordered files of a directory. The neighbours of the cursor (see SetPrefetchCursor)
+        /// are decoded in the background and LoadImage returns them without decoding them again.
+        /// An empty list releases all prefetched images and stops the background workers
+        /// </summary>
+        public static void SetPrefetchFiles(IReadOnlyList<string> files)
+        {
+            Dll.image_prefetch_set_files(files.ToArray(), files.Count);
+        }
+
+        /// <summary>
+        /// sets the index of the displayed file. The files [cursor - radius, cursor + radius] are prefetched
+        /// until memoryBudget bytes are in use
+        /// </summary>
+        public static void SetPrefetchCursor(int cursor, int radius = 2, ulong memoryBudget = 512ul * 1024 * 1024)
+        {
+            Dll.image_prefetch_set_cursor(cursor, radius, memoryBudget);
+        }
+
+        /// <summary>
+        /// runs the conversion daemon of DxImageLoader on the unix domain socket.
+        /// Blocks until a client sends "shutdown"
+        /// </summary>
+        /// <param name="socketPath">path of the socket file</param>
+        /// <param name="numWorkers">number of concurrently processed requests (0 = number of cores)</param>
+        public static void RunConversionDaemon(string socketPath, int numWorkers = 0)
+        {
+            if (!Dll.daemon_run(socketPath, numWorkers))
+                throw new Exception(Dll.GetError());
+        }
+
         public static List<GliFormat> GetExportFormats(string extension)
         {
             var ptr = Dll.get_export_formats(extension, out var nFormats);
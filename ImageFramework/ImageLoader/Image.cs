@@ -53,6 +53,26 @@ namespace ImageFramework.ImageLoader
             return res;
         }
 
+        /// <summary>
+        /// lazily decoded layers (webp animations) are freed and decoded again by the next GetMipmap call
+        /// </summary>
+        public override void ReleaseMipmap(LayerMipmapSlice lm)
+        {
+            Dll.image_release_mipmap(Resource.Id, lm.Layer, lm.Mipmap);
+        }
+
+        /// <summary>
+        /// copies the mipmap into dst (e.g. a mapped staging buffer) and converts it to the format.
+        /// Supported formats: Undefined (current format), RGBA32_SFLOAT, RGBA16_SFLOAT, RGBA8_UNORM, RGBA8_SRGB, BGRA8_UNORM, BGRA8_SRGB
+        /// </summary>
+        /// <param name="rowPitch">bytes between rows. 0 = tightly packed</param>
+        /// <param name="slicePitch">bytes between depth slices. 0 = height * rowPitch</param>
+        public void CopyTo(LayerMipmapSlice lm, IntPtr dst, ulong rowPitch, ulong slicePitch, GliFormat format, bool flipY = false)
+        {
+            if(!Dll.image_copy_to(Resource.Id, lm.Layer, lm.Mipmap, dst, rowPitch, slicePitch, (uint)format, flipY ? Dll.CopyFlags.FlipY : Dll.CopyFlags.None))
+                throw new Exception("error copying " + Filename + ": " + Dll.GetError());
+        }
+
         public void Dispose()
         {
             Resource.Dispose();
@@ -0,0 +1,38 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace ImageFramework.ImageLoader
+{
+    /// <summary>
+    /// options for IO.LoadImage that are applied once while loading (see ImageLoadOptions in interface.h).
+    /// The default value uses the default settings of all loaders
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ImageLoadOptions
+    {
+        public enum NpyLayouts : uint
+        {
+            Layers = 0, // 2D texture array
+            Volume = 1 // single 3D texture
+        }
+
+        public enum NpyChannelModes : uint
+        {
+            Auto = 0, // the last dimension is used for the channels if it is at most 4
+            None = 1 // all dimensions are spatial
+        }
+
+        public NpyLayouts NpyLayout;
+        public NpyChannelModes NpyChannels;
+        // first layer (first slice for volumes) that is loaded from numpy arrays
+        public uint FirstLayer;
+        // number of loaded layers starting with FirstLayer. 0 = all remaining layers
+        public uint NumLayers;
+        // the image is converted to this format after loading (must be one of IO.SupportedFormats). Undefined keeps the loader format
+        public GliFormat Format;
+    }
+}
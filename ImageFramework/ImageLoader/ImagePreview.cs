@@ -0,0 +1,38 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace ImageFramework.ImageLoader
+{
+    /// <summary>
+    /// intermediate result of IO.LoadImage with a preview callback (see ImagePreview in interface.h).
+    /// Data is only valid during the callback
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ImagePreview
+    {
+        public enum Stages : uint
+        {
+            Mipmap = 0, // smaller mipmap of the first layer (or dct scaled jpg)
+            Pass = 1, // full size with reduced detail (interlace pass or progressive jpg scans)
+            Rows = 2 // the rows [FirstRow, NumRows) are decoded
+        }
+
+        // pixels of the first layer with tightly packed rows
+        public IntPtr Data;
+        public uint Width;
+        public uint Height;
+        // one of IO.SupportedFormats or RGBA16_UNORM (passes of interlaced 16 bit png)
+        public GliFormat Format;
+        // rows [FirstRow, NumRows) contain valid pixels
+        public uint NumRows;
+        public Stages Stage;
+        // interlace pass (png) or preview index (jpg) for Stages.Pass
+        public uint Pass;
+        // 0 except for Stages.Rows of files that start with the bottom row (pfm)
+        public uint FirstRow;
+    }
+}
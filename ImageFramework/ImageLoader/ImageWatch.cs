@@ -0,0 +1,59 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using ImageFramework.Utility;
+
+namespace ImageFramework.ImageLoader
+{
+    /// <summary>
+    /// watches the file of a DllImageData and reloads only the layers and mipmaps that changed
+    /// </summary>
+    public class ImageWatch : IDisposable
+    {
+        private readonly DllImageData image;
+        // must stay alive while the dll is watching
+        private readonly Dll.WatchDelegate callback;
+
+        public int Id { get; private set; }
+
+        /// <summary>
+        /// raised on the watcher thread after the file was modified
+        /// </summary>
+        public event EventHandler Changed;
+
+        public ImageWatch(DllImageData image)
+        {
+            this.image = image;
+            callback = id => Changed?.Invoke(this, EventArgs.Empty);
+            Id = Dll.image_watch(image.Resource.Id, image.Filename, IntPtr.Zero, callback);
+            if (Id == 0)
+                throw new Exception("error watching " + image.Filename + ": " + Dll.GetError());
+        }
+
+        /// <summary>
+        /// reloads the file and updates the pixels of the image in place.
+        /// Throws if the format, number of layers, number of mipmaps or size changed (the file has to be opened again)
+        /// </summary>
+        /// <returns>layers and mipmaps that changed since the last reload</returns>
+        public List<LayerMipmapSlice> Reload()
+        {
+            var lm = image.LayerMipmap;
+            var dirty = new uint[lm.Layers * lm.Mipmaps];
+            if (!Dll.image_reload(Id, dirty, out var numDirty))
+                throw new Exception("error reloading " + image.Filename + ": " + Dll.GetError());
+
+            return dirty.Take(numDirty).Select(i => new LayerMipmapSlice((int)i / lm.Mipmaps, (int)i % lm.Mipmaps)).ToList();
+        }
+
+        public void Dispose()
+        {
+            if (Id != 0)
+            {
+                Dll.image_unwatch(Id);
+                Id = 0;
+            }
+        }
+    }
+}
@@ -18,6 +18,26 @@ namespace ImageFramework.ImageLoader
                 throw new Exception("error in " + file + ": " + Dll.GetError());
         }
 
+        public Resource(string file, ImageLoadOptions options)
+        {
+            Id = Dll.image_open_with_options(file, ref options);
+            if (Id == 0)
+                throw new Exception("error in " + file + ": " + Dll.GetError());
+        }
+
+        public Resource(string file, ImageLoadOptions options, Action<ImagePreview> onPreview)
+        {
+            Dll.PreviewDelegate callback = (ref ImagePreview preview) =>
+            {
+                onPreview(preview);
+                return 0;
+            };
+            Id = Dll.image_open_progressive(file, ref options, callback);
+            GC.KeepAlive(callback);
+            if (Id == 0)
+                throw new Exception("error in " + file + ": " + Dll.GetError());
+        }
+
         private Resource()
         {
             Id = 0;
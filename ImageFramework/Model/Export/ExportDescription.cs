@@ -279,6 +279,7 @@ namespace ImageFramework.Model.Export
                     formats.Add(new ExportFormatModel("bmp"));
                     formats.Add(new ExportFormatModel("hdr"));
                     formats.Add(new ExportFormatModel("pfm"));
+                    formats.Add(new ExportFormatModel("exr"));
                     formats.Add(new ExportFormatModel("dds"));
                     formats.Add(new ExportFormatModel("ktx"));
                     formats.Add(new ExportFormatModel("ktx2"));
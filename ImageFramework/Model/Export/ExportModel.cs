@@ -62,13 +62,28 @@ namespace ImageFramework.Model.Export
                 progress.What = "exporting frames";
                 int totalFrames = descriptions.Count;
                 int completedFrames = 0;
+                // the texture conversion runs on this thread, the encoding of the files runs concurrently
+                int maxPending = Math.Max(Environment.ProcessorCount, 1);
+                var pending = new Queue<Task>();
 
                 foreach (var desc in descriptions)
                 {
+                    if (pending.Count >= maxPending)
+                    {
+                        await pending.Dequeue();
+                        completedFrames++;
+                        progress.Progress = (float)completedFrames / (float)totalFrames;
+                    }
+                    progress.Token.ThrowIfCancellationRequested();
+
                     var task = ExportAsync(desc, progress.Token);
                     exportTasks.Add(task);
-                    
-                    await task;
+                    pending.Enqueue(task);
+                }
+
+                while (pending.Count > 0)
+                {
+                    await pending.Dequeue();
                     completedFrames++;
                     progress.Progress = (float)completedFrames / (float)totalFrames;
                     progress.Token.ThrowIfCancellationRequested();
@@ -187,6 +187,7 @@ namespace ImageViewer.Commands.Export
             {"bmp", "BMP (*.bmp)" },
             {"tga", "TGA (*.tga)"},
             {"pfm", "Portable float map (*.pfm)" },
+            {"exr", "OpenEXR (*.exr)" },
             {"ktx", "Khronos Texture (*.ktx)" },
         };
 
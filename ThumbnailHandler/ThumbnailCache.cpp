@@ -0,0 +1,272 @@
+#include "pch.h"
+#include "ThumbnailCache.h"
+#include <KnownFolders.h>
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t s_magic = 0x43485654; // "TVHC"
+	constexpr uint32_t s_version = 1;
+	constexpr uint32_t s_numSlots = 1 << 14;
+	constexpr uint32_t s_maxProbes = 8;
+	constexpr uint64_t s_ringSize = 64ull * 1024 * 1024;
+	// larger thumbnails would evict too many entries at once
+	constexpr uint64_t s_maxRecordSize = s_ringSize / 8;
+	// explorer should not wait for other processes that are inserting
+	constexpr DWORD s_insertTimeout = 50;
+
+	uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// FNV-1a
+	uint64_t hash(uint64_t h, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			h ^= bytes[i];
+			h *= 0x100000001b3ull;
+		}
+		return h;
+	}
+
+	// holds the named mutex for the lifetime of the object
+	class MutexLock
+	{
+	public:
+		MutexLock(HANDLE mutex, DWORD timeout) : m_mutex(mutex)
+		{
+			const DWORD res = WaitForSingleObject(mutex, timeout);
+			// abandoned => the previous owner crashed. The entries are validated on lookup, so the cache is still usable
+			m_locked = res == WAIT_OBJECT_0 || res == WAIT_ABANDONED;
+		}
+		~MutexLock()
+		{
+			if (m_locked) ReleaseMutex(m_mutex);
+		}
+		bool IsLocked() const { return m_locked; }
+
+	private:
+		HANDLE m_mutex;
+		bool m_locked;
+	};
+}
+
+struct ThumbnailCache::Header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numSlots;
+	uint32_t reserved;
+	uint64_t ringSize;
+	// absolute position of the next record (the physical offset is writePos % ringSize).
+	// Records before writePos - ringSize are overwritten
+	std::atomic<uint64_t> writePos;
+};
+
+struct ThumbnailCache::Slot
+{
+	std::atomic<uint64_t> key; // 0 = empty
+	std::atomic<uint64_t> pos; // absolute position of the record
+};
+
+struct ThumbnailCache::Record
+{
+	uint64_t key;
+	uint32_t width;
+	uint32_t height;
+	// followed by width * height BGRA pixels
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory requires lock-free atomics");
+
+ThumbnailCache& ThumbnailCache::Get()
+{
+	static ThumbnailCache s_cache;
+	return s_cache;
+}
+
+uint64_t ThumbnailCache::MakeKey(const std::wstring& filename, uint32_t size)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExW(filename.c_str(), GetFileExInfoStandard, &attributes))
+		return 0;
+
+	// paths are case insensitive
+	std::wstring path = filename;
+	CharLowerBuffW(path.data(), DWORD(path.size()));
+
+	uint64_t h = 0xcbf29ce484222325ull;
+	h = hash(h, path.data(), path.size() * sizeof(wchar_t));
+	h = hash(h, &attributes.nFileSizeHigh, sizeof(attributes.nFileSizeHigh));
+	h = hash(h, &attributes.nFileSizeLow, sizeof(attributes.nFileSizeLow));
+	h = hash(h, &attributes.ftLastWriteTime, sizeof(attributes.ftLastWriteTime));
+	h = hash(h, &size, sizeof(size));
+	return h ? h : 1;
+}
+
+ThumbnailCache::ThumbnailCache()
+{
+	if (!Open())
+	{
+		// disable the cache
+		m_header = nullptr;
+	}
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	if (m_view) UnmapViewOfFile(m_view);
+	if (m_mapping) CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+	if (m_mutex) CloseHandle(m_mutex);
+}
+
+bool ThumbnailCache::Open()
+{
+	PWSTR appData = nullptr;
+	if (FAILED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &appData)))
+		return false;
+	std::wstring directory = std::wstring(appData) + L"\\ImageViewer";
+	CoTaskMemFree(appData);
+	CreateDirectoryW(directory.c_str(), nullptr);
+
+	m_mutex = CreateMutexW(nullptr, FALSE, L"Local\\ImageViewerThumbnailCache");
+	if (!m_mutex) return false;
+
+	// the file is initialized by the first process
+	MutexLock lock(m_mutex, INFINITE);
+	if (!lock.IsLocked()) return false;
+
+	m_file = CreateFileW((directory + L"\\thumbnails.cache").c_str(), GENERIC_READ | GENERIC_WRITE,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NOT_CONTENT_INDEXED, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) return false;
+
+	const uint64_t ringOffset = alignUp(sizeof(Header) + sizeof(Slot) * s_numSlots, 4096);
+	const uint64_t fileSize = ringOffset + s_ringSize;
+
+	// extends the file if required
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, DWORD(fileSize >> 32), DWORD(fileSize), nullptr);
+	if (!m_mapping) return false;
+	m_view = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, SIZE_T(fileSize)));
+	if (!m_view) return false;
+
+	m_header = reinterpret_cast<Header*>(m_view);
+	m_slots = reinterpret_cast<Slot*>(m_view + sizeof(Header));
+	m_ring = m_view + ringOffset;
+
+	if (m_header->magic != s_magic || m_header->version != s_version || m_header->numSlots != s_numSlots || m_header->ringSize != s_ringSize)
+	{
+		// new file or different layout
+		m_header->magic = 0;
+		std::memset(m_slots, 0, sizeof(Slot) * s_numSlots);
+		m_header->version = s_version;
+		m_header->numSlots = s_numSlots;
+		m_header->ringSize = s_ringSize;
+		m_header->writePos.store(0);
+		m_header->magic = s_magic;
+		FlushViewOfFile(m_view, SIZE_T(ringOffset));
+	}
+
+	return true;
+}
+
+bool ThumbnailCache::IsValid(uint64_t pos, uint64_t size, uint64_t writePos) const
+{
+	// written and not overwritten yet
+	return pos + size <= writePos && writePos - pos <= s_ringSize;
+}
+
+bool ThumbnailCache::Find(uint64_t key, std::vector<uint8_t>& bgra, int& width, int& height) const
+{
+	if (!m_header || key == 0) return false;
+
+	for (uint32_t i = 0; i < s_maxProbes; ++i)
+	{
+		const Slot& slot = m_slots[(key + i) % s_numSlots];
+		if (slot.key.load(std::memory_order_acquire) != key) continue;
+
+		const uint64_t pos = slot.pos.load(std::memory_order_acquire);
+		if (!IsValid(pos, sizeof(Record), m_header->writePos.load(std::memory_order_acquire)))
+			return false;
+
+		// the slot might have been reused in the meantime => verify the record
+		Record record;
+		std::memcpy(&record, m_ring + pos % s_ringSize, sizeof(Record));
+		const uint64_t dataSize = uint64_t(record.width) * record.height * 4;
+		if (record.key != key || sizeof(Record) + dataSize > s_maxRecordSize)
+			return false;
+
+		bgra.resize(size_t(dataSize));
+		std::memcpy(bgra.data(), m_ring + pos % s_ringSize + sizeof(Record), size_t(dataSize));
+
+		// the record must not be overwritten while copying
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (!IsValid(pos, sizeof(Record) + dataSize, m_header->writePos.load(std::memory_order_relaxed)))
+			return false;
+
+		width = int(record.width);
+		height = int(record.height);
+		return true;
+	}
+
+	return false;
+}
+
+void ThumbnailCache::Insert(uint64_t key, const uint8_t* bgra, int width, int height)
+{
+	static_assert(sizeof(Record) % 16 == 0, "records are 16 byte aligned");
+	if (!m_header || key == 0 || width <= 0 || height <= 0) return;
+
+	const uint64_t dataSize = uint64_t(width) * uint64_t(height) * 4;
+	const uint64_t recordSize = alignUp(sizeof(Record) + dataSize, 16);
+	if (recordSize > s_maxRecordSize) return;
+
+	MutexLock lock(m_mutex, s_insertTimeout);
+	if (!lock.IsLocked()) return;
+
+	// reserve space. Records do not wrap around the end of the ring
+	uint64_t pos = m_header->writePos.load();
+	const uint64_t offset = pos % s_ringSize;
+	if (offset + recordSize > s_ringSize)
+		pos += s_ringSize - offset;
+
+	// readers of the overwritten records will notice the new write position
+	m_header->writePos.store(pos + recordSize);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	Record record;
+	record.key = key;
+	record.width = uint32_t(width);
+	record.height = uint32_t(height);
+	std::memcpy(m_ring + pos % s_ringSize, &record, sizeof(Record));
+	std::memcpy(m_ring + pos % s_ringSize + sizeof(Record), bgra, size_t(dataSize));
+
+	// use the slot with the same key, an empty or evicted slot, or the oldest slot
+	const uint64_t writePos = pos + recordSize;
+	Slot* target = nullptr;
+	uint64_t targetPos = UINT64_MAX;
+	for (uint32_t i = 0; i < s_maxProbes; ++i)
+	{
+		Slot& slot = m_slots[(key + i) % s_numSlots];
+		const uint64_t slotKey = slot.key.load(std::memory_order_relaxed);
+		const uint64_t slotPos = slot.pos.load(std::memory_order_relaxed);
+		if (slotKey == key || slotKey == 0 || !IsValid(slotPos, sizeof(Record), writePos))
+		{
+			target = &slot;
+			break;
+		}
+		if (slotPos < targetPos)
+		{
+			target = &slot;
+			targetPos = slotPos;
+		}
+	}
+
+	// publish the record after its data
+	target->key.store(0, std::memory_order_relaxed);
+	target->pos.store(pos, std::memory_order_release);
+	target->key.store(key, std::memory_order_release);
+}
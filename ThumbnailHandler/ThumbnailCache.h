@@ -0,0 +1,51 @@
+#pragma once
+
+#include <windows.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// persistent thumbnail cache that is shared by all processes of the session (%LOCALAPPDATA%\ImageViewer\thumbnails.cache).
+// The file is memory mapped and consists of a small hash index and an append-only ring buffer with BGRA bitmaps.
+// - lookups are lock-free: entries are validated with the ring write position after copying (like a seqlock)
+// - inserts are serialized with a named mutex
+// - eviction is size-bounded: new entries overwrite the oldest entries of the ring buffer
+class ThumbnailCache
+{
+public:
+	// returns the cache of the process (the cache is disabled if the file could not be mapped)
+	static ThumbnailCache& Get();
+
+	// key for the thumbnail of the file with the requested size. The key changes if the file is modified (size or write time).
+	// Returns 0 if the file attributes could not be retrieved (0 is never a valid key)
+	static uint64_t MakeKey(const std::wstring& filename, uint32_t size);
+
+	// copies the BGRA pixels of the thumbnail into bgra. Returns false if the thumbnail is not cached
+	bool Find(uint64_t key, std::vector<uint8_t>& bgra, int& width, int& height) const;
+
+	// adds the BGRA pixels of the thumbnail (width * height * 4 bytes) to the cache
+	void Insert(uint64_t key, const uint8_t* bgra, int width, int height);
+
+	~ThumbnailCache();
+	ThumbnailCache(const ThumbnailCache&) = delete;
+	ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+private:
+	struct Header;
+	struct Slot;
+	struct Record;
+
+	ThumbnailCache();
+	bool Open();
+	bool IsValid(uint64_t pos, uint64_t size, uint64_t writePos) const;
+
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+	HANDLE m_mutex = nullptr;
+	uint8_t* m_view = nullptr;
+
+	Header* m_header = nullptr;
+	Slot* m_slots = nullptr;
+	uint8_t* m_ring = nullptr;
+};
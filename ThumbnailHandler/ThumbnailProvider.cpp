@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "ThumbnailProvider.h"
+#include "ThumbnailCache.h"
 #include <Shlwapi.h>
 #include <Wincrypt.h>   // For CryptStringToBinary.
 #include <msxml6.h>
@@ -12,9 +13,25 @@
 extern HINSTANCE g_hInst;
 extern long g_cDllRef;
 
+// see image_thumbnail in DxImageLoader/interface.h
+typedef bool(__cdecl* ImageThumbnailFunc)(const char* filename, int maxSize, uint8_t* outRGBA, int& outWidth, int& outHeight);
+
+// the image loader is loaded once and stays loaded for the lifetime of the process (thumbnails are generated in-process)
+static ImageThumbnailFunc getImageThumbnail(const std::string& loaderPath)
+{
+	static ImageThumbnailFunc s_func = [&loaderPath]() -> ImageThumbnailFunc
+	{
+		// altered search path => dependencies of DxImageLoader.dll are searched in its directory
+		HMODULE module = LoadLibraryExA(loaderPath.c_str(), nullptr, LOAD_WITH_ALTERED_SEARCH_PATH);
+		if (!module) return nullptr;
+		return reinterpret_cast<ImageThumbnailFunc>(GetProcAddress(module, "image_thumbnail"));
+	}();
+	return s_func;
+}
+
 ThumbnailProvider::ThumbnailProvider(const std::string& directory)
 	:
-m_cRef(1), m_modelPath(directory + "ImageConsole.exe")
+m_cRef(1), m_loaderPath(directory + "DxImageLoader.dll")
 {
 	InterlockedIncrement(&g_cDllRef);
 }
@@ -60,26 +77,16 @@ IFACEMETHODIMP_(ULONG) ThumbnailProvider::Release()
 
 HRESULT ThumbnailProvider::Initialize(LPCWSTR pszFilePath, DWORD grfMode)
 {
-	if (m_model.has_value())
+	if (m_isInitialized)
 		return HRESULT_FROM_WIN32(ERROR_ALREADY_INITIALIZED);
 
-	std::wstring wpath(pszFilePath);
-	std::string spath;
-	spath.resize(wpath.size());
-	for (size_t i = 0; i < wpath.size(); ++i)
-		spath[i] = char(wpath[i]);
-
-	//m_model.ClearImages();
-	try
-	{
-		m_model.emplace(m_modelPath);
-		m_model->OpenImage(spath);
-		m_model->Sync();
-	}
-	catch (...)
-	{
+	if (!getImageThumbnail(m_loaderPath))
 		return S_FALSE;
-	}
+
+	m_path = pszFilePath;
+	m_filename.resize(m_path.size());
+	for (size_t i = 0; i < m_path.size(); ++i)
+		m_filename[i] = char(m_path[i]);
 
 	m_isInitialized = true;
 	return S_OK;
@@ -100,19 +107,32 @@ IFACEMETHODIMP ThumbnailProvider::GetThumbnail(UINT cx, HBITMAP* phbmp,
 {
 	if (!m_isInitialized) return S_FALSE;
 
+	if (cx == 0) return S_FALSE;
+
 	int width = 0, height = 0;
-	try
+	std::vector<uint8_t> data;
+	auto& cache = ThumbnailCache::Get();
+	const uint64_t key = ThumbnailCache::MakeKey(m_path, cx);
+	if (!cache.Find(key, data, width, height))
 	{
-		auto data = m_model->GenThumbnail(cx, width, height);
-		*phbmp = CreateBitmap(width, height, 1, 32, data.data());
+		const auto imageThumbnail = getImageThumbnail(m_loaderPath);
+		if (!imageThumbnail) return S_FALSE;
 
-		*pdwAlpha = WTSAT_ARGB;
-	}
-	catch (...)
-	{
-		return S_FALSE;
+		data.resize(size_t(cx) * size_t(cx) * 4);
+		if (!imageThumbnail(m_filename.c_str(), int(cx), data.data(), width, height))
+			return S_FALSE;
+
+		// windows bitmaps expect BGRA
+		for (size_t i = 0; i < size_t(width) * size_t(height); ++i)
+			std::swap(data[4 * i], data[4 * i + 2]);
+
+		cache.Insert(key, data.data(), width, height);
 	}
 
+	*phbmp = CreateBitmap(width, height, 1, 32, data.data());
+	if (!*phbmp) return S_FALSE;
+	*pdwAlpha = WTSAT_ARGB;
+
 	return S_OK;
 }
 
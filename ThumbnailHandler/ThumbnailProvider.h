@@ -4,8 +4,7 @@
 #include <thumbcache.h>     // For IThumbnailProvider
 #include <wincodec.h>       // Windows Imaging Codecs
 #include <string>
-#include "../ConsoleTest/ImageFramework.h"
-#include <optional>
+#include <vector>
 
 #pragma comment(lib, "windowscodecs.lib")
 
@@ -34,7 +33,8 @@ protected:
 private:
 	// Reference count of component.
 	long m_cRef;
-	std::optional<ImageFramework::Model> m_model;
-	std::string m_modelPath;
+	std::string m_loaderPath; // DxImageLoader.dll
+	std::string m_filename;
+	std::wstring m_path; // for the thumbnail cache
 	bool m_isInitialized = false;
 };
\ No newline at end of file